@@ -57,6 +57,29 @@ if "%1" == "-d" (
 
     popd
 
+) else if "%1" == "--tests" (
+
+    :: d_core tests
+    cl /O2 /EHsc /Fetimer_test ..\code\d_core\test\timer_test.cpp /I"..\code\d_core"
+    timer_test.exe
+    cl /O2 /EHsc /Feoffset_allocator_test ..\code\d_core\test\offset_allocator_test.cpp /I"..\code\d_core"
+    offset_allocator_test.exe
+    cl /O2 /EHsc /Fememory_arena_test ..\code\d_core\test\memory_arena_test.cpp /I"..\code\d_core"
+    memory_arena_test.exe
+    cl /O2 /EHsc /Fecache_test ..\code\d_core\test\cache_test.cpp /I"..\code\d_core"
+    cache_test.exe
+
+    popd
+
+) else if "%1" == "--tools" (
+
+    :: Command line tools
+    cl /O2 /EHsc /Feddx_counters ..\code\tools\ddx_counters.cpp /I"..\code\d_core"
+    cl /O2 /EHsc /std:c++17 /Feddx_io_bench ..\code\tools\ddx_io_bench.cpp /I"..\code\d_core"
+    cl /O2 /EHsc /std:c++17 /Feddx_cook ..\code\tools\ddx_cook.cpp /I"..\code\d_core" /I"..\third_party\tinygltf"
+
+    popd
+
 ) else (
 
     :: Compile this
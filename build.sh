@@ -0,0 +1,40 @@
+#!/bin/sh
+
+# Builds the parts of DDX123 that don't need D3D12: d_core tests and command line tools.
+# The renderer itself only builds on Windows, see build.bat
+
+# Change directory to this script's location
+cd "$(dirname "$0")"
+
+mkdir -p build_linux
+cd build_linux
+
+flags="-O2 -g -std=c++17 -pthread"
+includes="-I../code/d_core"
+
+if [ "$1" = "--tests" ]; then
+
+    # d_core tests
+    c++ $flags $includes -o timer_test ../code/d_core/test/timer_test.cpp || exit 1
+    ./timer_test || exit 1
+    c++ $flags $includes -o offset_allocator_test ../code/d_core/test/offset_allocator_test.cpp || exit 1
+    ./offset_allocator_test || exit 1
+    c++ $flags $includes -o memory_arena_test ../code/d_core/test/memory_arena_test.cpp || exit 1
+    ./memory_arena_test || exit 1
+    c++ $flags $includes -o cache_test ../code/d_core/test/cache_test.cpp || exit 1
+    ./cache_test || exit 1
+
+else
+
+    # Command line tools
+    c++ $flags $includes -o ddx_counters ../code/tools/ddx_counters.cpp || exit 1
+    c++ $flags $includes -o ddx_io_bench ../code/tools/ddx_io_bench.cpp || exit 1
+
+    # ddx_cook needs the tinygltf submodule
+    if [ -f ../third_party/tinygltf/tiny_gltf.h ]; then
+        c++ $flags $includes -I../third_party/tinygltf -o ddx_cook ../code/tools/ddx_cook.cpp || exit 1
+    else
+        echo "Skipping ddx_cook, third_party/tinygltf is missing. Run: git submodule update --init"
+    fi
+
+fi
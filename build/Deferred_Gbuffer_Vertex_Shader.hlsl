@@ -1,7 +1,7 @@
 
 #include "common.hlsli"
 
-ConstantBuffer<_Matrix>        model_matrix           : register(b1, VertexSpace);
+StructuredBuffer<Instance_Data> instance_data : register(t0, VertexSpace);
 
 struct VertexShaderOutput
 {
@@ -13,6 +13,21 @@ struct VertexShaderOutput
     float  tangent_handidness   : TEXCOORD5;
 };
 
+#ifdef QUANTIZED_VERTICES
+
+#include "vertex_quantization.hlsli"
+
+VertexShaderOutput main(Vertex_Quantized IN, uint instance_id : SV_InstanceID)
+{
+    VertexShaderOutput OUT;
+
+    float3 position = dequantize_position(IN.Position);
+    float3 normal;
+    float4 in_tangent;
+    decode_normal_tangent(IN.Normal_Tangent, normal, in_tangent);
+
+#else
+
 struct Vertex_Position_Normal_Tangent_Color_Texturecoord
 {
     float3 Position  : POSITION;
@@ -22,24 +37,31 @@ struct Vertex_Position_Normal_Tangent_Color_Texturecoord
     float4 Tangent   : TANGENT;
 };
 
-VertexShaderOutput main(Vertex_Position_Normal_Tangent_Color_Texturecoord IN)
+VertexShaderOutput main(Vertex_Position_Normal_Tangent_Color_Texturecoord IN, uint instance_id : SV_InstanceID)
 {
     VertexShaderOutput OUT;
 
+    float3 position   = IN.Position;
+    float3 normal     = normalize(IN.Normal.xyz);
+    float4 in_tangent = IN.Tangent;
+
+#endif
+
+    matrix model_matrix = instance_data[instance_id].model_matrix;
+
     // Convert Tangent, Normal vectors to world space:
-    float3 normal    = normalize(IN.Normal.xyz);
-    float3 w_normal  = normalize((mul(model_matrix._matrix, float4(normal, 0.0))).xyz);
-    float3 tangent   = normalize(IN.Tangent.xyz);
-    float3 w_tangent = normalize((mul(model_matrix._matrix, float4(tangent, 0.0))).xyz);
+    float3 w_normal  = normalize((mul(model_matrix, float4(normal, 0.0))).xyz);
+    float3 tangent   = normalize(in_tangent.xyz);
+    float3 w_tangent = normalize((mul(model_matrix, float4(tangent, 0.0))).xyz);
     
-    matrix mvp_matrix        = mul(per_frame_data.view_projection_matrix, model_matrix._matrix);
+    matrix mvp_matrix        = mul(per_frame_data.view_projection_matrix, model_matrix);
 
-    OUT.Position             = mul(mvp_matrix, float4(IN.Position, 1.0));
-    OUT.Frag_Position        = mul(model_matrix._matrix, float4(IN.Position, 1.0));
+    OUT.Position             = mul(mvp_matrix, float4(position, 1.0));
+    OUT.Frag_Position        = mul(model_matrix, float4(position, 1.0));
     OUT.TextureCoordinate    = IN.texCoord;
     OUT.t = w_tangent;
     OUT.n = w_normal;
-    OUT.tangent_handidness = IN.Tangent.w;
+    OUT.tangent_handidness = in_tangent.w;
 
     return OUT;
 }
\ No newline at end of file
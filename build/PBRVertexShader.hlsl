@@ -1,7 +1,7 @@
 
 #include "common.hlsli"
 
-ConstantBuffer<_Matrix>    model_matrix : register(b0, VertexSpace);
+StructuredBuffer<Instance_Data> instance_data : register(t0, VertexSpace);
 
 struct VertexPosColor
 {
@@ -40,6 +40,21 @@ struct VertexShaderOutput
     float  tangent_handidness   : TEXCOORD6;
 };
 
+#ifdef QUANTIZED_VERTICES
+
+#include "vertex_quantization.hlsli"
+
+VertexShaderOutput main(Vertex_Quantized IN, uint instance_id : SV_InstanceID)
+{
+    VertexShaderOutput OUT;
+
+    float3 position = dequantize_position(IN.Position);
+    float3 normal;
+    float4 tangent;
+    decode_normal_tangent(IN.Normal_Tangent, normal, tangent);
+
+#else
+
 struct Vertex_Position_Normal_Tangent_Color_Texturecoord
 {
     float3 Position  : POSITION;
@@ -49,26 +64,34 @@ struct Vertex_Position_Normal_Tangent_Color_Texturecoord
     float2 texCoord  : TEXCOORD;
 };
 
-VertexShaderOutput main(Vertex_Position_Normal_Tangent_Color_Texturecoord IN)
+VertexShaderOutput main(Vertex_Position_Normal_Tangent_Color_Texturecoord IN, uint instance_id : SV_InstanceID)
 {
     VertexShaderOutput OUT;
 
+    float3 position = IN.Position;
+    float3 normal   = IN.Normal.xyz;
+    float4 tangent  = IN.Tangent;
+
+#endif
+
+    matrix model_matrix = instance_data[instance_id].model_matrix;
+
     // Convert Tangent, Normal vectors to world space:
-    float3 n = normalize((mul(model_matrix._matrix, float4(IN.Normal.xyz, 0.0))).xyz);
-    float3 t = normalize((mul(model_matrix._matrix, float4(IN.Tangent.xyz, 0.0))).xyz);
+    float3 n = normalize((mul(model_matrix, float4(normal, 0.0))).xyz);
+    float3 t = normalize((mul(model_matrix, float4(tangent.xyz, 0.0))).xyz);
     
     // I think this is right..
-    matrix mvp_matrix     = mul(per_frame_data.view_projection_matrix, model_matrix._matrix);
+    matrix mvp_matrix     = mul(per_frame_data.view_projection_matrix, model_matrix);
 
     // I think this is right..
-    OUT.Position             = mul(mvp_matrix, float4(IN.Position, 1.0));
-    OUT.Frag_Position        = mul(model_matrix._matrix, float4(IN.Position, 1.0));
+    OUT.Position             = mul(mvp_matrix, float4(position, 1.0));
+    OUT.Frag_Position        = mul(model_matrix, float4(position, 1.0));
     matrix light_space_matrix = per_frame_data.light_space_matrix;
     OUT.Light_Space_Position = mul(per_frame_data.light_space_matrix, OUT.Frag_Position);
     OUT.TextureCoordinate = IN.texCoord;
     OUT.t = t;
     OUT.n = n;
-    OUT.tangent_handidness = IN.Tangent.w;
+    OUT.tangent_handidness = tangent.w;
 
     return OUT;
 }
\ No newline at end of file
@@ -2,28 +2,46 @@
 #include "common.hlsli"
 
 ConstantBuffer<_Matrix> light_matrix : register(b0, VertexSpace);
-ConstantBuffer<_Matrix> model_matrix : register(b1, VertexSpace);
+StructuredBuffer<Instance_Data> instance_data : register(t0, VertexSpace);
 
-struct Vertex_Position_Normal_Tangent_Color_Texturecoord
+struct VertexShaderOutput
 {
-    float3 Position  : POSITION;
-    float3 Normal    : NORMAL;
-    float3 Tangent   : TANGENT;
-    float3 Color     : COLOR;
-    float2 texCoord  : TEXCOORD;
+    float4 position  : SV_Position;
 };
 
-struct VertexShaderOutput
+// Only the position stream is bound
+#ifdef QUANTIZED_VERTICES
+
+#include "vertex_quantization.hlsli"
+
+struct Vertex_Position
 {
-    float4 position  : SV_Position;
+    float4 Position  : POSITION;
+};
+
+VertexShaderOutput main(Vertex_Position IN, uint instance_id : SV_InstanceID)
+{
+    VertexShaderOutput OUT;
+
+    float3 position = dequantize_position(IN.Position);
+
+#else
+
+struct Vertex_Position
+{
+    float3 Position  : POSITION;
 };
 
-VertexShaderOutput main(Vertex_Position_Normal_Tangent_Color_Texturecoord IN)
+VertexShaderOutput main(Vertex_Position IN, uint instance_id : SV_InstanceID)
 {
     VertexShaderOutput OUT;
 
+    float3 position = IN.Position;
+
+#endif
+
     // I think this is right..
-    OUT.position          = mul(model_matrix._matrix, float4(IN.Position, 1.0));
+    OUT.position          = mul(instance_data[instance_id].model_matrix, float4(position, 1.0));
     OUT.position          = mul(light_matrix._matrix, OUT.position);
 
     return OUT;
@@ -0,0 +1,47 @@
+// Decoding for Vertex_Quantized, encoded by quantize_mesh_vertices in model.cpp
+// Included by the vertex shaders when they're compiled with QUANTIZED_VERTICES
+
+ConstantBuffer<Mesh_Quantization> mesh_quantization : register(b2, VertexSpace);
+
+struct Vertex_Quantized
+{
+    float4 Position       : POSITION;  // Slot 0, R16G16B16A16_UNORM, within the mesh's bounds
+    float4 Normal_Tangent : NORMAL;    // Slot 1, R10G10B10A2_UNORM
+    float2 texCoord       : TEXCOORD;  // Slot 1, R16G16_FLOAT
+};
+
+float3 dequantize_position(float4 position){
+    return mesh_quantization.position_offset.xyz + position.xyz * mesh_quantization.position_scale.xyz;
+}
+
+// Octahedral encoding, e in [-1, 1]
+float3 oct_decode(float2 e){
+    float3 v = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    if(v.z < 0.0){
+        float2 folded = 1.0 - abs(v.yx);
+        v.x = v.x >= 0.0 ? folded.x : -folded.x;
+        v.y = v.y >= 0.0 ? folded.y : -folded.y;
+    }
+    return normalize(v);
+}
+
+// Orthonormal basis around n (Duff et al. 2017), has to match tangent_basis in model.cpp
+void tangent_basis(float3 n, out float3 b1, out float3 b2){
+    float s = n.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (s + n.z);
+    float b = n.x * n.y * a;
+    b1 = float3(1.0 + s * n.x * n.x * a, s * b, -s * n.x);
+    b2 = float3(b, s + n.y * n.y * a, -n.y);
+}
+
+// Normal in rg, tangent angle around the normal in b, handedness in a
+void decode_normal_tangent(float4 packed, out float3 normal, out float4 tangent){
+    normal = oct_decode(packed.xy * 2.0 - 1.0);
+
+    float3 b1, b2;
+    tangent_basis(normal, b1, b2);
+    float angle = (packed.z - 0.5) * 2.0 * PI;
+
+    tangent.xyz = cos(angle) * b1 + sin(angle) * b2;
+    tangent.w   = packed.w < 0.5 ? -1.0 : 1.0;
+}
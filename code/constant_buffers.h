@@ -62,4 +62,16 @@ ALIGN_STRUCT struct Texture_Index
 ALIGN_STRUCT struct _Matrix 
 {
     matrix _matrix;
-};
\ No newline at end of file
+};
+
+// Dequantizes Vertex_Quantized_Position: position = position_offset + unorm * position_scale
+ALIGN_STRUCT struct Mesh_Quantization
+{
+    float4 position_offset;
+    float4 position_scale;
+};
+// Per instance data, a StructuredBuffer element indexed by SV_InstanceID. Not a constant buffer, so not 256 aligned
+struct Instance_Data
+{
+    matrix model_matrix;
+};
@@ -0,0 +1,129 @@
+#ifndef _D_ATOMIC
+#define _D_ATOMIC
+
+#include "d_context.h"
+#include "d_types.h"
+
+#if COMPILER_MSVC
+#include <intrin.h>
+#elif ARCH_x64 || ARCH_x86
+#include <immintrin.h>
+#endif
+
+/*
+*   Thin wrappers around compiler atomic intrinsics.
+*   All operations are sequentially consistent (full barrier).
+*/
+
+namespace d_std {
+
+    #if COMPILER_MSVC
+
+    // Returns the value after the add
+    inline u32 atomic_add_u32(volatile u32* value, u32 amount){
+        return (u32)_InterlockedExchangeAdd((volatile long*)value, (long)amount) + amount;
+    }
+
+    // Returns the value after the add
+    inline u64 atomic_add_u64(volatile u64* value, u64 amount){
+        return (u64)_InterlockedExchangeAdd64((volatile __int64*)value, (__int64)amount) + amount;
+    }
+
+    // Returns the value before the exchange
+    inline u32 atomic_exchange_u32(volatile u32* value, u32 new_value){
+        return (u32)_InterlockedExchange((volatile long*)value, (long)new_value);
+    }
+
+    // Returns true if value was equal to expected and has been replaced with new_value
+    inline bool atomic_compare_exchange_u32(volatile u32* value, u32 expected, u32 new_value){
+        return (u32)_InterlockedCompareExchange((volatile long*)value, (long)new_value, (long)expected) == expected;
+    }
+
+    inline bool atomic_compare_exchange_u64(volatile u64* value, u64 expected, u64 new_value){
+        return (u64)_InterlockedCompareExchange64((volatile __int64*)value, (__int64)new_value, (__int64)expected) == expected;
+    }
+
+    inline u32 atomic_load_u32(volatile u32* value){
+        u32 result = *value;
+        _ReadWriteBarrier();
+        return result;
+    }
+
+    inline u64 atomic_load_u64(volatile u64* value){
+        u64 result = *value;
+        _ReadWriteBarrier();
+        return result;
+    }
+
+    inline void atomic_store_u32(volatile u32* value, u32 new_value){
+        _InterlockedExchange((volatile long*)value, (long)new_value);
+    }
+
+    inline void cpu_pause(){
+        _mm_pause();
+    }
+
+    #else
+
+    inline u32 atomic_add_u32(volatile u32* value, u32 amount){
+        return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+    }
+
+    inline u64 atomic_add_u64(volatile u64* value, u64 amount){
+        return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+    }
+
+    inline u32 atomic_exchange_u32(volatile u32* value, u32 new_value){
+        return __atomic_exchange_n(value, new_value, __ATOMIC_SEQ_CST);
+    }
+
+    inline bool atomic_compare_exchange_u32(volatile u32* value, u32 expected, u32 new_value){
+        return __atomic_compare_exchange_n(value, &expected, new_value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+
+    inline bool atomic_compare_exchange_u64(volatile u64* value, u64 expected, u64 new_value){
+        return __atomic_compare_exchange_n(value, &expected, new_value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+
+    inline u32 atomic_load_u32(volatile u32* value){
+        return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+    }
+
+    inline u64 atomic_load_u64(volatile u64* value){
+        return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+    }
+
+    inline void atomic_store_u32(volatile u32* value, u32 new_value){
+        __atomic_store_n(value, new_value, __ATOMIC_SEQ_CST);
+    }
+
+    inline void cpu_pause(){
+        #if ARCH_x64 || ARCH_x86
+        _mm_pause();
+        #endif
+    }
+
+    #endif // COMPILER_MSVC
+
+    // Only meant for short critical sections (registration, queue pushes)
+    struct Spin_Lock {
+
+        volatile u32 locked = 0;
+
+        inline void lock(){
+            while(!atomic_compare_exchange_u32(&locked, 0, 1)){
+                while(atomic_load_u32(&locked)){
+                    cpu_pause();
+                }
+            }
+        }
+
+        inline void unlock(){
+            atomic_store_u32(&locked, 0);
+        }
+
+    };
+
+}
+
+#endif // _D_ATOMIC
@@ -0,0 +1,218 @@
+#include "d_cache.h"
+#include "d_atomic.h"
+#include "d_helpers.h"
+#include "stdio.h"  // Entry files
+#include "stdlib.h" // qsort
+#include "string.h" // For strlen / strcmp
+
+namespace d_std {
+
+    Cache_Key cache_key(const char* kind, u32 version){
+
+        Cache_Key key = {};
+        cache_key_add(&key, kind, strlen(kind));
+        cache_key_add(&key, version);
+        return key;
+
+    }
+
+    // Each input is hashed on its own, then folded into the key, so the key doesn't depend on where one input ends and the next begins
+    void cache_key_add(Cache_Key* key, const void* data, u64 size){
+
+        Hash_128 chain[2] = {key->hash, murmur3_128((const u8*)data, size)};
+        key->hash = murmur3_128((const u8*)chain, sizeof(chain));
+
+    }
+
+    void cache_key_to_string(Cache_Key key, char* string){
+        snprintf(string, 33, "%016llx%016llx", key.hash.low, key.hash.high);
+    }
+
+    // False if it doesn't fit, a truncated path could be another entry's or another writer's temp file
+    static bool cache_path(char* path, const char* format, const char* directory, const char* name){
+
+        int length = snprintf(path, CACHE_PATH_SIZE, format, directory, name);
+        return length >= 0 && length < CACHE_PATH_SIZE;
+
+    }
+
+    static bool cache_entry_path(Derived_Data_Cache* cache, Cache_Key key, char* path){
+
+        char key_string[33];
+        cache_key_to_string(key, key_string);
+        return cache_path(path, "%s/%s.ddc", cache->directory, key_string);
+
+    }
+
+    bool cache_init(Derived_Data_Cache* cache, const char* directory, u64 size_cap){
+
+        *cache = {};
+
+        // Room for the slash and the longest name, so no entry or temp path is ever cut short
+        if(strlen(directory) + 1 + CACHE_NAME_MAX >= CACHE_PATH_SIZE){
+            return false;
+        }
+
+        strcpy(cache->directory, directory);
+        cache->size_cap = size_cap;
+
+        return os_create_directory(directory);
+
+    }
+
+    bool cache_get(Derived_Data_Cache* cache, Cache_Key key, Cache_Entry* entry){
+
+        *entry = {};
+
+        char path[CACHE_PATH_SIZE];
+        if(!cache_entry_path(cache, key, path) || !os_map_file(path, &entry->file, MAP_ACCESS_SEQUENTIAL)){
+            atomic_add_u32(&cache->misses, 1);
+            return false;
+        }
+
+        const Cache_Entry_Header* header = (const Cache_Entry_Header*)entry->file.data;
+        bool valid = entry->file.size >= sizeof(Cache_Entry_Header)               &&
+                     header->magic     == CACHE_ENTRY_MAGIC                        &&
+                     header->version   == CACHE_ENTRY_VERSION                      &&
+                     header->key.hash.low  == key.hash.low                         &&
+                     header->key.hash.high == key.hash.high                        &&
+                     header->data_size == entry->file.size - sizeof(Cache_Entry_Header);
+
+        // Entries are only ever written whole, so this is damage from outside. Drop it, it gets re-cooked
+        if(!valid){
+            os_unmap_file(&entry->file);
+            os_delete_file(path);
+            atomic_add_u32(&cache->misses, 1);
+            return false;
+        }
+
+        entry->data = entry->file.data + sizeof(Cache_Entry_Header);
+        entry->size = header->data_size;
+
+        // Least recently used is by write time
+        os_touch_file(path);
+        atomic_add_u32(&cache->hits, 1);
+
+        return true;
+
+    }
+
+    void cache_release(Cache_Entry* entry){
+
+        os_unmap_file(&entry->file);
+        *entry = {};
+
+    }
+
+    bool cache_put(Derived_Data_Cache* cache, Cache_Key key, const Cache_Blob* blobs, u32 blob_count){
+
+        char path[CACHE_PATH_SIZE];
+        char temp_path[CACHE_PATH_SIZE];
+        if(!cache_entry_path(cache, key, path)){
+            return false;
+        }
+
+        // Unique per process and per write, so concurrent writers never share a temp file
+        u32 temp_index = atomic_add_u32(&cache->temp_file_count, 1);
+        int temp_path_length = snprintf(temp_path, CACHE_PATH_SIZE, "%s.%u.%u.tmp", path, os_process_id(), temp_index);
+        if(temp_path_length < 0 || temp_path_length >= CACHE_PATH_SIZE){
+            return false;
+        }
+
+        FILE* file = fopen(temp_path, "wb");
+        if(file == NULL){
+            return false;
+        }
+
+        Cache_Entry_Header header = {};
+        header.magic   = CACHE_ENTRY_MAGIC;
+        header.version = CACHE_ENTRY_VERSION;
+        header.key     = key;
+        for(u32 i = 0; i < blob_count; i++){
+            header.data_size += blobs[i].size;
+        }
+
+        bool written = fwrite(&header, sizeof(Cache_Entry_Header), 1, file) == 1;
+        for(u32 i = 0; written && i < blob_count; i++){
+            written = fwrite(blobs[i].data, 1, blobs[i].size, file) == blobs[i].size;
+        }
+        written = fclose(file) == 0 && written;
+
+        // Another process may have put the same key first, either copy is the same data
+        if(!written || !os_rename_file(temp_path, path)){
+            os_delete_file(temp_path);
+            return false;
+        }
+
+        return true;
+
+    }
+
+    struct Cache_Trim_List {
+        File_Info* files;
+        u32        count;
+        u32        capacity;
+        u64        total_size;
+    };
+
+    static bool cache_file_name_has_suffix(const char* name, const char* suffix){
+        u64 name_length   = strlen(name);
+        u64 suffix_length = strlen(suffix);
+        return name_length > suffix_length && strcmp(name + name_length - suffix_length, suffix) == 0;
+    }
+
+    static void cache_trim_collect(const File_Info* file_info, void* data){
+
+        // Temp files count too, ones left behind by a crashed writer are the oldest and go first
+        if(file_info->is_directory || !(cache_file_name_has_suffix(file_info->name, ".ddc") || cache_file_name_has_suffix(file_info->name, ".tmp"))){
+            return;
+        }
+
+        Cache_Trim_List* list = (Cache_Trim_List*)data;
+        if(list->count == list->capacity){
+            list->capacity = d_max(list->capacity * 2, 256u);
+            list->files    = (File_Info*)realloc(list->files, list->capacity * sizeof(File_Info));
+        }
+
+        list->files[list->count++] = *file_info;
+        list->total_size += file_info->size;
+
+    }
+
+    static int cache_compare_write_time(const void* a, const void* b){
+        u64 time_a = ((const File_Info*)a)->last_write_time;
+        u64 time_b = ((const File_Info*)b)->last_write_time;
+        return (time_a > time_b) - (time_a < time_b);
+    }
+
+    u64 cache_trim(Derived_Data_Cache* cache){
+
+        Cache_Trim_List list = {};
+        os_list_directory(cache->directory, cache_trim_collect, &list);
+
+        u64 evicted_size = 0;
+
+        if(list.total_size > cache->size_cap){
+
+            qsort(list.files, list.count, sizeof(File_Info), cache_compare_write_time);
+
+            char path[CACHE_PATH_SIZE];
+            for(u32 i = 0; i < list.count && list.total_size - evicted_size > cache->size_cap; i++){
+                if(!cache_path(path, "%s/%s", cache->directory, list.files[i].name)){
+                    continue;
+                }
+                // Fails if another process has it open on Windows, it'll go next time
+                if(os_delete_file(path)){
+                    evicted_size += list.files[i].size;
+                }
+            }
+
+        }
+
+        free(list.files);
+
+        return evicted_size;
+
+    }
+
+}
@@ -0,0 +1,84 @@
+#ifndef _D_CACHE
+#define _D_CACHE
+
+#include "d_types.h"
+#include "d_hash.h"
+#include "d_os.h"
+
+/*
+*   Derived data cache
+*
+*   Cooked data (meshes, mip chains, ...) is stored on disk under a key hashed from everything
+*   that went into it: the source bytes, the processing parameters and the version of the code
+*   that produced it. Changing any input changes the key, so a stale entry is never read, it
+*   just stops being used and ages out.
+*
+*   Entries are written to a temporary file and renamed into place, so any number of processes
+*   can share a cache directory. A reader sees a whole entry or none.
+*
+*   Every hit touches the entry's write time. cache_trim deletes the least recently used
+*   entries until the directory fits under the size cap.
+*/
+
+#define CACHE_ENTRY_MAGIC    0x43444444 // "DDDC"
+#define CACHE_ENTRY_VERSION  1
+#define CACHE_PATH_SIZE      512
+// Longest name in the directory, "<32 hex key>.ddc.<pid>.<index>.tmp" with 10 digit u32s
+#define CACHE_NAME_MAX       (32 + 4 + 1 + 10 + 1 + 10 + 4)
+#define CACHE_DEFAULT_SIZE_CAP (2048ULL * 1024 * 1024)
+
+namespace d_std {
+
+    struct Cache_Key {
+        Hash_128 hash;
+    };
+
+    struct Cache_Entry_Header {
+        u32       magic;
+        u32       version;
+        Cache_Key key;        // Guards against a file under the wrong name
+        u64       data_size;
+    };
+
+    // A hit, data stays valid until cache_release
+    struct Cache_Entry {
+        Mapped_File file;
+        const u8*   data;
+        u64         size;
+    };
+
+    // One piece of an entry, cache_put writes the pieces back to back
+    struct Cache_Blob {
+        const void* data;
+        u64         size;
+    };
+
+    struct Derived_Data_Cache {
+        char         directory[CACHE_PATH_SIZE];
+        u64          size_cap;
+        volatile u32 hits;
+        volatile u32 misses;
+        volatile u32 temp_file_count;
+    };
+
+    // Every key starts from the kind of data and the version of the code that makes it
+    Cache_Key cache_key(const char* kind, u32 version);
+    void      cache_key_add(Cache_Key* key, const void* data, u64 size);
+    void      cache_key_to_string(Cache_Key key, char* string); // 33 chars with the terminator
+
+    // Fails if the directory is too long for its entries' paths to fit in CACHE_PATH_SIZE
+    bool cache_init(Derived_Data_Cache* cache, const char* directory, u64 size_cap = CACHE_DEFAULT_SIZE_CAP);
+    bool cache_get(Derived_Data_Cache* cache, Cache_Key key, Cache_Entry* entry);
+    void cache_release(Cache_Entry* entry);
+    bool cache_put(Derived_Data_Cache* cache, Cache_Key key, const Cache_Blob* blobs, u32 blob_count);
+    // Evicts least recently used entries until the cache is under its size cap. Returns bytes evicted
+    u64  cache_trim(Derived_Data_Cache* cache);
+
+    template <typename T>
+    inline void cache_key_add(Cache_Key* key, const T& value){
+        cache_key_add(key, &value, sizeof(T));
+    }
+
+}
+
+#endif // _D_CACHE
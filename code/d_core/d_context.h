@@ -21,6 +21,11 @@
 #define COMPILER_GCC 1
 #endif
 
+// Calling convention keywords only mean something to MSVC
+#if !COMPILER_MSVC
+#define __cdecl
+#endif
+
 /////////////////
 // OS
 /////////////////
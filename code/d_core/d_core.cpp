@@ -7,8 +7,28 @@
 // Strings
 #include "d_string.cpp"
 
+// Stats
+#include "d_stats.cpp"
+
+// Counters
+#include "d_counters.cpp"
+
+// Jobs
+#include "d_jobs.cpp"
+
+// Derived data cache
+#include "d_cache.cpp"
+
+// Offset allocator
+#include "d_offset_allocator.cpp"
+
 // Win32 OS implementations 
 #if OS_WINDOWS
 #include "win32/d_os_win32.cpp"
 #endif
 
+// Linux OS implementations
+#if OS_LINUX
+#include "linux/d_os_linux.cpp"
+#endif
+
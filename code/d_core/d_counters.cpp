@@ -0,0 +1,186 @@
+#include "d_counters.h"
+#include "d_atomic.h"
+#include "d_hash.h"
+#include "stdio.h"  // Ring file
+#include "string.h" // For memset / strncpy
+
+namespace d_std {
+
+    struct Counter_Registry {
+
+        // Interned names. name_table maps a name hash slot to (id + 1), 0 = empty slot
+        u16                  name_table[COUNTER_NAME_TABLE_SIZE];
+        char                 names[MAX_COUNTERS][COUNTER_NAME_SIZE];
+        volatile u32         count;
+        Spin_Lock            register_lock;
+
+        // Per-thread blocks. The last block is shared by any threads past MAX_COUNTER_THREADS
+        Counter_Thread_Block thread_blocks[MAX_COUNTER_THREADS + 1];
+        volatile u32         thread_block_count;
+
+        // Totals as of the last end of frame, used to turn running totals into per-frame values
+        u64                  previous_totals[MAX_COUNTERS];
+        Counter_Snapshot     last_frame;
+        u64                  frame_index;
+
+        // Ring file
+        FILE*                ring_file;
+        Counter_File_Header  ring_file_header;
+
+    };
+
+    static Counter_Registry counter_registry;
+    thread_local Counter_Thread_Block* counter_thread_block = nullptr;
+
+    Counter_Thread_Block* counter_acquire_thread_block(){
+
+        u32 block_index = atomic_add_u32(&counter_registry.thread_block_count, 1) - 1;
+        if(block_index >= MAX_COUNTER_THREADS){
+            block_index = MAX_COUNTER_THREADS;
+        }
+
+        counter_thread_block = &counter_registry.thread_blocks[block_index];
+        return counter_thread_block;
+
+    }
+
+    Counter_Id counter_register(const char* name){
+
+        u32 name_length = (u32)strlen(name);
+        u32 hash        = murmur3_32((const u8*)name, name_length);
+        Counter_Id id   = 0;
+
+        counter_registry.register_lock.lock();
+
+        // Linear probe for the name, or the first empty slot
+        for(u32 i = 0; i < COUNTER_NAME_TABLE_SIZE; i++){
+
+            u32 slot = (hash + i) % COUNTER_NAME_TABLE_SIZE;
+            u16 slot_value = counter_registry.name_table[slot];
+
+            if(slot_value == 0){
+
+                if(counter_registry.count >= MAX_COUNTERS){
+                    // Out of counters, everything past the limit aliases the last counter
+                    id = MAX_COUNTERS - 1;
+                    break;
+                }
+
+                id = (Counter_Id)counter_registry.count;
+                strncpy(counter_registry.names[id], name, COUNTER_NAME_SIZE - 1);
+                counter_registry.name_table[slot] = id + 1;
+                atomic_add_u32(&counter_registry.count, 1);
+                break;
+
+            } else if(strncmp(counter_registry.names[slot_value - 1], name, COUNTER_NAME_SIZE - 1) == 0){
+
+                id = slot_value - 1;
+                break;
+
+            }
+        }
+
+        counter_registry.register_lock.unlock();
+
+        return id;
+
+    }
+
+    u32 counter_count(){
+        return atomic_load_u32(&counter_registry.count);
+    }
+
+    const char* counter_name(Counter_Id id){
+        return counter_registry.names[id];
+    }
+
+    Counter_Snapshot* counters_last_frame(){
+        return &counter_registry.last_frame;
+    }
+
+    static void counters_write_ring_file_header(){
+
+        Counter_File_Header& header = counter_registry.ring_file_header;
+        header.counter_count  = counter_count();
+        header.frames_written = counter_registry.frame_index;
+        memcpy(header.names, counter_registry.names, sizeof(header.names));
+
+        fseek(counter_registry.ring_file, 0, SEEK_SET);
+        fwrite(&header, sizeof(Counter_File_Header), 1, counter_registry.ring_file);
+        fflush(counter_registry.ring_file);
+
+    }
+
+    bool counters_open_ring_file(const char* filename, u32 ring_capacity){
+
+        if(counter_registry.ring_file){
+            counters_close_ring_file();
+        }
+
+        counter_registry.ring_file = fopen(filename, "w+b");
+        if(counter_registry.ring_file == NULL){
+            return false;
+        }
+
+        Counter_File_Header& header = counter_registry.ring_file_header;
+        memset(&header, 0, sizeof(Counter_File_Header));
+        header.magic         = COUNTER_FILE_MAGIC;
+        header.version       = COUNTER_FILE_VERSION;
+        header.ring_capacity = ring_capacity;
+
+        counters_write_ring_file_header();
+
+        return true;
+
+    }
+
+    void counters_close_ring_file(){
+
+        if(counter_registry.ring_file){
+            counters_write_ring_file_header();
+            fclose(counter_registry.ring_file);
+            counter_registry.ring_file = NULL;
+        }
+
+    }
+
+    void counters_end_frame(){
+
+        u32 thread_block_count = d_min(atomic_load_u32(&counter_registry.thread_block_count), (u32)MAX_COUNTER_THREADS + 1);
+        u32 count              = counter_count();
+
+        Counter_Snapshot& snapshot = counter_registry.last_frame;
+        snapshot.frame_index = counter_registry.frame_index;
+
+        for(u32 counter = 0; counter < count; counter++){
+
+            // Other threads may be writing their blocks, aligned 64 bit reads won't tear
+            u64 total = 0;
+            for(u32 block = 0; block < thread_block_count; block++){
+                total += ((volatile u64*)counter_registry.thread_blocks[block].values)[counter];
+            }
+
+            snapshot.values[counter] = total - counter_registry.previous_totals[counter];
+            counter_registry.previous_totals[counter] = total;
+
+        }
+
+        counter_registry.frame_index++;
+
+        if(counter_registry.ring_file){
+
+            u32 ring_capacity = counter_registry.ring_file_header.ring_capacity;
+            u64 slot          = snapshot.frame_index % ring_capacity;
+
+            fseek(counter_registry.ring_file, (long)(sizeof(Counter_File_Header) + slot * sizeof(Counter_Snapshot)), SEEK_SET);
+            fwrite(&snapshot, sizeof(Counter_Snapshot), 1, counter_registry.ring_file);
+
+            if(counter_registry.frame_index % COUNTER_FILE_HEADER_FLUSH_INTERVAL == 0){
+                counters_write_ring_file_header();
+            }
+
+        }
+
+    }
+
+}
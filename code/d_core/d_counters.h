@@ -0,0 +1,80 @@
+#ifndef _D_COUNTERS
+#define _D_COUNTERS
+
+#include "d_types.h"
+
+/*
+*   Counter registry
+*
+*   Counters are registered by name once (names are interned, registering the same name twice
+*   returns the same id), then incremented from any thread with counter_add. Each thread writes
+*   to its own block of counters so the hot path is a plain add with no atomics.
+*
+*   counters_end_frame sums every thread's block and stores the difference from the last frame
+*   as that frame's snapshot. If a ring file is open, the snapshot is also written to it.
+*/
+
+#define MAX_COUNTERS                       64
+#define MAX_COUNTER_THREADS                64
+#define COUNTER_NAME_SIZE                  48
+#define COUNTER_NAME_TABLE_SIZE            (MAX_COUNTERS * 2)
+#define COUNTER_FILE_MAGIC                 0x43584444 // "DDXC"
+#define COUNTER_FILE_VERSION               1
+#define COUNTER_FILE_HEADER_FLUSH_INTERVAL 60
+
+namespace d_std {
+
+    typedef u16 Counter_Id;
+
+    struct Counter_Thread_Block {
+        u64 values[MAX_COUNTERS];
+    };
+
+    struct Counter_Snapshot {
+        u64 frame_index;
+        u64 values[MAX_COUNTERS];
+    };
+
+    /*
+        Counter ring file layout:
+            Counter_File_Header
+            Counter_Snapshot[ring_capacity]
+
+        Snapshot for frame f is stored in slot (f % ring_capacity).
+        Slots [0, min(frames_written, ring_capacity)) are valid.
+    */
+    struct Counter_File_Header {
+        u32  magic;
+        u32  version;
+        u32  counter_count;
+        u32  ring_capacity;
+        u64  frames_written;
+        char names[MAX_COUNTERS][COUNTER_NAME_SIZE];
+    };
+
+    extern thread_local Counter_Thread_Block* counter_thread_block;
+
+    Counter_Thread_Block* counter_acquire_thread_block();
+
+    Counter_Id        counter_register(const char* name);
+    u32               counter_count();
+    const char*       counter_name(Counter_Id id);
+    void              counters_end_frame();
+    Counter_Snapshot* counters_last_frame();
+    bool              counters_open_ring_file(const char* filename, u32 ring_capacity);
+    void              counters_close_ring_file();
+
+    inline void counter_add(Counter_Id id, u64 amount = 1){
+
+        Counter_Thread_Block* block = counter_thread_block;
+        if(block == nullptr){
+            block = counter_acquire_thread_block();
+        }
+
+        block->values[id] += amount;
+
+    }
+
+}
+
+#endif // _D_COUNTERS
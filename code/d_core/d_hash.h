@@ -47,6 +47,130 @@ namespace d_std {
         return h;
     }
 
+    struct Hash_128 {
+        u64 low;
+        u64 high;
+    };
+
+    static inline u64 murmur3_rotl_64(u64 x, u32 r){
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static inline u64 murmur3_fmix_64(u64 k){
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    // MurmurHash3_x64_128, for keys where 32 bits would collide (content hashes)
+    Hash_128 murmur3_128(const u8* key, u64 len, u64 seed = 0){
+        u64 h1 = seed;
+        u64 h2 = seed;
+        const u64 c1 = 0x87c37b91114253d5ULL;
+        const u64 c2 = 0x4cf5ad432745937fULL;
+
+        // For each 16 bytes in key
+        u64 k1, k2;
+        for(u64 i = len >> 4; i != 0; i--){
+            memcpy(&k1, key,     sizeof(u64));
+            memcpy(&k2, key + 8, sizeof(u64));
+            key += 16;
+
+            k1 *= c1; k1 = murmur3_rotl_64(k1, 31); k1 *= c2; h1 ^= k1;
+            h1 = murmur3_rotl_64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+            k2 *= c2; k2 = murmur3_rotl_64(k2, 33); k2 *= c1; h2 ^= k2;
+            h2 = murmur3_rotl_64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+        }
+
+        // Deal with the remaining bytes
+        k1 = 0;
+        k2 = 0;
+        u32 tail = (u32)(len & 15);
+        for(u32 i = tail; i > 8; i--){
+            k2 ^= (u64)key[i - 1] << ((i - 9) * 8);
+        }
+        for(u32 i = d_min(tail, 8u); i > 0; i--){
+            k1 ^= (u64)key[i - 1] << ((i - 1) * 8);
+        }
+        if(tail > 8){
+            k2 *= c2; k2 = murmur3_rotl_64(k2, 33); k2 *= c1; h2 ^= k2;
+        }
+        if(tail > 0){
+            k1 *= c1; k1 = murmur3_rotl_64(k1, 31); k1 *= c2; h1 ^= k1;
+        }
+
+        h1 ^= len;
+        h2 ^= len;
+        h1 += h2;
+        h2 += h1;
+        h1 = murmur3_fmix_64(h1);
+        h2 = murmur3_fmix_64(h2);
+        h1 += h2;
+        h2 += h1;
+
+        return {h1, h2};
+    }
+
+    // MurmurHash3's 32 bit finalizer. Hashes several u32s chained: murmur3_fmix_32(b ^ murmur3_fmix_32(a))
+    static inline u32 murmur3_fmix_32(u32 h){
+        h ^= h >> 16;
+        h *= 0x85ebca6b;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // Power of two with at least twice count slots, for open addressing with slot = hash & (size - 1)
+    static inline u32 hash_table_size(u32 count){
+        u32 size = 16;
+        while(size < count * 2){
+            size *= 2;
+        }
+        return size;
+    }
+
+    typedef bool (*Hash_Equal_Function)(void* data, u32 a, u32 b);
+
+    /*
+    *   Points each of count items (vertices mostly) at the first one equal to it, remap[i] <= i.
+    *   hashes has each item's hash, equal is only called for items with the same one.
+    *   Linear probing over a hash_table_size(count) table of item indices
+    */
+    void hash_remap_duplicates(const u32* hashes, u32 count, Hash_Equal_Function equal, void* data, u32* remap){
+
+        u32 size   = hash_table_size(count);
+        u32* table = (u32*)malloc((u64)size * sizeof(u32));
+        memset(table, 0xFF, (u64)size * sizeof(u32));
+
+        for(u32 i = 0; i < count; i++){
+
+            u32 h    = hashes[i];
+            u32 slot = h & (size - 1);
+            while(true){
+                u32 other = table[slot];
+                if(other == 0xFFFFFFFF){
+                    table[slot] = i;
+                    remap[i]    = i;
+                    break;
+                }
+                if(hashes[other] == h && equal(data, i, other)){
+                    remap[i] = other;
+                    break;
+                }
+                slot = (slot + 1) & (size - 1);
+            }
+
+        }
+
+        free(table);
+
+    }
+
     template<typename Value, u32 size>
     struct Static_String_Hash_Table {
 
@@ -60,7 +184,7 @@ namespace d_std {
 
     template<typename Value, u32 size>
     Value Static_String_Hash_Table<Value, size>::get_value(d_std::d_string key){
-        u32 value_index_32 = murmur3_32(key, key.size);
+        u32 value_index_32 = murmur3_32((const u8*)key.string, key.size);
         u32 value_index = value_index_32 % this->value_array_size;
 
         ASSERT(value_index < size);
@@ -69,7 +193,7 @@ namespace d_std {
 
     template<typename Value, u32 size>
     void Static_String_Hash_Table<Value, size>::add_value(d_std::d_string key, Value value){
-        u32 value_index_32 = murmur3_32(key, key.size);
+        u32 value_index_32 = murmur3_32((const u8*)key.string, key.size);
         u32 value_index = value_index_32 % this->value_array_size;
 
         ASSERT(value_index < size);
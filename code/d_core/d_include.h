@@ -13,5 +13,11 @@
 #include "d_span.h"
 #include "d_array.h"
 #include "d_hash.h"
+#include "d_stats.h"
+#include "d_atomic.h"
+#include "d_counters.h"
+#include "d_jobs.h"
+#include "d_cache.h"
+#include "d_offset_allocator.h"
 
 #endif // _D_INCLUDE
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "d_jobs.h"
+#include "d_atomic.h"
+#include "d_helpers.h"
+#include "d_os.h"
+
+namespace d_std {
+
+    struct Job {
+        Job_Function function;
+        void*        data;
+        u32          index;
+        Job_Counter* counter;
+    };
+
+    struct Job_System {
+
+        // Ring buffer, guarded by queue_lock
+        Job          queue[JOB_QUEUE_CAPACITY];
+        u32          queue_head;
+        u32          queue_count;
+        Spin_Lock    queue_lock;
+
+        // Counts queued jobs, idle workers sleep on it
+        u_ptr        work_semaphore;
+        u_ptr        workers[MAX_JOB_WORKERS];
+        u32          worker_count;
+        volatile u32 shutting_down;
+
+    };
+
+    static Job_System job_system;
+
+    static void job_run(Job& job){
+
+        job.function(job.data, job.index);
+        atomic_add_u32(&job.counter->remaining, (u32)-1);
+
+    }
+
+    static bool job_try_pop(Job* job){
+
+        bool popped = false;
+
+        job_system.queue_lock.lock();
+        if(job_system.queue_count > 0){
+            *job = job_system.queue[job_system.queue_head];
+            job_system.queue_head = (job_system.queue_head + 1) % JOB_QUEUE_CAPACITY;
+            job_system.queue_count--;
+            popped = true;
+        }
+        job_system.queue_lock.unlock();
+
+        return popped;
+
+    }
+
+    static void job_worker_main(void* data){
+
+        while(!atomic_load_u32(&job_system.shutting_down)){
+
+            Job job;
+            if(job_try_pop(&job)){
+                job_run(job);
+            } else {
+                os_semaphore_wait(job_system.work_semaphore);
+            }
+
+        }
+
+    }
+
+    void jobs_init(u32 worker_count){
+
+        if(job_system.worker_count > 0){
+            return;
+        }
+
+        if(worker_count == 0){
+            u32 processor_count = os_processor_count();
+            worker_count = processor_count > 1 ? processor_count - 1 : 0;
+        }
+        worker_count = d_min(worker_count, (u32)MAX_JOB_WORKERS);
+
+        job_system.queue_head     = 0;
+        job_system.queue_count    = 0;
+        job_system.shutting_down  = 0;
+        job_system.work_semaphore = os_create_semaphore(0);
+
+        for(u32 i = 0; i < worker_count; i++){
+            job_system.workers[i] = os_create_thread(job_worker_main, nullptr);
+        }
+        job_system.worker_count = worker_count;
+
+    }
+
+    void jobs_shutdown(){
+
+        if(job_system.worker_count == 0){
+            return;
+        }
+
+        atomic_store_u32(&job_system.shutting_down, 1);
+        os_semaphore_signal(job_system.work_semaphore, job_system.worker_count);
+
+        for(u32 i = 0; i < job_system.worker_count; i++){
+            os_join_thread(job_system.workers[i]);
+        }
+
+        os_destroy_semaphore(job_system.work_semaphore);
+        job_system.worker_count = 0;
+
+    }
+
+    u32 jobs_worker_count(){
+        return job_system.worker_count;
+    }
+
+    void jobs_dispatch(Job_Function function, void* data, u32 count, Job_Counter* counter){
+
+        atomic_add_u32(&counter->remaining, count);
+
+        u32 queued = 0;
+        for(u32 i = 0; i < count; i++){
+
+            Job job = {function, data, i, counter};
+
+            bool pushed = false;
+            if(job_system.worker_count > 0){
+                job_system.queue_lock.lock();
+                if(job_system.queue_count < JOB_QUEUE_CAPACITY){
+                    job_system.queue[(job_system.queue_head + job_system.queue_count) % JOB_QUEUE_CAPACITY] = job;
+                    job_system.queue_count++;
+                    pushed = true;
+                }
+                job_system.queue_lock.unlock();
+            }
+
+            // No workers, or the queue is full. Do it here
+            if(pushed){
+                queued++;
+            } else {
+                job_run(job);
+            }
+
+        }
+
+        if(queued > 0){
+            os_semaphore_signal(job_system.work_semaphore, d_min(queued, job_system.worker_count));
+        }
+
+    }
+
+    void jobs_wait(Job_Counter* counter){
+
+        while(atomic_load_u32(&counter->remaining) > 0){
+
+            Job job;
+            if(job_try_pop(&job)){
+                job_run(job);
+            } else {
+                cpu_pause();
+            }
+
+        }
+
+    }
+
+}
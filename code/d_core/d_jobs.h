@@ -0,0 +1,38 @@
+#ifndef _D_JOBS
+#define _D_JOBS
+
+#include "d_types.h"
+
+/*
+*   Job system
+*
+*   A fixed pool of worker threads pulling from one shared queue. Work is dispatched as
+*   a parallel for: jobs_dispatch queues function(data, index) for every index in [0, count)
+*   and adds count to a Job_Counter. jobs_wait runs queued jobs on the calling thread
+*   until the counter drops to 0, so waiting never idles a core.
+*
+*   Before jobs_init (or with 0 workers) jobs run inline in jobs_dispatch.
+*/
+
+#define JOB_QUEUE_CAPACITY 4096
+#define MAX_JOB_WORKERS    63
+
+namespace d_std {
+
+    typedef void (*Job_Function)(void* data, u32 index);
+
+    struct Job_Counter {
+        volatile u32 remaining = 0;
+    };
+
+    // worker_count = 0 starts one worker per processor, minus one for the calling thread
+    void jobs_init(u32 worker_count = 0);
+    void jobs_shutdown();
+    u32  jobs_worker_count();
+
+    void jobs_dispatch(Job_Function function, void* data, u32 count, Job_Counter* counter);
+    void jobs_wait(Job_Counter* counter);
+
+}
+
+#endif // _D_JOBS
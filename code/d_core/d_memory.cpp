@@ -3,11 +3,14 @@
 
 namespace d_std {
 
-    Memory_Arena* make_arena(u64 reserve_size) {
+    Memory_Arena* make_arena_reserve(u64 reserve_size) {
         Memory_Arena* arena = nullptr;
 
         if(reserve_size > sizeof(Memory_Arena)){
             u_ptr memory = d_reserve(reserve_size);
+            if(!memory){
+                return nullptr;
+            }
             d_commit(memory, sizeof(Memory_Arena));
             arena = (Memory_Arena*) memory;
 
@@ -20,7 +23,7 @@ namespace d_std {
     }
 
     Memory_Arena* make_arena() {
-        Memory_Arena* arena = make_arena(DEFAULT_ARENA_RESERVE_SIZE);
+        Memory_Arena* arena = make_arena_reserve(DEFAULT_ARENA_RESERVE_SIZE);
         return arena;
     }
 
@@ -66,7 +69,7 @@ namespace d_std {
     u_ptr Memory_Arena::push(u64 size) {
 
         u_ptr memory = 0;
-        if(size + this->position < capacity){
+        if(size + this->position <= capacity){
             if(size + this->position <= commit_position){
                 memory = (u_ptr)this + this->position;
                 this->position += size;
@@ -88,6 +91,15 @@ namespace d_std {
         return memory;
     }
 
+    u_ptr Memory_Arena::push_aligned(u64 size, u64 alignment) {
+
+        // The arena starts on a page, so an aligned position is an aligned address
+        u64 padding = AlignPow2Up(this->position, alignment) - this->position;
+        u_ptr memory = this->push(padding + size);
+
+        return memory ? memory + padding : 0;
+    }
+
     void Memory_Arena::pop_to(u64 position){
 
         if(position < this->position){
@@ -100,7 +112,7 @@ namespace d_std {
             if(next_commit_position < this->commit_position){
 
                 u64 decommission_size = this->commit_position - next_commit_position;
-                d_decommit((u_ptr)(this + next_commit_position), decommission_size);
+                d_decommit((u_ptr)this + next_commit_position, decommission_size);
                 this->commit_position = next_commit_position;
 
             }
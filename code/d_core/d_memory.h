@@ -5,11 +5,13 @@
 #include "d_os.h"
 #include "string.h" // For memcpy
 
+#if OS_WINDOWS
 #ifdef DEBUG
 #include "crtdbg.h"
 #else
 #include "crtdefs.h"
 #endif
+#endif
 
 // Would need to import d_os.h first to get os_*_memory definitions. Is that needed?
 
@@ -80,6 +82,8 @@ namespace d_std {
         //////////////////////////////////////////////////////
 
         u_ptr push(u64 size);
+        // Starts the allocation on a multiple of alignment, a power of 2 no bigger than a page
+        u_ptr push_aligned(u64 size, u64 alignment);
         void  pop_to(u64 position);
         void  pop_all();
 
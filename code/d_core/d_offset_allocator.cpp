@@ -0,0 +1,323 @@
+#include "d_offset_allocator.h"
+#include "d_helpers.h"
+#include "stdlib.h"
+#include "string.h" // For memset
+
+#if COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+namespace d_std {
+
+    static inline u32 offset_allocator_msb(u32 value){
+
+        #if COMPILER_MSVC
+        unsigned long index;
+        _BitScanReverse(&index, value);
+        return (u32)index;
+        #else
+        return 31 - (u32)__builtin_clz(value);
+        #endif
+
+    }
+
+    static inline u32 offset_allocator_lsb(u32 value){
+
+        #if COMPILER_MSVC
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return (u32)index;
+        #else
+        return (u32)__builtin_ctz(value);
+        #endif
+
+    }
+
+    /*
+    *   Group 0 has the sizes [0, SUB_BIN_COUNT), one bin each.
+    *   Group g > 0 has [SUB_BIN_COUNT << (g - 1), SUB_BIN_COUNT << g) in SUB_BIN_COUNT bins,
+    *   each of width 1 << (g - 1).
+    */
+    u32 offset_allocator_bin_floor(u32 size){
+
+        if(size < OFFSET_ALLOCATOR_SUB_BIN_COUNT){
+            return size;
+        }
+
+        u32 group = offset_allocator_msb(size) - OFFSET_ALLOCATOR_SUB_BIN_BITS + 1;
+        u32 sub_bin = (size >> (group - 1)) - OFFSET_ALLOCATOR_SUB_BIN_COUNT;
+        return group * OFFSET_ALLOCATOR_SUB_BIN_COUNT + sub_bin;
+
+    }
+
+    u32 offset_allocator_bin_size(u32 bin){
+
+        u32 group   = bin / OFFSET_ALLOCATOR_SUB_BIN_COUNT;
+        u32 sub_bin = bin % OFFSET_ALLOCATOR_SUB_BIN_COUNT;
+        if(group == 0){
+            return sub_bin;
+        }
+        return (OFFSET_ALLOCATOR_SUB_BIN_COUNT + sub_bin) << (group - 1);
+
+    }
+
+    // Can be OFFSET_ALLOCATOR_BIN_COUNT, past the last bin, for sizes above the last bin's smallest
+    u32 offset_allocator_bin_ceil(u32 size){
+
+        u32 bin = offset_allocator_bin_floor(size);
+        return offset_allocator_bin_size(bin) < size ? bin + 1 : bin;
+
+    }
+
+    /////////////////////////////////
+    // Bins
+    /////////////////////////////////
+
+    static void offset_allocator_insert_free(Offset_Allocator* allocator, u32 node_index){
+
+        Offset_Allocator_Node& node = allocator->nodes[node_index];
+        u32 bin = offset_allocator_bin_floor(node.size);
+
+        node.used         = 0;
+        node.bin_previous = OFFSET_ALLOCATOR_NO_NODE;
+        node.bin_next     = allocator->bin_heads[bin];
+        if(node.bin_next != OFFSET_ALLOCATOR_NO_NODE){
+            allocator->nodes[node.bin_next].bin_previous = node_index;
+        }
+        allocator->bin_heads[bin] = node_index;
+
+        u32 group = bin / OFFSET_ALLOCATOR_SUB_BIN_COUNT;
+        allocator->bin_masks[group] |= (u8)(1 << (bin % OFFSET_ALLOCATOR_SUB_BIN_COUNT));
+        allocator->group_mask       |= 1u << group;
+
+        allocator->free_size += node.size;
+        allocator->free_range_count++;
+
+    }
+
+    static void offset_allocator_remove_free(Offset_Allocator* allocator, u32 node_index){
+
+        Offset_Allocator_Node& node = allocator->nodes[node_index];
+        u32 bin = offset_allocator_bin_floor(node.size);
+
+        if(node.bin_previous != OFFSET_ALLOCATOR_NO_NODE){
+            allocator->nodes[node.bin_previous].bin_next = node.bin_next;
+        } else {
+            allocator->bin_heads[bin] = node.bin_next;
+        }
+        if(node.bin_next != OFFSET_ALLOCATOR_NO_NODE){
+            allocator->nodes[node.bin_next].bin_previous = node.bin_previous;
+        }
+
+        if(allocator->bin_heads[bin] == OFFSET_ALLOCATOR_NO_NODE){
+            u32 group = bin / OFFSET_ALLOCATOR_SUB_BIN_COUNT;
+            allocator->bin_masks[group] &= (u8)~(1 << (bin % OFFSET_ALLOCATOR_SUB_BIN_COUNT));
+            if(allocator->bin_masks[group] == 0){
+                allocator->group_mask &= ~(1u << group);
+            }
+        }
+
+        allocator->free_size -= node.size;
+        allocator->free_range_count--;
+
+    }
+
+    // First bin at or after bin with a free range, OFFSET_ALLOCATOR_BIN_COUNT if there's none
+    static u32 offset_allocator_find_bin(const Offset_Allocator* allocator, u32 bin){
+
+        if(bin >= OFFSET_ALLOCATOR_BIN_COUNT){
+            return OFFSET_ALLOCATOR_BIN_COUNT;
+        }
+
+        u32 group = bin / OFFSET_ALLOCATOR_SUB_BIN_COUNT;
+        u32 mask  = allocator->bin_masks[group] & (0xFFu << (bin % OFFSET_ALLOCATOR_SUB_BIN_COUNT));
+        if(mask == 0){
+            u32 group_mask = group + 1 < 32 ? allocator->group_mask & (~0u << (group + 1)) : 0;
+            if(group_mask == 0){
+                return OFFSET_ALLOCATOR_BIN_COUNT;
+            }
+            group = offset_allocator_lsb(group_mask);
+            mask  = allocator->bin_masks[group];
+        }
+
+        return group * OFFSET_ALLOCATOR_SUB_BIN_COUNT + offset_allocator_lsb(mask);
+
+    }
+
+    /////////////////////////////////
+    // Allocator
+    /////////////////////////////////
+
+    bool offset_allocator_init(Offset_Allocator* allocator, u32 size, u32 max_allocations){
+
+        memset(allocator, 0, sizeof(Offset_Allocator));
+        memset(allocator->bin_heads, 0xFF, sizeof(allocator->bin_heads));
+        allocator->size            = size;
+        allocator->max_allocations = max_allocations;
+
+        // Every allocation can have a free range before it, plus one at the end
+        u32 node_count = max_allocations * 2 + 1;
+        allocator->nodes        = (Offset_Allocator_Node*)malloc((u64)node_count * sizeof(Offset_Allocator_Node));
+        allocator->unused_nodes = (u32*)malloc((u64)node_count * sizeof(u32));
+        if(allocator->nodes == NULL || allocator->unused_nodes == NULL){
+            offset_allocator_release(allocator);
+            return false;
+        }
+
+        // Popped from the end, so node 0 goes first
+        for(u32 i = 0; i < node_count; i++){
+            allocator->unused_nodes[i] = node_count - 1 - i;
+        }
+        allocator->unused_node_count = node_count;
+
+        if(size > 0){
+            u32 node_index = allocator->unused_nodes[--allocator->unused_node_count];
+            Offset_Allocator_Node& node = allocator->nodes[node_index];
+            node.offset            = 0;
+            node.size              = size;
+            node.neighbor_previous = OFFSET_ALLOCATOR_NO_NODE;
+            node.neighbor_next     = OFFSET_ALLOCATOR_NO_NODE;
+            offset_allocator_insert_free(allocator, node_index);
+        }
+
+        return true;
+
+    }
+
+    void offset_allocator_release(Offset_Allocator* allocator){
+
+        free(allocator->nodes);
+        free(allocator->unused_nodes);
+        memset(allocator, 0, sizeof(Offset_Allocator));
+
+    }
+
+    Offset_Allocation offset_allocator_allocate(Offset_Allocator* allocator, u32 size){
+
+        Offset_Allocation allocation;
+        size = d_max(size, 1u);
+
+        // The split off remainder needs a node too
+        if(allocator->allocation_count >= allocator->max_allocations || allocator->unused_node_count == 0){
+            return allocation;
+        }
+
+        u32 node_index = OFFSET_ALLOCATOR_NO_NODE;
+        u32 bin = offset_allocator_find_bin(allocator, offset_allocator_bin_ceil(size));
+        if(bin < OFFSET_ALLOCATOR_BIN_COUNT){
+            node_index = allocator->bin_heads[bin];
+        } else {
+            // Nothing bigger is free, one of the ranges in size's own bin might still fit
+            u32 floor_bin = offset_allocator_bin_floor(size);
+            for(u32 i = allocator->bin_heads[floor_bin]; i != OFFSET_ALLOCATOR_NO_NODE; i = allocator->nodes[i].bin_next){
+                if(allocator->nodes[i].size >= size){
+                    node_index = i;
+                    break;
+                }
+            }
+        }
+
+        if(node_index == OFFSET_ALLOCATOR_NO_NODE){
+            return allocation;
+        }
+
+        offset_allocator_remove_free(allocator, node_index);
+        Offset_Allocator_Node& node = allocator->nodes[node_index];
+
+        // The rest of the range goes back as a free range right after the allocation
+        u32 remainder = node.size - size;
+        if(remainder > 0){
+            u32 remainder_index = allocator->unused_nodes[--allocator->unused_node_count];
+            Offset_Allocator_Node& remainder_node = allocator->nodes[remainder_index];
+            remainder_node.offset            = node.offset + size;
+            remainder_node.size              = remainder;
+            remainder_node.neighbor_previous = node_index;
+            remainder_node.neighbor_next     = node.neighbor_next;
+            if(node.neighbor_next != OFFSET_ALLOCATOR_NO_NODE){
+                allocator->nodes[node.neighbor_next].neighbor_previous = remainder_index;
+            }
+            node.neighbor_next = remainder_index;
+            offset_allocator_insert_free(allocator, remainder_index);
+        }
+
+        node.size = size;
+        node.used = 1;
+        allocator->allocation_count++;
+
+        allocation.offset = node.offset;
+        allocation.node   = node_index;
+        return allocation;
+
+    }
+
+    void offset_allocator_free(Offset_Allocator* allocator, Offset_Allocation allocation){
+
+        if(allocation.node == OFFSET_ALLOCATOR_NO_NODE || !allocator->nodes[allocation.node].used){
+            return;
+        }
+
+        u32 node_index = allocation.node;
+        Offset_Allocator_Node& node = allocator->nodes[node_index];
+
+        // Free neighbors are merged into this node and their nodes go back on the stack
+        u32 previous = node.neighbor_previous;
+        if(previous != OFFSET_ALLOCATOR_NO_NODE && !allocator->nodes[previous].used){
+            Offset_Allocator_Node& previous_node = allocator->nodes[previous];
+            offset_allocator_remove_free(allocator, previous);
+            node.offset            = previous_node.offset;
+            node.size             += previous_node.size;
+            node.neighbor_previous = previous_node.neighbor_previous;
+            if(node.neighbor_previous != OFFSET_ALLOCATOR_NO_NODE){
+                allocator->nodes[node.neighbor_previous].neighbor_next = node_index;
+            }
+            allocator->unused_nodes[allocator->unused_node_count++] = previous;
+        }
+
+        u32 next = node.neighbor_next;
+        if(next != OFFSET_ALLOCATOR_NO_NODE && !allocator->nodes[next].used){
+            Offset_Allocator_Node& next_node = allocator->nodes[next];
+            offset_allocator_remove_free(allocator, next);
+            node.size         += next_node.size;
+            node.neighbor_next = next_node.neighbor_next;
+            if(node.neighbor_next != OFFSET_ALLOCATOR_NO_NODE){
+                allocator->nodes[node.neighbor_next].neighbor_previous = node_index;
+            }
+            allocator->unused_nodes[allocator->unused_node_count++] = next;
+        }
+
+        offset_allocator_insert_free(allocator, node_index);
+        allocator->allocation_count--;
+
+    }
+
+    u32 offset_allocator_allocation_size(const Offset_Allocator* allocator, Offset_Allocation allocation){
+
+        if(allocation.node == OFFSET_ALLOCATOR_NO_NODE){
+            return 0;
+        }
+        return allocator->nodes[allocation.node].size;
+
+    }
+
+    Offset_Allocator_Report offset_allocator_report(const Offset_Allocator* allocator){
+
+        Offset_Allocator_Report report = {};
+        report.allocation_count = allocator->allocation_count;
+        report.allocated_size   = allocator->size - allocator->free_size;
+        report.free_size        = allocator->free_size;
+        report.free_range_count = allocator->free_range_count;
+
+        // The largest free range is in the highest non empty bin
+        if(allocator->group_mask){
+            u32 group = offset_allocator_msb(allocator->group_mask);
+            u32 bin   = group * OFFSET_ALLOCATOR_SUB_BIN_COUNT + offset_allocator_msb(allocator->bin_masks[group]);
+            for(u32 i = allocator->bin_heads[bin]; i != OFFSET_ALLOCATOR_NO_NODE; i = allocator->nodes[i].bin_next){
+                report.largest_free_range = d_max(report.largest_free_range, allocator->nodes[i].size);
+            }
+        }
+
+        return report;
+
+    }
+
+}
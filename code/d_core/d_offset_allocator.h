@@ -0,0 +1,91 @@
+#ifndef _D_OFFSET_ALLOCATOR
+#define _D_OFFSET_ALLOCATOR
+
+#include "d_types.h"
+
+/*
+*   Offset allocator
+*
+*   Hands out ranges of a fixed size space without touching it, for suballocating GPU buffers
+*   (vertices, indices, ...) from the CPU. Sizes and offsets are in whatever unit the caller uses.
+*
+*   Free ranges are kept in size bins like d_stats' histograms: sizes below 8 get a bin each,
+*   every power of two above is split into 8 bins. A bit per bin and per group of bins finds the
+*   smallest bin with a free range big enough in O(1). Freed ranges merge with free neighbors.
+*
+*   Allocating takes a range from the first non empty bin whose sizes are all big enough and
+*   returns the rest to the bins, which wastes nothing but can pass over a range in the size's own
+*   bin that would have fit. Those are only looked at when nothing bigger is free.
+*/
+
+#define OFFSET_ALLOCATOR_SUB_BIN_BITS   3
+#define OFFSET_ALLOCATOR_SUB_BIN_COUNT  (1 << OFFSET_ALLOCATOR_SUB_BIN_BITS)
+#define OFFSET_ALLOCATOR_GROUP_COUNT    (32 - OFFSET_ALLOCATOR_SUB_BIN_BITS + 1)
+#define OFFSET_ALLOCATOR_BIN_COUNT      (OFFSET_ALLOCATOR_GROUP_COUNT * OFFSET_ALLOCATOR_SUB_BIN_COUNT)
+#define OFFSET_ALLOCATOR_NO_SPACE       0xFFFFFFFF
+#define OFFSET_ALLOCATOR_NO_NODE        0xFFFFFFFF
+
+namespace d_std {
+
+    // offset is OFFSET_ALLOCATOR_NO_SPACE when the allocation failed. node is what offset_allocator_free takes back
+    struct Offset_Allocation {
+        u32 offset = OFFSET_ALLOCATOR_NO_SPACE;
+        u32 node   = OFFSET_ALLOCATOR_NO_NODE;
+    };
+
+    // A range, used or free, in offset order with its neighbors. Free ones are also in their bin's list
+    struct Offset_Allocator_Node {
+        u32 offset;
+        u32 size;
+        u32 bin_previous;
+        u32 bin_next;
+        u32 neighbor_previous;
+        u32 neighbor_next;
+        u32 used;
+    };
+
+    struct Offset_Allocator {
+        u32 size;
+        u32 max_allocations;
+        u32 allocation_count;
+        u32 free_size;
+        u32 free_range_count;
+
+        u32 group_mask;                                 // Bit g is set if any bin of group g has a free range
+        u8  bin_masks[OFFSET_ALLOCATOR_GROUP_COUNT];    // Bit s is set if bin s of the group has a free range
+        u32 bin_heads[OFFSET_ALLOCATOR_BIN_COUNT];
+
+        Offset_Allocator_Node* nodes;
+        u32* unused_nodes;          // Stack of node indices not in use
+        u32  unused_node_count;
+    };
+
+    struct Offset_Allocator_Report {
+        u32 allocation_count;
+        u32 allocated_size;
+        u32 free_size;
+        u32 free_range_count;
+        u32 largest_free_range;     // Biggest allocation that can succeed
+    };
+
+    // Bin the free ranges of a size go in, and the first bin whose ranges are all at least size
+    u32 offset_allocator_bin_floor(u32 size);
+    u32 offset_allocator_bin_ceil(u32 size);
+    // Smallest size in the bin
+    u32 offset_allocator_bin_size(u32 bin);
+
+    // Everything starts as one free range of size
+    bool offset_allocator_init(Offset_Allocator* allocator, u32 size, u32 max_allocations);
+    void offset_allocator_release(Offset_Allocator* allocator);
+
+    // A size of 0 is taken as 1
+    Offset_Allocation offset_allocator_allocate(Offset_Allocator* allocator, u32 size);
+    void              offset_allocator_free(Offset_Allocator* allocator, Offset_Allocation allocation);
+    // Size of a live allocation
+    u32               offset_allocator_allocation_size(const Offset_Allocator* allocator, Offset_Allocation allocation);
+
+    Offset_Allocator_Report offset_allocator_report(const Offset_Allocator* allocator);
+
+}
+
+#endif // _D_OFFSET_ALLOCATOR
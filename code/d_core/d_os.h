@@ -23,6 +23,131 @@ namespace d_std {
     void  os_debug_printf(char* lit_string, ...);
     void  os_debug_print (d_string);
 
+    // Memory mapped files
+    enum Map_Access_Hint {
+        MAP_ACCESS_SEQUENTIAL, // Read front to back once, read ahead aggressively
+        MAP_ACCESS_RANDOM,     // Scattered reads, don't read ahead
+    };
+
+    struct Mapped_File {
+        const u8* data = nullptr;
+        u64       size = 0;
+        u_ptr     file_handle    = 0;
+        u_ptr     mapping_handle = 0;
+    };
+
+    // Maps the whole file read only. Returns false if the file can't be opened or is empty
+    bool  os_map_file  (const char* filename, Mapped_File* mapped_file, Map_Access_Hint hint = MAP_ACCESS_SEQUENTIAL);
+    void  os_unmap_file(Mapped_File* mapped_file);
+    // Asks the OS to start reading [offset, offset + size) in the background
+    void  os_prefetch_mapped_file(Mapped_File* mapped_file, u64 offset, u64 size);
+
+    // Files
+    struct File_Info {
+        char name[256];        // Without the directory
+        u64  size;
+        u64  last_write_time;  // Nanoseconds since 1970
+        bool is_directory;
+    };
+
+    typedef void (*File_Info_Function)(const File_Info* file_info, void* data);
+
+    // Returns true if the directory exists afterwards
+    bool  os_create_directory(const char* path);
+    bool  os_delete_file(const char* filename);
+    // Replaces to in one step, anyone opening to sees either the old file or the new one
+    bool  os_rename_file(const char* from, const char* to);
+    // Sets the last write time to now
+    bool  os_touch_file(const char* filename);
+    // Calls function for every entry in the directory, except . and ..
+    bool  os_list_directory(const char* path, File_Info_Function function, void* data);
+    u32   os_process_id();
+
+    // Asynchronous file reads
+    //
+    // Reads are queued with os_async_reader_submit and handed back by os_async_reader_wait as they finish,
+    // in any order. Linux uses io_uring (5.6+, falls back to pread when unavailable), Windows uses
+    // overlapped reads completing into an I/O completion port. Up to queue_depth reads are kept in flight.
+    #define OS_ASYNC_DIRECT_ALIGNMENT 4096
+
+    struct Async_File {
+        u_ptr handle          = 0;
+        u64   size            = 0;
+        bool  is_open         = false;
+        bool  direct          = false; // Bypasses the OS file cache. Destination, offset and size must be OS_ASYNC_DIRECT_ALIGNMENT aligned
+        u_ptr completion_port = 0;     // Windows, the completion port the handle has been associated with
+    };
+
+    struct Async_Read {
+        Async_File* file;
+        u8*         destination;
+        u64         offset;
+        u32         size;
+        void*       user_data;
+
+        // Set when the read completes. bytes_read < size means the read hit the end of the file
+        u32         bytes_read;
+        s32         error;        // 0 on success, otherwise errno / GetLastError()
+
+        u8          os_data[32];  // Windows: OVERLAPPED
+    };
+
+    struct Async_Reader;
+
+    bool          os_open_async_file (const char* filename, bool direct, Async_File* file);
+    void          os_close_async_file(Async_File* file);
+    // Drops a file's pages from the OS file cache, so the next read comes from storage
+    bool          os_evict_file_cache(const char* filename);
+
+    Async_Reader* os_async_reader_create (u32 queue_depth);
+    void          os_async_reader_destroy(Async_Reader* reader);
+    const char*   os_async_reader_backend(Async_Reader* reader);
+    // Linux: reads landing inside [memory, memory + size) use io_uring fixed buffers. Does nothing on Windows
+    bool          os_async_reader_register_buffer(Async_Reader* reader, u8* memory, u64 size);
+    // Reads must stay valid until os_async_reader_wait returns them
+    void          os_async_reader_submit(Async_Reader* reader, Async_Read* reads, u32 count);
+    // Blocks until at least one read finishes, returns the number written to completed. 0 = nothing left in flight
+    u32           os_async_reader_wait  (Async_Reader* reader, Async_Read** completed, u32 max_completed);
+
+    // Time
+    // Ticks come from the invariant TSC when the CPU has one, calibrated once in os_timer_init
+    // against QueryPerformanceCounter / CLOCK_MONOTONIC_RAW. Otherwise ticks are the reference clock's.
+    void        os_timer_init();
+    u64         os_now_ticks();
+    u64         os_ticks_per_second();
+    const char* os_timer_source();
+    // Sleeps most of the way to target_ticks, then spins for the rest
+    void        os_sleep_until(u64 target_ticks);
+
+    // Threads
+    typedef void (*Thread_Function)(void* data);
+
+    u32   os_processor_count();
+    bool  os_pin_current_thread(u32 processor_index);
+    u_ptr os_create_thread(Thread_Function function, void* data);
+    void  os_join_thread(u_ptr thread);
+    u_ptr os_create_semaphore(u32 initial_count);
+    void  os_destroy_semaphore(u_ptr semaphore);
+    void  os_semaphore_wait(u_ptr semaphore);
+    void  os_semaphore_signal(u_ptr semaphore, u32 count);
+
+    inline f64 os_ticks_to_seconds(f64 ticks){ return ticks / (f64)os_ticks_per_second(); }
+    inline f64 os_ticks_to_ms     (f64 ticks){ return ticks * 1000. / (f64)os_ticks_per_second(); }
+    inline f64 os_ticks_to_us     (f64 ticks){ return ticks * 1000000. / (f64)os_ticks_per_second(); }
+    inline u64 os_seconds_to_ticks(f64 seconds){ return (u64)(seconds * (f64)os_ticks_per_second()); }
+    inline u64 os_ms_to_ticks     (f64 ms){ return (u64)(ms * (f64)os_ticks_per_second() / 1000.); }
+
+    // Exact integer conversions, split so ticks * 1e9 can't overflow
+    inline u64 os_ticks_to_ns(u64 ticks){
+        u64 frequency = os_ticks_per_second();
+        return (ticks / frequency) * 1000000000ULL + ((ticks % frequency) * 1000000000ULL) / frequency;
+    }
+
+    inline u64 os_ns_to_ticks(u64 ns){
+        u64 frequency = os_ticks_per_second();
+        return (ns / 1000000000ULL) * frequency + ((ns % 1000000000ULL) * frequency) / 1000000000ULL;
+    }
+
 }
 
-#endif // _D_OS
\ No newline at end of file
+#endif // _D_OS
@@ -15,7 +15,7 @@
 #endif // ifdef OS_WINDOWS
 #endif // ifdef PCOUNTER
 
-#ifndef PROFILED_SCOPE(ID)
+#ifndef PROFILED_SCOPE
 
 #define PROFILED_SCOPE(...)
 #define PROFILED_FUNCTION()
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "stdlib.h" // calloc / free
+
 namespace d_std {
 
     template <typename T>
@@ -42,6 +44,7 @@ namespace d_std {
             free(ptr);
             ptr = nullptr;
         }
+        nitems = 0;
     }
 
 };
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "d_stats.h"
+#include "d_helpers.h"
+#include "string.h" // For memset
+
+#if COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+namespace d_std {
+
+    static inline u32 most_significant_bit_64(u64 value){
+
+        #if COMPILER_MSVC
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return (u32)index;
+        #else
+        return 63 - (u32)__builtin_clzll(value);
+        #endif
+
+    }
+
+    /*
+    *   Group 0 stores the values [0, HISTOGRAM_SUB_BUCKET_COUNT) exactly.
+    *   Group g > 0 stores [SUB_BUCKET_COUNT << (g - 1), SUB_BUCKET_COUNT << g) in SUB_BUCKET_COUNT buckets,
+    *   each of width 1 << (g - 1).
+    */
+    u32 histogram_bucket_index(u64 value){
+
+        if(value < HISTOGRAM_SUB_BUCKET_COUNT){
+            return (u32)value;
+        }
+
+        u32 group = most_significant_bit_64(value) - HISTOGRAM_SUB_BUCKET_BITS + 1;
+        if(group >= HISTOGRAM_GROUP_COUNT){
+            return HISTOGRAM_BUCKET_COUNT - 1;
+        }
+
+        u32 sub_bucket = (u32)(value >> (group - 1)) - HISTOGRAM_SUB_BUCKET_COUNT;
+        return group * HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket;
+
+    }
+
+    u64 histogram_bucket_lower_bound(u32 bucket_index){
+
+        u32 group      = bucket_index / HISTOGRAM_SUB_BUCKET_COUNT;
+        u32 sub_bucket = bucket_index % HISTOGRAM_SUB_BUCKET_COUNT;
+
+        if(group == 0){
+            return sub_bucket;
+        }
+
+        return ((u64)(sub_bucket + HISTOGRAM_SUB_BUCKET_COUNT)) << (group - 1);
+
+    }
+
+    u64 histogram_bucket_upper_bound(u32 bucket_index){
+
+        u32 group = bucket_index / HISTOGRAM_SUB_BUCKET_COUNT;
+
+        if(group == 0){
+            return bucket_index;
+        }
+
+        return histogram_bucket_lower_bound(bucket_index) + (1ULL << (group - 1)) - 1;
+
+    }
+
+    //////////////////////////////////////////////////////
+    // Histogram
+    //////////////////////////////////////////////////////
+
+    void Histogram::reset(){
+
+        memset(this->bucket_counts, 0, sizeof(this->bucket_counts));
+        this->total_count = 0;
+        this->min_value   = (u64)-1;
+        this->max_value   = 0;
+        this->sum         = 0.;
+
+    }
+
+    void Histogram::record(u64 value){
+
+        this->bucket_counts[histogram_bucket_index(value)]++;
+        this->total_count++;
+        this->sum += (f64)value;
+
+        this->min_value = d_min(this->min_value, value);
+        this->max_value = d_max(this->max_value, value);
+
+    }
+
+    void Histogram::remove(u64 value){
+
+        u32 bucket_index = histogram_bucket_index(value);
+        if(this->bucket_counts[bucket_index] > 0){
+            this->bucket_counts[bucket_index]--;
+            this->total_count--;
+            this->sum -= (f64)value;
+        }
+
+    }
+
+    f64 Histogram::mean(){
+
+        if(this->total_count == 0) return 0.;
+        return this->sum / (f64)this->total_count;
+
+    }
+
+    // Returns the highest value that is equivalent (same bucket) to the value at the given percentile
+    u64 Histogram::value_at_percentile(f64 percentile){
+
+        if(this->total_count == 0) return 0;
+
+        u64 count_at_percentile = (u64)((percentile / 100.) * (f64)this->total_count + 0.5);
+        count_at_percentile = d_max(count_at_percentile, 1ULL);
+        count_at_percentile = d_min(count_at_percentile, this->total_count);
+
+        u64 running_count = 0;
+        for(u32 i = 0; i < HISTOGRAM_BUCKET_COUNT; i++){
+            running_count += this->bucket_counts[i];
+            if(running_count >= count_at_percentile){
+                u64 value = histogram_bucket_upper_bound(i);
+                return d_min(value, this->max_value);
+            }
+        }
+
+        return this->max_value;
+
+    }
+
+    //////////////////////////////////////////////////////
+    // Rolling Histogram
+    //////////////////////////////////////////////////////
+
+    void Rolling_Histogram::reset(){
+
+        this->window.reset();
+        this->lifetime.reset();
+        memset(this->window_values, 0, sizeof(this->window_values));
+        this->window_next_index = 0;
+
+    }
+
+    void Rolling_Histogram::record(u64 value){
+
+        // Age out the oldest value once the window is full
+        bool evicted_extreme = false;
+        if(this->window.total_count >= HISTOGRAM_WINDOW_SIZE){
+            u64 evicted = this->window_values[this->window_next_index];
+            evicted_extreme = evicted == this->window.min_value || evicted == this->window.max_value;
+            this->window.remove(evicted);
+        }
+
+        this->window_values[this->window_next_index] = value;
+        this->window_next_index = (this->window_next_index + 1) % HISTOGRAM_WINDOW_SIZE;
+
+        this->window.record(value);
+        this->lifetime.record(value);
+
+        // remove doesn't know the next smallest / largest value, the window does. Otherwise an old spike would
+        // keep clamping the window's percentiles until the next reset
+        if(evicted_extreme){
+            this->window.min_value = (u64)-1;
+            this->window.max_value = 0;
+            for(u32 i = 0; i < HISTOGRAM_WINDOW_SIZE; i++){
+                this->window.min_value = d_min(this->window.min_value, this->window_values[i]);
+                this->window.max_value = d_max(this->window.max_value, this->window_values[i]);
+            }
+        }
+
+    }
+
+    u64 Rolling_Histogram::window_max(){
+
+        return this->window.total_count ? this->window.max_value : 0;
+
+    }
+
+}
@@ -0,0 +1,66 @@
+#ifndef _D_STATS
+#define _D_STATS
+
+#include "d_types.h"
+
+/*
+*   Log-bucketed (HDR style) histograms for timing values.
+*
+*   Values are bucketed by their most significant bit, and each power of two range
+*   is split into HISTOGRAM_SUB_BUCKET_COUNT linear sub buckets. With 5 sub bucket bits,
+*   every recorded value is within ~3% of the value reported for its bucket, and the
+*   memory used by a histogram is constant no matter how many values are recorded.
+*/
+
+#define HISTOGRAM_SUB_BUCKET_BITS   5
+#define HISTOGRAM_SUB_BUCKET_COUNT  (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_GROUP_COUNT       40
+#define HISTOGRAM_BUCKET_COUNT      (HISTOGRAM_SUB_BUCKET_COUNT * HISTOGRAM_GROUP_COUNT)
+#define HISTOGRAM_WINDOW_SIZE       1024
+
+namespace d_std {
+
+    struct Histogram {
+
+        u32 bucket_counts[HISTOGRAM_BUCKET_COUNT];
+        u64 total_count;
+        u64 min_value;
+        u64 max_value;
+        f64 sum;
+
+        void reset();
+        void record(u64 value);
+        // Only valid for values that were previously recorded. Does not update min / max.
+        void remove(u64 value);
+        f64  mean();
+        // percentile is in the range [0, 100]
+        u64  value_at_percentile(f64 percentile);
+
+    };
+
+    /*
+        Keeps a histogram of the last HISTOGRAM_WINDOW_SIZE values, as well as a histogram of
+        every value recorded since the last reset. The raw values in the window are kept so
+        they can be removed from the window histogram as they age out, and so the window's min / max
+        are exact: they're recomputed from the values whenever the one aging out was the min or max.
+    */
+    struct Rolling_Histogram {
+
+        Histogram window;
+        Histogram lifetime;
+        u64       window_values[HISTOGRAM_WINDOW_SIZE];
+        u32       window_next_index;
+
+        void reset();
+        void record(u64 value);
+        u64  window_max();
+
+    };
+
+    u32 histogram_bucket_index(u64 value);
+    u64 histogram_bucket_lower_bound(u32 bucket_index);
+    u64 histogram_bucket_upper_bound(u32 bucket_index);
+
+}
+
+#endif // _D_STATS
@@ -4,6 +4,7 @@
 #include "d_context.h" // OS_WINDOWS_64
 #include "limits.h"
 
+#if COMPILER_MSVC
 typedef           __int8  s8;
 typedef  unsigned __int8  u8;
 typedef           __int16 s16;
@@ -17,6 +18,19 @@ typedef  unsigned __int64 u_ptr;
 #else
 typedef  unsigned __int32 u_ptr;
 #endif
+#else
+#include "stdint.h"
+typedef           int8_t  s8;
+typedef          uint8_t  u8;
+typedef          int16_t  s16;
+typedef         uint16_t  u16;
+typedef          int32_t  s32;
+typedef         uint32_t  u32;
+// long long so %lld / %llu stay correct on LP64
+typedef        long long  s64;
+typedef unsigned long long u64;
+typedef        uintptr_t  u_ptr;
+#endif
 
 typedef float  f32;
 typedef double f64;
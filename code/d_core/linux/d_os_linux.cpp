@@ -0,0 +1,913 @@
+#ifndef _D_OS_LINUX
+#define _D_OS_LINUX
+
+#include "../d_os.h"
+#include "../d_string.h"
+#include "../d_memory.h"
+#include "../d_helpers.h"
+#include "../d_atomic.h"
+
+#include "stdio.h"
+#include "stdarg.h"
+#include "time.h"
+#include "sched.h"
+#include "unistd.h"
+#include "pthread.h"
+#include "semaphore.h"
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "sys/syscall.h"
+#include "sys/uio.h"
+#include "dirent.h"
+#include "errno.h"
+#include "stdlib.h"
+#include "string.h"
+#include "linux/io_uring.h"
+
+#if ARCH_x64 || ARCH_x86
+#include "cpuid.h"
+#include "x86intrin.h"
+#endif
+
+namespace d_std {
+
+    //////////////////////////
+    // Memory
+    //////////////////////////
+
+    /*
+        munmap needs the size of the mapping, but os_release_memory only gets the pointer.
+        Reservations get one extra page in front that holds the reservation size.
+    */
+    static u64 os_page_size(){
+
+        static u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+        return page_size;
+
+    }
+
+    u_ptr
+    os_reserve_memory (u64 size){
+
+        u64   page_size = os_page_size();
+        void* mapping   = mmap(nullptr, size + page_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(mapping == MAP_FAILED){
+            return 0;
+        }
+
+        mprotect(mapping, page_size, PROT_READ | PROT_WRITE);
+        *(u64*)mapping = size;
+
+        return (u_ptr)mapping + page_size;
+
+    }
+
+    // Like VirtualAlloc / VirtualFree, every page touched by [memory, memory + size) is affected
+    static void os_page_range(u_ptr memory, u64 size, u_ptr* page_start, u64* page_range_size){
+
+        u64 page_size    = os_page_size();
+        *page_start      = memory & ~(page_size - 1);
+        *page_range_size = ((memory + size + page_size - 1) & ~(page_size - 1)) - *page_start;
+
+    }
+
+    void
+    os_commit_memory (u_ptr memory, u64 size){
+
+        u_ptr page_start;
+        u64   page_range_size;
+        os_page_range(memory, size, &page_start, &page_range_size);
+
+        mprotect((void*)page_start, page_range_size, PROT_READ | PROT_WRITE);
+
+    }
+
+    void
+    os_decommit_memory(u_ptr memory, u64 size){
+
+        u_ptr page_start;
+        u64   page_range_size;
+        os_page_range(memory, size, &page_start, &page_range_size);
+
+        madvise((void*)page_start, page_range_size, MADV_DONTNEED);
+        mprotect((void*)page_start, page_range_size, PROT_NONE);
+
+    }
+
+    void
+    os_release_memory (u_ptr memory){
+
+        u64   page_size = os_page_size();
+        void* mapping   = (void*)(memory - page_size);
+        munmap(mapping, *(u64*)mapping + page_size);
+
+    }
+
+    //////////////////////////
+    // Print
+    //////////////////////////
+
+    void
+    os_debug_print(const char * string)
+    {
+        fputs(string, stderr);
+    }
+
+    void
+    os_debug_print(d_string string)
+    {
+        fwrite(string.string, 1, string.size, stderr);
+    }
+
+    // _format_lit_string walks the stack for its arguments, which doesn't work with the
+    // System V calling convention (varargs are passed in registers). Use the C runtime instead.
+    void os_debug_printf(Memory_Arena *arena, char* lit_string, ...){
+
+        va_list va_args;
+        va_start(va_args, lit_string);
+        vfprintf(stderr, lit_string, va_args);
+        va_end(va_args);
+
+    }
+
+    //////////////////////////
+    // Memory mapped files
+    //////////////////////////
+
+    bool os_map_file(const char* filename, Mapped_File* mapped_file, Map_Access_Hint hint){
+
+        *mapped_file = {};
+
+        int file = open(filename, O_RDONLY);
+        if(file < 0){
+            return false;
+        }
+
+        struct stat file_stat;
+        if(fstat(file, &file_stat) != 0 || file_stat.st_size == 0){
+            close(file);
+            return false;
+        }
+
+        void* data = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if(data == MAP_FAILED){
+            close(file);
+            return false;
+        }
+
+        madvise(data, (size_t)file_stat.st_size, hint == MAP_ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+        if(hint == MAP_ACCESS_SEQUENTIAL){
+            madvise(data, (size_t)file_stat.st_size, MADV_WILLNEED);
+        }
+
+        mapped_file->data        = (const u8*)data;
+        mapped_file->size        = (u64)file_stat.st_size;
+        mapped_file->file_handle = (u_ptr)file;
+
+        return true;
+
+    }
+
+    void os_unmap_file(Mapped_File* mapped_file){
+
+        if(mapped_file->data){
+            munmap((void*)mapped_file->data, mapped_file->size);
+            close((int)mapped_file->file_handle);
+        }
+
+        *mapped_file = {};
+
+    }
+
+    void os_prefetch_mapped_file(Mapped_File* mapped_file, u64 offset, u64 size){
+
+        if(offset >= mapped_file->size){
+            return;
+        }
+
+        // madvise wants a page aligned start
+        u64 page_size     = os_page_size();
+        u64 aligned_start = offset & ~(page_size - 1);
+        u64 end           = d_min(offset + size, mapped_file->size);
+
+        madvise((void*)(mapped_file->data + aligned_start), end - aligned_start, MADV_WILLNEED);
+
+    }
+
+    //////////////////////////
+    // Files
+    //////////////////////////
+
+    bool os_create_directory(const char* path){
+        return mkdir(path, 0755) == 0 || errno == EEXIST;
+    }
+
+    bool os_delete_file(const char* filename){
+        return unlink(filename) == 0;
+    }
+
+    bool os_rename_file(const char* from, const char* to){
+        return rename(from, to) == 0;
+    }
+
+    bool os_touch_file(const char* filename){
+        return utimensat(AT_FDCWD, filename, NULL, 0) == 0;
+    }
+
+    bool os_list_directory(const char* path, File_Info_Function function, void* data){
+
+        DIR* directory = opendir(path);
+        if(directory == NULL){
+            return false;
+        }
+
+        char entry_path[4096];
+        while(dirent* entry = readdir(directory)){
+
+            if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0){
+                continue;
+            }
+
+            // A truncated name or path would be a different file, skip ones that don't fit
+            File_Info file_info = {};
+            u64 name_length = strlen(entry->d_name);
+            int path_length = snprintf(entry_path, sizeof(entry_path), "%s/%s", path, entry->d_name);
+            if(name_length >= sizeof(file_info.name) || path_length < 0 || path_length >= (int)sizeof(entry_path)){
+                continue;
+            }
+
+            struct stat entry_stat;
+            if(stat(entry_path, &entry_stat) != 0){
+                continue;   // Deleted since readdir
+            }
+
+            memcpy(file_info.name, entry->d_name, name_length + 1);
+            file_info.size            = (u64)entry_stat.st_size;
+            file_info.last_write_time = (u64)entry_stat.st_mtim.tv_sec * 1000000000ULL + (u64)entry_stat.st_mtim.tv_nsec;
+            file_info.is_directory    = S_ISDIR(entry_stat.st_mode);
+
+            function(&file_info, data);
+
+        }
+
+        closedir(directory);
+        return true;
+
+    }
+
+    u32 os_process_id(){
+        return (u32)getpid();
+    }
+
+    //////////////////////////
+    // Asynchronous file reads
+    //////////////////////////
+
+    bool os_open_async_file(const char* filename, bool direct, Async_File* file){
+
+        *file = {};
+
+        int handle = open(filename, O_RDONLY | (direct ? O_DIRECT : 0));
+        if(handle < 0){
+            return false;
+        }
+
+        struct stat file_stat;
+        if(fstat(handle, &file_stat) != 0){
+            close(handle);
+            return false;
+        }
+
+        if(!direct){
+            posix_fadvise(handle, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        file->handle  = (u_ptr)handle;
+        file->size    = (u64)file_stat.st_size;
+        file->is_open = true;
+        file->direct  = direct;
+
+        return true;
+
+    }
+
+    void os_close_async_file(Async_File* file){
+
+        if(file->is_open){
+            close((int)file->handle);
+        }
+
+        *file = {};
+
+    }
+
+    bool os_evict_file_cache(const char* filename){
+
+        int handle = open(filename, O_RDONLY);
+        if(handle < 0){
+            return false;
+        }
+
+        // Only drops clean pages, which is all a read only asset has
+        bool result = posix_fadvise(handle, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        close(handle);
+
+        return result;
+
+    }
+
+    struct Async_Reader {
+
+        // io_uring, ring_fd < 0 when io_uring isn't available and reads fall back to pread
+        int            ring_fd = -1;
+        u32            queue_depth;
+        u32            in_kernel;   // Consumed by the kernel, not completed yet
+        u32            unsubmitted; // In the submission ring past what io_uring_enter has consumed
+
+        void*          sq_ring;
+        u64            sq_ring_size;
+        void*          cq_ring;
+        u64            cq_ring_size;
+        io_uring_sqe*  sqes;
+        u64            sqes_size;
+
+        u32*           sq_head;
+        u32*           sq_tail;
+        u32*           sq_mask;
+        u32*           sq_entries;
+        u32*           sq_array;
+        u32*           cq_head;
+        u32*           cq_tail;
+        u32*           cq_mask;
+        io_uring_cqe*  cqes;
+
+        // Registered (fixed) buffer
+        u8*            registered_memory;
+        u64            registered_size;
+
+        // Reads waiting for a free slot in the ring. Ring buffer of pointers
+        Async_Read**   pending;
+        u32            pending_capacity;
+        u32            pending_head;
+        u32            pending_count;
+
+    };
+
+    static void async_pending_grow(Async_Reader* reader, u32 count){
+
+        if(reader->pending_count + count <= reader->pending_capacity){
+            return;
+        }
+
+        u32 new_capacity = d_max(reader->pending_capacity * 2, reader->pending_count + count);
+        Async_Read** new_pending = (Async_Read**)malloc(new_capacity * sizeof(Async_Read*));
+
+        for(u32 i = 0; i < reader->pending_count; i++){
+            new_pending[i] = reader->pending[(reader->pending_head + i) % reader->pending_capacity];
+        }
+
+        free(reader->pending);
+        reader->pending          = new_pending;
+        reader->pending_capacity = new_capacity;
+        reader->pending_head     = 0;
+
+    }
+
+    static void async_pending_push_back(Async_Reader* reader, Async_Read* read){
+
+        async_pending_grow(reader, 1);
+        reader->pending[(reader->pending_head + reader->pending_count) % reader->pending_capacity] = read;
+        reader->pending_count++;
+
+    }
+
+    // Short reads go back to the front so they finish before new work starts
+    static void async_pending_push_front(Async_Reader* reader, Async_Read* read){
+
+        async_pending_grow(reader, 1);
+        reader->pending_head = (reader->pending_head + reader->pending_capacity - 1) % reader->pending_capacity;
+        reader->pending[reader->pending_head] = read;
+        reader->pending_count++;
+
+    }
+
+    static Async_Read* async_pending_pop(Async_Reader* reader){
+
+        Async_Read* read = reader->pending[reader->pending_head];
+        reader->pending_head = (reader->pending_head + 1) % reader->pending_capacity;
+        reader->pending_count--;
+
+        return read;
+
+    }
+
+    static bool async_read_finished(Async_Read* read, s64 result){
+
+        if(result < 0){
+            read->error = (s32)-result;
+            return true;
+        }
+
+        read->bytes_read += (u32)result;
+
+        // 0 bytes = end of file
+        return result == 0 || read->bytes_read >= read->size;
+
+    }
+
+    Async_Reader* os_async_reader_create(u32 queue_depth){
+
+        Async_Reader* reader = (Async_Reader*)calloc(1, sizeof(Async_Reader));
+        reader->queue_depth = queue_depth;
+        reader->ring_fd     = -1;
+
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        int ring_fd = (int)syscall(__NR_io_uring_setup, queue_depth, &params);
+        if(ring_fd < 0){
+            return reader;
+        }
+
+        reader->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+        reader->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if(params.features & IORING_FEAT_SINGLE_MMAP){
+            reader->sq_ring_size = d_max(reader->sq_ring_size, reader->cq_ring_size);
+        }
+
+        reader->sq_ring = mmap(nullptr, reader->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if(params.features & IORING_FEAT_SINGLE_MMAP){
+            reader->cq_ring = reader->sq_ring;
+        } else {
+            reader->cq_ring = mmap(nullptr, reader->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        }
+        reader->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        reader->sqes      = (io_uring_sqe*)mmap(nullptr, reader->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+        if(reader->sq_ring == MAP_FAILED || reader->cq_ring == MAP_FAILED || reader->sqes == MAP_FAILED){
+            if(reader->sqes != MAP_FAILED){
+                munmap(reader->sqes, reader->sqes_size);
+            }
+            if(reader->cq_ring != MAP_FAILED && reader->cq_ring != reader->sq_ring){
+                munmap(reader->cq_ring, reader->cq_ring_size);
+            }
+            if(reader->sq_ring != MAP_FAILED){
+                munmap(reader->sq_ring, reader->sq_ring_size);
+            }
+            close(ring_fd);
+            return reader;
+        }
+
+        u8* sq_ring = (u8*)reader->sq_ring;
+        u8* cq_ring = (u8*)reader->cq_ring;
+        reader->sq_head    = (u32*)(sq_ring + params.sq_off.head);
+        reader->sq_tail    = (u32*)(sq_ring + params.sq_off.tail);
+        reader->sq_mask    = (u32*)(sq_ring + params.sq_off.ring_mask);
+        reader->sq_entries = (u32*)(sq_ring + params.sq_off.ring_entries);
+        reader->sq_array   = (u32*)(sq_ring + params.sq_off.array);
+        reader->cq_head    = (u32*)(cq_ring + params.cq_off.head);
+        reader->cq_tail    = (u32*)(cq_ring + params.cq_off.tail);
+        reader->cq_mask    = (u32*)(cq_ring + params.cq_off.ring_mask);
+        reader->cqes       = (io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+
+        // The completion ring can't overflow as long as in flight reads fit in the submission ring
+        reader->queue_depth = params.sq_entries;
+        reader->ring_fd     = ring_fd;
+
+        return reader;
+
+    }
+
+    void os_async_reader_destroy(Async_Reader* reader){
+
+        if(reader->ring_fd >= 0){
+            munmap(reader->sqes, reader->sqes_size);
+            if(reader->cq_ring != reader->sq_ring){
+                munmap(reader->cq_ring, reader->cq_ring_size);
+            }
+            munmap(reader->sq_ring, reader->sq_ring_size);
+            close(reader->ring_fd);
+        }
+
+        free(reader->pending);
+        free(reader);
+
+    }
+
+    const char* os_async_reader_backend(Async_Reader* reader){
+        return reader->ring_fd >= 0 ? "io_uring" : "pread (io_uring unavailable)";
+    }
+
+    bool os_async_reader_register_buffer(Async_Reader* reader, u8* memory, u64 size){
+
+        if(reader->ring_fd < 0 || reader->registered_memory){
+            return false;
+        }
+
+        iovec buffer;
+        buffer.iov_base = memory;
+        buffer.iov_len  = size;
+
+        // Pins the pages, fails past RLIMIT_MEMLOCK. Reads still work, just without fixed buffers
+        if(syscall(__NR_io_uring_register, reader->ring_fd, IORING_REGISTER_BUFFERS, &buffer, 1) < 0){
+            return false;
+        }
+
+        reader->registered_memory = memory;
+        reader->registered_size   = size;
+
+        return true;
+
+    }
+
+    /*
+    *   io_uring_enter with every entry the kernel hasn't consumed yet. It can consume fewer than it's given, or
+    *   none when it fails with EAGAIN / EBUSY, the rest stay unsubmitted and go with the next call.
+    *   Returns false if the call failed
+    */
+    static bool async_reader_enter(Async_Reader* reader, u32 min_complete, u32 flags){
+
+        while(true){
+
+            int result = (int)syscall(__NR_io_uring_enter, reader->ring_fd, reader->unsubmitted, min_complete, flags, nullptr, 0);
+            if(result >= 0){
+                u32 consumed = d_min((u32)result, reader->unsubmitted);
+                reader->unsubmitted -= consumed;
+                reader->in_kernel   += consumed;
+                return true;
+            }
+
+            if(errno != EINTR){
+                return false;
+            }
+
+        }
+
+    }
+
+    // Moves pending reads into the submission ring and submits them with one io_uring_enter
+    static void async_reader_submit_pending(Async_Reader* reader){
+
+        u32 tail      = *reader->sq_tail;
+        u32 submitted = 0;
+
+        while(reader->pending_count > 0 && reader->in_kernel + reader->unsubmitted + submitted < reader->queue_depth){
+
+            Async_Read* read = async_pending_pop(reader);
+
+            u32 index = tail & *reader->sq_mask;
+            io_uring_sqe* sqe = &reader->sqes[index];
+            memset(sqe, 0, sizeof(io_uring_sqe));
+
+            u8* destination = read->destination + read->bytes_read;
+            u32 size        = read->size - read->bytes_read;
+            bool fixed      = destination >= reader->registered_memory && destination + size <= reader->registered_memory + reader->registered_size;
+
+            sqe->opcode    = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            sqe->fd        = (int)read->file->handle;
+            sqe->addr      = (u64)destination;
+            sqe->len       = size;
+            sqe->off       = read->offset + read->bytes_read;
+            sqe->buf_index = 0;
+            sqe->user_data = (u64)read;
+
+            reader->sq_array[index] = index;
+            tail++;
+            submitted++;
+
+        }
+
+        if(submitted == 0 && reader->unsubmitted == 0){
+            return;
+        }
+
+        // The kernel must see the filled entries before the new tail
+        atomic_store_u32(reader->sq_tail, tail);
+        reader->unsubmitted += submitted;
+
+        async_reader_enter(reader, 0, 0);
+
+    }
+
+    // Takes the entries io_uring_enter didn't consume back out of the submission ring, their reads go back to the
+    // front of pending in the same order. Without SQPOLL the kernel only looks at the ring inside io_uring_enter
+    static void async_reader_unsubmit(Async_Reader* reader){
+
+        u32 tail = *reader->sq_tail;
+        for(; reader->unsubmitted > 0; reader->unsubmitted--){
+            tail--;
+            async_pending_push_front(reader, (Async_Read*)reader->sqes[tail & *reader->sq_mask].user_data);
+        }
+        atomic_store_u32(reader->sq_tail, tail);
+
+    }
+
+    // Does pending reads with pread, for when io_uring isn't available or io_uring_enter fails
+    static u32 async_reader_read_pending(Async_Reader* reader, Async_Read** completed, u32 max_completed){
+
+        u32 completed_count = 0;
+
+        while(reader->pending_count > 0 && completed_count < max_completed){
+
+            Async_Read* read = async_pending_pop(reader);
+
+            bool finished = false;
+            while(!finished){
+                ssize_t result = pread((int)read->file->handle, read->destination + read->bytes_read, read->size - read->bytes_read, (off_t)(read->offset + read->bytes_read));
+                finished = async_read_finished(read, result < 0 ? -(s64)errno : (s64)result);
+            }
+
+            completed[completed_count++] = read;
+
+        }
+
+        return completed_count;
+
+    }
+
+    void os_async_reader_submit(Async_Reader* reader, Async_Read* reads, u32 count){
+
+        async_pending_grow(reader, count);
+
+        for(u32 i = 0; i < count; i++){
+            reads[i].bytes_read = 0;
+            reads[i].error      = 0;
+            async_pending_push_back(reader, &reads[i]);
+        }
+
+        if(reader->ring_fd >= 0){
+            async_reader_submit_pending(reader);
+        }
+
+    }
+
+    u32 os_async_reader_wait(Async_Reader* reader, Async_Read** completed, u32 max_completed){
+
+        // Fallback, do the reads here
+        if(reader->ring_fd < 0){
+            return async_reader_read_pending(reader, completed, max_completed);
+        }
+
+        u32 completed_count = 0;
+
+        while(completed_count == 0 && (reader->in_kernel > 0 || reader->unsubmitted > 0 || reader->pending_count > 0)){
+
+            // Entries an earlier enter didn't get to are submitted first, only waiting on them would never return
+            u32 head     = *reader->cq_head;
+            bool entered = true;
+            if(head == atomic_load_u32(reader->cq_tail)){
+                if(reader->unsubmitted > 0){
+                    entered = async_reader_enter(reader, 0, 0);
+                }
+                if(entered && reader->in_kernel > 0 && head == atomic_load_u32(reader->cq_tail)){
+                    entered = async_reader_enter(reader, 1, IORING_ENTER_GETEVENTS);
+                }
+            }
+
+            // Retrying a failing io_uring_enter would spin here. What the kernel already has completes into the
+            // ring, everything else is read with pread. If there's nothing else, give up like Windows does
+            if(!entered){
+                async_reader_unsubmit(reader);
+                completed_count = async_reader_read_pending(reader, completed, max_completed);
+                if(completed_count == 0){
+                    break;
+                }
+            }
+
+            u32 tail = atomic_load_u32(reader->cq_tail);
+            while(head != tail && completed_count < max_completed){
+
+                io_uring_cqe* cqe = &reader->cqes[head & *reader->cq_mask];
+                Async_Read* read  = (Async_Read*)cqe->user_data;
+                head++;
+                reader->in_kernel--;
+
+                if(async_read_finished(read, cqe->res)){
+                    completed[completed_count++] = read;
+                } else {
+                    async_pending_push_front(reader, read);
+                }
+
+            }
+
+            atomic_store_u32(reader->cq_head, head);
+
+            // Refill the ring with whatever is still waiting
+            async_reader_submit_pending(reader);
+
+        }
+
+        return completed_count;
+
+    }
+
+    //////////////////////////
+    // Time
+    //////////////////////////
+
+    #define OS_TIMER_CALIBRATION_NS 50000000ULL // 50ms
+    #define OS_SLEEP_SPIN_MARGIN_NS 200000ULL   // clock_nanosleep usually wakes within ~100us
+
+    static bool os_timer_use_tsc          = false;
+    static u64  os_timer_ticks_per_second = 1000000000ULL;
+
+    static u64 os_reference_now_ns(){
+
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+        return (u64)time.tv_sec * 1000000000ULL + (u64)time.tv_nsec;
+
+    }
+
+    static u64 os_read_tsc(){
+
+        #if ARCH_x64 || ARCH_x86
+        // rdtscp waits for earlier instructions to finish, so the read can't be hoisted
+        unsigned int processor_id;
+        return __rdtscp(&processor_id);
+        #else
+        return 0;
+        #endif
+
+    }
+
+    static bool os_has_invariant_tsc(){
+
+        #if ARCH_x64 || ARCH_x86
+        unsigned int eax, ebx, ecx, edx;
+        if(!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007){
+            return false;
+        }
+
+        // rdtscp support, CPUID.80000001H:EDX[27]
+        __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+        if(!(edx & (1u << 27))){
+            return false;
+        }
+
+        // Invariant TSC, CPUID.80000007H:EDX[8]
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+        #else
+        return false;
+        #endif
+
+    }
+
+    void os_timer_init(){
+
+        if(!os_has_invariant_tsc()){
+            os_timer_use_tsc          = false;
+            os_timer_ticks_per_second = 1000000000ULL;
+            return;
+        }
+
+        // Spin on the reference clock so both clocks cover the same interval
+        u64 reference_start = os_reference_now_ns();
+        u64 tsc_start       = os_read_tsc();
+        u64 reference_end   = reference_start;
+        while(reference_end - reference_start < OS_TIMER_CALIBRATION_NS){
+            reference_end = os_reference_now_ns();
+        }
+        u64 tsc_end = os_read_tsc();
+
+        f64 elapsed_seconds = (f64)(reference_end - reference_start) / 1e9;
+        os_timer_ticks_per_second = (u64)((f64)(tsc_end - tsc_start) / elapsed_seconds);
+        os_timer_use_tsc          = true;
+
+    }
+
+    u64 os_now_ticks(){
+
+        if(os_timer_use_tsc){
+            return os_read_tsc();
+        }
+
+        return os_reference_now_ns();
+
+    }
+
+    u64 os_ticks_per_second(){
+        return os_timer_ticks_per_second;
+    }
+
+    const char* os_timer_source(){
+        return os_timer_use_tsc ? "rdtscp (calibrated against CLOCK_MONOTONIC_RAW)" : "CLOCK_MONOTONIC_RAW";
+    }
+
+    void os_sleep_until(u64 target_ticks){
+
+        u64 now = os_now_ticks();
+        if(now >= target_ticks){
+            return;
+        }
+
+        u64 remaining_ns = os_ticks_to_ns(target_ticks - now);
+        if(remaining_ns > OS_SLEEP_SPIN_MARGIN_NS){
+
+            u64 sleep_ns = remaining_ns - OS_SLEEP_SPIN_MARGIN_NS;
+            timespec duration;
+            duration.tv_sec  = (time_t)(sleep_ns / 1000000000ULL);
+            duration.tv_nsec = (long)(sleep_ns % 1000000000ULL);
+            clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, nullptr);
+
+        }
+
+        while(os_now_ticks() < target_ticks){
+            cpu_pause();
+        }
+
+    }
+
+    //////////////////////////
+    // Threads
+    //////////////////////////
+
+    u32 os_processor_count(){
+
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (u32)count : 1;
+
+    }
+
+    bool os_pin_current_thread(u32 processor_index){
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(processor_index, &cpu_set);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0;
+
+    }
+
+    struct Os_Thread {
+        pthread_t       thread;
+        Thread_Function function;
+        void*           data;
+    };
+
+    static void* os_thread_start(void* parameter){
+
+        Os_Thread* thread = (Os_Thread*)parameter;
+        thread->function(thread->data);
+        return nullptr;
+
+    }
+
+    u_ptr os_create_thread(Thread_Function function, void* data){
+
+        Os_Thread* thread = (Os_Thread*)malloc(sizeof(Os_Thread));
+        thread->function = function;
+        thread->data     = data;
+
+        if(pthread_create(&thread->thread, nullptr, os_thread_start, thread) != 0){
+            free(thread);
+            return 0;
+        }
+
+        return (u_ptr)thread;
+
+    }
+
+    void os_join_thread(u_ptr thread){
+
+        Os_Thread* os_thread = (Os_Thread*)thread;
+        pthread_join(os_thread->thread, nullptr);
+        free(os_thread);
+
+    }
+
+    u_ptr os_create_semaphore(u32 initial_count){
+
+        sem_t* semaphore = (sem_t*)malloc(sizeof(sem_t));
+        sem_init(semaphore, 0, initial_count);
+        return (u_ptr)semaphore;
+
+    }
+
+    void os_destroy_semaphore(u_ptr semaphore){
+
+        sem_destroy((sem_t*)semaphore);
+        free((sem_t*)semaphore);
+
+    }
+
+    void os_semaphore_wait(u_ptr semaphore){
+
+        while(sem_wait((sem_t*)semaphore) != 0 && errno == EINTR){
+        }
+
+    }
+
+    void os_semaphore_signal(u_ptr semaphore, u32 count){
+
+        for(u32 i = 0; i < count; i++){
+            sem_post((sem_t*)semaphore);
+        }
+
+    }
+
+}
+
+#endif // _D_OS_LINUX
@@ -0,0 +1,171 @@
+// Checks the derived data cache: misses, put then get returning the same bytes, entries with a damaged
+// header being rejected and deleted, trimming evicting the least recently used entries down to the cap,
+// and directories too long for the entry paths being refused.
+//
+// Windows: cl /O2 /EHsc cache_test.cpp
+// Linux:   c++ -O2 -pthread cache_test.cpp
+
+#include "../d_core.cpp"
+
+#include <stdio.h>
+
+using namespace d_std;
+
+#define TEST_DIRECTORY      "cache_test_entries"
+#define TEST_TRIM_ENTRIES   6
+#define TEST_TRIM_KEPT      3
+#define TEST_ENTRY_SIZE     1000
+
+static Cache_Key test_key(u32 index){
+    Cache_Key key = cache_key("cache_test", 1);
+    cache_key_add(&key, index);
+    return key;
+}
+
+static void delete_test_file(const File_Info* file_info, void* data){
+    char path[CACHE_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/%s", TEST_DIRECTORY, file_info->name);
+    os_delete_file(path);
+}
+
+static void count_test_file(const File_Info* file_info, void* data){
+    *(u64*)data += file_info->size;
+}
+
+static bool test_entry_exists(u32 index){
+    char key_string[33];
+    char path[CACHE_PATH_SIZE];
+    cache_key_to_string(test_key(index), key_string);
+    snprintf(path, sizeof(path), "%s/%s.ddc", TEST_DIRECTORY, key_string);
+    FILE* file = fopen(path, "rb");
+    if(file){
+        fclose(file);
+    }
+    return file != NULL;
+}
+
+// Write times have to differ for the least recently used order to be known
+static void wait_for_write_time(){
+    os_sleep_until(os_now_ticks() + os_ticks_per_second() / 50);
+}
+
+int main(){
+
+    os_timer_init();
+
+    int failures = 0;
+
+    // Left over from an earlier run
+    os_create_directory(TEST_DIRECTORY);
+    os_list_directory(TEST_DIRECTORY, delete_test_file, NULL);
+
+    Derived_Data_Cache cache;
+    bool initialized = cache_init(&cache, TEST_DIRECTORY);
+    printf("init:               %s\n", initialized ? "ok" : "FAILED");
+    if(!initialized){
+        return 1;
+    }
+
+    // Nothing there yet
+    Cache_Entry entry;
+    bool missed = !cache_get(&cache, test_key(0), &entry) && cache.misses == 1 && cache.hits == 0;
+    printf("miss:               %s\n", missed ? "ok" : "FAILED");
+    failures += !missed;
+
+    // Blobs come back as one run of bytes, in order
+    u8 first[300];
+    u8 second[TEST_ENTRY_SIZE];
+    for(u32 i = 0; i < sizeof(first); i++)  first[i]  = (u8)(i * 7);
+    for(u32 i = 0; i < sizeof(second); i++) second[i] = (u8)(i * 13 + 1);
+    Cache_Blob blobs[] = {{first, sizeof(first)}, {second, sizeof(second)}};
+
+    bool round_trip = cache_put(&cache, test_key(0), blobs, 2) && cache_get(&cache, test_key(0), &entry);
+    if(round_trip){
+        round_trip = entry.size == sizeof(first) + sizeof(second) &&
+                     memcmp(entry.data, first, sizeof(first)) == 0 &&
+                     memcmp(entry.data + sizeof(first), second, sizeof(second)) == 0 &&
+                     cache.hits == 1;
+        cache_release(&entry);
+    }
+    printf("put then get:       %s\n", round_trip ? "ok" : "FAILED");
+    failures += !round_trip;
+
+    // A damaged magic, a size that doesn't match the file and an entry under another key's name are all dropped
+    char key_string[33];
+    char path[CACHE_PATH_SIZE];
+    char other_path[CACHE_PATH_SIZE];
+    cache_key_to_string(test_key(0), key_string);
+    snprintf(path, sizeof(path), "%s/%s.ddc", TEST_DIRECTORY, key_string);
+
+    bool corruption_rejected = true;
+    for(u32 damage = 0; damage < 3; damage++){
+
+        corruption_rejected &= cache_put(&cache, test_key(0), blobs, 2);
+
+        if(damage == 2){
+            cache_key_to_string(test_key(1), key_string);
+            snprintf(other_path, sizeof(other_path), "%s/%s.ddc", TEST_DIRECTORY, key_string);
+            corruption_rejected &= os_rename_file(path, other_path);
+            corruption_rejected &= !cache_get(&cache, test_key(1), &entry) && !test_entry_exists(1);
+            continue;
+        }
+
+        FILE* file = fopen(path, "r+b");
+        corruption_rejected &= file != NULL;
+        if(file){
+            Cache_Entry_Header header;
+            corruption_rejected &= fread(&header, sizeof(header), 1, file) == 1;
+            if(damage == 0) header.magic     ^= 1;
+            if(damage == 1) header.data_size += 1;
+            fseek(file, 0, SEEK_SET);
+            corruption_rejected &= fwrite(&header, sizeof(header), 1, file) == 1;
+            fclose(file);
+        }
+        corruption_rejected &= !cache_get(&cache, test_key(0), &entry) && !test_entry_exists(0);
+
+    }
+    printf("corrupt headers:    %s\n", corruption_rejected ? "ok" : "FAILED");
+    failures += !corruption_rejected;
+
+    // Entries put oldest first, then a hit on the oldest makes it the most recently used
+    bool trimmed = true;
+    for(u32 i = 0; i < TEST_TRIM_ENTRIES; i++){
+        trimmed &= cache_put(&cache, test_key(i), blobs + 1, 1);
+        wait_for_write_time();
+    }
+    trimmed &= cache_get(&cache, test_key(0), &entry);
+    if(trimmed){
+        cache_release(&entry);
+    }
+
+    u64 entry_file_size = sizeof(Cache_Entry_Header) + TEST_ENTRY_SIZE;
+    cache.size_cap = entry_file_size * TEST_TRIM_KEPT;
+    trimmed &= cache_trim(&cache) == entry_file_size * (TEST_TRIM_ENTRIES - TEST_TRIM_KEPT);
+
+    u64 remaining_size = 0;
+    os_list_directory(TEST_DIRECTORY, count_test_file, &remaining_size);
+    trimmed &= remaining_size <= cache.size_cap;
+
+    // The hit one and the newest survive
+    trimmed &= test_entry_exists(0);
+    for(u32 i = 1; i < TEST_TRIM_ENTRIES; i++){
+        trimmed &= test_entry_exists(i) == (i >= TEST_TRIM_ENTRIES - TEST_TRIM_KEPT + 1);
+    }
+    printf("trim to cap:        %s\n", trimmed ? "ok" : "FAILED");
+    failures += !trimmed;
+
+    // A directory that leaves no room for the entry names is refused rather than truncated
+    char long_directory[CACHE_PATH_SIZE];
+    memset(long_directory, 'd', sizeof(long_directory) - CACHE_NAME_MAX);
+    long_directory[sizeof(long_directory) - CACHE_NAME_MAX] = '\0';
+    Derived_Data_Cache long_cache;
+    bool refused = !cache_init(&long_cache, long_directory);
+    printf("long directory:     %s\n", refused ? "ok" : "FAILED");
+    failures += !refused;
+
+    os_list_directory(TEST_DIRECTORY, delete_test_file, NULL);
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+
+}
@@ -0,0 +1,94 @@
+// Checks Memory_Arena's linear allocation: push_aligned alignment, filling a reservation exactly,
+// failing past it, memory staying writable across commit boundaries and pop_all starting over.
+//
+// Windows: cl /O2 /EHsc memory_arena_test.cpp
+// Linux:   c++ -O2 memory_arena_test.cpp
+
+#include "../d_core.cpp"
+
+#include <stdio.h>
+
+using namespace d_std;
+
+#define TEST_ALIGNED_PUSHES 10000
+#define TEST_BIG_SIZE       (DEFAULT_ARENA_COMMIT_SIZE * 2 + 4096)
+
+static u32 random_state = 0x12345678;
+static u32 random_u32(){
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+int main(){
+
+    int failures = 0;
+
+    // Random sizes and alignments, every push starts aligned and after the previous one
+    Memory_Arena* arena = make_arena_reserve(MB(64));
+    bool aligned = arena != nullptr;
+    u_ptr previous_end = (u_ptr)arena + sizeof(Memory_Arena);
+    for(u32 i = 0; aligned && i < TEST_ALIGNED_PUSHES; i++){
+        u64 alignment = (u64)1 << (random_u32() % 8);
+        u64 size      = random_u32() % 300;
+        u_ptr memory  = arena->push_aligned(size, alignment);
+        aligned &= memory != 0 && (memory & (alignment - 1)) == 0 && memory >= previous_end && memory - previous_end < alignment;
+        memset((void*)memory, 0xAB, size);
+        previous_end = memory + size;
+    }
+    aligned &= previous_end == (u_ptr)arena + arena->position;
+    printf("push_aligned:       %s\n", aligned ? "ok" : "FAILED");
+    failures += !aligned;
+
+    // pop_all starts over from just after the header
+    arena->pop_all();
+    bool popped = arena->position == sizeof(Memory_Arena) && arena->push_aligned(16, 16) == (u_ptr)arena + AlignPow2Up(sizeof(Memory_Arena), 16);
+    printf("pop_all:            %s\n", popped ? "ok" : "FAILED");
+    failures += !popped;
+    arena->release();
+
+    // A reservation sized for exactly what's pushed fills up, one more byte doesn't fit
+    u64 sizes[]    = {96, 4000, 32, 1};
+    u32 size_count = sizeof(sizes) / sizeof(sizes[0]);
+    u64 reserve    = AlignPow2Up(sizeof(Memory_Arena), 16);
+    for(u32 i = 0; i < size_count; i++){
+        reserve += AlignPow2Up(sizes[i], 16);
+    }
+    arena = make_arena_reserve(reserve);
+    bool filled = arena != nullptr;
+    for(u32 i = 0; filled && i < size_count; i++){
+        u_ptr memory = arena->push_aligned(sizes[i], 16);
+        filled &= memory != 0;
+        if(memory){
+            memset((void*)memory, (int)i, sizes[i]);
+        }
+    }
+    filled = filled && arena->push(15) != 0 && arena->position == reserve && arena->push(1) == 0;
+    printf("exact fill:         %s\n", filled ? "ok" : "FAILED");
+    failures += !filled;
+    if(arena){
+        arena->release();
+    }
+
+    // One push past two commit steps, all of it writable
+    arena = make_arena_reserve(TEST_BIG_SIZE + MB(1));
+    u8* big = arena ? (u8*)arena->push_aligned(TEST_BIG_SIZE, 4096) : NULL;
+    bool committed = big != NULL;
+    if(big){
+        for(u64 i = 0; i < TEST_BIG_SIZE; i += 4096){
+            big[i] = (u8)i;
+        }
+        big[TEST_BIG_SIZE - 1] = 1;
+        committed = arena->commit_position >= arena->position;
+    }
+    printf("commit:             %s\n", committed ? "ok" : "FAILED");
+    failures += !committed;
+    if(arena){
+        arena->release();
+    }
+
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures;
+
+}
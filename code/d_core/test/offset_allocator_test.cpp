@@ -0,0 +1,172 @@
+// Checks the offset allocator against a reference that tracks who owns every unit: random allocations
+// and frees must never overlap or leave the space, free_size must match, and freeing everything must
+// merge back into a single range. Also times allocate/free pairs.
+//
+// Windows: cl /O2 /EHsc offset_allocator_test.cpp
+// Linux:   c++ -O2 offset_allocator_test.cpp
+
+#include "../d_core.cpp"
+
+#include <stdio.h>
+
+using namespace d_std;
+
+#define TEST_SIZE               (1 << 20)
+#define TEST_MAX_ALLOCATIONS    4096
+#define TEST_ROUNDS             200000
+#define TEST_MAX_SIZE           4096
+#define BENCH_ROUNDS            10000000
+
+#define NO_OWNER 0xFFFFFFFF
+
+static u32 random_state = 0x12345678;
+static u32 random_u32(){
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// Marks [offset, offset + size) as owned by slot, or checks and clears it when freeing
+static int claim_range(u32* owners, u32 offset, u32 size, u32 slot){
+
+    if((u64)offset + size > TEST_SIZE){
+        return 1;
+    }
+
+    for(u32 i = offset; i < offset + size; i++){
+        if(owners[i] != NO_OWNER){
+            return 1;
+        }
+        owners[i] = slot;
+    }
+    return 0;
+
+}
+
+static void release_range(u32* owners, u32 offset, u32 size){
+    for(u32 i = offset; i < offset + size; i++){
+        owners[i] = NO_OWNER;
+    }
+}
+
+int main(){
+
+    int failures = 0;
+
+    // Bins
+    u32 bin_failures = 0;
+    for(u32 size = 0; size < (1 << 20); size++){
+        u32 floor = offset_allocator_bin_floor(size);
+        u32 ceil  = offset_allocator_bin_ceil(size);
+        if(offset_allocator_bin_size(floor) > size || offset_allocator_bin_size(ceil) < size || ceil - floor > 1){
+            bin_failures++;
+        }
+    }
+    if(offset_allocator_bin_floor(0xFFFFFFFF) != OFFSET_ALLOCATOR_BIN_COUNT - 1){
+        bin_failures++;
+    }
+    printf("bins:               %u failures\n", bin_failures);
+    failures += bin_failures != 0;
+
+    Offset_Allocator allocator;
+    if(!offset_allocator_init(&allocator, TEST_SIZE, TEST_MAX_ALLOCATIONS)){
+        printf("init:               FAILED\n");
+        return 1;
+    }
+
+    // Random allocations and frees
+    u32* owners = (u32*)malloc(TEST_SIZE * sizeof(u32));
+    memset(owners, 0xFF, TEST_SIZE * sizeof(u32));
+    Offset_Allocation* allocations = (Offset_Allocation*)malloc(TEST_MAX_ALLOCATIONS * sizeof(Offset_Allocation));
+    u32* sizes = (u32*)malloc(TEST_MAX_ALLOCATIONS * sizeof(u32));
+    u32 live_count = 0;
+    u64 live_size  = 0;
+    u32 overlap_failures = 0;
+    u32 free_size_failures = 0;
+    u32 failed_allocations = 0;
+
+    for(u32 round = 0; round < TEST_ROUNDS; round++){
+
+        bool allocate = live_count == 0 || (live_count < TEST_MAX_ALLOCATIONS && (random_u32() & 1));
+        if(allocate){
+            // Mostly small sizes, sometimes big ones
+            u32 size = (random_u32() & 7) ? random_u32() % 64 + 1 : random_u32() % TEST_MAX_SIZE + 1;
+            Offset_Allocation allocation = offset_allocator_allocate(&allocator, size);
+            if(allocation.offset == OFFSET_ALLOCATOR_NO_SPACE){
+                failed_allocations++;
+            } else {
+                overlap_failures += claim_range(owners, allocation.offset, size, live_count);
+                overlap_failures += offset_allocator_allocation_size(&allocator, allocation) != size;
+                allocations[live_count] = allocation;
+                sizes[live_count]       = size;
+                live_count++;
+                live_size += size;
+            }
+        } else {
+            u32 slot = random_u32() % live_count;
+            release_range(owners, allocations[slot].offset, sizes[slot]);
+            offset_allocator_free(&allocator, allocations[slot]);
+            live_size -= sizes[slot];
+            live_count--;
+            allocations[slot] = allocations[live_count];
+            sizes[slot]       = sizes[live_count];
+        }
+
+        if(allocator.free_size != TEST_SIZE - live_size || allocator.allocation_count != live_count){
+            free_size_failures++;
+        }
+
+    }
+
+    Offset_Allocator_Report report = offset_allocator_report(&allocator);
+    printf("random:             %u rounds, %u live, %u free ranges, largest %u, %u failed allocations\n", TEST_ROUNDS,
+        report.allocation_count, report.free_range_count, report.largest_free_range, failed_allocations);
+    printf("overlaps:           %u\n", overlap_failures);
+    printf("free size:          %u mismatches\n", free_size_failures);
+    failures += overlap_failures != 0;
+    failures += free_size_failures != 0;
+
+    // Everything freed goes back to one range
+    for(u32 i = 0; i < live_count; i++){
+        offset_allocator_free(&allocator, allocations[i]);
+    }
+    report = offset_allocator_report(&allocator);
+    bool coalesced = report.free_range_count == 1 && report.largest_free_range == TEST_SIZE && report.allocation_count == 0;
+    printf("coalescing:         %u free ranges, largest %u\n", report.free_range_count, report.largest_free_range);
+    failures += !coalesced;
+
+    // Filling the whole space exactly, then one more has to fail
+    u32 fill_size = TEST_SIZE / TEST_MAX_ALLOCATIONS;
+    bool filled = true;
+    for(u32 i = 0; i < TEST_MAX_ALLOCATIONS; i++){
+        allocations[i] = offset_allocator_allocate(&allocator, fill_size);
+        filled &= allocations[i].offset == i * fill_size;
+    }
+    filled &= allocator.free_size == 0;
+    offset_allocator_free(&allocator, allocations[TEST_MAX_ALLOCATIONS / 2]);
+    filled &= offset_allocator_allocate(&allocator, fill_size + 1).offset == OFFSET_ALLOCATOR_NO_SPACE;
+    allocations[TEST_MAX_ALLOCATIONS / 2] = offset_allocator_allocate(&allocator, fill_size);
+    filled &= allocations[TEST_MAX_ALLOCATIONS / 2].offset == TEST_MAX_ALLOCATIONS / 2 * fill_size;
+    printf("exact fill:         %s\n", filled ? "ok" : "FAILED");
+    failures += !filled;
+    offset_allocator_release(&allocator);
+
+    // Speed
+    offset_allocator_init(&allocator, TEST_SIZE, TEST_MAX_ALLOCATIONS);
+    u64 start = os_now_ticks();
+    for(u32 i = 0; i < BENCH_ROUNDS; i++){
+        Offset_Allocation allocation = offset_allocator_allocate(&allocator, (i & 1023) + 1);
+        offset_allocator_free(&allocator, allocation);
+    }
+    printf("allocate + free:    %.1f ns\n", (f64)os_ticks_to_ns(os_now_ticks() - start) / BENCH_ROUNDS);
+    offset_allocator_release(&allocator);
+
+    free(owners);
+    free(allocations);
+    free(sizes);
+
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures;
+
+}
@@ -0,0 +1,120 @@
+// Checks that os_now_ticks is monotonic within a thread, as a thread hops between cores,
+// and across threads pinned to different cores. Also reports how closely os_sleep_until lands.
+//
+// Windows: cl /O2 /EHsc timer_test.cpp
+// Linux:   c++ -O2 -pthread timer_test.cpp
+
+#include "../d_core.cpp"
+
+#include <stdio.h>
+#include <thread>
+
+using namespace d_std;
+
+#define SINGLE_THREAD_READS     10000000
+#define CORE_HOP_ROUNDS         200
+#define CROSS_THREAD_READS      200000
+#define SLEEP_TEST_COUNT        20
+#define SLEEP_TEST_MS           5.
+
+static volatile u64 shared_last_ticks = 0;
+static volatile u64 cross_thread_violations = 0;
+static Spin_Lock    shared_lock;
+
+static void cross_thread_worker(u32 processor_index){
+
+    os_pin_current_thread(processor_index);
+
+    for(u32 i = 0; i < CROSS_THREAD_READS; i++){
+
+        // Reading inside the lock orders the reads, so a later read must never be smaller
+        shared_lock.lock();
+        u64 now = os_now_ticks();
+        if(now < shared_last_ticks){
+            cross_thread_violations++;
+        }
+        shared_last_ticks = now;
+        shared_lock.unlock();
+
+    }
+
+}
+
+int main(){
+
+    int failures = 0;
+
+    os_timer_init();
+    u32 processor_count = os_processor_count();
+
+    printf("timer source:       %s\n", os_timer_source());
+    printf("ticks per second:   %llu\n", os_ticks_per_second());
+    printf("processors:         %u\n", processor_count);
+
+    // Single thread
+    u64 single_thread_violations = 0;
+    u64 last = os_now_ticks();
+    u64 single_thread_start = last;
+    for(u32 i = 0; i < SINGLE_THREAD_READS; i++){
+        u64 now = os_now_ticks();
+        if(now < last){
+            single_thread_violations++;
+        }
+        last = now;
+    }
+    printf("single thread:      %u reads, %llu backwards, %.1f ns per read\n", SINGLE_THREAD_READS, single_thread_violations,
+        (f64)os_ticks_to_ns(last - single_thread_start) / SINGLE_THREAD_READS);
+    failures += single_thread_violations != 0;
+
+    // One thread migrating between cores
+    u64 core_hop_violations = 0;
+    last = os_now_ticks();
+    for(u32 round = 0; round < CORE_HOP_ROUNDS; round++){
+        for(u32 processor = 0; processor < processor_count; processor++){
+            os_pin_current_thread(processor);
+            u64 now = os_now_ticks();
+            if(now < last){
+                core_hop_violations++;
+            }
+            last = now;
+        }
+    }
+    printf("core hops:          %u hops, %llu backwards\n", CORE_HOP_ROUNDS * processor_count, core_hop_violations);
+    failures += core_hop_violations != 0;
+
+    // One thread per core
+    std::thread* threads = new std::thread[processor_count];
+    for(u32 processor = 0; processor < processor_count; processor++){
+        threads[processor] = std::thread(cross_thread_worker, processor);
+    }
+    for(u32 processor = 0; processor < processor_count; processor++){
+        threads[processor].join();
+    }
+    delete[] threads;
+    printf("cross thread:       %u reads, %llu backwards\n", CROSS_THREAD_READS * processor_count, cross_thread_violations);
+    failures += cross_thread_violations != 0;
+
+    // Sleep accuracy
+    f64 max_overshoot_us = 0.;
+    f64 sum_overshoot_us = 0.;
+    for(u32 i = 0; i < SLEEP_TEST_COUNT; i++){
+        u64 target = os_now_ticks() + os_ms_to_ticks(SLEEP_TEST_MS);
+        os_sleep_until(target);
+        f64 overshoot_us = os_ticks_to_us((f64)(os_now_ticks() - target));
+        sum_overshoot_us += overshoot_us;
+        max_overshoot_us  = d_max(max_overshoot_us, overshoot_us);
+    }
+    printf("os_sleep_until:     %.1fms x %u, mean overshoot %.2f us, max %.2f us\n", SLEEP_TEST_MS, SLEEP_TEST_COUNT,
+        sum_overshoot_us / SLEEP_TEST_COUNT, max_overshoot_us);
+
+    // Conversions round trip
+    u64 one_second = os_seconds_to_ticks(1.);
+    if(os_ticks_to_ns(one_second) / 1000000 != 1000 || os_ns_to_ticks(1000000000ULL) != os_ticks_per_second()){
+        printf("conversions:        FAILED\n");
+        failures++;
+    }
+
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures;
+
+}
@@ -4,11 +4,22 @@
 #include "../d_os.h"
 #include "../d_string.h"
 #include "../d_memory.h"
+#include "../d_helpers.h"
 
 // Windows.h
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include "windows.h"
+#include <intrin.h>
+#include <stddef.h> // offsetof
+#include <stdlib.h>
+#include <stdio.h>  // snprintf
+#include <string.h> // strcmp / strncpy
+
+// Windows 10 1803+, older SDKs don't define it
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 namespace d_std {
 
@@ -99,6 +110,581 @@ namespace d_std {
 
     }
 
+    //////////////////////////
+    // Memory mapped files
+    //////////////////////////
+
+    bool os_map_file(const char* filename, Mapped_File* mapped_file, Map_Access_Hint hint){
+
+        *mapped_file = {};
+
+        DWORD flags = hint == MAP_ACCESS_SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+        // FILE_SHARE_DELETE so the file can still be renamed over or deleted while it's mapped, like on Linux
+        HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, flags, NULL);
+        if(file == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0){
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping == NULL){
+            CloseHandle(file);
+            return false;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(data == NULL){
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        mapped_file->data           = (const u8*)data;
+        mapped_file->size           = (u64)file_size.QuadPart;
+        mapped_file->file_handle    = (u_ptr)file;
+        mapped_file->mapping_handle = (u_ptr)mapping;
+
+        if(hint == MAP_ACCESS_SEQUENTIAL){
+            os_prefetch_mapped_file(mapped_file, 0, mapped_file->size);
+        }
+
+        return true;
+
+    }
+
+    void os_unmap_file(Mapped_File* mapped_file){
+
+        if(mapped_file->data){
+            UnmapViewOfFile(mapped_file->data);
+            CloseHandle((HANDLE)mapped_file->mapping_handle);
+            CloseHandle((HANDLE)mapped_file->file_handle);
+        }
+
+        *mapped_file = {};
+
+    }
+
+    void os_prefetch_mapped_file(Mapped_File* mapped_file, u64 offset, u64 size){
+
+        if(offset >= mapped_file->size){
+            return;
+        }
+
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = (PVOID)(mapped_file->data + offset);
+        range.NumberOfBytes  = (SIZE_T)(d_min(offset + size, mapped_file->size) - offset);
+
+        // Only a hint, failure just means no read ahead
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+
+    }
+
+    //////////////////////////
+    // Files
+    //////////////////////////
+
+    // FILETIME counts 100ns intervals since 1601
+    static u64 os_filetime_to_ns(FILETIME file_time){
+        u64 intervals = ((u64)file_time.dwHighDateTime << 32) | file_time.dwLowDateTime;
+        return (intervals - 116444736000000000ULL) * 100;
+    }
+
+    bool os_create_directory(const char* path){
+        return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+    }
+
+    bool os_delete_file(const char* filename){
+        return DeleteFileA(filename);
+    }
+
+    bool os_rename_file(const char* from, const char* to){
+        return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING);
+    }
+
+    bool os_touch_file(const char* filename){
+
+        HANDLE file = CreateFileA(filename, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(file == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        bool touched = SetFileTime(file, NULL, NULL, &now);
+
+        CloseHandle(file);
+        return touched;
+
+    }
+
+    bool os_list_directory(const char* path, File_Info_Function function, void* data){
+
+        char search_path[MAX_PATH];
+        int search_path_length = snprintf(search_path, sizeof(search_path), "%s\\*", path);
+        if(search_path_length < 0 || search_path_length >= (int)sizeof(search_path)){
+            return false;
+        }
+
+        WIN32_FIND_DATAA find_data;
+        HANDLE find = FindFirstFileA(search_path, &find_data);
+        if(find == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        do {
+
+            if(strcmp(find_data.cFileName, ".") == 0 || strcmp(find_data.cFileName, "..") == 0){
+                continue;
+            }
+
+            // A truncated name would be a different file, skip ones that don't fit
+            File_Info file_info = {};
+            u64 name_length = strlen(find_data.cFileName);
+            if(name_length >= sizeof(file_info.name)){
+                continue;
+            }
+            memcpy(file_info.name, find_data.cFileName, name_length + 1);
+            file_info.size            = ((u64)find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+            file_info.last_write_time = os_filetime_to_ns(find_data.ftLastWriteTime);
+            file_info.is_directory    = (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+
+            function(&file_info, data);
+
+        } while(FindNextFileA(find, &find_data));
+
+        FindClose(find);
+        return true;
+
+    }
+
+    u32 os_process_id(){
+        return (u32)GetCurrentProcessId();
+    }
+
+    //////////////////////////
+    // Asynchronous file reads
+    //////////////////////////
+
+    static_assert(sizeof(OVERLAPPED) <= sizeof(((Async_Read*)0)->os_data), "Async_Read::os_data can't hold an OVERLAPPED");
+
+    #define ASYNC_READER_MAX_DEQUEUE 64
+
+    bool os_open_async_file(const char* filename, bool direct, Async_File* file){
+
+        *file = {};
+
+        DWORD flags = FILE_FLAG_OVERLAPPED | (direct ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN);
+        HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+        if(handle == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if(!GetFileSizeEx(handle, &file_size)){
+            CloseHandle(handle);
+            return false;
+        }
+
+        file->handle  = (u_ptr)handle;
+        file->size    = (u64)file_size.QuadPart;
+        file->is_open = true;
+        file->direct  = direct;
+
+        return true;
+
+    }
+
+    void os_close_async_file(Async_File* file){
+
+        if(file->is_open){
+            CloseHandle((HANDLE)file->handle);
+        }
+
+        *file = {};
+
+    }
+
+    // Opening a file without buffering makes the cache manager flush and purge its cached pages
+    bool os_evict_file_cache(const char* filename){
+
+        HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+        if(handle == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        CloseHandle(handle);
+        return true;
+
+    }
+
+    struct Async_Reader {
+
+        HANDLE       completion_port;
+        u32          queue_depth;
+        u32          in_kernel;
+
+        // Reads waiting for a free slot. Ring buffer of pointers
+        Async_Read** pending;
+        u32          pending_capacity;
+        u32          pending_head;
+        u32          pending_count;
+
+    };
+
+    static void async_pending_push_back(Async_Reader* reader, Async_Read* read){
+
+        if(reader->pending_count == reader->pending_capacity){
+
+            u32 new_capacity = d_max(reader->pending_capacity * 2, (u32)64);
+            Async_Read** new_pending = (Async_Read**)malloc(new_capacity * sizeof(Async_Read*));
+
+            for(u32 i = 0; i < reader->pending_count; i++){
+                new_pending[i] = reader->pending[(reader->pending_head + i) % reader->pending_capacity];
+            }
+
+            free(reader->pending);
+            reader->pending          = new_pending;
+            reader->pending_capacity = new_capacity;
+            reader->pending_head     = 0;
+
+        }
+
+        reader->pending[(reader->pending_head + reader->pending_count) % reader->pending_capacity] = read;
+        reader->pending_count++;
+
+    }
+
+    static Async_Read* async_pending_pop(Async_Reader* reader){
+
+        Async_Read* read = reader->pending[reader->pending_head];
+        reader->pending_head = (reader->pending_head + 1) % reader->pending_capacity;
+        reader->pending_count--;
+
+        return read;
+
+    }
+
+    Async_Reader* os_async_reader_create(u32 queue_depth){
+
+        Async_Reader* reader = (Async_Reader*)calloc(1, sizeof(Async_Reader));
+        reader->queue_depth     = queue_depth;
+        reader->completion_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+
+        return reader;
+
+    }
+
+    void os_async_reader_destroy(Async_Reader* reader){
+
+        CloseHandle(reader->completion_port);
+        free(reader->pending);
+        free(reader);
+
+    }
+
+    const char* os_async_reader_backend(Async_Reader* reader){
+        return "overlapped ReadFile + I/O completion port";
+    }
+
+    bool os_async_reader_register_buffer(Async_Reader* reader, u8* memory, u64 size){
+        return false;
+    }
+
+    // Issues pending reads until queue_depth reads are in flight
+    static void async_reader_submit_pending(Async_Reader* reader){
+
+        while(reader->pending_count > 0 && reader->in_kernel < reader->queue_depth){
+
+            Async_Read* read = async_pending_pop(reader);
+            Async_File* file = read->file;
+
+            // A handle can only be associated with one completion port, once
+            if(file->completion_port != (u_ptr)reader->completion_port){
+                CreateIoCompletionPort((HANDLE)file->handle, reader->completion_port, 0, 0);
+                file->completion_port = (u_ptr)reader->completion_port;
+            }
+
+            OVERLAPPED* overlapped = (OVERLAPPED*)read->os_data;
+            memset(overlapped, 0, sizeof(OVERLAPPED));
+            overlapped->Offset     = (DWORD)(read->offset & 0xFFFFFFFF);
+            overlapped->OffsetHigh = (DWORD)(read->offset >> 32);
+
+            reader->in_kernel++;
+
+            // Even reads that finish immediately post a completion packet
+            if(!ReadFile((HANDLE)file->handle, read->destination, read->size, NULL, overlapped)){
+                DWORD error = GetLastError();
+                if(error != ERROR_IO_PENDING){
+                    read->error = error == ERROR_HANDLE_EOF ? 0 : (s32)error;
+                    PostQueuedCompletionStatus(reader->completion_port, 0, 0, overlapped);
+                }
+            }
+
+        }
+
+    }
+
+    void os_async_reader_submit(Async_Reader* reader, Async_Read* reads, u32 count){
+
+        for(u32 i = 0; i < count; i++){
+            reads[i].bytes_read = 0;
+            reads[i].error      = 0;
+            async_pending_push_back(reader, &reads[i]);
+        }
+
+        async_reader_submit_pending(reader);
+
+    }
+
+    u32 os_async_reader_wait(Async_Reader* reader, Async_Read** completed, u32 max_completed){
+
+        if(reader->in_kernel == 0){
+            return 0;
+        }
+
+        OVERLAPPED_ENTRY entries[ASYNC_READER_MAX_DEQUEUE];
+        ULONG entry_count = 0;
+        ULONG max_entries = (ULONG)d_min(max_completed, (u32)ASYNC_READER_MAX_DEQUEUE);
+
+        if(!GetQueuedCompletionStatusEx(reader->completion_port, entries, max_entries, &entry_count, INFINITE, FALSE)){
+            return 0;
+        }
+
+        for(ULONG i = 0; i < entry_count; i++){
+
+            Async_Read* read = (Async_Read*)((u8*)entries[i].lpOverlapped - offsetof(Async_Read, os_data));
+            read->bytes_read = entries[i].dwNumberOfBytesTransferred;
+
+            if(read->error == 0){
+                DWORD bytes;
+                if(!GetOverlappedResult((HANDLE)read->file->handle, entries[i].lpOverlapped, &bytes, FALSE)){
+                    DWORD error = GetLastError();
+                    read->error = error == ERROR_HANDLE_EOF ? 0 : (s32)error;
+                }
+            }
+
+            completed[i] = read;
+            reader->in_kernel--;
+
+        }
+
+        async_reader_submit_pending(reader);
+
+        return (u32)entry_count;
+
+    }
+
+    //////////////////////////
+    // Time
+    //////////////////////////
+
+    #define OS_TIMER_CALIBRATION_MS        50
+    #define OS_SLEEP_SPIN_MARGIN_NS        1000000ULL  // High resolution waitable timers wake within ~0.5ms
+    #define OS_SLEEP_SPIN_MARGIN_LEGACY_NS 16000000ULL // Plain Sleep() is at the mercy of the 15.6ms scheduler tick
+
+    static bool  os_timer_use_tsc          = false;
+    static u64   os_timer_ticks_per_second = 1;
+    static thread_local HANDLE os_sleep_timer = NULL;
+    static thread_local bool   os_sleep_timer_created = false;
+
+    static u64 os_reference_now(){
+
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return (u64)counter.QuadPart;
+
+    }
+
+    static u64 os_read_tsc(){
+
+        // rdtscp waits for earlier instructions to finish, so the read can't be hoisted
+        unsigned int processor_id;
+        return __rdtscp(&processor_id);
+
+    }
+
+    static bool os_has_invariant_tsc(){
+
+        int registers[4];
+        __cpuid(registers, 0x80000000);
+        if((u32)registers[0] < 0x80000007){
+            return false;
+        }
+
+        // rdtscp support, CPUID.80000001H:EDX[27]
+        __cpuid(registers, 0x80000001);
+        if(!(registers[3] & (1 << 27))){
+            return false;
+        }
+
+        // Invariant TSC, CPUID.80000007H:EDX[8]
+        __cpuid(registers, 0x80000007);
+        return (registers[3] & (1 << 8)) != 0;
+
+    }
+
+    void os_timer_init(){
+
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        u64 reference_frequency = (u64)frequency.QuadPart;
+
+        if(!os_has_invariant_tsc()){
+            os_timer_use_tsc          = false;
+            os_timer_ticks_per_second = reference_frequency;
+            return;
+        }
+
+        // Spin on QPC so both clocks cover the same interval
+        u64 calibration_ticks = reference_frequency * OS_TIMER_CALIBRATION_MS / 1000;
+        u64 reference_start   = os_reference_now();
+        u64 tsc_start         = os_read_tsc();
+        u64 reference_end     = reference_start;
+        while(reference_end - reference_start < calibration_ticks){
+            reference_end = os_reference_now();
+        }
+        u64 tsc_end = os_read_tsc();
+
+        f64 elapsed_seconds = (f64)(reference_end - reference_start) / (f64)reference_frequency;
+        os_timer_ticks_per_second = (u64)((f64)(tsc_end - tsc_start) / elapsed_seconds);
+        os_timer_use_tsc          = true;
+
+    }
+
+    u64 os_now_ticks(){
+
+        if(os_timer_use_tsc){
+            return os_read_tsc();
+        }
+
+        return os_reference_now();
+
+    }
+
+    u64 os_ticks_per_second(){
+        return os_timer_ticks_per_second;
+    }
+
+    const char* os_timer_source(){
+        return os_timer_use_tsc ? "rdtscp (calibrated against QueryPerformanceCounter)" : "QueryPerformanceCounter";
+    }
+
+    void os_sleep_until(u64 target_ticks){
+
+        u64 now = os_now_ticks();
+        if(now >= target_ticks){
+            return;
+        }
+
+        if(!os_sleep_timer_created){
+            os_sleep_timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+            os_sleep_timer_created = true;
+        }
+
+        u64 remaining_ns = os_ticks_to_ns(target_ticks - now);
+        u64 spin_margin  = os_sleep_timer ? OS_SLEEP_SPIN_MARGIN_NS : OS_SLEEP_SPIN_MARGIN_LEGACY_NS;
+
+        if(remaining_ns > spin_margin){
+
+            u64 sleep_ns = remaining_ns - spin_margin;
+
+            if(os_sleep_timer){
+                // Negative due time = relative, in 100ns units
+                LARGE_INTEGER due_time;
+                due_time.QuadPart = -(LONGLONG)(sleep_ns / 100);
+                SetWaitableTimer(os_sleep_timer, &due_time, 0, NULL, NULL, FALSE);
+                WaitForSingleObject(os_sleep_timer, INFINITE);
+            } else {
+                Sleep((DWORD)(sleep_ns / 1000000));
+            }
+
+        }
+
+        while(os_now_ticks() < target_ticks){
+            _mm_pause();
+        }
+
+    }
+
+    //////////////////////////
+    // Threads
+    //////////////////////////
+
+    u32 os_processor_count(){
+        return (u32)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    }
+
+    // Only covers the first processor group (64 logical processors)
+    bool os_pin_current_thread(u32 processor_index){
+
+        if(processor_index >= 64){
+            return false;
+        }
+
+        return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << processor_index) != 0;
+
+    }
+
+    struct Os_Thread {
+        HANDLE          handle;
+        Thread_Function function;
+        void*           data;
+    };
+
+    static DWORD WINAPI os_thread_start(LPVOID parameter){
+
+        Os_Thread* thread = (Os_Thread*)parameter;
+        thread->function(thread->data);
+        return 0;
+
+    }
+
+    u_ptr os_create_thread(Thread_Function function, void* data){
+
+        Os_Thread* thread = (Os_Thread*)malloc(sizeof(Os_Thread));
+        thread->function = function;
+        thread->data     = data;
+        thread->handle   = CreateThread(NULL, 0, os_thread_start, thread, 0, NULL);
+
+        if(thread->handle == NULL){
+            free(thread);
+            return 0;
+        }
+
+        return (u_ptr)thread;
+
+    }
+
+    void os_join_thread(u_ptr thread){
+
+        Os_Thread* os_thread = (Os_Thread*)thread;
+        WaitForSingleObject(os_thread->handle, INFINITE);
+        CloseHandle(os_thread->handle);
+        free(os_thread);
+
+    }
+
+    u_ptr os_create_semaphore(u32 initial_count){
+        return (u_ptr)CreateSemaphoreA(NULL, (LONG)initial_count, LONG_MAX, NULL);
+    }
+
+    void os_destroy_semaphore(u_ptr semaphore){
+        CloseHandle((HANDLE)semaphore);
+    }
+
+    void os_semaphore_wait(u_ptr semaphore){
+        WaitForSingleObject((HANDLE)semaphore, INFINITE);
+    }
+
+    void os_semaphore_signal(u_ptr semaphore, u32 count){
+        ReleaseSemaphore((HANDLE)semaphore, (LONG)count, NULL);
+    }
+
 }
 
 #endif // _D_OS_WIN32
\ No newline at end of file
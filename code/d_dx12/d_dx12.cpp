@@ -25,6 +25,16 @@ namespace d_dx12 {
     u8   current_backbuffer_index = 0;
     bool is_tearing_supported = false;
 
+    // Per frame counters, registered in d_dx12_init
+    Counter_Id counter_draw_calls;
+    Counter_Id counter_dispatches;
+    Counter_Id counter_descriptor_copies;
+    Counter_Id counter_view_creations;
+    Counter_Id counter_cbv_creations;
+    Counter_Id counter_resource_barriers;
+    Counter_Id counter_dynamic_buffer_bytes;
+    Counter_Id counter_upload_buffer_bytes;
+
 
     /* 
     *   Initialize the library by creating the d3d12 device and debug stuff
@@ -36,6 +46,19 @@ namespace d_dx12 {
         ////////////////
 
         d_dx12_arena = d_std::make_arena();
+
+        //////////////////
+        // Init Counters
+        //////////////////
+
+        counter_draw_calls           = counter_register("draw_calls");
+        counter_dispatches           = counter_register("dispatches");
+        counter_descriptor_copies    = counter_register("descriptor_copies");
+        counter_view_creations       = counter_register("srv_uav_creations");
+        counter_cbv_creations        = counter_register("cbv_creations");
+        counter_resource_barriers    = counter_register("resource_barriers");
+        counter_dynamic_buffer_bytes = counter_register("dynamic_buffer_bytes");
+        counter_upload_buffer_bytes  = counter_register("upload_buffer_bytes");
             
         //////////////////////////
         // Init DirectX 12 Device
@@ -635,6 +658,13 @@ namespace d_dx12 {
                 //L"-Qstrip_reflect",          
             };
 
+            // Variants of the same file, e.g. QUANTIZED_VERTICES
+            std::vector<LPCWSTR> vertex_shader_argument_list(vertex_shader_arguments, vertex_shader_arguments + _countof(vertex_shader_arguments));
+            if(desc.vertex_shader_define){
+                vertex_shader_argument_list.push_back(L"-D");
+                vertex_shader_argument_list.push_back(desc.vertex_shader_define);
+            }
+
             //
             // Open source file.  
             //
@@ -652,8 +682,8 @@ namespace d_dx12 {
             Microsoft::WRL::ComPtr<IDxcResult> pResults;
             pCompiler->Compile(
                 &Source,                           // Source buffer.
-                vertex_shader_arguments,           // Array of pointers to arguments.
-                _countof(vertex_shader_arguments), // Number of arguments.
+                vertex_shader_argument_list.data(),         // Array of pointers to arguments.
+                (UINT32)vertex_shader_argument_list.size(), // Number of arguments.
                 pIncludeHandler.Get(),                   // User-provided interface to handle #include directives (optional).
                 IID_PPV_ARGS(&pResults)            // Compiler output status, buffer, and errors.
             );
@@ -1202,6 +1232,8 @@ namespace d_dx12 {
                 input_element_desc.InstanceDataStepRate = 0;
 
                 input_layout.push_back(input_element_desc);
+
+                shader->vertex_buffer_slot_count = d_max(shader->vertex_buffer_slot_count, (u8)(desc.input_layout[i].input_slot + 1));
             }
 
             // Create Blend Desc
@@ -1524,9 +1556,9 @@ namespace d_dx12 {
     { 
         if (d3d12_fence->GetCompletedValue() < fence_value_to_wait_for) {
             HANDLE fence_event = CreateEvent(NULL, FALSE, FALSE, NULL);
-            std::chrono::milliseconds duration = std::chrono::milliseconds::max();
             ThrowIfFailed(d3d12_fence->SetEventOnCompletion(fence_value_to_wait_for, fence_event));
-            WaitForSingleObject(fence_event, static_cast<DWORD> (duration.count()));
+            WaitForSingleObject(fence_event, INFINITE);
+            CloseHandle(fence_event);
         }
     }
 
@@ -1615,6 +1647,7 @@ namespace d_dx12 {
 
         // Inserts the barrier into the command list
         d3d12_command_list->ResourceBarrier(1, &barrier_to_render_target);
+        counter_add(counter_resource_barriers);
 
 
     }
@@ -1634,6 +1667,7 @@ namespace d_dx12 {
 
             // Inserts the barrier into the command list
             d3d12_command_list->ResourceBarrier(1, &barrier_to_render_target);
+            counter_add(counter_resource_barriers);
 
         }
 
@@ -2188,7 +2222,12 @@ namespace d_dx12 {
 
                 buffer->index_buffer_view.SizeInBytes = desc.number_of_elements * desc.size_of_each_element;
                 buffer->index_buffer_view.BufferLocation = buffer->d3d12_resource->GetGPUVirtualAddress();
-                buffer->index_buffer_view.Format = DXGI_FORMAT_R16_UINT;
+                // u16 indices unless the desc asks for u32 ones, either with the format or the element size
+                if(desc.format == DXGI_FORMAT_R32_UINT || (desc.format == DXGI_FORMAT_UNKNOWN && desc.size_of_each_element == sizeof(u32))){
+                    buffer->index_buffer_view.Format = DXGI_FORMAT_R32_UINT;
+                } else {
+                    buffer->index_buffer_view.Format = DXGI_FORMAT_R16_UINT;
+                }
 
             }
             break;
@@ -2234,6 +2273,23 @@ namespace d_dx12 {
                 d3d12_device->CreateConstantBufferView(&cbv_desc, buffer->offline_descriptor_handle.cpu_descriptor_handle);
             }
             break;
+
+            // Suballocated, so there's no view of the whole buffer. See load_frame_structured_buffer_view
+            case(Buffer::USAGE::USAGE_STRUCTURED_BUFFER):
+            {
+                D3D12_HEAP_PROPERTIES heap_prop = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+                D3D12_RESOURCE_DESC resource_desc = CD3DX12_RESOURCE_DESC::Buffer(total_size);
+
+                d3d12_device->CreateCommittedResource(
+                    &heap_prop,
+                    D3D12_HEAP_FLAG_NONE,
+                    &resource_desc,
+                    D3D12_RESOURCE_STATE_COPY_DEST,
+                    nullptr,
+                    IID_PPV_ARGS(buffer->d3d12_resource.GetAddressOf())
+                );
+            }
+            break;
         }
 
         return buffer;
@@ -2255,6 +2311,51 @@ namespace d_dx12 {
         // Constant buffer requirement
         cbv_desc.SizeInBytes = AlignPow2Up(allocation.aligned_size, 256); 
         d3d12_device->CreateConstantBufferView(&cbv_desc, handle.cpu_descriptor_handle);
+        counter_add(counter_cbv_creations);
+
+        return handle;
+    }
+
+    // Same as load_dyanamic_frame_data, but viewed as a StructuredBuffer of element_count elements
+    Descriptor_Handle Resource_Manager::load_dyanamic_frame_structured_buffer(void* input_data_ptr, u32 element_count, u32 element_size){
+
+        // 256 keeps the allocations after this one aligned for constant buffers, and is a multiple of any element size we use
+        u64 size = (u64)element_count * element_size;
+        Dynamic_Buffer::Allocation allocation = dynamic_buffer.allocate(size, 256);
+        memcpy(allocation.cpu_addr, input_data_ptr, size);
+
+        Descriptor_Handle handle = this->online_cbv_srv_uav_descriptor_heap[current_backbuffer_index].get_next_handle();
+
+        // The view starts at the allocation, counted in elements from the start of the buffer
+        D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+        srv_desc.Shader4ComponentMapping    = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srv_desc.Format                     = DXGI_FORMAT_UNKNOWN;
+        srv_desc.ViewDimension              = D3D12_SRV_DIMENSION_BUFFER;
+        srv_desc.Buffer.FirstElement        = allocation.resource_offset / element_size;
+        srv_desc.Buffer.NumElements         = element_count;
+        srv_desc.Buffer.StructureByteStride = element_size;
+        srv_desc.Buffer.Flags               = D3D12_BUFFER_SRV_FLAG_NONE;
+        d3d12_device->CreateShaderResourceView(allocation.d3d12_resource.Get(), &srv_desc, handle.cpu_descriptor_handle);
+        counter_add(counter_view_creations);
+
+        return handle;
+    }
+
+    // A StructuredBuffer view of part of a buffer that stays on the GPU, nothing is copied
+    Descriptor_Handle Resource_Manager::load_frame_structured_buffer_view(Buffer* buffer, u32 first_element, u32 element_count){
+
+        Descriptor_Handle handle = this->online_cbv_srv_uav_descriptor_heap[current_backbuffer_index].get_next_handle();
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+        srv_desc.Shader4ComponentMapping    = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srv_desc.Format                     = DXGI_FORMAT_UNKNOWN;
+        srv_desc.ViewDimension              = D3D12_SRV_DIMENSION_BUFFER;
+        srv_desc.Buffer.FirstElement        = first_element;
+        srv_desc.Buffer.NumElements         = element_count;
+        srv_desc.Buffer.StructureByteStride = (u32)buffer->size_of_each_element;
+        srv_desc.Buffer.Flags               = D3D12_BUFFER_SRV_FLAG_NONE;
+        d3d12_device->CreateShaderResourceView(buffer->d3d12_resource.Get(), &srv_desc, handle.cpu_descriptor_handle);
+        counter_add(counter_view_creations);
 
         return handle;
     }
@@ -2333,6 +2434,8 @@ namespace d_dx12 {
 
         offset += allocation_size;
 
+        counter_add(counter_upload_buffer_bytes, allocation_size);
+
         return allocation;
 
     }
@@ -2441,6 +2544,83 @@ namespace d_dx12 {
         return;
     }
 
+    /*
+    *   Uploads a texture whose mips were generated offline (ddx_cook)
+    *   data holds mip 0 to mip_count - 1, tightly packed one after another
+    */
+    void Command_List::load_mip_chain_from_memory(Texture* texture, u_ptr data, u16 mip_count){
+
+        if(texture->usage != Texture::USAGE::USAGE_SAMPLED){
+            OutputDebugString("Error (load_mip_chain_from_memory): Invalid Texture Usage");
+            return;
+        }
+
+        if(data != NULL){
+
+            HRESULT hr;
+
+            TexMetadata tex_metadata = {};
+            tex_metadata.width      = texture->width;
+            tex_metadata.height     = texture->height;
+            tex_metadata.depth      = 1;
+            tex_metadata.arraySize  = 1;
+            tex_metadata.mipLevels  = mip_count;
+            tex_metadata.format     = texture->format;
+            tex_metadata.dimension  = TEX_DIMENSION_TEXTURE2D;
+
+            hr = CreateTexture(d3d12_device.Get(), tex_metadata, texture->d3d12_resource.GetAddressOf());
+            if(FAILED(hr)){
+                OutputDebugString("Error (load_mip_chain_from_memory): Error when creating texture resource");
+                DEBUG_BREAK;
+            }
+
+            // The above "CreateTexture" function creates the texture with this state
+            texture->state = D3D12_RESOURCE_STATE_COPY_DEST;
+
+            texture->d3d12_resource->SetName(L"Texture");
+
+            // Point each subresource at its mip, no copies or conversions
+            D3D12_SUBRESOURCE_DATA subresources[D3D12_REQ_MIP_LEVELS];
+            u8* mip_data = (u8*)data;
+            u64 width    = texture->width;
+            u64 height   = texture->height;
+
+            for(u16 mip = 0; mip < mip_count; mip++){
+
+                subresources[mip].pData      = mip_data;
+                subresources[mip].RowPitch   = width * get_bits_pp(texture->format) / 8;
+                subresources[mip].SlicePitch = subresources[mip].RowPitch * height;
+
+                mip_data += subresources[mip].SlicePitch;
+                width     = d_max(width / 2, 1);
+                height    = d_max(height / 2, 1);
+
+            }
+
+            const u64 upload_buffer_size = GetRequiredIntermediateSize(texture->d3d12_resource.Get(), 0, mip_count);
+
+            Upload_Buffer::Allocation upload_allocation = upload_buffer.allocate(upload_buffer_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            UpdateSubresources(this->d3d12_command_list.Get(),
+                texture->d3d12_resource.Get(), upload_allocation.d3d12_resource.Get(),
+                upload_allocation.resource_offset, 0, mip_count, subresources);
+
+            // Remap after Update Subresources unmaps
+            upload_buffer.d3d12_resource->Map(0, &CD3DX12_RANGE(0, upload_buffer.capacity), (void**)&(upload_buffer.start_cpu));
+
+            D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+            srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            srv_desc.Format = texture->format;
+            // Only works for 2d textures currently
+            srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            srv_desc.Texture2D.MipLevels = mip_count;
+
+            d3d12_device->CreateShaderResourceView(texture->d3d12_resource.Get(), &srv_desc, texture->offline_descriptor_handle.cpu_descriptor_handle);
+        }
+
+        return;
+    }
+
     
     void Dynamic_Buffer::init(){
 
@@ -2521,6 +2701,8 @@ namespace d_dx12 {
         allocation.d3d12_resource = d3d12_resource;
         allocation.aligned_size = aligned_size;
 
+        counter_add(counter_dynamic_buffer_bytes, aligned_size);
+
         return allocation;
     }
 
@@ -2638,15 +2820,33 @@ namespace d_dx12 {
 
     void Command_List::load_buffer(Buffer* buffer, u8* data, u64 size, u64 alignment){
 
-        if(size > (buffer->number_of_elements * buffer->size_of_each_element)){
+        u8* upload_memory = load_buffer_in_place(buffer, size, alignment);
+        memcpy(upload_memory, data, size);
+
+        return;
+    }
+
+    /*
+    *   Records the copy from the upload heap into buffer, and returns the upload heap memory for the caller to fill.
+    *   The copy doesn't run until the command list is executed, so the memory must be filled before then.
+    *   Lets loaders write straight into the upload heap instead of staging the data in CPU memory first.
+    */
+    u8* Command_List::load_buffer_in_place(Buffer* buffer, u64 size, u64 alignment){
+
+        return load_buffer_in_place(buffer, 0, size, alignment);
+
+    }
+
+    // Suballocated buffers are filled a range at a time, see geometry_buffer.h
+    u8* Command_List::load_buffer_in_place(Buffer* buffer, u64 destination_offset, u64 size, u64 alignment){
+
+        if(destination_offset + size > (buffer->number_of_elements * buffer->size_of_each_element)){
             OutputDebugString("Error (load_buffer): Trying to copy more data than is available");
             DEBUG_BREAK;
         }
 
         // Allocate data from the upload buffer
         Upload_Buffer::Allocation upload_allocation = upload_buffer.allocate(size, alignment);
-        // Copy our data into that buffer
-        memcpy(upload_allocation.cpu_addr, data, size);
 
         // Transition buffer to copy destination state
         if(buffer->state != D3D12_RESOURCE_STATE_COPY_DEST){
@@ -2656,13 +2856,32 @@ namespace d_dx12 {
         // Copy the data from the upload buffer resource into the Buffer buffer resource
         d3d12_command_list->CopyBufferRegion(
             buffer->d3d12_resource.Get(),                // Dest Resource
-            0,                                           // Dest Resource Offset
+            destination_offset,                          // Dest Resource Offset
             upload_allocation.d3d12_resource.Get(),      // Src Resource
             upload_allocation.resource_offset,           // Src Resource Offset
             size                                         // Copy size
         );
 
-        return;
+        return upload_allocation.cpu_addr;
+    }
+
+    // The upload buffer is only for loading, per frame updates come out of the dynamic buffer's ring instead
+    u8* Command_List::update_buffer_in_place(Buffer* buffer, u64 destination_offset, u64 size, u64 alignment){
+
+        if(destination_offset + size > (buffer->number_of_elements * buffer->size_of_each_element)){
+            OutputDebugString("Error (update_buffer_in_place): Trying to copy more data than is available");
+            DEBUG_BREAK;
+        }
+
+        Dynamic_Buffer::Allocation allocation = dynamic_buffer.allocate(size, alignment);
+
+        if(buffer->state != D3D12_RESOURCE_STATE_COPY_DEST){
+            this->transition_buffer(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+        }
+
+        d3d12_command_list->CopyBufferRegion(buffer->d3d12_resource.Get(), destination_offset, allocation.d3d12_resource.Get(), allocation.resource_offset, size);
+
+        return allocation.cpu_addr;
     }
 
     void Command_List::bind_vertex_buffer(Buffer* buffer, u32 slot){
@@ -2685,6 +2904,42 @@ namespace d_dx12 {
 
     }
 
+    void Command_List::bind_vertex_buffer(Buffer** buffers, u32 buffer_count, u32 start_slot){
+
+        if(buffer_count > D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT){
+            OutputDebugString("Error: bind_vertex_buffer was given more buffers than there are vertex buffer slots");
+            DEBUG_BREAK;
+            return;
+        }
+
+        D3D12_VERTEX_BUFFER_VIEW vertex_buffer_views[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+
+        for(u32 i = 0; i < buffer_count; i++){
+
+            Buffer* buffer = buffers[i];
+
+            if(buffer->usage != Buffer::USAGE::USAGE_VERTEX_BUFFER){
+                OutputDebugString("Error: bind_vertex_buffer requires a buffer with usage: USAGE_VERTEX_BUFFER");
+                DEBUG_BREAK;
+                return;
+            }
+
+            if(buffer->state != D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER){
+                this->transition_buffer(buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+            }
+
+            vertex_buffer_views[i] = buffer->vertex_buffer_view;
+
+        }
+
+        d3d12_command_list->IASetVertexBuffers(start_slot, buffer_count, vertex_buffer_views);
+
+    }
+
+    void Command_List::set_primitive_topology(D3D_PRIMITIVE_TOPOLOGY topology){
+        d3d12_command_list->IASetPrimitiveTopology(topology);
+    }
+
     void Command_List::bind_index_buffer(Buffer* buffer){
 
         if(buffer->usage == Buffer::USAGE::USAGE_INDEX_BUFFER){
@@ -2732,6 +2987,7 @@ namespace d_dx12 {
 
                 // Need to copy offline descriptor to online descriptor
                 d3d12_device->CopyDescriptorsSimple(1, buffer->online_descriptor_handle.cpu_descriptor_handle, buffer->offline_descriptor_handle.cpu_descriptor_handle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+                counter_add(counter_descriptor_copies);
 
                 if(current_bound_shader->type == Shader::Shader_Type::TYPE_GRAPHICS){
                     d3d12_command_list->SetGraphicsRootDescriptorTable(current_bound_shader->binding_points[binding_point_index].root_signature_index, buffer->online_descriptor_handle.gpu_descriptor_handle);
@@ -2778,6 +3034,7 @@ namespace d_dx12 {
 
                     // Copy offline descriptor to online descriptor
                     d3d12_device->CopyDescriptorsSimple(1, texture->online_descriptor_handle.cpu_descriptor_handle, texture->offline_descriptor_handle.cpu_descriptor_handle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+                    counter_add(counter_descriptor_copies);
                     index_to_return = resource_manager->online_cbv_srv_uav_descriptor_heap[current_backbuffer_index].texture_table_size - 1;
                     
                     // Remember that we have bound this texture to the online_descriptor_heap
@@ -2823,6 +3080,7 @@ namespace d_dx12 {
                     srvDesc.Texture2D.ResourceMinLODClamp   = 0.0f;
                     srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
                     d3d12_device->CreateShaderResourceView(texture->d3d12_resource.Get(), &srvDesc, texture->online_descriptor_handle.cpu_descriptor_handle);
+                    counter_add(counter_view_creations);
 
                     
                     // Remember that we have bound this texture to the online_descriptor_heap
@@ -2867,6 +3125,7 @@ namespace d_dx12 {
                         srvDesc.Texture2D.ResourceMinLODClamp   = 0.0f;
                         srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
                         d3d12_device->CreateShaderResourceView(texture->d3d12_resource.Get(), &srvDesc, texture->online_descriptor_handle.cpu_descriptor_handle);
+                        counter_add(counter_view_creations);
 
                         // Remember that we have bound this texture to the online_descriptor_heap
                         resource_manager->is_bound_online[texture->is_bound_index].srv_index = index_to_return;
@@ -2900,6 +3159,7 @@ namespace d_dx12 {
                         uavDesc.Texture2D.MipSlice = 0;
                         uavDesc.Texture2D.PlaneSlice = 0;
                         d3d12_device->CreateUnorderedAccessView(texture->d3d12_resource.Get(), nullptr, &uavDesc, texture->online_descriptor_handle.cpu_descriptor_handle);
+                        counter_add(counter_view_creations);
 
                         // Remember that we have bound this texture to the online_descriptor_heap
                         resource_manager->is_bound_online[texture->is_bound_index].uav_index = index_to_return;
@@ -2961,6 +3221,7 @@ namespace d_dx12 {
         Descriptor_Handle online_descriptor_handle = resource_manager->online_cbv_srv_uav_descriptor_heap[current_backbuffer_index].get_next_handle();
 
         d3d12_device->CopyDescriptorsSimple(count, online_descriptor_handle.cpu_descriptor_handle, handle.cpu_descriptor_handle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        counter_add(counter_descriptor_copies, count);
 
         return online_descriptor_handle;
 
@@ -3050,14 +3311,22 @@ namespace d_dx12 {
 
     void inline Command_List::draw(u32 number_of_indicies){
         d3d12_command_list->DrawIndexedInstanced(number_of_indicies, 1, 0, 0, 0); 
+        counter_add(counter_draw_calls);
     }
 
     void inline Command_List::draw_indexed(u32 index_count, u32 index_offset, s32 vertex_offset){
         d3d12_command_list->DrawIndexedInstanced(index_count, 1, index_offset, vertex_offset, 0); 
+        counter_add(counter_draw_calls);
+    }
+
+    void inline Command_List::draw_indexed_instanced(u32 index_count, u32 instance_count, u32 index_offset, s32 vertex_offset){
+        d3d12_command_list->DrawIndexedInstanced(index_count, instance_count, index_offset, vertex_offset, 0); 
+        counter_add(counter_draw_calls);
     }
 
     void inline Command_List::dispatch(u32 threadgroup_count_x, u32 threadgroup_count_y, u32 threadgroup_count_z){
         d3d12_command_list->Dispatch(threadgroup_count_x, threadgroup_count_y, threadgroup_count_z); 
+        counter_add(counter_dispatches);
     }
 
     void present(bool using_v_sync){
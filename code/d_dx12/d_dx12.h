@@ -56,6 +56,9 @@ namespace d_dx12 {
 
         Binding_Point binding_points[BINDING_POINT_INDEX_COUNT];
 
+        // Vertex buffer slots the input layout reads from, slots 0 to vertex_buffer_slot_count - 1
+        u8 vertex_buffer_slot_count = 0;
+
         void d_dx12_release();
 
     };
@@ -70,6 +73,7 @@ namespace d_dx12 {
             wchar_t* pixel_shader = nullptr; 
             wchar_t* compute_shader; 
         };
+        const wchar_t* vertex_shader_define = nullptr; // Passed to dxc as -D, for variants of one vertex shader file
 
         u8           num_render_targets              = 1;
         DXGI_FORMAT* render_target_formats           = nullptr;
@@ -154,6 +158,8 @@ namespace d_dx12 {
         Texture* create_texture(wchar_t* name, Texture_Desc& desc);
         Buffer*  create_buffer(wchar_t* name, Buffer_Desc& desc);
         Descriptor_Handle load_dyanamic_frame_data(void* ptr, u64 size, u64 alignment);
+        Descriptor_Handle load_dyanamic_frame_structured_buffer(void* ptr, u32 element_count, u32 element_size);
+        Descriptor_Handle load_frame_structured_buffer_view(Buffer* buffer, u32 first_element, u32 element_count); // Elements of a USAGE_STRUCTURED_BUFFER, for this frame
         void reset_is_bound_online();
         void d_dx12_release();
     };
@@ -203,7 +209,8 @@ namespace d_dx12 {
             USAGE_NONE,
             USAGE_VERTEX_BUFFER,
             USAGE_INDEX_BUFFER,
-            USAGE_CONSTANT_BUFFER
+            USAGE_CONSTANT_BUFFER,
+            USAGE_STRUCTURED_BUFFER
         };
 
         Microsoft::WRL::ComPtr<ID3D12Resource2>   d3d12_resource;
@@ -264,11 +271,17 @@ namespace d_dx12 {
         void clear_render_target(Texture* rt);
         void clear_depth_stencil(Texture* ds, const float depth);
         void load_buffer(Buffer* buffer, u8* data, u64 size, u64 alignment);
+        u8*  load_buffer_in_place(Buffer* buffer, u64 size, u64 alignment);
+        u8*  load_buffer_in_place(Buffer* buffer, u64 destination_offset, u64 size, u64 alignment); // Into [destination_offset, destination_offset + size) of buffer
+        u8*  update_buffer_in_place(Buffer* buffer, u64 destination_offset, u64 size, u64 alignment); // Same, staged in the frame's dynamic buffer so it can run every frame
         void load_texture_from_file(Texture* texture, const wchar_t* filename);
         void load_decoded_texture_from_memory(Texture* texture, u_ptr data, bool create_mipchain);
+        void load_mip_chain_from_memory(Texture* texture, u_ptr data, u16 mip_count);
         void reset();
         void close();
         void bind_vertex_buffer(Buffer* buffer, u32 slot);
+        void bind_vertex_buffer(Buffer** buffers, u32 buffer_count, u32 start_slot); // buffers[i] goes to start_slot + i, in one IASetVertexBuffers, leaves the topology alone
+        void set_primitive_topology(D3D_PRIMITIVE_TOPOLOGY topology);
         void bind_index_buffer(Buffer* buffer);
         void bind_handle(Descriptor_Handle handle, u32 binding_point);
         void bind_buffer(Buffer* buffer, Resource_Manager* resource_manager, u32  binding_point, bool write = false);
@@ -285,6 +298,7 @@ namespace d_dx12 {
         void draw(u32 number_of_verticies);
         void dispatch(u32 threadgroup_count_x, u32 threadgroup_count_y, u32 threadgroup_count_z);
         void draw_indexed(u32 index_count, u32 index_offset, s32 vertex_offset);
+        void draw_indexed_instanced(u32 index_count, u32 instance_count, u32 index_offset, s32 vertex_offset);
         void d_dx12_release();
 
     };
@@ -12,13 +12,14 @@ const enum Binding_Point_Index : u32 {
     SSAO_SAMPLE,
     SSAO_TEXTURE_INDEX,
     SHADOW_TEXTURE_INDEX,
-    MODEL_MATRIX,
+    INSTANCE_DATA,
     LIGHT_MATRIX,
     OUTPUT_TEXTURE,
     INPUT_TEXTURE,
     OUTPUT_TEXTURE_INDEX,
     INPUT_TEXTURE_INDEX,
     TEXTURE_2D_UAV_TABLE,
+    MESH_QUANTIZATION,
     BINDING_POINT_INDEX_COUNT,
 };
 
@@ -37,13 +38,14 @@ constexpr const Binding_Point_String_Map binding_point_map[] = {
     {"ssao_sample", SSAO_SAMPLE},
     {"ssao_texture_index", SSAO_TEXTURE_INDEX},
     {"shadow_texture_index", SHADOW_TEXTURE_INDEX},
-    {"model_matrix", MODEL_MATRIX},
+    {"instance_data", INSTANCE_DATA},
     {"light_matrix", LIGHT_MATRIX},
     {"outputTexture", OUTPUT_TEXTURE},
     {"inputTexture", INPUT_TEXTURE},
     {"output_texture_index", OUTPUT_TEXTURE_INDEX},
     {"input_texture_index", INPUT_TEXTURE_INDEX},
     {"texture_2d_uav_table", TEXTURE_2D_UAV_TABLE},
+    {"mesh_quantization", MESH_QUANTIZATION},
 };
 
 // Got from: https://stackoverflow.com/questions/27490858/how-can-you-compare-two-character-strings-statically-at-compile-time
@@ -0,0 +1,335 @@
+#ifndef _DDX_PACKAGE
+#define _DDX_PACKAGE
+
+#include "d_types.h"
+#include "meshlet.h"
+#include "mesh_simplify.h"
+#include "mesh_bounds.h"
+#include "scene.h"
+
+/*
+*   Cooked model package (.ddxpkg), written by ddx_cook and memory mapped by load_package_model
+*
+*   Everything is stored the way the renderer uploads it: vertices already in
+*   Vertex_Position_Normal_Tangent_Color_Texturecoord layout with Z flipped, u16 indices (u32 for
+*   meshes with a primitive that has more vertices than u16 reaches, even after welding), every
+*   triangle list's meshlets and LOD chain apart from those wide primitives', every texture's full mip chain and the node
+*   hierarchy already flattened. Loading is mapping the file and pointing at it.
+*   Primitives, meshes and the whole scene carry their Mesh_Bounds.
+*
+*   Layout:
+*       Package_Header
+*       Package_Mesh[mesh_count]
+*       Package_Primitive[primitive_count]
+*       Package_Material[material_count]
+*       Package_Texture[texture_count]
+*       Package_Node[node_count], depth first like Scene
+*       Blobs, each PACKAGE_BLOB_ALIGNMENT aligned:
+*           Per mesh: Package_Vertex[vertex_count], then u16 or u32[index_count] depending on index_size
+*           Per texture: mip 0 .. mip_count - 1, tightly packed
+*           Per mesh: Meshlet[meshlet_count], then u16[meshlet_vertex_count], then u8[meshlet_triangle_count * 3]
+*           Per mesh: u16[lod_index_count], LOD 1 and up of every primitive
+*/
+
+#define PACKAGE_MAGIC          0x50584444 // "DDXP"
+#define PACKAGE_VERSION        7
+#define PACKAGE_BLOB_ALIGNMENT 16
+#define PACKAGE_NO_TEXTURE     0xFFFFFFFF
+#define PACKAGE_U16_VERTEX_MAX 0x10000    // Primitives with more vertices need u32 indices
+
+// Same values as DXGI_FORMAT, so the runtime can cast them
+enum Package_Format : u32 {
+    PACKAGE_FORMAT_R16G16B16A16_UNORM = 11,
+    PACKAGE_FORMAT_R8G8B8A8_UNORM     = 28,
+};
+
+// Same values as D3D_PRIMITIVE_TOPOLOGY
+enum Package_Topology : u32 {
+    PACKAGE_TOPOLOGY_POINT_LIST     = 1,
+    PACKAGE_TOPOLOGY_LINE_LIST      = 2,
+    PACKAGE_TOPOLOGY_LINE_STRIP     = 3,
+    PACKAGE_TOPOLOGY_TRIANGLE_LIST  = 4,
+    PACKAGE_TOPOLOGY_TRIANGLE_STRIP = 5,
+};
+
+// Same values as D_Material_Flags
+enum Package_Material_Flags : u32 {
+    PACKAGE_MATERIAL_FLAG_NORMAL_TEXTURE            = 0x1,
+    PACKAGE_MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE = 0x2,
+};
+
+struct Package_Header {
+    u32 magic;
+    u32 version;
+    u64 file_size;
+
+    u32 mesh_count;
+    u32 primitive_count;
+    u32 material_count;
+    u32 texture_count;
+
+    u64 meshes_offset;
+    u64 primitives_offset;
+    u64 materials_offset;
+    u64 textures_offset;
+
+    u32 node_count;
+    u32 padding;
+    u64 nodes_offset;
+
+    Mesh_Bounds bounds;  // Every mesh instance, in the scene's space
+};
+
+struct Package_Mesh {
+    u32 first_primitive;
+    u32 primitive_count;
+    u32 vertex_count;
+    u32 index_count;
+    u64 vertex_offset;   // File offset of the mesh's Package_Vertex blob
+    u64 index_offset;    // File offset of the mesh's index blob
+
+    u32 index_size;      // 2, or 4 when a primitive has more than PACKAGE_U16_VERTEX_MAX vertices
+    u32 meshlet_count;
+    u32 meshlet_vertex_count;
+    u32 meshlet_triangle_count;
+    u64 meshlet_offset;          // File offset of the mesh's Meshlet blob
+    u64 meshlet_vertex_offset;   // u16 blob, indices into the primitive's vertices
+    u64 meshlet_triangle_offset; // u8 blob, 3 per triangle, indices into the meshlet's vertices
+
+    u32 lod_index_count;
+    u32 padding_1;
+    u64 lod_index_offset;        // u16 blob, relative to the primitive's vertices like the indices
+
+    Mesh_Bounds bounds;          // Every primitive's
+};
+
+// Offsets are in elements, from the start of the mesh's blobs
+struct Package_Primitive {
+    u32 topology;
+    u32 material_index;  // Always < material_count, ddx_cook adds an untextured material for primitives without one
+    u32 vertex_offset;
+    u32 vertex_count;
+    u32 index_offset;
+    u32 index_count;
+
+    // Meshlet offsets and vertex / triangle offsets inside the Meshlets are relative to these
+    u32 meshlet_offset;
+    u32 meshlet_count;
+    u32 meshlet_vertex_offset;
+    u32 meshlet_vertex_count;
+    u32 meshlet_triangle_offset;
+    u32 meshlet_triangle_count;
+
+    // lods[0] is the primitive's indices. The indices of LOD 1 and up are at lod_index_offset in the mesh's
+    // LOD index blob, their index_offsets count from index_offset as if they followed LOD 0's indices
+    u32      lod_index_offset;
+    u32      lod_index_count;
+    u32      lod_count;
+    Mesh_Lod lods[MESH_LOD_MAX];
+    Mesh_Bounds bounds;  // Also what LOD selection measures the errors against
+};
+
+// Texture indices are PACKAGE_NO_TEXTURE when the slot is empty
+struct Package_Material {
+    u32 albedo_texture;
+    u32 normal_texture;
+    u32 roughness_metallic_texture;
+    u32 material_flags;
+};
+
+struct Package_Texture {
+    u32 width;
+    u32 height;
+    u32 format;
+    u32 mip_count;
+    u64 data_offset;
+    u64 data_size;       // All mips
+};
+
+// One node of the Scene, the local matrix is already z flipped
+struct Package_Node {
+    u32 parent;          // SCENE_NO_PARENT, or a node before this one
+    u32 subtree_end;
+    u32 mesh_index;      // SCENE_NO_MESH, or an index into the meshes
+    u32 padding;
+    f32 local_matrix[16];
+};
+
+// Matches Vertex_Position_Normal_Tangent_Color_Texturecoord
+struct Package_Vertex {
+    f32 position[3];
+    f32 normal[3];
+    f32 color[3];
+    f32 texture_coordinates[2];
+    f32 tangent[4];
+};
+
+inline u32 package_format_bytes_per_pixel(u32 format){
+    return format == PACKAGE_FORMAT_R16G16B16A16_UNORM ? 8 : 4;
+}
+
+// Full chain down to 1x1
+inline u32 package_mip_count(u32 width, u32 height){
+    u32 mip_count = 1;
+    while(width > 1 || height > 1){
+        width  = width  > 1 ? width  / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        mip_count++;
+    }
+    return mip_count;
+}
+
+inline u64 package_mip_chain_size(u32 width, u32 height, u32 mip_count, u32 bytes_per_pixel){
+    u64 size = 0;
+    for(u32 mip = 0; mip < mip_count; mip++){
+        size  += (u64)width * height * bytes_per_pixel;
+        width  = width  > 1 ? width  / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
+
+inline bool package_range_valid(u64 file_size, u64 offset, u64 size){
+    return offset <= file_size && size <= file_size - offset;
+}
+
+/*
+*   Checks the header and that every table and blob lies inside the file.
+*   Returns NULL if it's valid, otherwise what's wrong.
+*/
+inline const char* package_validate(const u8* data, u64 size){
+
+    if(size < sizeof(Package_Header)){
+        return "file is smaller than the header";
+    }
+
+    const Package_Header* header = (const Package_Header*)data;
+    if(header->magic != PACKAGE_MAGIC){
+        return "not a ddx package";
+    }
+    if(header->version != PACKAGE_VERSION){
+        return "package version doesn't match, re-cook it";
+    }
+    if(header->file_size != size){
+        return "file size doesn't match the header, the package is truncated";
+    }
+
+    if(!package_range_valid(size, header->meshes_offset,     (u64)header->mesh_count      * sizeof(Package_Mesh))      ||
+       !package_range_valid(size, header->primitives_offset, (u64)header->primitive_count * sizeof(Package_Primitive)) ||
+       !package_range_valid(size, header->materials_offset,  (u64)header->material_count  * sizeof(Package_Material))  ||
+       !package_range_valid(size, header->textures_offset,   (u64)header->texture_count   * sizeof(Package_Texture))   ||
+       !package_range_valid(size, header->nodes_offset,      (u64)header->node_count      * sizeof(Package_Node))){
+        return "table out of range";
+    }
+
+    const Package_Mesh* meshes = (const Package_Mesh*)(data + header->meshes_offset);
+    for(u32 i = 0; i < header->mesh_count; i++){
+        const Package_Mesh& mesh = meshes[i];
+        if((mesh.index_size != sizeof(u16) && mesh.index_size != sizeof(u32)) ||
+           (u64)mesh.first_primitive + mesh.primitive_count > header->primitive_count ||
+           !package_range_valid(size, mesh.vertex_offset, (u64)mesh.vertex_count * sizeof(Package_Vertex)) ||
+           !package_range_valid(size, mesh.index_offset,  (u64)mesh.index_count  * mesh.index_size)     ||
+           !package_range_valid(size, mesh.meshlet_offset,          (u64)mesh.meshlet_count          * sizeof(Meshlet)) ||
+           !package_range_valid(size, mesh.meshlet_vertex_offset,   (u64)mesh.meshlet_vertex_count   * sizeof(u16))     ||
+           !package_range_valid(size, mesh.meshlet_triangle_offset, (u64)mesh.meshlet_triangle_count * 3) ||
+           !package_range_valid(size, mesh.lod_index_offset,        (u64)mesh.lod_index_count        * sizeof(u16))){
+            return "mesh out of range";
+        }
+
+        const Package_Primitive* primitives = (const Package_Primitive*)(data + header->primitives_offset) + mesh.first_primitive;
+        for(u32 j = 0; j < mesh.primitive_count; j++){
+            const Package_Primitive& primitive = primitives[j];
+            if((u64)primitive.vertex_offset  + primitive.vertex_count  > mesh.vertex_count ||
+               (u64)primitive.index_offset   + primitive.index_count   > mesh.index_count  ||
+               (u64)primitive.meshlet_offset + primitive.meshlet_count > mesh.meshlet_count ||
+               (u64)primitive.meshlet_vertex_offset   + primitive.meshlet_vertex_count   > mesh.meshlet_vertex_count ||
+               (u64)primitive.meshlet_triangle_offset + primitive.meshlet_triangle_count > mesh.meshlet_triangle_count ||
+               (u64)primitive.lod_index_offset + primitive.lod_index_count > mesh.lod_index_count ||
+               primitive.lod_count == 0 || primitive.lod_count > MESH_LOD_MAX){
+                return "primitive out of range";
+            }
+
+            // Neither u16 indices nor the u16 meshlet vertices and LOD indices reach all of a wide primitive's vertices
+            if(primitive.vertex_count > PACKAGE_U16_VERTEX_MAX &&
+               (mesh.index_size != sizeof(u32) || primitive.meshlet_count || primitive.lod_index_count || primitive.lod_count != 1)){
+                return "primitive has too many vertices for its indices";
+            }
+
+            // Drawing indexes the materials with it
+            if(primitive.material_index >= header->material_count){
+                return "primitive material out of range";
+            }
+
+            for(u32 k = 0; k < primitive.lod_count; k++){
+                if((u64)primitive.lods[k].index_offset + primitive.lods[k].index_count > (u64)primitive.index_count + primitive.lod_index_count){
+                    return "LOD out of range";
+                }
+            }
+
+            // The culler only reads the bounds, but anything drawing the meshlets reads through these
+            const Meshlet* meshlets = (const Meshlet*)(data + mesh.meshlet_offset) + primitive.meshlet_offset;
+            for(u32 k = 0; k < primitive.meshlet_count; k++){
+                if((u64)meshlets[k].vertex_offset + meshlets[k].vertex_count > primitive.meshlet_vertex_count ||
+                   (u64)meshlets[k].triangle_offset + meshlets[k].triangle_count * 3ull > (u64)primitive.meshlet_triangle_count * 3){
+                    return "meshlet out of range";
+                }
+            }
+        }
+    }
+
+    const Package_Material* materials = (const Package_Material*)(data + header->materials_offset);
+    for(u32 i = 0; i < header->material_count; i++){
+        const u32 material_textures[] = {materials[i].albedo_texture, materials[i].normal_texture, materials[i].roughness_metallic_texture};
+        for(u32 slot = 0; slot < 3; slot++){
+            if(material_textures[slot] != PACKAGE_NO_TEXTURE && material_textures[slot] >= header->texture_count){
+                return "material texture out of range";
+            }
+        }
+    }
+
+    const Package_Texture* textures = (const Package_Texture*)(data + header->textures_offset);
+    for(u32 i = 0; i < header->texture_count; i++){
+        const Package_Texture& texture = textures[i];
+        if(texture.mip_count == 0 || texture.mip_count > package_mip_count(texture.width, texture.height)){
+            return "texture mip count out of range";
+        }
+        u64 chain_size = package_mip_chain_size(texture.width, texture.height, texture.mip_count, package_format_bytes_per_pixel(texture.format));
+        if(texture.data_size != chain_size || !package_range_valid(size, texture.data_offset, texture.data_size)){
+            return "texture out of range";
+        }
+    }
+
+    // scene_update_world_matrices relies on parents coming first and subtrees nesting
+    const Package_Node* nodes = (const Package_Node*)(data + header->nodes_offset);
+    for(u32 i = 0; i < header->node_count; i++){
+        const Package_Node& node = nodes[i];
+        if(node.subtree_end <= i || node.subtree_end > header->node_count ||
+           (node.parent != SCENE_NO_PARENT && (node.parent >= i || nodes[node.parent].subtree_end < node.subtree_end)) ||
+           (node.mesh_index != SCENE_NO_MESH && node.mesh_index >= header->mesh_count)){
+            return "node out of range";
+        }
+    }
+
+    return NULL;
+
+}
+
+// Copies the package's nodes into scene, which can then be moved around. The package has to be valid
+inline void package_load_scene(const u8* data, Scene* scene){
+
+    const Package_Header* header = (const Package_Header*)data;
+    const Package_Node*   nodes  = (const Package_Node*)(data + header->nodes_offset);
+
+    scene_alloc(scene, header->node_count);
+    for(u32 i = 0; i < header->node_count; i++){
+        scene->parents.ptr[i]      = nodes[i].parent;
+        scene->subtree_ends.ptr[i] = nodes[i].subtree_end;
+        scene->mesh_indices.ptr[i] = nodes[i].mesh_index;
+        scene_set_local_matrix(scene, i, nodes[i].local_matrix);
+    }
+    scene_build_instances(scene, header->mesh_count);
+    scene_update_world_matrices(scene);
+
+}
+
+#endif // _DDX_PACKAGE
@@ -0,0 +1,111 @@
+#include "geometry_buffer.h"
+
+static d_dx12::Buffer* geometry_buffer_create(d_dx12::Resource_Manager* resource_manager, wchar_t* name, u32 element_count, u32 element_size,
+                                              d_dx12::Buffer::USAGE usage, DXGI_FORMAT format){
+
+    if(element_count == 0){
+        return NULL;
+    }
+
+    d_dx12::Buffer_Desc desc = {};
+    desc.number_of_elements   = element_count;
+    desc.size_of_each_element = element_size;
+    desc.format               = format;
+    desc.usage                = usage;
+
+    return resource_manager->create_buffer(name, desc);
+
+}
+
+bool geometry_buffer_init(D_Geometry_Buffer* geometry_buffer, d_dx12::Resource_Manager* resource_manager, u32 vertex_capacity, u32 index_16_capacity, u32 index_32_capacity,
+                          u32 position_size, u32 attribute_size, u32 max_ranges){
+
+    *geometry_buffer = {};
+    geometry_buffer->position_size  = position_size;
+    geometry_buffer->attribute_size = attribute_size;
+
+    if(!d_std::offset_allocator_init(&geometry_buffer->vertices,   vertex_capacity,   max_ranges) ||
+       !d_std::offset_allocator_init(&geometry_buffer->indices_16, index_16_capacity, max_ranges) ||
+       !d_std::offset_allocator_init(&geometry_buffer->indices_32, index_32_capacity, max_ranges)){
+        OutputDebugString("Error (geometry_buffer_init): Couldn't allocate the offset allocators\n");
+        geometry_buffer_release(geometry_buffer);
+        return false;
+    }
+
+    geometry_buffer->position_buffer  = geometry_buffer_create(resource_manager, L"Geometry Position Buffer",  vertex_capacity,   position_size,  d_dx12::Buffer::USAGE::USAGE_VERTEX_BUFFER, DXGI_FORMAT_UNKNOWN);
+    geometry_buffer->attribute_buffer = geometry_buffer_create(resource_manager, L"Geometry Attribute Buffer", vertex_capacity,   attribute_size, d_dx12::Buffer::USAGE::USAGE_VERTEX_BUFFER, DXGI_FORMAT_UNKNOWN);
+    geometry_buffer->index_buffer_16  = geometry_buffer_create(resource_manager, L"Geometry Index Buffer u16", index_16_capacity, sizeof(u16),    d_dx12::Buffer::USAGE::USAGE_INDEX_BUFFER,  DXGI_FORMAT_R16_UINT);
+    geometry_buffer->index_buffer_32  = geometry_buffer_create(resource_manager, L"Geometry Index Buffer u32", index_32_capacity, sizeof(u32),    d_dx12::Buffer::USAGE::USAGE_INDEX_BUFFER,  DXGI_FORMAT_R32_UINT);
+
+    return true;
+
+}
+
+void geometry_buffer_release(D_Geometry_Buffer* geometry_buffer){
+
+    d_dx12::Buffer* buffers[] = {geometry_buffer->position_buffer, geometry_buffer->attribute_buffer, geometry_buffer->index_buffer_16, geometry_buffer->index_buffer_32};
+    for(u32 i = 0; i < _countof(buffers); i++){
+        if(buffers[i]){
+            buffers[i]->d_dx12_release();
+        }
+    }
+
+    d_std::offset_allocator_release(&geometry_buffer->vertices);
+    d_std::offset_allocator_release(&geometry_buffer->indices_16);
+    d_std::offset_allocator_release(&geometry_buffer->indices_32);
+
+    *geometry_buffer = {};
+
+}
+
+bool geometry_buffer_allocate(D_Geometry_Buffer* geometry_buffer, u32 vertex_count, u32 index_count, u32 index_size, D_Geometry_Range* range){
+
+    *range = {};
+    range->index_size = index_size;
+
+    d_std::Offset_Allocator* index_allocator = index_size == sizeof(u32) ? &geometry_buffer->indices_32 : &geometry_buffer->indices_16;
+    range->vertices = d_std::offset_allocator_allocate(&geometry_buffer->vertices, vertex_count);
+    range->indices  = d_std::offset_allocator_allocate(index_allocator, index_count);
+
+    if(range->vertices.offset == OFFSET_ALLOCATOR_NO_SPACE || range->indices.offset == OFFSET_ALLOCATOR_NO_SPACE){
+        geometry_buffer_free(geometry_buffer, range);
+        return false;
+    }
+
+    return true;
+
+}
+
+void geometry_buffer_free(D_Geometry_Buffer* geometry_buffer, D_Geometry_Range* range){
+
+    d_std::offset_allocator_free(&geometry_buffer->vertices, range->vertices);
+    d_std::offset_allocator_free(range->index_size == sizeof(u32) ? &geometry_buffer->indices_32 : &geometry_buffer->indices_16, range->indices);
+    range->vertices = {};
+    range->indices  = {};
+
+}
+
+d_dx12::Buffer* geometry_buffer_index_buffer(D_Geometry_Buffer* geometry_buffer, u32 index_size){
+
+    return index_size == sizeof(u32) ? geometry_buffer->index_buffer_32 : geometry_buffer->index_buffer_16;
+
+}
+
+void geometry_buffer_load_in_place(D_Geometry_Buffer* geometry_buffer, d_dx12::Command_List* command_list, const D_Geometry_Range& range, u32 vertex_count, u32 index_count,
+                                   u8** positions, u8** attributes, u8** indices){
+
+    u64 position_size  = geometry_buffer->position_size;
+    u64 attribute_size = geometry_buffer->attribute_size;
+    u64 index_size     = range.index_size;
+
+    if(positions){
+        *positions  = command_list->load_buffer_in_place(geometry_buffer->position_buffer,  range.vertices.offset * position_size,  vertex_count * position_size,  position_size);
+    }
+    if(attributes){
+        *attributes = command_list->load_buffer_in_place(geometry_buffer->attribute_buffer, range.vertices.offset * attribute_size, vertex_count * attribute_size, attribute_size);
+    }
+    if(indices){
+        *indices    = command_list->load_buffer_in_place(geometry_buffer_index_buffer(geometry_buffer, range.index_size), range.indices.offset * index_size, index_count * index_size, index_size);
+    }
+
+}
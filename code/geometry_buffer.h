@@ -0,0 +1,64 @@
+#ifndef _GEOMETRY_BUFFER
+#define _GEOMETRY_BUFFER
+
+#include "d_dx12.h"
+#include "d_offset_allocator.h"
+
+/*
+*   Every mesh's vertices and indices, suballocated from one set of buffers
+*
+*   Two vertex streams, positions for slot 0 and attributes for slot 1, and a u16 and a u32 index buffer.
+*   Meshes get a range of each from offset allocators, and their draw calls use absolute base vertex and
+*   first index, so the streams are bound once per pass and the index buffer only when the index size changes.
+*
+*   Ranges are in vertices and indices, not bytes. Positions and attributes share the vertex range.
+*/
+
+#define GEOMETRY_BUFFER_DEFAULT_VERTICES    (1 << 20)
+#define GEOMETRY_BUFFER_DEFAULT_INDICES_16  (4 << 20)
+#define GEOMETRY_BUFFER_DEFAULT_INDICES_32  (1 << 20)
+#define GEOMETRY_BUFFER_DEFAULT_RANGES      4096
+
+struct D_Geometry_Buffer {
+
+    d_dx12::Buffer* position_buffer;
+    d_dx12::Buffer* attribute_buffer;
+    d_dx12::Buffer* index_buffer_16;
+    d_dx12::Buffer* index_buffer_32;
+
+    d_std::Offset_Allocator vertices;
+    d_std::Offset_Allocator indices_16;
+    d_std::Offset_Allocator indices_32;
+
+    u32 position_size;
+    u32 attribute_size;
+
+};
+
+struct D_Geometry_Range {
+
+    d_std::Offset_Allocation vertices;
+    d_std::Offset_Allocation indices;
+    u32 index_size;                     // Which index buffer indices is in, 2 or 4
+
+};
+
+// Capacities are in vertices and indices, max_ranges is the most meshes the buffer holds at once
+bool geometry_buffer_init(D_Geometry_Buffer* geometry_buffer, d_dx12::Resource_Manager* resource_manager, u32 vertex_capacity, u32 index_16_capacity, u32 index_32_capacity,
+                          u32 position_size, u32 attribute_size, u32 max_ranges);
+void geometry_buffer_release(D_Geometry_Buffer* geometry_buffer);
+
+// Returns false and leaves range empty if any of the buffers is out of space
+bool geometry_buffer_allocate(D_Geometry_Buffer* geometry_buffer, u32 vertex_count, u32 index_count, u32 index_size, D_Geometry_Range* range);
+void geometry_buffer_free(D_Geometry_Buffer* geometry_buffer, D_Geometry_Range* range);
+
+d_dx12::Buffer* geometry_buffer_index_buffer(D_Geometry_Buffer* geometry_buffer, u32 index_size);
+
+/*
+*   Returns pointers into the upload heap for the range's vertices and indices, for the caller to fill before the
+*   command list executes. Any of the pointers can be NULL to skip that buffer.
+*/
+void geometry_buffer_load_in_place(D_Geometry_Buffer* geometry_buffer, d_dx12::Command_List* command_list, const D_Geometry_Range& range, u32 vertex_count, u32 index_count,
+                                   u8** positions, u8** attributes, u8** indices);
+
+#endif // _GEOMETRY_BUFFER
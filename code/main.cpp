@@ -6,12 +6,19 @@
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx12.h"
 
-#include <chrono>
 #include <random>
-#include "timeapi.h"
 
 #include "d_core.cpp"
 #include "d_dx12.cpp"
+#include "mesh_optimize.cpp"
+#include "meshlet.cpp"
+#include "mesh_simplify.cpp"
+#include "mesh_tangents.cpp"
+#include "mesh_weld.cpp"
+#include "mesh_bounds.cpp"
+#include "scene.cpp"
+#include "scene_file.cpp"
+#include "geometry_buffer.cpp"
 #include "model.cpp"
 #include "shaders.cpp"
 #include "constant_buffers.h"
@@ -78,10 +85,58 @@ static const char* render_pass_names[NUM_RENDER_PASSES] = {
     "Ray_Tracing",
 };
 
+enum D_Frame_Timers : u8 {
+    TIMER_SHADOW_MAP,
+    TIMER_FORWARD_SHADING,
+    TIMER_DEFERRED_GBUFFER,
+    TIMER_DEFERRED_SHADING,
+    TIMER_SSAO,
+    TIMER_POST_PROCESSING,
+    TIMER_RAY_TRACING,
+    TIMER_IMGUI,
+    TIMER_SUBMIT,
+    NUM_FRAME_TIMERS
+};
+
+static const char* frame_timer_names[NUM_FRAME_TIMERS] = {
+    "Shadow_Map",
+    "Forward_Shading",
+    "Deferred_Gbuffer",
+    "Deferred_Shading",
+    "SSAO",
+    "Post_Processing",
+    "Ray_Tracing",
+    "ImGui",
+    "Submit",
+};
+
+// Timing histograms, all values are in nanoseconds
+struct D_Frame_Stats {
+    Rolling_Histogram cpu_frame;            // CPU time to record and submit a frame, not including present
+    Rolling_Histogram present_to_present;   // Time between consecutive presents
+    Rolling_Histogram passes[NUM_FRAME_TIMERS];
+    u64               last_present_time = 0;
+    u64               startup_time = 0;           // Ticks at the start of WinMain
+    f64               time_to_first_frame_ms = 0; // Startup to the first present
+
+    void init();
+    void show_imgui_table();
+    void dump_csv(const char* filename);
+    void dump_json(const char* filename);
+};
+
 struct D_Renderer_Config {
     bool fullscreen_mode = false;
     bool imgui_demo      = false;         
     u8   render_pass     = RAY_TRACING;
+    s32  frame_rate_limit = 0;  // Frames per second, 0 = unlimited
+    bool quantized_vertices = false; // 16 byte quantized vertex streams instead of the full float vertices, --quantized-vertices
+    f32  lod_pixel_error = MESH_LOD_DEFAULT_PIXEL_ERROR; // Pixels a LOD's error may cover, 0 draws LOD 0 everywhere
+    u32  instance_grid = 0;          // Repeats each model's scene this many times on a grid, --instance-grid N
+    u32  synthetic_copies = 0;       // Places the model this many times on a grid and writes the scene out, --synthetic-scene N
+    bool meshlet_cull_stats = false; // Runs the CPU reference meshlet culler every frame, per instance. --meshlet-cull-stats or the checkbox turns it on
+    const char* model_path = "C:\\dev\\glTF-Sample-Models\\2.0\\Sponza\\glTF\\Sponza.gltf"; // .gltf / .glb, or a .ddxpkg from ddx_cook
+    const char* scene_path = NULL;   // A .ddxscene to load instead of model_path, see scene_file.h
 
     #ifdef d_4k
     u16 display_width  = 3840;
@@ -97,6 +152,12 @@ struct D_Renderer_Config {
 
 };
 
+// Triangles bind_and_draw_model drew in a view, and what LOD 0 everywhere would have been
+struct D_Lod_Stats {
+    u64 full_triangles;
+    u64 drawn_triangles;
+};
+
 // Global Vars, In order of creation
 struct D_Renderer {
     HWND              hWnd;
@@ -111,8 +172,19 @@ struct D_Renderer {
 
     Descriptor_Handle imgui_font_handle;
     RECT              window_rect;
-    Span<D_Model>     models;
+    Span<D_Model>     models;               // One per asset in scene_file, all of them drawn by every pass
+    Scene_File        scene_file;
+    f64               scene_load_ms;        // Every model, loaded in parallel
     Per_Frame_Data    per_frame_data;
+    D_Frame_Stats     frame_stats;
+    Meshlet_Cull_Stats meshlet_cull_stats; // Last frame, CPU reference culler only
+    Mesh_Lod_View     camera_lod_view;
+    Mesh_Lod_View     shadow_lod_view;
+    D_Lod_Stats       camera_lod_stats;     // Last frame
+    D_Lod_Stats       shadow_lod_stats;
+    u32               scene_nodes_updated;  // Last frame, world matrices scene_update_world_matrices redid
+    Buffer*           instance_buffer;      // Every mesh instance's Instance_Data, each mesh's at D_Mesh::instance_offset, see init_instance_buffer
+    D_Geometry_Buffer geometry_buffer;      // Every model's vertices and indices, sized for all of them by init_geometry_buffer
 
 
     int  init();
@@ -123,8 +195,15 @@ struct D_Renderer {
     void compute_rayt_pass(Command_List* command_list);
     void shutdown();
     void toggle_fullscreen();
+    void init_geometry_buffer();
+    void init_instance_buffer();
     void upload_model_to_gpu(Command_List* command_list, D_Model& test_model);
-    void bind_and_draw_model(Command_List* command_list, D_Model* model);
+    void upload_instance_data(Command_List* command_list, D_Model* model);
+    void bind_and_draw_model(Command_List* command_list, D_Model* model, const Mesh_Lod_View& lod_view, D_Lod_Stats* lod_stats);
+    void bind_and_draw_models(Command_List* command_list, const Mesh_Lod_View& lod_view, D_Lod_Stats* lod_stats);
+    void limit_frame_rate();
+
+    u64               next_frame_ticks = 0;
 
 };
 
@@ -132,162 +211,362 @@ D_Renderer renderer;
 Memory_Arena *per_frame_arena;
 bool application_is_initialized = false;
 
-#define MAX_TICK_SAMPLES 20
-int tick_index = 0;
-double tick_sum = 0.;
-double *tick_list = NULL;
 
 /*******************/
 
+#define COUNTER_RING_FILE_FRAMES 4096
+
 bool using_v_sync = false;
 bool capturing_mouse = false;
 
-void D_Renderer::upload_model_to_gpu(Command_List* command_list, D_Model& test_model){
+// Cooked textures carry their mip chain, decoded glTF images get one generated
+static void load_material_texture(Command_List* command_list, D_Texture& texture){
+
+    if(texture.cpu_texture_data.ptr == NULL){
+        return;
+    }
+
+    if(texture.cpu_mip_count > 0){
+        command_list->load_mip_chain_from_memory(texture.texture, (u_ptr)texture.cpu_texture_data.ptr, texture.cpu_mip_count);
+    } else {
+        command_list->load_decoded_texture_from_memory(texture.texture, (u_ptr)texture.cpu_texture_data.ptr, true);
+    }
+
+}
+
+/*
+*   Draws offset the vertices, so indices only have to reach within a primitive group. A mesh's indices are
+*   u16 unless one of them needed u32 indices, sets each mesh's index_size and adds up the model's
+*/
+static void count_model_geometry(D_Model& model, u64* verticies, u64* indicies){
+
+    for(u64 i = 0; i < model.meshes.nitems; i++){
+
+        D_Mesh* mesh = model.meshes.ptr + i;
+        mesh->index_size = sizeof(u16);
+        u64 number_of_indicies = 0;
+        for(u64 j = 0; j < mesh->primitive_groups.nitems; j++){
+
+            D_Primitive_Group* primitive_group = mesh->primitive_groups.ptr + j;
+            *verticies         += primitive_group->verticies.nitems;
+            number_of_indicies += primitive_group->indicies.nitems + primitive_group->indicies_32.nitems + primitive_group->lod_indicies.nitems;
+            if(primitive_group->indicies_32.nitems){
+                mesh->index_size = sizeof(u32);
+            }
+
+        }
+        indicies[mesh->index_size == sizeof(u32)] += number_of_indicies;
+
+    }
+
+}
+
+// Big enough for every loaded model and at least the defaults, before any of them is uploaded
+void D_Renderer::init_geometry_buffer(){
+
+    // Vertex streams, a position stream for slot 0 and an attribute stream for slot 1
+    u64 position_size  = config.quantized_vertices ? sizeof(Vertex_Quantized_Position)   : sizeof(Vertex_Position);
+    u64 attribute_size = config.quantized_vertices ? sizeof(Vertex_Quantized_Attributes) : sizeof(Vertex_Normal_Color_Texturecoord_Tangent);
+
+    u64 scene_verticies   = 0;
+    u64 scene_indicies[2] = {}; // u16, u32
+    u64 scene_meshes      = 0;
+    for(u64 i = 0; i < models.nitems; i++){
+        count_model_geometry(models.ptr[i], &scene_verticies, scene_indicies);
+        scene_meshes += models.ptr[i].meshes.nitems;
+    }
 
-    // Strategy: Each primative group gets it's own vertex buffer?
-    // Not good, but will do for now
-    // ... new stratagy, each mesh gets it's own buffer ..?
-    // ++
+    geometry_buffer_init(&geometry_buffer, &resource_manager,
+        (u32)d_max(scene_verticies,   (u64)GEOMETRY_BUFFER_DEFAULT_VERTICES),
+        (u32)d_max(scene_indicies[0], (u64)GEOMETRY_BUFFER_DEFAULT_INDICES_16),
+        (u32)d_max(scene_indicies[1], (u64)GEOMETRY_BUFFER_DEFAULT_INDICES_32),
+        (u32)position_size, (u32)attribute_size, (u32)d_max(scene_meshes, (u64)GEOMETRY_BUFFER_DEFAULT_RANGES));
+
+}
+
+/*
+*   One range per mesh, in model then mesh order, each holding the mesh's instances in instance_nodes order.
+*   The scenes have to be final, a replicated scene needs a bigger buffer
+*/
+void D_Renderer::init_instance_buffer(){
+
+    u32 instance_count = 0;
+    for(u64 i = 0; i < models.nitems; i++){
+        D_Model* model = &models.ptr[i];
+        for(u64 j = 0; j < model->meshes.nitems; j++){
+            model->meshes.ptr[j].instance_offset = instance_count + model->scene.mesh_instance_offsets.ptr[j];
+        }
+        instance_count += (u32)model->scene.instance_nodes.nitems;
+    }
+
+    if(instance_count == 0){
+        instance_buffer = NULL;
+        return;
+    }
+
+    Buffer_Desc desc = {};
+    desc.number_of_elements   = instance_count;
+    desc.size_of_each_element = sizeof(Instance_Data);
+    desc.usage                = Buffer::USAGE::USAGE_STRUCTURED_BUFFER;
+    instance_buffer = resource_manager.create_buffer(L"Instance Buffer", desc);
+
+}
+
+void D_Renderer::upload_model_to_gpu(Command_List* command_list, D_Model& test_model){
 
     //////////////////////
     // Model Buffers
     //////////////////////
 
-    // For each primitive group
+    // The geometry buffer is already sized for it, see init_geometry_buffer
+    u64 model_verticies  = 0;
+    u64 model_indicies[2] = {}; // u16, u32
+    count_model_geometry(test_model, &model_verticies, model_indicies);
+
     for(u64 i = 0; i < test_model.meshes.nitems; i++){
 
         D_Mesh* mesh = test_model.meshes.ptr + i;
 
-        // Get the number of verticies in this mesh
         u64 number_of_verticies = 0;
         u64 number_of_indicies  = 0;
         for(u64 j = 0; j < mesh->primitive_groups.nitems; j++){
-
             D_Primitive_Group* primitive_group = mesh->primitive_groups.ptr + j;
-            number_of_verticies +=  primitive_group->verticies.nitems;
-            number_of_indicies  +=  primitive_group->indicies.nitems;
-
+            number_of_verticies += primitive_group->verticies.nitems;
+            number_of_indicies  += primitive_group->indicies.nitems + primitive_group->indicies_32.nitems + primitive_group->lod_indicies.nitems;
         }
 
-        // Allocate space for the draw calls
-        mesh->draw_calls.alloc(mesh->primitive_groups.nitems);
-
-        // Allocate cpu space for the verticies
-        Span<Vertex_Position_Normal_Tangent_Color_Texturecoord> verticies_buffer;
-        verticies_buffer.alloc(number_of_verticies);
-
-        // Copy the verticies in all primitive groups to this buffer
-        Vertex_Position_Normal_Tangent_Color_Texturecoord* start_vertex_ptr = verticies_buffer.ptr;
-        Vertex_Position_Normal_Tangent_Color_Texturecoord* current_vertex_ptr = start_vertex_ptr;
-
-        // Allocate cpu space for the indicies
-        Span<u16> indicies_buffer;
-        indicies_buffer.alloc(number_of_indicies);
+        if(!geometry_buffer_allocate(&geometry_buffer, (u32)number_of_verticies, (u32)number_of_indicies, mesh->index_size, &mesh->geometry)){
+            OutputDebugString("Error (upload_model_to_gpu): The geometry buffer is out of space\n");
+            DEBUG_BREAK;
+            mesh->draw_calls.nitems = 0;
+            continue;
+        }
 
-        // Copy the verticies in all primitive groups to this buffer
-        u16* start_index_ptr = indicies_buffer.ptr;
-        u16* current_index_ptr = start_index_ptr;
+        // Primitive groups are split into the streams straight in the upload heap, no staging copy
+        u8* position_ptr;
+        u8* attribute_ptr;
+        u8* index_ptr;
+        geometry_buffer_load_in_place(&geometry_buffer, command_list, mesh->geometry, (u32)number_of_verticies, (u32)number_of_indicies, &position_ptr, &attribute_ptr, &index_ptr);
+        u64 vertex_offset = 0;
+        u64 index_offset  = 0;
+
+        // Quantized vertices are encoded the whole mesh at once, since it shares one set of bounds
+        if(config.quantized_vertices){
+            quantize_mesh_vertices(*mesh, (Vertex_Quantized_Position*)position_ptr, (Vertex_Quantized_Attributes*)attribute_ptr, &test_model.quantization_error);
+        }
 
         for(u64 j = 0; j < mesh->primitive_groups.nitems; j++){
 
             // Get the primitive group
             D_Primitive_Group* primitive_group = mesh->primitive_groups.ptr + j;
 
-            // Copy the verticies
-            memcpy(current_vertex_ptr, primitive_group->verticies.ptr, primitive_group->verticies.nitems * sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord));
+            // Split the verticies into the position and attribute streams
+            if(!config.quantized_vertices){
+                Vertex_Position*                          positions  = (Vertex_Position*)position_ptr + vertex_offset;
+                Vertex_Normal_Color_Texturecoord_Tangent* attributes = (Vertex_Normal_Color_Texturecoord_Tangent*)attribute_ptr + vertex_offset;
+                for(u64 k = 0; k < primitive_group->verticies.nitems; k++){
+                    const Vertex_Position_Normal_Tangent_Color_Texturecoord& vertex = primitive_group->verticies.ptr[k];
+                    positions[k].position             = vertex.position;
+                    attributes[k].normal              = vertex.normal;
+                    attributes[k].color               = vertex.color;
+                    attributes[k].texture_coordinates = vertex.texture_coordinates;
+                    attributes[k].tangent             = vertex.tangent;
+                }
+            }
 
-            // Copy the indicies
-            memcpy(current_index_ptr, primitive_group->indicies.ptr, primitive_group->indicies.nitems * sizeof(u16));
+            // Copy the indicies, LOD 1 and up right after LOD 0. u16 ones are widened when the mesh's indices are u32
+            u64 index_count = primitive_group->indicies.nitems + primitive_group->indicies_32.nitems;
+            if(primitive_group->indicies_32.nitems){
+                u32* indices = (u32*)index_ptr + index_offset;
+                memcpy(indices, primitive_group->indicies_32.ptr, index_count * sizeof(u32));
+                for(u64 k = 0; k < primitive_group->lod_indicies.nitems; k++){
+                    indices[index_count + k] = primitive_group->lod_indicies.ptr[k];
+                }
+            } else if(mesh->index_size == sizeof(u32)){
+                u32* indices = (u32*)index_ptr + index_offset;
+                for(u64 k = 0; k < primitive_group->indicies.nitems; k++){
+                    indices[k] = primitive_group->indicies.ptr[k];
+                }
+                for(u64 k = 0; k < primitive_group->lod_indicies.nitems; k++){
+                    indices[index_count + k] = primitive_group->lod_indicies.ptr[k];
+                }
+            } else {
+                u16* indices = (u16*)index_ptr + index_offset;
+                memcpy(indices, primitive_group->indicies.ptr, index_count * sizeof(u16));
+                memcpy(indices + index_count, primitive_group->lod_indicies.ptr, primitive_group->lod_indicies.nitems * sizeof(u16));
+            }
 
-            // Update draw_call information
-            mesh->draw_calls.ptr[j].index_count    = primitive_group->indicies.nitems;
-            mesh->draw_calls.ptr[j].index_offset   = current_index_ptr - start_index_ptr;
-            mesh->draw_calls.ptr[j].vertex_offset  = current_vertex_ptr - start_vertex_ptr;
+            // Update draw_call information, offsets are absolute in the geometry buffer
+            mesh->draw_calls.ptr[j].index_count    = index_count;
+            mesh->draw_calls.ptr[j].index_offset   = mesh->geometry.indices.offset + index_offset;
+            mesh->draw_calls.ptr[j].vertex_offset  = mesh->geometry.vertices.offset + vertex_offset;
             mesh->draw_calls.ptr[j].material_index = primitive_group->material_index;
+            mesh->draw_calls.ptr[j].bounds         = primitive_group->bounds;
 
-            // Update pointers
-            current_vertex_ptr += primitive_group->verticies.nitems;
-            current_index_ptr  += primitive_group->indicies.nitems;
+            // Update offsets
+            vertex_offset += primitive_group->verticies.nitems;
+            index_offset  += index_count + primitive_group->lod_indicies.nitems;
             
         }
+    }
+
+    Offset_Allocator_Report vertex_report = offset_allocator_report(&geometry_buffer.vertices);
+    char geometry_string[256];
+    snprintf(geometry_string, sizeof(geometry_string), "Geometry buffer: %u / %u vertices, %llu u16 and %llu u32 indices, %u ranges\n",
+        vertex_report.allocated_size, geometry_buffer.vertices.size, model_indicies[0], model_indicies[1], vertex_report.allocation_count);
+    os_debug_print(geometry_string);
+
+    if(config.quantized_vertices){
+        D_Vertex_Quantization_Error& error = test_model.quantization_error;
+        char error_string[256];
+        snprintf(error_string, sizeof(error_string), "Quantized vertices: max position error %f, normal %.3f deg, tangent %.3f deg, texture coordinate %f\n",
+            error.max_position_error, error.max_normal_error, error.max_tangent_error, error.max_texture_coordinate_error);
+        os_debug_print(error_string);
+    }
+
+    //////////////////////
+    //  Textures
+    //////////////////////
+
+    // Materials share the model's textures, each is created and uploaded once
+    for(u32 texture_index = 0; texture_index < test_model.textures.nitems; texture_index++){
 
-        // Vertex buffer
-        Buffer_Desc vertex_buffer_desc = {};
-        vertex_buffer_desc.number_of_elements = verticies_buffer.nitems;
-        vertex_buffer_desc.size_of_each_element = sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord);
-        vertex_buffer_desc.usage = Buffer::USAGE::USAGE_VERTEX_BUFFER;
+        D_Texture& texture = test_model.textures.ptr[texture_index];
 
-        mesh->vertex_buffer = resource_manager.create_buffer(L"Vertex Buffer", vertex_buffer_desc);
+        // TODO: This name is not useful, however I do not know how to handle wchar_t that resource needs, vs char that tinygltf gives me
+        texture.texture = resource_manager.create_texture(L"Material_Texture", texture.texture_desc);
+
+        load_material_texture(command_list, texture);
+    }
+}
+
+// Every model is drawn at this scale
+#define MODEL_SCALE 0.1f
+
+static DirectX::XMMATRIX get_model_matrix(D_Model* model){
+
+    DirectX::XMMATRIX model_matrix = DirectX::XMMatrixIdentity();
+    DirectX::XMMATRIX scale_matrix = DirectX::XMMatrixScaling(MODEL_SCALE, MODEL_SCALE, MODEL_SCALE);
+    model_matrix = DirectX::XMMatrixMultiply(scale_matrix, DirectX::XMMatrixIdentity());
+    DirectX::XMMATRIX translation_matrix = DirectX::XMMatrixTranslation(model->coords.x, model->coords.y, model->coords.z);
+    model_matrix = DirectX::XMMatrixMultiply(translation_matrix, model_matrix);
+    return model_matrix;
 
-        command_list->load_buffer(mesh->vertex_buffer, (u8*)verticies_buffer.ptr, verticies_buffer.nitems * sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord), sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord));//Fix: sizeof(Vertex_Position_Color));
+}
 
-        // Index Buffer
-        Buffer_Desc index_buffer_desc = {};
-        index_buffer_desc.number_of_elements = indicies_buffer.nitems;
-        index_buffer_desc.size_of_each_element = sizeof(u16);
-        index_buffer_desc.usage = Buffer::USAGE::USAGE_INDEX_BUFFER;
+// The instance node's world matrix, then the model's
+static DirectX::XMMATRIX get_instance_matrix(D_Model* model, u32 node, DirectX::XMMATRIX model_matrix){
 
-        mesh->index_buffer = resource_manager.create_buffer(L"Index Buffer", index_buffer_desc);
+    DirectX::XMMATRIX world_matrix = DirectX::XMLoadFloat4x4((DirectX::XMFLOAT4X4*)model->scene.world_matrices.ptr[node].m);
+    return DirectX::XMMatrixMultiply(world_matrix, model_matrix);
 
-        command_list->load_buffer(mesh->index_buffer, (u8*)indicies_buffer.ptr, indicies_buffer.nitems * sizeof(u16), sizeof(u16));
+}
 
-        indicies_buffer.d_free();
-        verticies_buffer.d_free();
+// How far the model's bounds reach from the scene's origin, in the scene's units
+static f32 get_scene_radius(D_Model* model){
+
+    if(model->bounds.radius < 0.f){
+        return 0.f;
     }
+    const f32* center = model->bounds.center;
+    return sqrtf(center[0] * center[0] + center[1] * center[1] + center[2] * center[2]) + model->bounds.radius;
 
-    //////////////////////
-    //  Materials
-    //////////////////////
-    for(u32 material_index = 0; material_index < test_model.materials.nitems; material_index++){
+}
 
-        D_Material& material = test_model.materials.ptr[material_index];
+/*
+*   Runs the CPU reference meshlet culler against the camera, nothing is drawn any differently yet.
+*   The frustum and camera are taken into each instance's mesh space so the meshlet bounds are used as they are
+*/
+static void cull_model_meshlets(D_Model* model, DirectX::XMMATRIX view_projection_matrix, DirectX::XMVECTOR camera_position, Meshlet_Cull_Stats* stats){
 
-        // Albedo Texture
-        // TODO: This name is not useful, however I do not know how to handle wchar_t that resource needs, vs char that tinygltf gives me
-        material.albedo_texture.texture = resource_manager.create_texture(L"Albedo_Texture", material.albedo_texture.texture_desc);
+    DirectX::XMMATRIX model_matrix = get_model_matrix(model);
 
-        if(material.albedo_texture.cpu_texture_data.ptr){
-            command_list->load_decoded_texture_from_memory(material.albedo_texture.texture, (u_ptr)material.albedo_texture.cpu_texture_data.ptr, true);
+    for(u64 i = 0; i < model->scene.instance_nodes.nitems; i++){
+
+        u32 node = model->scene.instance_nodes.ptr[i];
+        DirectX::XMMATRIX instance_matrix = get_instance_matrix(model, node, model_matrix);
+
+        DirectX::XMFLOAT4X4 instance_view_projection;
+        DirectX::XMStoreFloat4x4(&instance_view_projection, DirectX::XMMatrixMultiply(instance_matrix, view_projection_matrix));
+        Meshlet_Frustum frustum;
+        meshlet_frustum_from_matrix(&instance_view_projection.m[0][0], &frustum);
+
+        DirectX::XMFLOAT3 instance_camera_position;
+        DirectX::XMStoreFloat3(&instance_camera_position, DirectX::XMVector3Transform(camera_position, DirectX::XMMatrixInverse(NULL, instance_matrix)));
+
+        D_Mesh* mesh = model->meshes.ptr + model->scene.mesh_indices.ptr[node];
+        for(u64 j = 0; j < mesh->primitive_groups.nitems; j++){
+            D_Primitive_Group* primitive_group = mesh->primitive_groups.ptr + j;
+            cull_meshlets(primitive_group->meshlets.ptr, (u32)primitive_group->meshlets.nitems, frustum, &instance_camera_position.x, NULL, stats);
         }
 
-        // Normal Map
-        // TODO: This name is not useful, however I do not know how to handle wchar_t that resource needs, vs char that tinygltf gives me
-        if(material.material_flags & MATERIAL_FLAG_NORMAL_TEXTURE){
-            material.normal_texture.texture = resource_manager.create_texture(L"Normal_Texture", material.normal_texture.texture_desc);
+    }
 
-            if(material.normal_texture.cpu_texture_data.ptr){
-                command_list->load_decoded_texture_from_memory(material.normal_texture.texture, (u_ptr)material.normal_texture.cpu_texture_data.ptr, true);
-            }
+}
+
+/*
+*   Rewrites the instance matrices and LOD bounds of the meshes whose instances moved since the last call, the
+*   rest stay in instance_buffer as they are. Gives every mesh a view of its range, both passes draw from them,
+*   so this runs once a frame after the world matrices are updated. The model matrix never changes once loaded
+*/
+void D_Renderer::upload_instance_data(Command_List* command_list, D_Model* model){
+
+    Scene& scene = model->scene;
+    DirectX::XMMATRIX model_matrix = get_model_matrix(model);
+
+    for(u64 i = 0; i < model->meshes.nitems; i++){
+
+        D_Mesh* mesh = model->meshes.ptr + i;
+        u32 first_instance = scene.mesh_instance_offsets.ptr[i];
+        mesh->instance_count = scene.mesh_instance_offsets.ptr[i + 1] - first_instance;
+        if(mesh->instance_count == 0){
+            continue;
         }
 
-        // RoughnessMetallic Map
-        // TODO: This name is not useful, however I do not know how to handle wchar_t that resource needs, vs char that tinygltf gives me
-        if(material.material_flags & MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE){
-            material.roughness_metallic_texture.texture = resource_manager.create_texture(L"RoughnessMetallic_Texture", material.roughness_metallic_texture.texture_desc);
+        // Views only last the frame, the data stays
+        mesh->instance_data_handle = resource_manager.load_frame_structured_buffer_view(instance_buffer, mesh->instance_offset, mesh->instance_count);
+        if(!scene.mesh_instances_dirty.ptr[i]){
+            continue;
+        }
+        scene.mesh_instances_dirty.ptr[i] = 0;
+
+        // Written straight into the copy's staging memory
+        Instance_Data* instance_data = (Instance_Data*)command_list->update_buffer_in_place(instance_buffer, (u64)mesh->instance_offset * sizeof(Instance_Data),
+            (u64)mesh->instance_count * sizeof(Instance_Data), sizeof(Instance_Data));
+
+        // Bounds of the instances' origins and their largest scale, for picking one LOD for all of them
+        DirectX::XMVECTOR origin_min        = DirectX::XMVectorReplicate(FLT_MAX);
+        DirectX::XMVECTOR origin_max        = DirectX::XMVectorReplicate(-FLT_MAX);
+        DirectX::XMVECTOR max_scale_squared = DirectX::XMVectorZero();
+
+        for(u32 j = first_instance; j < first_instance + mesh->instance_count; j++){
+
+            DirectX::XMMATRIX instance_matrix = get_instance_matrix(model, scene.instance_nodes.ptr[j], model_matrix);
+            instance_data[j - first_instance].model_matrix = instance_matrix;
+
+            origin_min = DirectX::XMVectorMin(origin_min, instance_matrix.r[3]);
+            origin_max = DirectX::XMVectorMax(origin_max, instance_matrix.r[3]);
+            max_scale_squared = DirectX::XMVectorMax(max_scale_squared, DirectX::XMVector3LengthSq(instance_matrix.r[0]));
+            max_scale_squared = DirectX::XMVectorMax(max_scale_squared, DirectX::XMVector3LengthSq(instance_matrix.r[1]));
+            max_scale_squared = DirectX::XMVectorMax(max_scale_squared, DirectX::XMVector3LengthSq(instance_matrix.r[2]));
 
-            if(material.roughness_metallic_texture.cpu_texture_data.ptr){
-                command_list->load_decoded_texture_from_memory(material.roughness_metallic_texture.texture, (u_ptr)material.roughness_metallic_texture.cpu_texture_data.ptr, true);
-            }
         }
+
+        DirectX::XMStoreFloat3((DirectX::XMFLOAT3*)mesh->instance_origin_center, DirectX::XMVectorScale(DirectX::XMVectorAdd(origin_min, origin_max), 0.5f));
+        mesh->instance_origin_radius = 0.5f * DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(origin_max, origin_min)));
+        mesh->instance_max_scale     = sqrtf(DirectX::XMVectorGetX(max_scale_squared));
+
     }
+
 }
 
-void D_Renderer::bind_and_draw_model(Command_List* command_list, D_Model* model){
+void D_Renderer::bind_and_draw_model(Command_List* command_list, D_Model* model, const Mesh_Lod_View& lod_view, D_Lod_Stats* lod_stats){
 
-    DirectX::XMMATRIX model_matrix = DirectX::XMMatrixIdentity();
-    DirectX::XMMATRIX scale_matrix = DirectX::XMMatrixScaling(0.1, 0.1, 0.1);
-    model_matrix = DirectX::XMMatrixMultiply(scale_matrix, DirectX::XMMatrixIdentity());
-    DirectX::XMMATRIX translation_matrix = DirectX::XMMatrixTranslation(model->coords.x, model->coords.y, model->coords.z);
-    model_matrix = DirectX::XMMatrixMultiply(translation_matrix, model_matrix);
-    //command_list->bind_constant_arguments(&model_matrix, sizeof(DirectX::XMMATRIX) / 4, binding_point_string_lookup("model_matrix"));
-    Descriptor_Handle model_matrix_handle = resource_manager.load_dyanamic_frame_data((void*)&model_matrix, sizeof(DirectX::XMMATRIX), 256);
-    command_list->bind_handle(model_matrix_handle, binding_point_string_lookup("model_matrix"));
+    DirectX::XMMATRIX model_matrix = get_model_matrix(model);
 
     // Begin by initializing each textures binding table index to an invalid value
-    for(u64 i = 0; i < model->materials.nitems; i++){
-        model->materials.ptr[i].albedo_texture.texture_binding_table_index = -1;
-        model->materials.ptr[i].normal_texture.texture_binding_table_index = -1;
-        model->materials.ptr[i].roughness_metallic_texture.texture_binding_table_index = -1;
+    for(u64 i = 0; i < model->textures.nitems; i++){
+        model->textures.ptr[i].texture_binding_table_index = -1;
     }
 
     // Then, we copy all the texture descriptors to the texture table in online_descriptor_heap
@@ -297,25 +576,18 @@ void D_Renderer::bind_and_draw_model(Command_List* command_list, D_Model* model)
         // For each draw call
         for(u64 j = 0; j < mesh->draw_calls.nitems; j++){
 
-            D_Draw_Call draw_call = mesh->draw_calls.ptr[j];
-            
-            // Check if table index is < 0 (-1). Only bind albedo texture if it needs to be bound to avoid unncessary descriptor copies
-            model->materials.ptr[draw_call.material_index].albedo_texture.texture_binding_table_index = command_list->bind_texture(model->materials.ptr[draw_call.material_index].albedo_texture.texture, &resource_manager, 0);
-
-            // If this material uses a normal map
-            if(model->materials.ptr[draw_call.material_index].material_flags & MATERIAL_FLAG_NORMAL_TEXTURE){
-
-                // Check if table index is < 0 (-1). Only bind albedo texture if it needs to be bound to avoid unncessary descriptor copies
-                model->materials.ptr[draw_call.material_index].normal_texture.texture_binding_table_index = command_list->bind_texture(model->materials.ptr[draw_call.material_index].normal_texture.texture, &resource_manager, 0);
-
-            }
-
-            // If this material uses roughness metallic map
-            if(model->materials.ptr[draw_call.material_index].material_flags & MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE){
-
-                // Check if table index is < 0 (-1). Only bind albedo texture if it needs to be bound to avoid unncessary descriptor copies
-                model->materials.ptr[draw_call.material_index].roughness_metallic_texture.texture_binding_table_index = command_list->bind_texture(model->materials.ptr[draw_call.material_index].roughness_metallic_texture.texture, &resource_manager, 0);
+            const D_Material& material = model->materials.ptr[mesh->draw_calls.ptr[j].material_index];
+            u32 material_textures[] = {material.albedo_texture, material.normal_texture, material.roughness_metallic_texture};
 
+            // Materials share textures, each one is only bound the first time a draw call uses it
+            for(u32 slot = 0; slot < _countof(material_textures); slot++){
+                if(material_textures[slot] == MATERIAL_NO_TEXTURE){
+                    continue;
+                }
+                D_Texture& texture = model->textures.ptr[material_textures[slot]];
+                if(texture.texture_binding_table_index < 0){
+                    texture.texture_binding_table_index = command_list->bind_texture(texture.texture, &resource_manager, 0);
+                }
             }
         }
     }
@@ -327,20 +599,85 @@ void D_Renderer::bind_and_draw_model(Command_List* command_list, D_Model* model)
         command_list->bind_online_descriptor_heap_texture_table(&resource_manager, tex_2d_table_index);
     }
 
+    // Every mesh is in the geometry buffer, draws pick their vertices and indices with base vertex and first index.
+    // Only the streams the shader's input layout reads, depth only passes skip the attribute stream
+    Buffer* vertex_streams[] = {geometry_buffer.position_buffer, geometry_buffer.attribute_buffer};
+    command_list->bind_vertex_buffer(vertex_streams, d_min(command_list->current_bound_shader->vertex_buffer_slot_count, (u8)_countof(vertex_streams)), 0);
+    u32 bound_index_size = 0;
+    D3D_PRIMITIVE_TOPOLOGY bound_topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+    // Each mesh once, all of its instances in one instanced draw per draw call
+    constexpr u32 instance_data_index = binding_point_string_lookup("instance_data");
     for(u64 i = 0; i < model->meshes.nitems; i++){
+
         D_Mesh* mesh = model->meshes.ptr + i;
+        if(mesh->instance_count == 0){
+            continue;
+        }
 
-        // Bind the buffers to the command list somewhere in the root signature
-        command_list->bind_vertex_buffer(mesh->vertex_buffer, 0);
-        command_list->bind_index_buffer(mesh->index_buffer);
+        command_list->bind_handle(mesh->instance_data_handle, instance_data_index);
+
+        // With one instance its own matrix places the LOD bounds, otherwise they're taken around every instance's origin
+        DirectX::XMMATRIX single_instance_matrix = DirectX::XMMatrixIdentity();
+        if(mesh->instance_count == 1){
+            u32 node = model->scene.instance_nodes.ptr[model->scene.mesh_instance_offsets.ptr[i]];
+            single_instance_matrix = get_instance_matrix(model, node, model_matrix);
+        }
+
+        // Only rebound when this mesh's index size differs from the last one's
+        if(mesh->index_size != bound_index_size){
+            command_list->bind_index_buffer(geometry_buffer_index_buffer(&geometry_buffer, mesh->index_size));
+            bound_index_size = mesh->index_size;
+        }
+
+        // Bounds to dequantize the positions with, only the QUANTIZED_VERTICES shaders have it
+        constexpr u32 mesh_quantization_index = binding_point_string_lookup("mesh_quantization");
+        if(command_list->current_bound_shader->binding_points[mesh_quantization_index].input_type != Shader::Input_Type::TYPE_INVALID){
+
+            Mesh_Quantization mesh_quantization = {};
+            mesh_quantization.position_offset = mesh->position_offset;
+            mesh_quantization.position_scale  = mesh->position_scale;
+
+            Descriptor_Handle mesh_quantization_handle = resource_manager.load_dyanamic_frame_data((void*)&mesh_quantization, sizeof(Mesh_Quantization), 256);
+            command_list->bind_handle(mesh_quantization_handle, mesh_quantization_index);
+
+        }
 
         // For each draw call
         for(u64 j = 0; j < mesh->draw_calls.nitems; j++){
 
-            D_Draw_Call draw_call = mesh->draw_calls.ptr[j];
+            const D_Draw_Call& draw_call = mesh->draw_calls.ptr[j];
+
+            // Every pipeline is built for triangles, point and line primitives can't be drawn with them
+            D3D_PRIMITIVE_TOPOLOGY topology = mesh->primitive_groups.ptr[j].primitive_topology;
+            if(topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST && topology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP){
+                continue;
+            }
+            if(topology != bound_topology){
+                command_list->set_primitive_topology(topology);
+                bound_topology = topology;
+            }
 
             D_Material material = model->materials.ptr[draw_call.material_index];
 
+            // Coarsest LOD whose error stays under lod_view.max_pixel_error pixels for the instance that needs the most detail.
+            // The LOD errors are in mesh space, the instances stretch them by up to instance_max_scale
+            D_Primitive_Group* primitive_group = mesh->primitive_groups.ptr + j;
+            DirectX::XMFLOAT3 bounds_center;
+            f32 bounds_radius;
+            if(mesh->instance_count == 1){
+                DirectX::XMStoreFloat3(&bounds_center, DirectX::XMVector3Transform(DirectX::XMLoadFloat3((DirectX::XMFLOAT3*)draw_call.bounds.center), single_instance_matrix));
+                bounds_radius = draw_call.bounds.radius * mesh->instance_max_scale;
+            } else {
+                f32 center_distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMLoadFloat3((DirectX::XMFLOAT3*)draw_call.bounds.center)));
+                bounds_center = *(DirectX::XMFLOAT3*)mesh->instance_origin_center;
+                bounds_radius = mesh->instance_origin_radius + (center_distance + draw_call.bounds.radius) * mesh->instance_max_scale;
+            }
+            u32 lod = select_lod(primitive_group->lods, primitive_group->lod_count, &bounds_center.x, bounds_radius, mesh->instance_max_scale, lod_view);
+            const Mesh_Lod& mesh_lod = primitive_group->lods[lod];
+
+            lod_stats->full_triangles  += (u64)(draw_call.index_count / 3) * mesh->instance_count;
+            lod_stats->drawn_triangles += (u64)(mesh_lod.index_count / 3) * mesh->instance_count;
 
             constexpr u32 material_data_index = binding_point_string_lookup("material_data");
             if(command_list->current_bound_shader->binding_points[material_data_index].input_type != Shader::Input_Type::TYPE_INVALID){
@@ -349,14 +686,14 @@ void D_Renderer::bind_and_draw_model(Command_List* command_list, D_Model* model)
 
                 Material_Data material_data_for_shader = {};
 
-                material_data_for_shader.albedo_index             = material.albedo_texture.texture_binding_table_index;
+                material_data_for_shader.albedo_index             = model->textures.ptr[material.albedo_texture].texture_binding_table_index;
                 material_data_for_shader.flags                    = material.material_flags;
 
                 if(material.material_flags & MATERIAL_FLAG_NORMAL_TEXTURE)
-                    material_data_for_shader.normal_index             = material.normal_texture.texture_binding_table_index;
+                    material_data_for_shader.normal_index             = model->textures.ptr[material.normal_texture].texture_binding_table_index;
 
                 if(material.material_flags & MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE)
-                    material_data_for_shader.roughness_metallic_index = material.roughness_metallic_texture.texture_binding_table_index;
+                    material_data_for_shader.roughness_metallic_index = model->textures.ptr[material.roughness_metallic_texture].texture_binding_table_index;
 
 
                 // Upload and bind buffer
@@ -366,17 +703,31 @@ void D_Renderer::bind_and_draw_model(Command_List* command_list, D_Model* model)
                 
             }
 
-            command_list->draw_indexed(draw_call.index_count, draw_call.index_offset, draw_call.vertex_offset);
+            command_list->draw_indexed_instanced(mesh_lod.index_count, mesh->instance_count, draw_call.index_offset + mesh_lod.index_offset, draw_call.vertex_offset);
 
         }
     }
 }
 
+// Every model in the scene. Textures stay bound across models, so the scene's textures have to fit the texture table together
+void D_Renderer::bind_and_draw_models(Command_List* command_list, const Mesh_Lod_View& lod_view, D_Lod_Stats* lod_stats){
+
+    for(u64 i = 0; i < models.nitems; i++){
+        bind_and_draw_model(command_list, models.ptr + i, lod_view, lod_stats);
+    }
+
+}
+
 /*
 *   Release d3d12 obj before exiting application
 */
 void D_Renderer::shutdown(){
 
+    // Write out frame timing percentiles for regression tracking
+    frame_stats.dump_csv("frame_stats.csv");
+    frame_stats.dump_json("frame_stats.json");
+    counters_close_ring_file();
+
     // Dear ImGui Shutdown
     ImGui_ImplDX12_Shutdown();
     ImGui_ImplWin32_Shutdown();
@@ -396,25 +747,34 @@ void D_Renderer::shutdown(){
     buffers.ssao_sample_kernel->d_dx12_release();
 
     // Release model resources
-    D_Model* model = &models.ptr[0];
+    for(u64 model_index = 0; model_index < models.nitems; model_index++){
 
-    for(u64 i = 0; i < model->meshes.nitems; i++){
+        D_Model* model = &models.ptr[model_index];
 
-        D_Mesh* mesh = model->meshes.ptr + i;
-        mesh->index_buffer->d_dx12_release();
-        mesh->vertex_buffer->d_dx12_release();
+        for(u64 i = 0; i < model->meshes.nitems; i++){
 
-    }
+            D_Mesh* mesh = model->meshes.ptr + i;
+            geometry_buffer_free(&geometry_buffer, &mesh->geometry);
+
+        }
 
-    for(u32 i = 0; i < model->materials.nitems; i++){
+        for(u32 i = 0; i < model->textures.nitems; i++){
 
-        if(model->materials.ptr[i].albedo_texture.texture)
-            model->materials.ptr[i].albedo_texture.texture->d_dx12_release();
+            if(model->textures.ptr[i].texture)
+                model->textures.ptr[i].texture->d_dx12_release();
 
-        if(model->materials.ptr[i].normal_texture.texture)
-            model->materials.ptr[i].normal_texture.texture->d_dx12_release();
+        }
+
+        // The model's arena, scene and package mapping
+        model_release(*model);
 
     }
+    geometry_buffer_release(&geometry_buffer);
+    if(instance_buffer){
+        instance_buffer->d_dx12_release();
+    }
+    models.d_free();
+    scene_file_free(&scene_file);
 
 
     // Releases DirectX 12 objects in library 
@@ -431,15 +791,149 @@ void D_Renderer::shutdown(){
 }
 
 /*
-*   FPS / Tick counter
+*   Frame timing
 */
-double avg_ms_per_tick(double tick){
-    tick_sum -= tick_list[tick_index];
-    tick_list[tick_index] = tick;
-    tick_sum += tick_list[tick_index];
-    tick_index++;
-    tick_index = tick_index % MAX_TICK_SAMPLES;
-    return ((double)tick_sum/(double)MAX_TICK_SAMPLES);
+inline u64 frame_timer_now(){
+    return os_now_ticks();
+}
+
+// Histograms hold nanoseconds, so convert the tick delta when recording
+inline void frame_timer_record(Rolling_Histogram& histogram, u64 start_time, u64 end_time){
+    histogram.record(os_ticks_to_ns(end_time - start_time));
+}
+
+inline void frame_timer_end(D_Frame_Timers timer, u64 start_time){
+    frame_timer_record(renderer.frame_stats.passes[timer], start_time, frame_timer_now());
+}
+
+#define NS_TO_MS(ns) ((f64)(ns) / 1000000.)
+
+void D_Frame_Stats::init(){
+
+    cpu_frame.reset();
+    present_to_present.reset();
+    for(u32 i = 0; i < NUM_FRAME_TIMERS; i++){
+        passes[i].reset();
+    }
+    last_present_time = 0;
+
+}
+
+static void show_imgui_histogram_row(const char* name, Rolling_Histogram& histogram){
+
+    if(histogram.window.total_count == 0) return;
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn(); ImGui::Text("%s", name);
+    ImGui::TableNextColumn(); ImGui::Text("%.3lf", NS_TO_MS(histogram.window.value_at_percentile(50.)));
+    ImGui::TableNextColumn(); ImGui::Text("%.3lf", NS_TO_MS(histogram.window.value_at_percentile(90.)));
+    ImGui::TableNextColumn(); ImGui::Text("%.3lf", NS_TO_MS(histogram.window.value_at_percentile(99.)));
+    ImGui::TableNextColumn(); ImGui::Text("%.3lf", NS_TO_MS(histogram.window.value_at_percentile(99.9)));
+    ImGui::TableNextColumn(); ImGui::Text("%.3lf", NS_TO_MS(histogram.window_max()));
+
+}
+
+// Percentiles over the last HISTOGRAM_WINDOW_SIZE samples of each timer, in ms
+void D_Frame_Stats::show_imgui_table(){
+
+    if(ImGui::BeginTable("Frame Timings", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)){
+
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p90");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("p99.9");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableHeadersRow();
+
+        show_imgui_histogram_row("CPU Frame", cpu_frame);
+        show_imgui_histogram_row("Present", present_to_present);
+        for(u32 i = 0; i < NUM_FRAME_TIMERS; i++){
+            show_imgui_histogram_row(frame_timer_names[i], passes[i]);
+        }
+
+        ImGui::EndTable();
+    }
+
+}
+
+static void write_histogram_csv_row(FILE* file, const char* name, Histogram& histogram){
+
+    if(histogram.total_count == 0) return;
+
+    fprintf(file, "%s,%llu,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf,%.4lf\n", name, histogram.total_count,
+        NS_TO_MS(histogram.mean()),
+        NS_TO_MS(histogram.value_at_percentile(50.)),
+        NS_TO_MS(histogram.value_at_percentile(90.)),
+        NS_TO_MS(histogram.value_at_percentile(99.)),
+        NS_TO_MS(histogram.value_at_percentile(99.9)),
+        NS_TO_MS(histogram.min_value),
+        NS_TO_MS(histogram.max_value));
+
+}
+
+// Writes the lifetime percentiles of every timer, one row per timer
+void D_Frame_Stats::dump_csv(const char* filename){
+
+    FILE* file = fopen(filename, "w");
+    if(file == NULL){
+        DEBUG_LOG("Couldn't open frame stats csv file");
+        return;
+    }
+
+    fprintf(file, "timer,count,mean_ms,p50_ms,p90_ms,p99_ms,p99_9_ms,min_ms,max_ms\n");
+    write_histogram_csv_row(file, "CPU_Frame", cpu_frame.lifetime);
+    write_histogram_csv_row(file, "Present_To_Present", present_to_present.lifetime);
+    for(u32 i = 0; i < NUM_FRAME_TIMERS; i++){
+        write_histogram_csv_row(file, frame_timer_names[i], passes[i].lifetime);
+    }
+
+    fclose(file);
+
+}
+
+static void write_histogram_json(FILE* file, Histogram& histogram, u64 max_value){
+
+    fprintf(file, "{\"count\": %llu, \"mean_ms\": %.4lf, \"p50_ms\": %.4lf, \"p90_ms\": %.4lf, \"p99_ms\": %.4lf, \"p99_9_ms\": %.4lf, \"max_ms\": %.4lf}",
+        histogram.total_count,
+        NS_TO_MS(histogram.mean()),
+        NS_TO_MS(histogram.value_at_percentile(50.)),
+        NS_TO_MS(histogram.value_at_percentile(90.)),
+        NS_TO_MS(histogram.value_at_percentile(99.)),
+        NS_TO_MS(histogram.value_at_percentile(99.9)),
+        NS_TO_MS(max_value));
+
+}
+
+static void write_rolling_histogram_json(FILE* file, const char* name, Rolling_Histogram& histogram, bool last){
+
+    fprintf(file, "    \"%s\": {\n      \"lifetime\": ", name);
+    write_histogram_json(file, histogram.lifetime, histogram.lifetime.max_value);
+    fprintf(file, ",\n      \"window\": ");
+    write_histogram_json(file, histogram.window, histogram.window_max());
+    fprintf(file, "\n    }%s\n", last ? "" : ",");
+
+}
+
+// Writes the lifetime and last-window percentiles of every timer
+void D_Frame_Stats::dump_json(const char* filename){
+
+    FILE* file = fopen(filename, "w");
+    if(file == NULL){
+        DEBUG_LOG("Couldn't open frame stats json file");
+        return;
+    }
+
+    fprintf(file, "{\n  \"window_size\": %u,\n  \"timers\": {\n", HISTOGRAM_WINDOW_SIZE);
+    write_rolling_histogram_json(file, "CPU_Frame", cpu_frame, false);
+    write_rolling_histogram_json(file, "Present_To_Present", present_to_present, false);
+    for(u32 i = 0; i < NUM_FRAME_TIMERS; i++){
+        write_rolling_histogram_json(file, frame_timer_names[i], passes[i], i == NUM_FRAME_TIMERS - 1);
+    }
+    fprintf(file, "  }\n}\n");
+
+    fclose(file);
+
 }
 
 
@@ -568,10 +1062,10 @@ int D_Renderer::init(){
     // Set Shaders
     ////////////////////////////////////////
 
-    shaders.pbr_shader               = create_forward_render_pbr_shader();
-    shaders.deferred_g_buffer_shader = create_deferred_render_gbuffer_shader();
+    shaders.pbr_shader               = create_forward_render_pbr_shader(config.quantized_vertices);
+    shaders.deferred_g_buffer_shader = create_deferred_render_gbuffer_shader(config.quantized_vertices);
     shaders.deferred_shading_shader  = create_deferred_render_shading_shader();
-    shaders.shadow_map_shader        = create_shadow_mapping_shader();
+    shaders.shadow_map_shader        = create_shadow_mapping_shader(config.quantized_vertices);
     shaders.ssao_shader              = create_ssao_shader();
     shaders.post_processing_shader   = create_post_processing_shader();
     shaders.compute_rayt_shader      = create_compute_rayt_shader();
@@ -585,16 +1079,82 @@ int D_Renderer::init(){
 
 
     //////////////////////////
-    //  Upload our GLTF Model
+    //  Load the Scene
     //////////////////////////
 
     // NOTE: DONT NEGLECT BACKSIDE CULLING (:
 
-    renderer.models.alloc(sizeof(D_Model), 1);
-    D_Model& test_model = renderer.models.ptr[0];
+    // The scene file, or model_path on its own. --synthetic-scene places it once its size is known
+    Scene_File& scene_file = renderer.scene_file;
+    if(!config.scene_path || !scene_file_load(&scene_file, config.scene_path)){
 
-    load_gltf_model(test_model, "C:\\dev\\glTF-Sample-Models\\2.0\\Sponza\\glTF\\Sponza.gltf");
-    upload_model_to_gpu(upload_command_list, test_model);
+        scene_file_free(&scene_file);
+        scene_file_reserve(&scene_file, 1, 1);
+        u32 asset = scene_file_add_asset(&scene_file, config.model_path);
+
+        if(config.synthetic_copies == 0){
+            Scene_File_Placement& placement = scene_file.placements.ptr[scene_file.placement_count++];
+            placement = {asset, {0.f, 0.f, 0.f}, 0.f, 1.f};
+        }
+
+    }
+
+    u64 scene_load_start_time = os_now_ticks();
+    renderer.models.alloc(scene_file.asset_count);
+    load_models(renderer.models.ptr, scene_file.asset_paths.ptr, scene_file.asset_count);
+    renderer.scene_load_ms = os_ticks_to_ms((f64)(os_now_ticks() - scene_load_start_time));
+
+    // Stress test for CPU submission, copies of the model side by side. Written out so it can be loaded or edited as a scene.
+    // Only without a scene file, which places everything itself
+    if(config.synthetic_copies > 0 && scene_file.placement_count == 0){
+        f32 spacing = 2.f * get_scene_radius(&renderer.models.ptr[0]);
+        scene_file_add_grid(&scene_file, 0, config.synthetic_copies, spacing > 0.f ? spacing : 1.f);
+        if(!scene_file_write(&scene_file, "synthetic.ddxscene")){
+            OutputDebugString("Error (init): couldn't write synthetic.ddxscene\n");
+        }
+    }
+
+    char scene_string[256];
+    snprintf(scene_string, sizeof(scene_string), "Scene: %u models, %u placements, loaded in %.2fms\n", scene_file.asset_count, scene_file.placement_count,
+        renderer.scene_load_ms);
+    os_debug_print(scene_string);
+
+    // Each model's whole scene once per placement. A model placed several times is still drawn with one instanced draw per primitive
+    Span<Scene_Matrix> placement_matrices;
+    placement_matrices.alloc(scene_file.placement_count);
+    for(u32 model_index = 0; model_index < scene_file.asset_count; model_index++){
+
+        D_Model& model = renderer.models.ptr[model_index];
+
+        u32 copies = 0;
+        for(u32 i = 0; i < scene_file.placement_count; i++){
+            if(scene_file.placements.ptr[i].asset == model_index){
+                scene_file_placement_matrix(scene_file.placements.ptr[i], placement_matrices.ptr + copies++);
+            }
+        }
+        scene_replicate(&model.scene, placement_matrices.ptr, copies, (u32)model.meshes.nitems);
+
+        // Stress test for instanced drawing, copies of the whole scene side by side
+        if(config.instance_grid > 1){
+            f32 spacing = 2.f * get_scene_radius(&model);
+            scene_replicate_grid(&model.scene, config.instance_grid, spacing > 0.f ? spacing : 1.f, (u32)model.meshes.nitems);
+        }
+
+        scene_update_world_matrices(&model.scene);
+        model_update_bounds(model);
+
+    }
+    placement_matrices.d_free();
+
+    //////////////////////////
+    //  Upload the Models
+    //////////////////////////
+
+    init_geometry_buffer();
+    for(u64 i = 0; i < renderer.models.nitems; i++){
+        upload_model_to_gpu(upload_command_list, renderer.models.ptr[i]);
+    }
+    init_instance_buffer();
 
 
     //////////////////////////
@@ -761,8 +1321,13 @@ int D_Renderer::init(){
 
     upload_command_list->d_dx12_release();
 
-    // Sets up FPS Counter
-    tick_list = (double*)calloc(MAX_TICK_SAMPLES, sizeof(double));
+    // Sets up frame timing histograms
+    frame_stats.init();
+
+    // Per frame counter snapshots, the last COUNTER_RING_FILE_FRAMES frames are kept on disk
+    if(!counters_open_ring_file("counters.bin", COUNTER_RING_FILE_FRAMES)){
+        DEBUG_LOG("Couldn't open counters ring file");
+    }
 
     application_is_initialized = true;
 
@@ -804,7 +1369,14 @@ void D_Renderer::render_shadow_map(Command_List* command_list){
     Descriptor_Handle light_matrix_handle = resource_manager.load_dyanamic_frame_data((void*)&light_view_projection_matrix, sizeof(DirectX::XMMATRIX), 256);
     command_list->bind_handle(light_matrix_handle, binding_point_string_lookup("light_matrix"));
 
-    bind_and_draw_model(command_list, &renderer.models.ptr[0]);
+    // The orthographic projection above spreads 500 units over the shadow map's height
+    shadow_lod_view = {};
+    shadow_lod_view.pixel_scale     = textures.shadow_ds->height / 500.f;
+    shadow_lod_view.orthographic    = true;
+    shadow_lod_view.max_pixel_error = config.lod_pixel_error;
+
+    shadow_lod_stats = {};
+    bind_and_draw_models(command_list, shadow_lod_view, &shadow_lod_stats);
     
     // Transition shadow ds to Pixel Resource State
     command_list->transition_texture(textures.shadow_ds, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
@@ -835,7 +1407,7 @@ void D_Renderer::forward_render_pass(Command_List* command_list){
     Descriptor_Handle per_frame_data_handle = resource_manager.load_dyanamic_frame_data((void*)&this->per_frame_data, sizeof(Per_Frame_Data), 256);
     command_list->bind_handle(per_frame_data_handle, binding_point_string_lookup("per_frame_data"));
 
-    bind_and_draw_model(command_list, &renderer.models.ptr[0]);
+    bind_and_draw_models(command_list, camera_lod_view, &camera_lod_stats);
 }
 
 void D_Renderer::deferred_render_pass(Command_List* command_list){
@@ -848,6 +1420,8 @@ void D_Renderer::deferred_render_pass(Command_List* command_list){
     // Geometry Pass
     ///////////////////////
 
+    u64 gbuffer_start_time = frame_timer_now();
+
     // Transition Albedo Buffer
     if(textures.g_buffer_albedo->state != D3D12_RESOURCE_STATE_RENDER_TARGET)
         command_list->transition_texture(textures.g_buffer_albedo, D3D12_RESOURCE_STATE_RENDER_TARGET);
@@ -879,12 +1453,16 @@ void D_Renderer::deferred_render_pass(Command_List* command_list){
     // command_list->bind_constant_arguments(&view_projection_matrix, sizeof(DirectX::XMMATRIX) / 4, binding_point_string_lookup("view_projection_matrix"));
     // command_list->bind_constant_arguments(&camera.eye_position,    sizeof(DirectX::XMVECTOR),     binding_point_string_lookup("camera_position_buffer"));
 
-    bind_and_draw_model(command_list, &renderer.models.ptr[0]);
+    bind_and_draw_models(command_list, camera_lod_view, &camera_lod_stats);
+
+    frame_timer_end(TIMER_DEFERRED_GBUFFER, gbuffer_start_time);
 
     ///////////////////////
     // Shading Pass
     ///////////////////////
 
+    u64 shading_start_time = frame_timer_now();
+
     command_list->set_render_targets(1, &textures.main_render_target, NULL);
     command_list->set_viewport      (display.viewport);
     command_list->set_scissor_rect  (display.scissor_rect);
@@ -948,10 +1526,13 @@ void D_Renderer::deferred_render_pass(Command_List* command_list){
     command_list->bind_index_buffer (buffers.full_screen_quad_index_buffer);
     command_list->draw(6);
 
+    frame_timer_end(TIMER_DEFERRED_SHADING, shading_start_time);
+
     //////////////////////////////////////////////////////////
     // SSAO
     //////////////////////////////////////////////////////////
     {
+        u64 ssao_start_time = frame_timer_now();
 
         command_list->set_shader(shaders.ssao_shader);
 
@@ -1005,6 +1586,8 @@ void D_Renderer::deferred_render_pass(Command_List* command_list){
         command_list->bind_online_descriptor_heap_texture_table(&resource_manager, binding_point_string_lookup("texture_2d_uav_table"));
         command_list->dispatch((int)(textures.ssao_output_texture->width / 8), (int)(textures.ssao_output_texture->height / 4), 1);
 
+        frame_timer_end(TIMER_SSAO, ssao_start_time);
+
         // command_list->transition_texture(textures.main_render_target,           D3D12_RESOURCE_STATE_RENDER_TARGET);
     }
 
@@ -1012,6 +1595,8 @@ void D_Renderer::deferred_render_pass(Command_List* command_list){
     // Post Processing
     //////////////////////////////////////////////////////////
     {
+        u64 post_processing_start_time = frame_timer_now();
+
         command_list->set_shader(shaders.post_processing_shader);
 
         command_list->bind_handle(per_frame_data_handle, binding_point_string_lookup("per_frame_data"));
@@ -1038,6 +1623,8 @@ void D_Renderer::deferred_render_pass(Command_List* command_list){
         command_list->bind_online_descriptor_heap_texture_table(&resource_manager, binding_point_string_lookup("texture_2d_table"));
         command_list->bind_online_descriptor_heap_texture_table(&resource_manager, binding_point_string_lookup("texture_2d_uav_table"));
         command_list->dispatch((int)(display.display_width / 8), (int)(display.display_height / 4), 1);
+
+        frame_timer_end(TIMER_POST_PROCESSING, post_processing_start_time);
     }
 
 }
@@ -1081,14 +1668,11 @@ void D_Renderer::render(){
 
     PROFILED_SCOPE("CPU_FRAME");
 
-    // TODO: Rewrite all of this !!!
-    static std::chrono::high_resolution_clock::time_point tp1;
-    std::chrono::high_resolution_clock::time_point tp2 = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> frame_time = std::chrono::duration_cast<std::chrono::duration<double>>(tp2 - tp1);
-    tp1 = tp2;
-    double frame_ms = frame_time.count() * 1000.;
-    double avg_frame_ms = avg_ms_per_tick(frame_ms);
-    double fps = 1000. / avg_frame_ms;
+    u64 cpu_frame_start_time = frame_timer_now();
+
+    // Mean frame time over the histogram window, used for the FPS readout
+    double avg_frame_ms = NS_TO_MS(frame_stats.present_to_present.window.mean());
+    double fps = avg_frame_ms > 0. ? 1000. / avg_frame_ms : 0.;
 
     Command_List* command_list = direct_command_lists[current_backbuffer_index];
     
@@ -1122,6 +1706,33 @@ void D_Renderer::render(){
     DirectX::XMMATRIX projection_matrix = DirectX::XMMatrixPerspectiveFovRH(DirectX::XMConvertToRadians(camera.fov), (f32) config.render_width / (f32) config.render_height, 0.01f, 2500000000.0f);
     per_frame_data.view_projection_matrix = DirectX::XMMatrixMultiply(view_matrix, projection_matrix);
     DirectX::XMStoreFloat4(&per_frame_data.camera_pos, camera.eye_position);
+
+    // Nothing moves the nodes yet, so after the first frame this only checks the dirty flags
+    scene_nodes_updated = 0;
+    meshlet_cull_stats  = {};
+    for(u64 i = 0; i < models.nitems; i++){
+
+        scene_nodes_updated += scene_update_world_matrices(&models.ptr[i].scene);
+
+        upload_instance_data(command_list, &models.ptr[i]);
+
+        if(config.meshlet_cull_stats){
+            cull_model_meshlets(&models.ptr[i], per_frame_data.view_projection_matrix, camera.eye_position, &meshlet_cull_stats);
+        }
+
+    }
+
+    // Vertex shaders read it, one barrier after every model's copies. Nothing to do on frames nothing moved
+    if(instance_buffer){
+        command_list->transition_buffer(instance_buffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    }
+
+    camera_lod_view = {};
+    DirectX::XMStoreFloat3((DirectX::XMFLOAT3*)camera_lod_view.position, camera.eye_position);
+    camera_lod_view.pixel_scale     = config.render_height / (2.f * tanf(DirectX::XMConvertToRadians(camera.fov) * 0.5f));
+    camera_lod_view.orthographic    = false;
+    camera_lod_view.max_pixel_error = config.lod_pixel_error;
+    camera_lod_stats = {};
     
     ////////////////////////////////////
     /// Update Render To Display Scale
@@ -1132,7 +1743,9 @@ void D_Renderer::render(){
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // Shadow Map
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    u64 shadow_map_start_time = frame_timer_now();
     render_shadow_map(command_list);
+    frame_timer_end(TIMER_SHADOW_MAP, shadow_map_start_time);
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // Physically based shading
@@ -1161,15 +1774,23 @@ void D_Renderer::render(){
     // Choose render passed based on config. Set by IMGUI below
     switch(config.render_pass){
         case D_Render_Passes::FORWARD_SHADING:
+        {
+            u64 forward_start_time = frame_timer_now();
             forward_render_pass(command_list);
+            frame_timer_end(TIMER_FORWARD_SHADING, forward_start_time);
+        }
             break;
         case D_Render_Passes::DEFERRED_SHADING:
             deferred_render_pass(command_list);
             command_list->set_render_targets(1, &textures.main_output_target, nullptr);
             break;
         case D_Render_Passes::RAY_TRACING:
+        {
+            u64 ray_tracing_start_time = frame_timer_now();
             compute_rayt_pass(command_list);
+            frame_timer_end(TIMER_RAY_TRACING, ray_tracing_start_time);
             command_list->set_render_targets(1, &textures.main_output_target, nullptr);
+        }
             break;
     }
 
@@ -1191,6 +1812,7 @@ void D_Renderer::render(){
     // command_list->transition_texture(textures.main_render_target,           D3D12_RESOURCE_STATE_RENDER_TARGET);
 
     // Create IMGUI window
+    u64 imgui_start_time = frame_timer_now();
     ImGui::Begin("Info");
     ImGui::Text("Controls:");
     ImGui::Text("Mouse - Look");
@@ -1199,9 +1821,73 @@ void D_Renderer::render(){
     ImGui::Text("Space Bar - Full Screen Toggle");
     ImGui::Text("FPS: %.3lf", fps);
     ImGui::Text("Frame MS: %.2lf", avg_frame_ms);
+    frame_stats.show_imgui_table();
+    if(ImGui::CollapsingHeader("Model Load")){
+        ImGui::Text("Scene: %u models, %u placements, loaded in parallel in %.2lf ms", scene_file.asset_count, scene_file.placement_count, scene_load_ms);
+        for(u64 model_index = 0; model_index < models.nitems; model_index++){
+            D_Model& model = models.ptr[model_index];
+            ImGuiTreeNodeFlags tree_flags = models.nitems == 1 ? ImGuiTreeNodeFlags_DefaultOpen : ImGuiTreeNodeFlags_None;
+            if(!ImGui::TreeNodeEx((void*)(u_ptr)model_index, tree_flags, "%s", scene_file.asset_paths.ptr[model_index])){
+                continue;
+            }
+            D_Model_Load_Timings& timings = model.load_timings;
+            ImGui::Text("Parse: %.2lf ms", timings.parse_ms);
+            ImGui::Text("Mesh Decode: %.2lf ms (%u primitives, %u workers)", timings.mesh_decode_ms, timings.primitive_count, timings.worker_count);
+            ImGui::Text("Materials: %.2lf ms (%u images)", timings.materials_ms, timings.image_count);
+            ImGui::Text("Textures: %u for %u material slots", timings.texture_count, timings.texture_slot_count);
+            ImGui::Text("Model Memory: %.2lf MB (one arena)", (f64)timings.arena_bytes / (1024. * 1024.));
+            ImGui::Text("Buffers: %.2lf MB (%s)", (f64)timings.buffer_bytes / (1024. * 1024.), timings.buffers_mapped ? "mapped" : "copied");
+            ImGui::Text("Vertex Cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", vertex_cache_acmr(timings.mesh_optimize.before), vertex_cache_acmr(timings.mesh_optimize.after),
+                vertex_cache_atvr(timings.mesh_optimize.before), vertex_cache_atvr(timings.mesh_optimize.after));
+            // Packages are welded when they're cooked
+            if(timings.mesh_weld.vertex_count){
+                ImGui::Text("Vertex Welding: %llu -> %llu vertices (-%.1f%%)", timings.mesh_weld.vertex_count, timings.mesh_weld.welded_vertex_count,
+                    mesh_weld_reduction(timings.mesh_weld) * 100.f);
+            }
+            const Mesh_Bounds& model_bounds = model.bounds;
+            ImGui::Text("Scene Bounds: (%.2f, %.2f, %.2f) to (%.2f, %.2f, %.2f), radius %.2f", model_bounds.min[0], model_bounds.min[1], model_bounds.min[2],
+                model_bounds.max[0], model_bounds.max[1], model_bounds.max[2], model_bounds.radius);
+            if(config.quantized_vertices){
+                D_Vertex_Quantization_Error& error = model.quantization_error;
+                ImGui::Text("Quantization Error: position %.5f, normal %.3f deg, tangent %.3f deg", error.max_position_error, error.max_normal_error, error.max_tangent_error);
+            }
+            ImGui::Text("Nodes: %u, %llu mesh instances", model.scene.node_count, (u64)model.scene.instance_nodes.nitems);
+            ImGui::Text("Total: %.2lf ms", timings.total_ms);
+            ImGui::TreePop();
+        }
+        // How full the shared vertex and index buffers are, and how many free ranges they're split into
+        Offset_Allocator_Report vertex_report   = offset_allocator_report(&geometry_buffer.vertices);
+        Offset_Allocator_Report index_16_report = offset_allocator_report(&geometry_buffer.indices_16);
+        Offset_Allocator_Report index_32_report = offset_allocator_report(&geometry_buffer.indices_32);
+        ImGui::Text("Geometry Buffer: %u / %u vertices, %u / %u u16 indices, %u / %u u32 indices, %u free ranges", vertex_report.allocated_size, geometry_buffer.vertices.size,
+            index_16_report.allocated_size, geometry_buffer.indices_16.size, index_32_report.allocated_size, geometry_buffer.indices_32.size,
+            vertex_report.free_range_count + index_16_report.free_range_count + index_32_report.free_range_count);
+        if(config.quantized_vertices){
+            ImGui::Text("Vertices: quantized, %u + %u bytes", (u32)sizeof(Vertex_Quantized_Position), (u32)sizeof(Vertex_Quantized_Attributes));
+        } else {
+            ImGui::Text("Vertices: float, %u + %u bytes", (u32)sizeof(Vertex_Position), (u32)sizeof(Vertex_Normal_Color_Texturecoord_Tangent));
+        }
+        if(config.meshlet_cull_stats){
+            ImGui::Text("Meshlets: %llu, frustum culled %.1f%%, backface culled %.1f%% of triangles", meshlet_cull_stats.meshlet_count,
+                100.f * meshlet_culled_ratio(meshlet_cull_stats.frustum_culled_triangles, meshlet_cull_stats),
+                100.f * meshlet_culled_ratio(meshlet_cull_stats.cone_culled_triangles, meshlet_cull_stats));
+        }
+        ImGui::Text("LOD Triangles: camera %llu of %llu, shadow %llu of %llu", camera_lod_stats.drawn_triangles, camera_lod_stats.full_triangles,
+            shadow_lod_stats.drawn_triangles, shadow_lod_stats.full_triangles);
+        ImGui::Text("World Matrices Updated: %u", scene_nodes_updated);
+        ImGui::Text("Time To First Frame: %.2lf ms", frame_stats.time_to_first_frame_ms);
+    }
+    if(ImGui::CollapsingHeader("Counters (last frame)")){
+        Counter_Snapshot* counters = counters_last_frame();
+        for(u32 i = 0; i < counter_count(); i++){
+            ImGui::Text("%s: %llu", counter_name(i), counters->values[i]);
+        }
+    }
     ImGui::SliderFloat3("Light Position", &this->per_frame_data.light_position.x, -10., 10);
     ImGui::DragFloat3("Light Color", &this->per_frame_data.light_color.x);
     ImGui::SliderFloat("Camera FOV", &this->camera.fov, 35., 120.);
+    ImGui::SliderFloat("LOD Pixel Error (0 = off)", &config.lod_pixel_error, 0., 8.);
+    ImGui::Checkbox("CPU Meshlet Culling Stats", &config.meshlet_cull_stats);
     // Combo box for choosing which render pass to use
     // Copied from imgui_demo.cpp
     if (ImGui::BeginCombo("Render Pass", render_pass_names[config.render_pass], /*flags*/ 0))
@@ -1219,6 +1905,7 @@ void D_Renderer::render(){
         ImGui::EndCombo();
     }
     ImGui::Checkbox("Demo Window?", &config.imgui_demo);
+    ImGui::SliderInt("Frame Rate Limit (0 = off)", &config.frame_rate_limit, 0, 240);
 
     // Render a texture
     u16 ssao_output_index = command_list->bind_texture(textures.main_render_target, &resource_manager, binding_point_string_lookup("ssao_output"));
@@ -1231,9 +1918,11 @@ void D_Renderer::render(){
 
     // Render ImGui on top of everything
     ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), command_list->d3d12_command_list.Get());
+    frame_timer_end(TIMER_IMGUI, imgui_start_time);
 
 
     // Prepare screen buffer for copy destination
+    u64 submit_start_time = frame_timer_now();
     command_list->copy_texture(textures.main_output_target, textures.rt[current_backbuffer_index]);
 
     // Transition RT to presentation state
@@ -1242,12 +1931,54 @@ void D_Renderer::render(){
     // Execute Command List
     command_list->close();
     execute_command_list(command_list);
+    frame_timer_end(TIMER_SUBMIT, submit_start_time);
+
+    frame_timer_record(frame_stats.cpu_frame, cpu_frame_start_time, frame_timer_now());
 
     } // CPU_FRAME profile scope
     present(using_v_sync);
+
+    u64 present_time = frame_timer_now();
+    if(frame_stats.time_to_first_frame_ms == 0){
+        frame_stats.time_to_first_frame_ms = os_ticks_to_ms((f64)(present_time - frame_stats.startup_time));
+
+        char time_string[512];
+        snprintf(time_string, sizeof(time_string), "Time to first frame: %.2fms (%s)\n", frame_stats.time_to_first_frame_ms, config.scene_path ? config.scene_path : config.model_path);
+        os_debug_print(time_string);
+    }
+    if(frame_stats.last_present_time != 0){
+        frame_timer_record(frame_stats.present_to_present, frame_stats.last_present_time, present_time);
+    }
+    frame_stats.last_present_time = present_time;
+
+    counters_end_frame();
     
 }
 
+/*
+*   Sleeps until the next frame's start time when config.frame_rate_limit is set.
+*   Deadlines advance by a fixed period so frame pacing doesn't drift, unless we've
+*   fallen more than a frame behind, then the schedule restarts from now.
+*/
+void D_Renderer::limit_frame_rate(){
+
+    if(config.frame_rate_limit <= 0){
+        next_frame_ticks = 0;
+        return;
+    }
+
+    u64 frame_period = os_ticks_per_second() / (u64)config.frame_rate_limit;
+    u64 now          = os_now_ticks();
+
+    if(next_frame_ticks == 0 || now > next_frame_ticks + frame_period){
+        next_frame_ticks = now;
+    }
+
+    next_frame_ticks += frame_period;
+    os_sleep_until(next_frame_ticks);
+
+}
+
 /*
 *   Window event callback
 */
@@ -1463,7 +2194,43 @@ WinMain(HINSTANCE hInstance,
     *   docs.microsoft.com : Set the DPI awareness for the current thread to the provided value. 
     */
     SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
-    timeBeginPeriod(1);
+
+    // Calibrate the tick timer before anything is timed
+    os_timer_init();
+    renderer.frame_stats.startup_time = os_now_ticks();
+
+    // Optional flags, then an optional model to load instead of Sponza, e.g. a package from ddx_cook, or a .ddxscene
+    const char* quantized_vertices_flag = "--quantized-vertices";
+    const char* instance_grid_flag      = "--instance-grid";
+    const char* synthetic_scene_flag    = "--synthetic-scene";
+    const char* meshlet_cull_stats_flag = "--meshlet-cull-stats";
+    while(lpCmdLine && strncmp(lpCmdLine, "--", 2) == 0){
+        if(strncmp(lpCmdLine, quantized_vertices_flag, strlen(quantized_vertices_flag)) == 0){
+            renderer.config.quantized_vertices = true;
+            lpCmdLine += strlen(quantized_vertices_flag);
+        } else if(strncmp(lpCmdLine, instance_grid_flag, strlen(instance_grid_flag)) == 0){
+            renderer.config.instance_grid      = (u32)strtoul(lpCmdLine + strlen(instance_grid_flag), &lpCmdLine, 10);
+        } else if(strncmp(lpCmdLine, synthetic_scene_flag, strlen(synthetic_scene_flag)) == 0){
+            renderer.config.synthetic_copies   = (u32)strtoul(lpCmdLine + strlen(synthetic_scene_flag), &lpCmdLine, 10);
+        } else if(strncmp(lpCmdLine, meshlet_cull_stats_flag, strlen(meshlet_cull_stats_flag)) == 0){
+            renderer.config.meshlet_cull_stats = true;
+            lpCmdLine += strlen(meshlet_cull_stats_flag);
+        } else {
+            break;
+        }
+        while(*lpCmdLine == ' ') lpCmdLine++;
+    }
+    if(lpCmdLine && lpCmdLine[0]){
+        u64 length = strlen(lpCmdLine);
+        if(length > 9 && strcmp(lpCmdLine + length - 9, ".ddxscene") == 0){
+            renderer.config.scene_path = lpCmdLine;
+        } else {
+            renderer.config.model_path = lpCmdLine;
+        }
+    }
+
+    // Worker threads for asset loading
+    jobs_init();
 
     // Set up memory arenas
     per_frame_arena = d_std::make_arena(); 
@@ -1547,6 +2314,7 @@ WinMain(HINSTANCE hInstance,
                 renderer.render();
                 per_frame_arena->reset();
                 d_dx12_arena->reset();
+                renderer.limit_frame_rate();
             }
         }
 
@@ -1562,6 +2330,8 @@ WinMain(HINSTANCE hInstance,
     *   frees any other resources that the thread maintains, and forces all RPC connections on the thread to close.
     */
 
+    jobs_shutdown();
+
     CoUninitialize();
 
     return 0;
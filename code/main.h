@@ -11,10 +11,32 @@ struct Vertex_Position_Normal_Tangent_Color_Texturecoord {
     DirectX::XMFLOAT4 tangent;
 };
 
+// Also the mesh position stream, vertex buffer slot 0
 struct Vertex_Position {
     DirectX::XMFLOAT3 position;
 };
 
+// Mesh attribute stream, vertex buffer slot 1. Depth only passes never bind it
+struct Vertex_Normal_Color_Texturecoord_Tangent {
+    DirectX::XMFLOAT3 normal;
+    DirectX::XMFLOAT3 color;
+    DirectX::XMFLOAT2 texture_coordinates;
+    DirectX::XMFLOAT4 tangent;
+};
+
+/*
+*   Compact vertex streams, 16 bytes a vertex instead of 60. Encoded by quantize_mesh_vertices, decoded in the
+*   vertex shaders when they're compiled with QUANTIZED_VERTICES. Color is dropped, no pass reads it.
+*/
+struct Vertex_Quantized_Position {
+    u16 position[4];             // R16G16B16A16_UNORM, within the mesh's bounds, w unused
+};
+struct Vertex_Quantized_Attributes {
+    u32 normal_tangent;          // R10G10B10A2_UNORM, octahedral normal, tangent angle around the normal, handedness
+    u16 texture_coordinates[2];  // R16G16_FLOAT
+};
+static_assert(sizeof(Vertex_Quantized_Position) == 8 && sizeof(Vertex_Quantized_Attributes) == 8, "Quantized vertex streams have to match their input layout");
+
 /*
 struct Per_Frame_Data {
     float light_pos[3] = {0., -2., -1.};    
@@ -0,0 +1,212 @@
+#include "mesh_bounds.h"
+#include "string.h"
+#include "math.h"
+#include "float.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define MESH_BOUNDS_SSE
+#include <xmmintrin.h>
+#endif
+
+Mesh_Bounds mesh_bounds_empty(){
+
+    Mesh_Bounds bounds;
+    for(u32 k = 0; k < 3; k++){
+        bounds.min[k]    =  FLT_MAX;
+        bounds.max[k]    = -FLT_MAX;
+        bounds.center[k] = 0.f;
+    }
+    bounds.radius = -1.f;
+    return bounds;
+
+}
+
+#ifdef MESH_BOUNDS_SSE
+
+static f32 bounds_horizontal_min(__m128 v){
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static f32 bounds_horizontal_max(__m128 v){
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+// Four positions as x, y and z vectors. Each load reads a float past the position, so the caller keeps them in range
+static inline void bounds_load_4(const u8* positions, u32 position_stride, __m128* x, __m128* y, __m128* z){
+    __m128 p0 = _mm_loadu_ps((const f32*)(positions));
+    __m128 p1 = _mm_loadu_ps((const f32*)(positions + position_stride));
+    __m128 p2 = _mm_loadu_ps((const f32*)(positions + position_stride * 2));
+    __m128 p3 = _mm_loadu_ps((const f32*)(positions + position_stride * 3));
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+    *x = p0;
+    *y = p1;
+    *z = p2;
+}
+
+#endif
+
+void mesh_bounds_compute(const u8* positions, u32 position_stride, u32 vertex_count, Mesh_Bounds* bounds){
+
+    *bounds = mesh_bounds_empty();
+    if(vertex_count == 0){
+        return;
+    }
+
+    u32 vertex = 0;
+
+#ifdef MESH_BOUNDS_SSE
+
+    // Groups of four whose extra float still lands inside the positions, at most the last group or two are left out
+    u64 size       = (u64)vertex_count * position_stride;
+    u32 simd_count = vertex_count & ~3u;
+    while(simd_count > 0 && (u64)(simd_count - 1) * position_stride + 4 * sizeof(f32) > size){
+        simd_count -= 4;
+    }
+
+    __m128 min_x = _mm_set1_ps(FLT_MAX),  min_y = min_x, min_z = min_x;
+    __m128 max_x = _mm_set1_ps(-FLT_MAX), max_y = max_x, max_z = max_x;
+    for(; vertex < simd_count; vertex += 4){
+        __m128 x, y, z;
+        bounds_load_4(positions + (u64)vertex * position_stride, position_stride, &x, &y, &z);
+        min_x = _mm_min_ps(min_x, x); max_x = _mm_max_ps(max_x, x);
+        min_y = _mm_min_ps(min_y, y); max_y = _mm_max_ps(max_y, y);
+        min_z = _mm_min_ps(min_z, z); max_z = _mm_max_ps(max_z, z);
+    }
+    bounds->min[0] = bounds_horizontal_min(min_x); bounds->max[0] = bounds_horizontal_max(max_x);
+    bounds->min[1] = bounds_horizontal_min(min_y); bounds->max[1] = bounds_horizontal_max(max_y);
+    bounds->min[2] = bounds_horizontal_min(min_z); bounds->max[2] = bounds_horizontal_max(max_z);
+
+#endif
+
+    for(; vertex < vertex_count; vertex++){
+        const f32* position = (const f32*)(positions + (u64)vertex * position_stride);
+        for(u32 k = 0; k < 3; k++){
+            bounds->min[k] = position[k] < bounds->min[k] ? position[k] : bounds->min[k];
+            bounds->max[k] = position[k] > bounds->max[k] ? position[k] : bounds->max[k];
+        }
+    }
+
+    for(u32 k = 0; k < 3; k++){
+        bounds->center[k] = (bounds->min[k] + bounds->max[k]) * 0.5f;
+    }
+
+    // Second pass for the farthest vertex from the center
+    f32 max_squared = 0.f;
+    vertex = 0;
+
+#ifdef MESH_BOUNDS_SSE
+
+    __m128 center_x = _mm_set1_ps(bounds->center[0]);
+    __m128 center_y = _mm_set1_ps(bounds->center[1]);
+    __m128 center_z = _mm_set1_ps(bounds->center[2]);
+    __m128 max_distance = _mm_setzero_ps();
+    for(; vertex < simd_count; vertex += 4){
+        __m128 x, y, z;
+        bounds_load_4(positions + (u64)vertex * position_stride, position_stride, &x, &y, &z);
+        x = _mm_sub_ps(x, center_x);
+        y = _mm_sub_ps(y, center_y);
+        z = _mm_sub_ps(z, center_z);
+        __m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        max_distance = _mm_max_ps(max_distance, squared);
+    }
+    max_squared = bounds_horizontal_max(max_distance);
+
+#endif
+
+    for(; vertex < vertex_count; vertex++){
+        const f32* position = (const f32*)(positions + (u64)vertex * position_stride);
+        f32 d[3] = {position[0] - bounds->center[0], position[1] - bounds->center[1], position[2] - bounds->center[2]};
+        f32 squared = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        max_squared = squared > max_squared ? squared : max_squared;
+    }
+
+    bounds->radius = sqrtf(max_squared);
+
+}
+
+void mesh_bounds_merge(Mesh_Bounds* bounds, const Mesh_Bounds& other){
+
+    if(other.radius < 0.f){
+        return;
+    }
+    if(bounds->radius < 0.f){
+        *bounds = other;
+        return;
+    }
+
+    for(u32 k = 0; k < 3; k++){
+        bounds->min[k] = other.min[k] < bounds->min[k] ? other.min[k] : bounds->min[k];
+        bounds->max[k] = other.max[k] > bounds->max[k] ? other.max[k] : bounds->max[k];
+    }
+
+    // Smallest sphere around both spheres
+    f32 d[3] = {other.center[0] - bounds->center[0], other.center[1] - bounds->center[1], other.center[2] - bounds->center[2]};
+    f32 distance = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    if(distance + other.radius <= bounds->radius){
+        // Already inside
+    } else if(distance + bounds->radius <= other.radius){
+        memcpy(bounds->center, other.center, sizeof(bounds->center));
+        bounds->radius = other.radius;
+    } else {
+        f32 radius = (distance + bounds->radius + other.radius) * 0.5f;
+        f32 t = (radius - bounds->radius) / distance;
+        for(u32 k = 0; k < 3; k++){
+            bounds->center[k] += d[k] * t;
+        }
+        bounds->radius = radius;
+    }
+
+    // The sphere around the merged box can be the smaller one
+    f32 half_extent[3];
+    for(u32 k = 0; k < 3; k++){
+        half_extent[k] = (bounds->max[k] - bounds->min[k]) * 0.5f;
+    }
+    f32 box_radius = sqrtf(half_extent[0] * half_extent[0] + half_extent[1] * half_extent[1] + half_extent[2] * half_extent[2]);
+    if(box_radius < bounds->radius){
+        for(u32 k = 0; k < 3; k++){
+            bounds->center[k] = bounds->min[k] + half_extent[k];
+        }
+        bounds->radius = box_radius;
+    }
+
+}
+
+void mesh_bounds_transform(const Mesh_Bounds& bounds, const f32* matrix, Mesh_Bounds* result){
+
+    if(bounds.radius < 0.f){
+        *result = bounds;
+        return;
+    }
+
+    // The box's center moves with the matrix, its half extent along each axis is the sum of the rows' reach
+    f32 box_center[3];
+    f32 half_extent[3];
+    for(u32 k = 0; k < 3; k++){
+        box_center[k]  = (bounds.min[k] + bounds.max[k]) * 0.5f;
+        half_extent[k] = (bounds.max[k] - bounds.min[k]) * 0.5f;
+    }
+
+    f32 max_scale_squared = 0.f;
+    for(u32 row = 0; row < 3; row++){
+        const f32* r = matrix + row * 4;
+        f32 squared = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        max_scale_squared = squared > max_scale_squared ? squared : max_scale_squared;
+    }
+
+    Mesh_Bounds moved;
+    for(u32 column = 0; column < 3; column++){
+        f32 center = box_center[0] * matrix[column] + box_center[1] * matrix[4 + column] + box_center[2] * matrix[8 + column] + matrix[12 + column];
+        f32 extent = half_extent[0] * fabsf(matrix[column]) + half_extent[1] * fabsf(matrix[4 + column]) + half_extent[2] * fabsf(matrix[8 + column]);
+        moved.min[column]    = center - extent;
+        moved.max[column]    = center + extent;
+        moved.center[column] = bounds.center[0] * matrix[column] + bounds.center[1] * matrix[4 + column] + bounds.center[2] * matrix[8 + column] + matrix[12 + column];
+    }
+    moved.radius = bounds.radius * sqrtf(max_scale_squared);
+
+    *result = moved;
+
+}
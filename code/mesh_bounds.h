@@ -0,0 +1,36 @@
+#ifndef _MESH_BOUNDS
+#define _MESH_BOUNDS
+
+#include "d_types.h"
+
+/*
+*   Axis aligned box and bounding sphere of a primitive, mesh or model
+*
+*   load_gltf_model and ddx_cook compute them per primitive from the vertex positions, with SSE four vertices
+*   at a time. Meshes merge their primitives' bounds and models merge their instances', see model_update_bounds.
+*   Packages store all three so loading them doesn't touch the vertices.
+*
+*   The sphere of a primitive is centered on its box and reaches the farthest vertex. Merged spheres enclose
+*   the spheres they were merged from, or the merged box when that's smaller.
+*/
+
+struct Mesh_Bounds {
+    f32 min[3];
+    f32 max[3];
+    f32 center[3];
+    f32 radius;     // Negative when the bounds are empty
+};
+
+// Bounds with nothing in them, for merging into
+Mesh_Bounds mesh_bounds_empty();
+
+// Bounds of vertex_count positions, 3 floats each, position_stride bytes apart. Empty for no vertices
+void mesh_bounds_compute(const u8* positions, u32 position_stride, u32 vertex_count, Mesh_Bounds* bounds);
+
+// Grows bounds to also hold other, empty bounds change nothing
+void mesh_bounds_merge(Mesh_Bounds* bounds, const Mesh_Bounds& other);
+
+// Bounds around the bounds moved by a row major matrix that transforms row vectors, like Scene_Matrix
+void mesh_bounds_transform(const Mesh_Bounds& bounds, const f32* matrix, Mesh_Bounds* result);
+
+#endif // _MESH_BOUNDS
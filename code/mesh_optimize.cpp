@@ -0,0 +1,433 @@
+#include "mesh_optimize.h"
+#include "stdlib.h" // qsort
+#include "string.h"
+#include "math.h"
+
+#define NO_VERTEX 0xFFFFFFFF
+
+/////////////////////////////////
+// Vertex cache simulation
+/////////////////////////////////
+
+// FIFO cache. A vertex is cached while fewer than cache_size misses have happened since it went in
+struct Cache_Simulation {
+    u32* inserted_at;  // Miss count right after the vertex went in, 0 if it never has
+    u32  misses;
+    u32  cache_size;
+};
+
+static u32 cache_simulation_triangle(Cache_Simulation* simulation, const u16* triangle){
+
+    u32 misses = 0;
+    for(u32 corner = 0; corner < 3; corner++){
+        u32 vertex = triangle[corner];
+        if(simulation->inserted_at[vertex] == 0 || simulation->misses - simulation->inserted_at[vertex] >= simulation->cache_size){
+            simulation->misses++;
+            simulation->inserted_at[vertex] = simulation->misses;
+            misses++;
+        }
+    }
+    return misses;
+
+}
+
+// Everything cached so far is evicted
+static void cache_simulation_flush(Cache_Simulation* simulation){
+    simulation->misses += simulation->cache_size;
+}
+
+Vertex_Cache_Stats vertex_cache_stats(const u16* indices, u32 index_count, u32 vertex_count, u32 cache_size){
+
+    Vertex_Cache_Stats stats = {};
+    stats.triangle_count = index_count / 3;
+
+    Cache_Simulation simulation = {(u32*)calloc(vertex_count ? vertex_count : 1, sizeof(u32)), 0, cache_size};
+
+    for(u32 triangle = 0; triangle < stats.triangle_count; triangle++){
+        stats.transformed_count += cache_simulation_triangle(&simulation, indices + triangle * 3);
+    }
+
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+        stats.vertex_count += simulation.inserted_at[vertex] != 0;
+    }
+
+    free(simulation.inserted_at);
+
+    return stats;
+
+}
+
+/////////////////////////////////
+// Tipsify
+/////////////////////////////////
+
+// The most recent dead end vertex that still has triangles, otherwise the next one in index order
+static u32 tipsify_skip_dead_end(const u32* live_triangles, const u32* dead_ends, u32* dead_end_count, u32 vertex_count, u32* cursor){
+
+    while(*dead_end_count){
+        u32 vertex = dead_ends[--*dead_end_count];
+        if(live_triangles[vertex]){
+            return vertex;
+        }
+    }
+
+    for(; *cursor < vertex_count; (*cursor)++){
+        if(live_triangles[*cursor]){
+            return *cursor;
+        }
+    }
+
+    return NO_VERTEX;
+
+}
+
+// Fans around one vertex at a time, emitting all its triangles, then moves to the neighbour that's still in the cache and gets the most out of it
+static void tipsify(const u16* indices, u32 index_count, u32 vertex_count, u32 cache_size, u32* triangle_order){
+
+    u32 triangle_count = index_count / 3;
+
+    // Triangles using each vertex
+    u32* live_triangles    = (u32*)calloc(vertex_count, sizeof(u32));
+    u32* adjacency_offsets = (u32*)malloc(((u64)vertex_count + 1) * sizeof(u32));
+    u32* adjacency         = (u32*)malloc((u64)index_count * sizeof(u32));
+    u32* cache_time        = (u32*)calloc(vertex_count, sizeof(u32));
+
+    for(u32 i = 0; i < index_count; i++){
+        live_triangles[indices[i]]++;
+    }
+
+    adjacency_offsets[0] = 0;
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+        adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_triangles[vertex];
+        cache_time[vertex]            = adjacency_offsets[vertex];
+    }
+
+    // cache_time is the fill cursor until the timestamps start
+    for(u32 i = 0; i < index_count; i++){
+        adjacency[cache_time[indices[i]]++] = i / 3;
+    }
+    memset(cache_time, 0, (u64)vertex_count * sizeof(u32));
+
+    bool* emitted  = (bool*)calloc(triangle_count, sizeof(bool));
+    u32* dead_ends  = (u32*)malloc((u64)index_count * sizeof(u32));
+    u32* candidates = (u32*)malloc((u64)index_count * sizeof(u32));
+
+    u32 dead_end_count = 0;
+    u32 order_count    = 0;
+    u32 cursor         = 0;
+    u32 time           = cache_size + 1; // Every vertex starts out of the cache
+
+    u32 fan_vertex = tipsify_skip_dead_end(live_triangles, dead_ends, &dead_end_count, vertex_count, &cursor);
+
+    while(fan_vertex != NO_VERTEX){
+
+        u32 candidate_count = 0;
+
+        for(u32 i = adjacency_offsets[fan_vertex]; i < adjacency_offsets[fan_vertex + 1]; i++){
+
+            u32 triangle = adjacency[i];
+            if(emitted[triangle]){
+                continue;
+            }
+
+            emitted[triangle] = true;
+            triangle_order[order_count++] = triangle;
+
+            for(u32 corner = 0; corner < 3; corner++){
+                u32 vertex = indices[triangle * 3 + corner];
+                dead_ends[dead_end_count++]   = vertex;
+                candidates[candidate_count++] = vertex;
+                live_triangles[vertex]--;
+                if(time - cache_time[vertex] > cache_size){
+                    cache_time[vertex] = time;
+                    time++;
+                }
+            }
+
+        }
+
+        // Prefer the candidate that entered the cache earliest, as long as its remaining triangles won't push it out
+        u32 next_vertex = NO_VERTEX;
+        s64 best_priority = -1;
+        for(u32 i = 0; i < candidate_count; i++){
+            u32 vertex = candidates[i];
+            if(live_triangles[vertex] == 0){
+                continue;
+            }
+            s64 priority = 0;
+            if(time - cache_time[vertex] + 2 * live_triangles[vertex] <= cache_size){
+                priority = time - cache_time[vertex];
+            }
+            if(priority > best_priority){
+                best_priority = priority;
+                next_vertex   = vertex;
+            }
+        }
+
+        if(next_vertex == NO_VERTEX){
+            next_vertex = tipsify_skip_dead_end(live_triangles, dead_ends, &dead_end_count, vertex_count, &cursor);
+        }
+
+        fan_vertex = next_vertex;
+
+    }
+
+    free(live_triangles);
+    free(adjacency_offsets);
+    free(adjacency);
+    free(cache_time);
+    free(emitted);
+    free(dead_ends);
+    free(candidates);
+
+}
+
+/////////////////////////////////
+// Overdraw
+/////////////////////////////////
+
+struct Overdraw_Cluster {
+    f32 sort_key;
+    u32 first_triangle;
+    u32 triangle_count;
+};
+
+static int overdraw_compare_clusters(const void* a, const void* b){
+
+    const Overdraw_Cluster* cluster_a = (const Overdraw_Cluster*)a;
+    const Overdraw_Cluster* cluster_b = (const Overdraw_Cluster*)b;
+
+    // Descending key, ties keep their Tipsify order
+    if(cluster_a->sort_key != cluster_b->sort_key){
+        return cluster_a->sort_key < cluster_b->sort_key ? 1 : -1;
+    }
+    return (cluster_a->first_triangle > cluster_b->first_triangle) - (cluster_a->first_triangle < cluster_b->first_triangle);
+
+}
+
+/*
+*   Hard boundaries are where all three of a triangle's vertices miss, the cache is cold there anyway.
+*   Each hard cluster is split again as soon as its running ACMR gets within the threshold of the
+*   whole cluster's, so moving the pieces around costs little cache efficiency.
+*/
+static u32 overdraw_clusters(const u16* indices, u32 triangle_count, u32 vertex_count, u32 cache_size, Overdraw_Cluster* clusters){
+
+    Cache_Simulation simulation = {(u32*)calloc(vertex_count, sizeof(u32)), 0, cache_size};
+
+    u32* hard_starts = (u32*)malloc(((u64)triangle_count + 1) * sizeof(u32));
+    u32 hard_count   = 0;
+
+    for(u32 triangle = 0; triangle < triangle_count; triangle++){
+        if(cache_simulation_triangle(&simulation, indices + triangle * 3) == 3 || triangle == 0){
+            hard_starts[hard_count++] = triangle;
+        }
+    }
+    hard_starts[hard_count] = triangle_count;
+
+    u32 cluster_count = 0;
+
+    for(u32 hard = 0; hard < hard_count; hard++){
+
+        u32 start = hard_starts[hard];
+        u32 end   = hard_starts[hard + 1];
+
+        cache_simulation_flush(&simulation);
+        u32 cluster_misses = 0;
+        for(u32 triangle = start; triangle < end; triangle++){
+            cluster_misses += cache_simulation_triangle(&simulation, indices + triangle * 3);
+        }
+        f32 threshold = MESH_OPTIMIZE_OVERDRAW_THRESHOLD * (f32)cluster_misses / (f32)(end - start);
+
+        cache_simulation_flush(&simulation);
+        u32 soft_start  = start;
+        u32 soft_misses = 0;
+
+        for(u32 triangle = start; triangle < end; triangle++){
+
+            soft_misses += cache_simulation_triangle(&simulation, indices + triangle * 3);
+
+            if(triangle + 1 == end || (f32)soft_misses / (f32)(triangle + 1 - soft_start) <= threshold){
+                clusters[cluster_count].first_triangle = soft_start;
+                clusters[cluster_count].triangle_count = triangle + 1 - soft_start;
+                cluster_count++;
+                soft_start  = triangle + 1;
+                soft_misses = 0;
+                cache_simulation_flush(&simulation);
+            }
+
+        }
+
+    }
+
+    free(simulation.inserted_at);
+    free(hard_starts);
+
+    return cluster_count;
+
+}
+
+static void triangle_centroid_and_normal(const u16* triangle, const u8* positions, u32 position_stride, f32* centroid, f32* normal){
+
+    const f32* p0 = (const f32*)(positions + (u64)triangle[0] * position_stride);
+    const f32* p1 = (const f32*)(positions + (u64)triangle[1] * position_stride);
+    const f32* p2 = (const f32*)(positions + (u64)triangle[2] * position_stride);
+
+    f32 edge0[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    f32 edge1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+
+    // Front face normal of a clockwise triangle, twice the area long
+    normal[0] = edge0[1] * edge1[2] - edge0[2] * edge1[1];
+    normal[1] = edge0[2] * edge1[0] - edge0[0] * edge1[2];
+    normal[2] = edge0[0] * edge1[1] - edge0[1] * edge1[0];
+
+    for(u32 axis = 0; axis < 3; axis++){
+        centroid[axis] = (p0[axis] + p1[axis] + p2[axis]) / 3.f;
+    }
+
+}
+
+void optimize_triangle_order(u16* indices, u32 index_count, u32 vertex_count, const u8* positions, u32 position_stride, u32 cache_size){
+
+    u32 triangle_count = index_count / 3;
+    if(triangle_count == 0){
+        return;
+    }
+
+    u32* triangle_order = (u32*)malloc((u64)triangle_count * sizeof(u32));
+    tipsify(indices, index_count, vertex_count, cache_size, triangle_order);
+
+    u16* ordered = (u16*)malloc((u64)index_count * sizeof(u16));
+    for(u32 i = 0; i < triangle_count; i++){
+        memcpy(ordered + i * 3, indices + triangle_order[i] * 3, 3 * sizeof(u16));
+    }
+    free(triangle_order);
+
+    Overdraw_Cluster* clusters = (Overdraw_Cluster*)malloc((u64)triangle_count * sizeof(Overdraw_Cluster));
+    u32 cluster_count = overdraw_clusters(ordered, triangle_count, vertex_count, cache_size, clusters);
+
+    // Area weighted centroid of the mesh and of each cluster, and each cluster's area weighted normal
+    f32 mesh_centroid[3] = {};
+    f32 mesh_area        = 0.f;
+    f32* cluster_data    = (f32*)calloc((u64)cluster_count * 7, sizeof(f32)); // centroid, normal, area
+
+    for(u32 i = 0; i < cluster_count; i++){
+
+        f32* data = cluster_data + i * 7;
+
+        for(u32 triangle = clusters[i].first_triangle; triangle < clusters[i].first_triangle + clusters[i].triangle_count; triangle++){
+
+            f32 centroid[3], normal[3];
+            triangle_centroid_and_normal(ordered + triangle * 3, positions, position_stride, centroid, normal);
+            f32 area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            for(u32 axis = 0; axis < 3; axis++){
+                data[axis]          += centroid[axis] * area;
+                data[3 + axis]      += normal[axis];
+                mesh_centroid[axis] += centroid[axis] * area;
+            }
+            data[6]   += area;
+            mesh_area += area;
+
+        }
+
+    }
+
+    for(u32 axis = 0; axis < 3; axis++){
+        mesh_centroid[axis] = mesh_area > 0.f ? mesh_centroid[axis] / mesh_area : 0.f;
+    }
+
+    // Clusters facing away from the middle of the mesh are on the outside, draw them first
+    for(u32 i = 0; i < cluster_count; i++){
+
+        f32* data = cluster_data + i * 7;
+        f32 normal_length = sqrtf(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+
+        clusters[i].sort_key = 0.f;
+        if(data[6] > 0.f && normal_length > 0.f){
+            for(u32 axis = 0; axis < 3; axis++){
+                clusters[i].sort_key += (data[axis] / data[6] - mesh_centroid[axis]) * data[3 + axis] / normal_length;
+            }
+        }
+
+    }
+
+    qsort(clusters, cluster_count, sizeof(Overdraw_Cluster), overdraw_compare_clusters);
+
+    u32 index = 0;
+    for(u32 i = 0; i < cluster_count; i++){
+        memcpy(indices + index, ordered + clusters[i].first_triangle * 3, (u64)clusters[i].triangle_count * 3 * sizeof(u16));
+        index += clusters[i].triangle_count * 3;
+    }
+
+    free(cluster_data);
+    free(clusters);
+    free(ordered);
+
+}
+
+/////////////////////////////////
+// Vertex fetch
+/////////////////////////////////
+
+void optimize_vertex_fetch(u8* vertices, u32 vertex_count, u32 vertex_size, u16* indices, u32 index_count){
+
+    u32* remap = (u32*)malloc((u64)vertex_count * sizeof(u32));
+    memset(remap, 0xFF, (u64)vertex_count * sizeof(u32));
+
+    u32 next_vertex = 0;
+    for(u32 i = 0; i < index_count; i++){
+        if(remap[indices[i]] == NO_VERTEX){
+            remap[indices[i]] = next_vertex++;
+        }
+        indices[i] = (u16)remap[indices[i]];
+    }
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+        if(remap[vertex] == NO_VERTEX){
+            remap[vertex] = next_vertex++;
+        }
+    }
+
+    u8* reordered = (u8*)malloc((u64)vertex_count * vertex_size);
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+        memcpy(reordered + (u64)remap[vertex] * vertex_size, vertices + (u64)vertex * vertex_size, vertex_size);
+    }
+    memcpy(vertices, reordered, (u64)vertex_count * vertex_size);
+
+    free(reordered);
+    free(remap);
+
+}
+
+Mesh_Optimize_Stats optimize_mesh(u8* vertices, u32 vertex_count, u32 vertex_size, u16* indices, u32 index_count){
+
+    Mesh_Optimize_Stats stats = {};
+
+    if(index_count == 0 || index_count % 3 != 0){
+        return stats;
+    }
+    for(u32 i = 0; i < index_count; i++){
+        if(indices[i] >= vertex_count){
+            return stats;
+        }
+    }
+
+    stats.before = vertex_cache_stats(indices, index_count, vertex_count);
+
+    u16* original_indices = (u16*)malloc((u64)index_count * sizeof(u16));
+    memcpy(original_indices, indices, (u64)index_count * sizeof(u16));
+
+    optimize_triangle_order(indices, index_count, vertex_count, vertices, vertex_size);
+    stats.after = vertex_cache_stats(indices, index_count, vertex_count);
+
+    // Small or already optimized meshes can come out a little worse, keep what they had
+    if(stats.after.transformed_count > stats.before.transformed_count){
+        memcpy(indices, original_indices, (u64)index_count * sizeof(u16));
+        stats.after = stats.before;
+    }
+    free(original_indices);
+
+    optimize_vertex_fetch(vertices, vertex_count, vertex_size, indices, index_count);
+
+    return stats;
+
+}
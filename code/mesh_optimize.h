@@ -0,0 +1,70 @@
+#ifndef _MESH_OPTIMIZE
+#define _MESH_OPTIMIZE
+
+#include "d_types.h"
+
+/*
+*   Mesh optimization for indexed triangle lists, run on every primitive by load_gltf_model and ddx_cook
+*
+*   1. Triangles are reordered for the post transform vertex cache with Tipsify
+*      (Sander, Nehab, Barczak - Fast Triangle Reordering for Vertex Locality and Reduced Overdraw)
+*   2. The result is split into clusters where the cache goes cold anyway, and the clusters are
+*      ordered outward facing first, so they tend to occlude the ones drawn after them
+*   3. Vertices are reordered into the order the indices first use them, for vertex fetch locality
+*
+*   Indices are relative to the primitive's vertices. The vertex position is the vertex's first 3 floats.
+*   Front faces are clockwise, which is what the loaders' z flip turns glTF's counter-clockwise into.
+*/
+
+// FIFO cache size Tipsify targets and the stats simulate
+#define MESH_OPTIMIZE_CACHE_SIZE 16
+
+// How much worse than its Tipsify order a cluster's ACMR may get, to make smaller clusters for the overdraw sort
+#define MESH_OPTIMIZE_OVERDRAW_THRESHOLD 1.05f
+
+struct Vertex_Cache_Stats {
+    u64 triangle_count;
+    u64 vertex_count;       // Vertices the indices use
+    u64 transformed_count;  // Cache misses, each one is a vertex shader invocation
+};
+
+struct Mesh_Optimize_Stats {
+    Vertex_Cache_Stats before;
+    Vertex_Cache_Stats after;
+};
+
+// Average cache miss ratio, vertex shader invocations per triangle. 3 is no reuse at all, ~0.5 is the best a regular grid gets
+inline f32 vertex_cache_acmr(const Vertex_Cache_Stats& stats){
+    return stats.triangle_count ? (f32)stats.transformed_count / stats.triangle_count : 0.f;
+}
+
+// Average transformed vertex ratio, vertex shader invocations per vertex. 1 is every vertex once
+inline f32 vertex_cache_atvr(const Vertex_Cache_Stats& stats){
+    return stats.vertex_count ? (f32)stats.transformed_count / stats.vertex_count : 0.f;
+}
+
+inline void mesh_optimize_stats_add(Mesh_Optimize_Stats* total, const Mesh_Optimize_Stats& stats){
+    total->before.triangle_count    += stats.before.triangle_count;
+    total->before.vertex_count      += stats.before.vertex_count;
+    total->before.transformed_count += stats.before.transformed_count;
+    total->after.triangle_count     += stats.after.triangle_count;
+    total->after.vertex_count       += stats.after.vertex_count;
+    total->after.transformed_count  += stats.after.transformed_count;
+}
+
+// Simulates a FIFO cache of cache_size vertices over the triangle list
+Vertex_Cache_Stats vertex_cache_stats(const u16* indices, u32 index_count, u32 vertex_count, u32 cache_size = MESH_OPTIMIZE_CACHE_SIZE);
+
+// Tipsify, then the overdraw cluster sort. positions are position_stride bytes apart
+void optimize_triangle_order(u16* indices, u32 index_count, u32 vertex_count, const u8* positions, u32 position_stride, u32 cache_size = MESH_OPTIMIZE_CACHE_SIZE);
+
+// Reorders the vertices in order of first use and remaps the indices. Unused vertices go last
+void optimize_vertex_fetch(u8* vertices, u32 vertex_count, u32 vertex_size, u16* indices, u32 index_count);
+
+/*
+*   All three steps. Returns the vertex cache stats before and after.
+*   Leaves the mesh alone if it isn't a triangle list or an index is out of range.
+*/
+Mesh_Optimize_Stats optimize_mesh(u8* vertices, u32 vertex_count, u32 vertex_size, u16* indices, u32 index_count);
+
+#endif // _MESH_OPTIMIZE
@@ -0,0 +1,542 @@
+#include "mesh_simplify.h"
+#include "mesh_optimize.h"
+#include "d_hash.h"
+#include "stdlib.h" // qsort
+#include "string.h"
+#include "math.h"
+
+#define NO_VERTEX 0xFFFFFFFF
+#define NO_EDGE   0xFFFFFFFFFFFFFFFFull
+
+// A normal turned 90 degrees costs as much as moving the surface this share of the bounding radius
+#define SIMPLIFY_NORMAL_WEIGHT 0.02f
+
+// So does moving the texture coordinates by 0.1
+#define SIMPLIFY_TEXTURE_COORDINATE_WEIGHT 0.2f
+
+/////////////////////////////////
+// Quadrics
+/////////////////////////////////
+
+// Sum of squared distances to a set of planes, weighted by the area of the triangles they came from
+struct Quadric {
+    f64 a00, a11, a22, a01, a02, a12;
+    f64 b0, b1, b2;
+    f64 c;
+    f64 weight;
+};
+
+static const f32* simplify_position(const u8* vertices, u32 vertex_size, u32 vertex){
+    return (const f32*)(vertices + (u64)vertex * vertex_size);
+}
+
+static void simplify_cross(const f32* a, const f32* b, f32* result){
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static f32 simplify_dot(const f32* a, const f32* b){
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void quadric_add_triangle(Quadric* quadric, const f32* p0, const f32* p1, const f32* p2){
+
+    f32 edge0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    f32 edge1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    f32 normal[3];
+    simplify_cross(edge0, edge1, normal);
+
+    f64 length = sqrt((f64)simplify_dot(normal, normal));
+    if(length == 0.){
+        return;
+    }
+
+    f64 a = normal[0] / length;
+    f64 b = normal[1] / length;
+    f64 c = normal[2] / length;
+    f64 d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+    f64 area = length * 0.5;
+
+    quadric->a00 += area * a * a; quadric->a11 += area * b * b; quadric->a22 += area * c * c;
+    quadric->a01 += area * a * b; quadric->a02 += area * a * c; quadric->a12 += area * b * c;
+    quadric->b0  += area * a * d; quadric->b1  += area * b * d; quadric->b2  += area * c * d;
+    quadric->c   += area * d * d;
+    quadric->weight += area;
+
+}
+
+static void quadric_add(Quadric* quadric, const Quadric& other){
+    quadric->a00 += other.a00; quadric->a11 += other.a11; quadric->a22 += other.a22;
+    quadric->a01 += other.a01; quadric->a02 += other.a02; quadric->a12 += other.a12;
+    quadric->b0  += other.b0;  quadric->b1  += other.b1;  quadric->b2  += other.b2;
+    quadric->c   += other.c;
+    quadric->weight += other.weight;
+}
+
+// Squared distance, averaged over the planes' area
+static f64 quadric_error(const Quadric& q, const f32* p){
+
+    if(q.weight == 0.){
+        return 0.;
+    }
+
+    f64 x = p[0], y = p[1], z = p[2];
+    f64 error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + 2. * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+                2. * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+
+    return error > 0. ? error / q.weight : 0.;
+
+}
+
+/////////////////////////////////
+// Vertex classification
+/////////////////////////////////
+
+struct Simplify_Positions {
+    const u8* vertices;
+    u32       vertex_size;
+};
+
+static bool simplify_positions_equal(void* data, u32 a, u32 b){
+    const Simplify_Positions* positions = (const Simplify_Positions*)data;
+    const f32* p = simplify_position(positions->vertices, positions->vertex_size, a);
+    const f32* o = simplify_position(positions->vertices, positions->vertex_size, b);
+    return p[0] == o[0] && p[1] == o[1] && p[2] == o[2];
+}
+
+// The first vertex at each vertex's position. -0 and 0 are the same position
+static void position_remap(const u8* vertices, u32 vertex_count, u32 vertex_size, u32* remap){
+
+    u32* hashes = (u32*)malloc((u64)vertex_count * sizeof(u32));
+
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+        const f32* p = simplify_position(vertices, vertex_size, vertex);
+        f32 position[3] = {p[0] + 0.f, p[1] + 0.f, p[2] + 0.f};
+        u32 bits[3];
+        memcpy(bits, position, sizeof(bits));
+        hashes[vertex] = d_std::murmur3_fmix_32(bits[0] ^ d_std::murmur3_fmix_32(bits[1] ^ d_std::murmur3_fmix_32(bits[2])));
+    }
+
+    Simplify_Positions positions = {vertices, vertex_size};
+    d_std::hash_remap_duplicates(hashes, vertex_count, simplify_positions_equal, &positions, remap);
+
+    free(hashes);
+
+}
+
+static u64 edge_key(u32 from, u32 to){
+    return ((u64)from << 32) | to;
+}
+
+static u32 edge_slot(const u64* table, u32 size, u64 key){
+    u32 slot = d_std::murmur3_fmix_32((u32)key ^ d_std::murmur3_fmix_32((u32)(key >> 32))) & (size - 1);
+    while(table[slot] != NO_EDGE && table[slot] != key){
+        slot = (slot + 1) & (size - 1);
+    }
+    return slot;
+}
+
+/*
+*   Positions shared by several vertices are seams, positions on an edge only one triangle
+*   has (in either direction) are borders. Both are locked, indexed by position
+*/
+static void lock_seams_and_borders(const u16* indices, u32 index_count, u32 vertex_count, const u32* remap, u8* locked){
+
+    memset(locked, 0, vertex_count);
+
+    // Each position is locked if a vertex other than its first is used
+    for(u32 i = 0; i < index_count; i++){
+        if(remap[indices[i]] != indices[i]){
+            locked[remap[indices[i]]] = 1;
+        }
+    }
+
+    u32  size  = d_std::hash_table_size(index_count);
+    u64* table = (u64*)malloc((u64)size * sizeof(u64));
+    memset(table, 0xFF, (u64)size * sizeof(u64));
+
+    for(u32 i = 0; i < index_count; i += 3){
+        for(u32 corner = 0; corner < 3; corner++){
+            u64 key = edge_key(remap[indices[i + corner]], remap[indices[i + (corner + 1) % 3]]);
+            table[edge_slot(table, size, key)] = key;
+        }
+    }
+
+    for(u32 i = 0; i < index_count; i += 3){
+        for(u32 corner = 0; corner < 3; corner++){
+            u32 from = remap[indices[i + corner]];
+            u32 to   = remap[indices[i + (corner + 1) % 3]];
+            if(table[edge_slot(table, size, edge_key(to, from))] == NO_EDGE){
+                locked[from] = 1;
+                locked[to]   = 1;
+            }
+        }
+    }
+
+    free(table);
+
+}
+
+/////////////////////////////////
+// Edge collapse
+/////////////////////////////////
+
+struct Collapse {
+    u32 from;
+    u32 to;
+    f32 cost;  // Squared
+};
+
+static int collapse_compare(const void* a, const void* b){
+    f32 cost_a = ((const Collapse*)a)->cost;
+    f32 cost_b = ((const Collapse*)b)->cost;
+    return cost_a < cost_b ? -1 : cost_a > cost_b ? 1 : 0;
+}
+
+// Would moving from onto to turn any of from's triangles that survive over
+static bool collapse_flips(const u8* vertices, u32 vertex_size, const u16* indices, const u32* triangles, u32 triangle_count, u32 from, u32 to){
+
+    const f32* p_to = simplify_position(vertices, vertex_size, to);
+
+    for(u32 i = 0; i < triangle_count; i++){
+
+        const u16* triangle = indices + triangles[i] * 3;
+        if(triangle[0] == to || triangle[1] == to || triangle[2] == to){
+            continue;
+        }
+
+        const f32* p[3];
+        const f32* moved[3];
+        for(u32 corner = 0; corner < 3; corner++){
+            p[corner]     = simplify_position(vertices, vertex_size, triangle[corner]);
+            moved[corner] = triangle[corner] == from ? p_to : p[corner];
+        }
+
+        f32 edge0[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+        f32 edge1[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+        f32 moved_edge0[3] = {moved[1][0] - moved[0][0], moved[1][1] - moved[0][1], moved[1][2] - moved[0][2]};
+        f32 moved_edge1[3] = {moved[2][0] - moved[0][0], moved[2][1] - moved[0][1], moved[2][2] - moved[0][2]};
+
+        f32 normal[3], moved_normal[3];
+        simplify_cross(edge0, edge1, normal);
+        simplify_cross(moved_edge0, moved_edge1, moved_normal);
+
+        f32 dot = simplify_dot(normal, moved_normal);
+        if(dot < 0.f || (dot == 0.f && simplify_dot(normal, normal) > 0.f)){
+            return true;
+        }
+
+    }
+
+    return false;
+
+}
+
+u32 simplify_mesh(const u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset,
+                  const u16* indices, u32 index_count, u32 target_index_count, f32 target_error, u16* destination, f32* result_error){
+
+    *result_error = 0.f;
+    memcpy(destination, indices, (u64)index_count * sizeof(u16));
+
+    if(index_count == 0 || index_count % 3 != 0 || index_count <= target_index_count){
+        return index_count;
+    }
+    for(u32 i = 0; i < index_count; i++){
+        if(indices[i] >= vertex_count){
+            return index_count;
+        }
+    }
+
+    u32* remap          = (u32*)malloc((u64)vertex_count * sizeof(u32));
+    u8*  locked         = (u8*)malloc(vertex_count);
+    u8*  touched        = (u8*)malloc(vertex_count);
+    u32* collapse_to    = (u32*)malloc((u64)vertex_count * sizeof(u32));
+    u32* triangle_start = (u32*)malloc(((u64)vertex_count + 1) * sizeof(u32));
+    u32* triangles      = (u32*)malloc((u64)index_count * sizeof(u32));
+    Quadric* quadrics   = (Quadric*)calloc(vertex_count, sizeof(Quadric));
+    Collapse* collapses = (Collapse*)malloc((u64)vertex_count * sizeof(Collapse));
+
+    position_remap(vertices, vertex_count, vertex_size, remap);
+    lock_seams_and_borders(indices, index_count, vertex_count, remap, locked);
+
+    // Quadrics are per position, so the vertices of a seam share theirs
+    f32 bounds_center[3], bounds_radius;
+    mesh_bounding_sphere(vertices, vertex_size, indices, index_count, bounds_center, &bounds_radius);
+
+    for(u32 i = 0; i < index_count; i += 3){
+        const f32* p0 = simplify_position(vertices, vertex_size, indices[i + 0]);
+        const f32* p1 = simplify_position(vertices, vertex_size, indices[i + 1]);
+        const f32* p2 = simplify_position(vertices, vertex_size, indices[i + 2]);
+        for(u32 corner = 0; corner < 3; corner++){
+            quadric_add_triangle(&quadrics[remap[indices[i + corner]]], p0, p1, p2);
+        }
+    }
+
+    // Attribute differences are in squared bounding radii
+    f32 radius_squared      = bounds_radius * bounds_radius;
+    f32 normal_weight       = SIMPLIFY_NORMAL_WEIGHT * SIMPLIFY_NORMAL_WEIGHT * radius_squared;
+    f32 texture_coordinate_weight = SIMPLIFY_TEXTURE_COORDINATE_WEIGHT * SIMPLIFY_TEXTURE_COORDINATE_WEIGHT * radius_squared;
+    f32 max_cost            = target_error * target_error;
+    f32 max_collapse_cost   = 0.f;
+
+    while(index_count > target_index_count){
+
+        // Triangles around each vertex
+        memset(triangle_start, 0, ((u64)vertex_count + 1) * sizeof(u32));
+        for(u32 i = 0; i < index_count; i++){
+            triangle_start[destination[i] + 1]++;
+        }
+        for(u32 vertex = 0; vertex < vertex_count; vertex++){
+            triangle_start[vertex + 1] += triangle_start[vertex];
+        }
+        for(u32 i = 0; i < index_count; i++){
+            triangles[triangle_start[destination[i]]++] = i / 3;
+        }
+        for(u32 vertex = vertex_count; vertex > 0; vertex--){
+            triangle_start[vertex] = triangle_start[vertex - 1];
+        }
+        triangle_start[0] = 0;
+
+        // The cheapest edge out of each unlocked vertex
+        for(u32 vertex = 0; vertex < vertex_count; vertex++){
+            collapses[vertex] = {vertex, NO_VERTEX, INFINITY};
+        }
+
+        for(u32 i = 0; i < index_count; i += 3){
+            for(u32 corner = 0; corner < 3; corner++){
+
+                u32 a = destination[i + corner];
+                u32 b = destination[i + (corner + 1) % 3];
+
+                for(u32 direction = 0; direction < 2; direction++){
+
+                    u32 from = direction ? b : a;
+                    u32 to   = direction ? a : b;
+                    if(locked[remap[from]]){
+                        continue;
+                    }
+
+                    Quadric quadric = quadrics[remap[from]];
+                    quadric_add(&quadric, quadrics[remap[to]]);
+                    f64 cost = quadric_error(quadric, simplify_position(vertices, vertex_size, to));
+
+                    const f32* from_normal = (const f32*)(vertices + (u64)from * vertex_size + normal_offset);
+                    const f32* to_normal   = (const f32*)(vertices + (u64)to   * vertex_size + normal_offset);
+                    const f32* from_uv     = (const f32*)(vertices + (u64)from * vertex_size + texture_coordinate_offset);
+                    const f32* to_uv       = (const f32*)(vertices + (u64)to   * vertex_size + texture_coordinate_offset);
+                    f32 uv_offset[2]       = {from_uv[0] - to_uv[0], from_uv[1] - to_uv[1]};
+
+                    cost += (1.f - d_min(simplify_dot(from_normal, to_normal), 1.f)) * normal_weight;
+                    cost += (uv_offset[0] * uv_offset[0] + uv_offset[1] * uv_offset[1]) * texture_coordinate_weight;
+
+                    if(cost <= max_cost && cost < collapses[from].cost){
+                        collapses[from].to   = to;
+                        collapses[from].cost = (f32)cost;
+                    }
+
+                }
+
+            }
+        }
+
+        u32 collapse_count = 0;
+        for(u32 vertex = 0; vertex < vertex_count; vertex++){
+            if(collapses[vertex].to != NO_VERTEX){
+                collapses[collapse_count++] = collapses[vertex];
+            }
+        }
+
+        qsort(collapses, collapse_count, sizeof(Collapse), collapse_compare);
+
+        // Cheapest first. A collapse changes the triangles around from, so their vertices wait for the next pass
+        memset(touched, 0, vertex_count);
+        for(u32 vertex = 0; vertex < vertex_count; vertex++){
+            collapse_to[vertex] = vertex;
+        }
+
+        u32 triangles_to_remove = (index_count - target_index_count + 2) / 3;
+        u32 triangles_removed   = 0;
+        u32 collapsed           = 0;
+
+        for(u32 i = 0; i < collapse_count && triangles_removed < triangles_to_remove; i++){
+
+            const Collapse& collapse = collapses[i];
+            if(touched[collapse.from] || touched[collapse.to]){
+                continue;
+            }
+
+            const u32* from_triangles = triangles + triangle_start[collapse.from];
+            u32 from_triangle_count   = triangle_start[collapse.from + 1] - triangle_start[collapse.from];
+
+            if(collapse_flips(vertices, vertex_size, destination, from_triangles, from_triangle_count, collapse.from, collapse.to)){
+                continue;
+            }
+
+            for(u32 j = 0; j < from_triangle_count; j++){
+                const u16* triangle = destination + from_triangles[j] * 3;
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+                triangles_removed += triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to;
+            }
+
+            collapse_to[collapse.from] = collapse.to;
+            quadric_add(&quadrics[remap[collapse.to]], quadrics[remap[collapse.from]]);
+            max_collapse_cost = d_max(max_collapse_cost, collapse.cost);
+            collapsed++;
+
+        }
+
+        if(collapsed == 0){
+            break;
+        }
+
+        // Move the collapsed corners and drop the triangles that went degenerate
+        u32 kept = 0;
+        for(u32 i = 0; i < index_count; i += 3){
+            u16 a = (u16)collapse_to[destination[i + 0]];
+            u16 b = (u16)collapse_to[destination[i + 1]];
+            u16 c = (u16)collapse_to[destination[i + 2]];
+            if(a != b && b != c && a != c){
+                destination[kept++] = a;
+                destination[kept++] = b;
+                destination[kept++] = c;
+            }
+        }
+        index_count = kept;
+
+    }
+
+    *result_error = sqrtf(max_collapse_cost);
+
+    free(remap);
+    free(locked);
+    free(touched);
+    free(collapse_to);
+    free(triangle_start);
+    free(triangles);
+    free(quadrics);
+    free(collapses);
+
+    return index_count;
+
+}
+
+/////////////////////////////////
+// LOD chain
+/////////////////////////////////
+
+template <typename Index>
+static void bounding_sphere(const u8* positions, u32 position_stride, const Index* indices, u32 index_count, f32* center, f32* radius){
+
+    f32 bounds_min[3] = { INFINITY,  INFINITY,  INFINITY};
+    f32 bounds_max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for(u32 i = 0; i < index_count; i++){
+        const f32* p = simplify_position(positions, position_stride, indices[i]);
+        for(u32 axis = 0; axis < 3; axis++){
+            bounds_min[axis] = p[axis] < bounds_min[axis] ? p[axis] : bounds_min[axis];
+            bounds_max[axis] = p[axis] > bounds_max[axis] ? p[axis] : bounds_max[axis];
+        }
+    }
+
+    center[0] = center[1] = center[2] = 0.f;
+    *radius   = 0.f;
+    if(index_count == 0){
+        return;
+    }
+
+    for(u32 axis = 0; axis < 3; axis++){
+        center[axis] = (bounds_min[axis] + bounds_max[axis]) * 0.5f;
+    }
+
+    f32 radius_squared = 0.f;
+    for(u32 i = 0; i < index_count; i++){
+        const f32* p = simplify_position(positions, position_stride, indices[i]);
+        f32 offset[3] = {p[0] - center[0], p[1] - center[1], p[2] - center[2]};
+        radius_squared = d_max(radius_squared, simplify_dot(offset, offset));
+    }
+    *radius = sqrtf(radius_squared);
+
+}
+
+void mesh_bounding_sphere(const u8* positions, u32 position_stride, const u16* indices, u32 index_count, f32* center, f32* radius){
+    bounding_sphere(positions, position_stride, indices, index_count, center, radius);
+}
+
+void mesh_bounding_sphere(const u8* positions, u32 position_stride, const u32* indices, u32 index_count, f32* center, f32* radius){
+    bounding_sphere(positions, position_stride, indices, index_count, center, radius);
+}
+
+u32 build_lod_chain(const u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset,
+                    const u16* indices, u32 index_count, u16* lod_indices, Mesh_Lod* lods, u32* lod_index_count){
+
+    lods[0] = {0, index_count, 0.f};
+    *lod_index_count = 0;
+
+    if(index_count < 3 || index_count % 3 != 0){
+        return 1;
+    }
+
+    f32 center[3], radius;
+    mesh_bounding_sphere(vertices, vertex_size, indices, index_count, center, &radius);
+
+    u32 lod_count = 1;
+    u32 written   = 0;
+
+    while(lod_count < MESH_LOD_MAX){
+
+        u32 previous_count = lods[lod_count - 1].index_count;
+        u32 target         = (u32)(previous_count / 3 * MESH_LOD_REDUCTION) * 3;
+        if(target < 3){
+            break;
+        }
+
+        // From the full mesh every time, so the errors are against it and don't stack
+        u16* destination = lod_indices + written;
+        f32 error;
+        u32 count = simplify_mesh(vertices, vertex_count, vertex_size, normal_offset, texture_coordinate_offset,
+                                  indices, index_count, target, radius * MESH_LOD_MAX_ERROR, destination, &error);
+
+        if(count == 0 || count > previous_count * MESH_LOD_MIN_REDUCTION){
+            break;
+        }
+
+        optimize_triangle_order(destination, count, vertex_count, vertices, vertex_size);
+
+        lods[lod_count] = {index_count + written, count, d_max(error, lods[lod_count - 1].error)};
+        written += count;
+        lod_count++;
+
+    }
+
+    *lod_index_count = written;
+
+    return lod_count;
+
+}
+
+/////////////////////////////////
+// Selection
+/////////////////////////////////
+
+u32 select_lod(const Mesh_Lod* lods, u32 lod_count, const f32* center, f32 radius, f32 error_scale, const Mesh_Lod_View& view){
+
+    f32 pixels_per_unit = view.pixel_scale;
+
+    if(!view.orthographic){
+        f32 offset[3]  = {center[0] - view.position[0], center[1] - view.position[1], center[2] - view.position[2]};
+        f32 distance   = sqrtf(simplify_dot(offset, offset)) - radius;
+        // Inside the bounds, anything could be right in front of the camera
+        if(distance <= 0.f){
+            return 0;
+        }
+        pixels_per_unit = view.pixel_scale / distance;
+    }
+
+    u32 lod = 0;
+    while(lod + 1 < lod_count && lods[lod + 1].error * error_scale * pixels_per_unit <= view.max_pixel_error){
+        lod++;
+    }
+
+    return lod;
+
+}
@@ -0,0 +1,87 @@
+#ifndef _MESH_SIMPLIFY
+#define _MESH_SIMPLIFY
+
+#include "d_types.h"
+
+/*
+*   Level of detail chains for indexed triangle lists, built by ddx_cook and load_gltf_model after optimize_mesh
+*
+*   simplify_mesh is a quadric error metric edge collapser (Garland, Heckbert - Surface Simplification
+*   Using Quadric Error Metrics). A vertex is only ever collapsed onto one of its neighbours, so every LOD
+*   indexes the primitive's own vertices and only the indices change.
+*   A collapse costs its position quadric error plus a penalty for how far apart the two vertices' normals
+*   and texture coordinates are, so flat, evenly mapped areas go first. Vertices on a seam (several vertices
+*   at one position, a UV or hard normal split) and on an open border are locked and never move.
+*
+*   select_lod picks the coarsest LOD whose error projects to at most max_pixel_error pixels in a view.
+*/
+
+// LOD 0, the full mesh, and up to 4 simplified ones
+#define MESH_LOD_MAX 5
+
+// Each LOD aims for this share of the previous one's triangles
+#define MESH_LOD_REDUCTION 0.5f
+
+// A LOD that keeps more than this share of the previous one's triangles isn't worth its indices, the chain stops
+#define MESH_LOD_MIN_REDUCTION 0.85f
+
+// No LOD is simplified further than this, relative to the primitive's bounding radius
+#define MESH_LOD_MAX_ERROR 0.1f
+
+// How many pixels a LOD's error may cover before a finer one is drawn
+#define MESH_LOD_DEFAULT_PIXEL_ERROR 1.f
+
+struct Mesh_Lod {
+    u32 index_offset;  // From the primitive's first index, LOD 1 and up follow LOD 0's indices
+    u32 index_count;
+    f32 error;         // How far the LOD is from the full mesh, in model units. Never less than the previous LOD's
+};
+
+// How much room build_lod_chain needs for the indices of LOD 1 and up
+inline u32 mesh_lod_indices_bound(u32 index_count){
+    return index_count * (MESH_LOD_MAX - 1);
+}
+
+/*
+*   Collapses edges until the triangle list has at most target_index_count indices, or the next collapse
+*   would cost more than target_error. Writes the indices to destination, which has to hold index_count,
+*   and returns how many there are. result_error is the largest error a collapse cost, in position units.
+*
+*   The vertex position is the vertex's first 3 floats, the normal is 3 floats at normal_offset and the
+*   texture coordinates are 2 floats at texture_coordinate_offset.
+*/
+u32 simplify_mesh(const u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset,
+                  const u16* indices, u32 index_count, u32 target_index_count, f32 target_error, u16* destination, f32* result_error);
+
+// Sphere around the center of the bounding box of the vertices the indices use
+void mesh_bounding_sphere(const u8* positions, u32 position_stride, const u16* indices, u32 index_count, f32* center, f32* radius);
+void mesh_bounding_sphere(const u8* positions, u32 position_stride, const u32* indices, u32 index_count, f32* center, f32* radius);
+
+/*
+*   Simplifies the primitive down to MESH_LOD_MAX LODs, each from the full mesh, and reorders each
+*   LOD's triangles for the vertex cache. lods[0] is the full mesh.
+*   lod_indices has to hold mesh_lod_indices_bound(index_count), lod_index_count is how much of it is used.
+*   Returns the LOD count.
+*/
+u32 build_lod_chain(const u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset,
+                    const u16* indices, u32 index_count, u16* lod_indices, Mesh_Lod* lods, u32* lod_index_count);
+
+/////////////////////////////////
+// Selection
+/////////////////////////////////
+
+// How a view turns an error into pixels
+struct Mesh_Lod_View {
+    f32  position[3];      // Perspective only, in the space the bounds are in
+    f32  pixel_scale;      // Perspective: render height / (2 * tan(fov_y / 2)), pixels = error * pixel_scale / distance. Orthographic: pixels per unit
+    bool orthographic;
+    f32  max_pixel_error;
+};
+
+/*
+*   The coarsest LOD whose error is at most max_pixel_error pixels. center and radius are the primitive's
+*   bounding sphere in the view's space, error_scale takes the LODs' model space errors there.
+*/
+u32 select_lod(const Mesh_Lod* lods, u32 lod_count, const f32* center, f32 radius, f32 error_scale, const Mesh_Lod_View& view);
+
+#endif // _MESH_SIMPLIFY
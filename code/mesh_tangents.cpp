@@ -0,0 +1,254 @@
+#include "mesh_tangents.h"
+#include "d_hash.h"
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "float.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define TANGENTS_SSE
+#include <xmmintrin.h>
+#endif
+
+/////////////////////////////////
+// Vectors
+/////////////////////////////////
+
+// 3 floats and a 0, one SSE register where there is SSE
+#ifdef TANGENTS_SSE
+
+typedef __m128 Tangent_Vector;
+
+static inline Tangent_Vector tangent_load(const f32* v)                         { return _mm_setr_ps(v[0], v[1], v[2], 0.f); }
+static inline Tangent_Vector tangent_sub(Tangent_Vector a, Tangent_Vector b)   { return _mm_sub_ps(a, b); }
+static inline Tangent_Vector tangent_scale(Tangent_Vector a, f32 s)            { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+
+static inline f32 tangent_dot(Tangent_Vector a, Tangent_Vector b){
+    __m128 m = _mm_mul_ps(a, b);
+    __m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    s = _mm_add_ss(s, _mm_movehl_ps(s, s));
+    return _mm_cvtss_f32(s);
+}
+
+// Accumulators are plain floats, 4 a vertex
+static inline void tangent_accumulate(f32* sum, Tangent_Vector v, f32 weight){
+    _mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), _mm_mul_ps(v, _mm_set1_ps(weight))));
+}
+
+static inline void tangent_store(Tangent_Vector v, f32* result){
+    f32 lanes[4];
+    _mm_storeu_ps(lanes, v);
+    result[0] = lanes[0]; result[1] = lanes[1]; result[2] = lanes[2];
+}
+
+#else
+
+struct Tangent_Vector {
+    f32 x, y, z;
+};
+
+static inline Tangent_Vector tangent_load(const f32* v)                         { return {v[0], v[1], v[2]}; }
+static inline Tangent_Vector tangent_sub(Tangent_Vector a, Tangent_Vector b)   { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+static inline Tangent_Vector tangent_scale(Tangent_Vector a, f32 s)            { return {a.x * s, a.y * s, a.z * s}; }
+static inline f32            tangent_dot(Tangent_Vector a, Tangent_Vector b)   { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+static inline void tangent_accumulate(f32* sum, Tangent_Vector v, f32 weight){
+    sum[0] += v.x * weight; sum[1] += v.y * weight; sum[2] += v.z * weight;
+}
+
+static inline void tangent_store(Tangent_Vector v, f32* result){
+    result[0] = v.x; result[1] = v.y; result[2] = v.z;
+}
+
+#endif
+
+// a with its component along unit vector n removed
+static inline Tangent_Vector tangent_project(Tangent_Vector a, Tangent_Vector n){
+    return tangent_sub(a, tangent_scale(n, tangent_dot(n, a)));
+}
+
+// Zero stays zero
+static inline Tangent_Vector tangent_normalize(Tangent_Vector a){
+    f32 length_squared = tangent_dot(a, a);
+    return length_squared > FLT_MIN ? tangent_scale(a, 1.f / sqrtf(length_squared)) : tangent_scale(a, 0.f);
+}
+
+/////////////////////////////////
+// Matching vertices
+/////////////////////////////////
+
+// The 8 floats MikkTSpace tells vertices apart by. -0 and 0 are the same
+static void tangent_vertex_key(const u8* vertex, u32 normal_offset, u32 texture_coordinate_offset, f32* key){
+
+    const f32* position            = (const f32*)vertex;
+    const f32* normal              = (const f32*)(vertex + normal_offset);
+    const f32* texture_coordinates = (const f32*)(vertex + texture_coordinate_offset);
+    key[0] = position[0] + 0.f; key[1] = position[1] + 0.f; key[2] = position[2] + 0.f;
+    key[3] = normal[0] + 0.f;   key[4] = normal[1] + 0.f;   key[5] = normal[2] + 0.f;
+    key[6] = texture_coordinates[0] + 0.f; key[7] = texture_coordinates[1] + 0.f;
+
+}
+
+struct Tangent_Vertices {
+    const u8* vertices;
+    u32       vertex_size;
+    u32       normal_offset;
+    u32       texture_coordinate_offset;
+};
+
+static bool tangent_vertices_equal(void* data, u32 a, u32 b){
+
+    const Tangent_Vertices* tangent_vertices = (const Tangent_Vertices*)data;
+    f32 key_a[8];
+    f32 key_b[8];
+    tangent_vertex_key(tangent_vertices->vertices + (u64)a * tangent_vertices->vertex_size, tangent_vertices->normal_offset, tangent_vertices->texture_coordinate_offset, key_a);
+    tangent_vertex_key(tangent_vertices->vertices + (u64)b * tangent_vertices->vertex_size, tangent_vertices->normal_offset, tangent_vertices->texture_coordinate_offset, key_b);
+    return memcmp(key_a, key_b, sizeof(key_a)) == 0;
+
+}
+
+// The first vertex with each vertex's position, normal and texture coordinates
+static void tangent_vertex_remap(const u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset, u32* remap){
+
+    u32* hashes = (u32*)malloc((u64)vertex_count * sizeof(u32));
+
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+
+        f32 key[8];
+        u32 bits[8];
+        tangent_vertex_key(vertices + (u64)vertex * vertex_size, normal_offset, texture_coordinate_offset, key);
+        memcpy(bits, key, sizeof(bits));
+
+        u32 h = 0;
+        for(u32 i = 0; i < 8; i++){
+            h = d_std::murmur3_fmix_32(h ^ bits[i]);
+        }
+        hashes[vertex] = h;
+
+    }
+
+    Tangent_Vertices tangent_vertices = {vertices, vertex_size, normal_offset, texture_coordinate_offset};
+    d_std::hash_remap_duplicates(hashes, vertex_count, tangent_vertices_equal, &tangent_vertices, remap);
+
+    free(hashes);
+
+}
+
+/////////////////////////////////
+// Generation
+/////////////////////////////////
+
+// Some unit vector perpendicular to n (Duff et al. 2017), +x if n is zero
+static void tangent_fallback(const f32* n, f32* tangent){
+
+    if(n[0] * n[0] + n[1] * n[1] + n[2] * n[2] <= FLT_MIN){
+        tangent[0] = 1.f; tangent[1] = 0.f; tangent[2] = 0.f;
+        return;
+    }
+    f32 s = n[2] >= 0.f ? 1.f : -1.f;
+    f32 a = -1.f / (s + n[2]);
+    tangent[0] = 1.f + s * n[0] * n[0] * a;
+    tangent[1] = s * n[0] * n[1] * a;
+    tangent[2] = -s * n[0];
+
+}
+
+template <typename Index>
+static void tangent_generate(u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset, u32 tangent_offset,
+                             const Index* indices, u32 index_count){
+
+    if(vertex_count == 0){
+        return;
+    }
+
+    u32* remap          = (u32*)malloc((u64)vertex_count * sizeof(u32));
+    f32* tangent_sums   = (f32*)calloc((u64)vertex_count * 4, sizeof(f32));
+    f32* bitangent_sums = (f32*)calloc((u64)vertex_count * 4, sizeof(f32));
+    tangent_vertex_remap(vertices, vertex_count, vertex_size, normal_offset, texture_coordinate_offset, remap);
+
+    for(u32 i = 0; i + 2 < index_count; i += 3){
+
+        u32 corners[3] = {indices[i], indices[i + 1], indices[i + 2]};
+        if(corners[0] >= vertex_count || corners[1] >= vertex_count || corners[2] >= vertex_count){
+            continue;
+        }
+
+        const u8* v0 = vertices + (u64)corners[0] * vertex_size;
+        const u8* v1 = vertices + (u64)corners[1] * vertex_size;
+        const u8* v2 = vertices + (u64)corners[2] * vertex_size;
+        Tangent_Vector p[3] = {tangent_load((const f32*)v0), tangent_load((const f32*)v1), tangent_load((const f32*)v2)};
+        const f32* uv0 = (const f32*)(v0 + texture_coordinate_offset);
+        const f32* uv1 = (const f32*)(v1 + texture_coordinate_offset);
+        const f32* uv2 = (const f32*)(v2 + texture_coordinate_offset);
+
+        // Texture space directions of the triangle, flipped with its winding in texture space so they point along +u and +v
+        Tangent_Vector edge1 = tangent_sub(p[1], p[0]);
+        Tangent_Vector edge2 = tangent_sub(p[2], p[0]);
+        f32 s1 = uv1[0] - uv0[0], t1 = uv1[1] - uv0[1];
+        f32 s2 = uv2[0] - uv0[0], t2 = uv2[1] - uv0[1];
+        f32 signed_area = s1 * t2 - s2 * t1;
+        if(fabsf(signed_area) <= FLT_MIN){
+            continue;
+        }
+        f32 orientation = signed_area > 0.f ? 1.f : -1.f;
+        Tangent_Vector triangle_tangent   = tangent_normalize(tangent_scale(tangent_sub(tangent_scale(edge1, t2), tangent_scale(edge2, t1)), orientation));
+        Tangent_Vector triangle_bitangent = tangent_normalize(tangent_scale(tangent_sub(tangent_scale(edge2, s1), tangent_scale(edge1, s2)), orientation));
+
+        for(u32 corner = 0; corner < 3; corner++){
+
+            Tangent_Vector n = tangent_normalize(tangent_load((const f32*)(vertices + (u64)corners[corner] * vertex_size + normal_offset)));
+
+            // Corner angle between the edges, in the plane of the corner's normal
+            Tangent_Vector to_next     = tangent_normalize(tangent_project(tangent_sub(p[(corner + 1) % 3], p[corner]), n));
+            Tangent_Vector to_previous = tangent_normalize(tangent_project(tangent_sub(p[(corner + 2) % 3], p[corner]), n));
+            f32 cosine = tangent_dot(to_next, to_previous);
+            f32 angle  = acosf(cosine > 1.f ? 1.f : (cosine < -1.f ? -1.f : cosine));
+
+            u32 vertex = remap[corners[corner]];
+            tangent_accumulate(tangent_sums + (u64)vertex * 4, tangent_normalize(tangent_project(triangle_tangent, n)), angle);
+            tangent_accumulate(bitangent_sums + (u64)vertex * 4, triangle_bitangent, angle);
+
+        }
+
+    }
+
+    for(u32 i = 0; i < vertex_count; i++){
+
+        u8* vertex  = vertices + (u64)i * vertex_size;
+        f32* result = (f32*)(vertex + tangent_offset);
+        const f32* normal = (const f32*)(vertex + normal_offset);
+
+        // Every direction in the sum is in the plane of the normal already
+        Tangent_Vector tangent = tangent_normalize(tangent_load(tangent_sums + (u64)remap[i] * 4));
+        if(tangent_dot(tangent, tangent) == 0.f){
+            tangent_fallback(normal, result);
+            result[3] = 1.f;
+            continue;
+        }
+
+        tangent_store(tangent, result);
+
+        // Handedness from which side of cross(n, t) the summed bitangent is on
+        f32 t[3];
+        tangent_store(tangent, t);
+        f32 cross[3] = {normal[1] * t[2] - normal[2] * t[1], normal[2] * t[0] - normal[0] * t[2], normal[0] * t[1] - normal[1] * t[0]};
+        const f32* bitangent = bitangent_sums + (u64)remap[i] * 4;
+        result[3] = cross[0] * bitangent[0] + cross[1] * bitangent[1] + cross[2] * bitangent[2] < 0.f ? -1.f : 1.f;
+
+    }
+
+    free(remap);
+    free(tangent_sums);
+    free(bitangent_sums);
+
+}
+
+void generate_tangents(u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset, u32 tangent_offset,
+                       const u16* indices, u32 index_count){
+    tangent_generate(vertices, vertex_count, vertex_size, normal_offset, texture_coordinate_offset, tangent_offset, indices, index_count);
+}
+
+void generate_tangents(u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset, u32 tangent_offset,
+                       const u32* indices, u32 index_count){
+    tangent_generate(vertices, vertex_count, vertex_size, normal_offset, texture_coordinate_offset, tangent_offset, indices, index_count);
+}
@@ -0,0 +1,31 @@
+#ifndef _MESH_TANGENTS
+#define _MESH_TANGENTS
+
+#include "d_types.h"
+
+/*
+*   Tangents for indexed triangle lists that don't come with them, run by load_gltf_model and ddx_cook on
+*   primitives without a TANGENT attribute. Both already decode primitives in parallel, so this is per primitive.
+*
+*   Follows MikkTSpace (Mikkelsen - Simulation of Wrinkled Surfaces Revisited), which is what glTF asks for:
+*   each triangle's texture space directions are projected onto the plane of each corner's normal and summed,
+*   weighted by the corner's angle. Vertices with the same position, normal and texture coordinates are
+*   summed together like MikkTSpace does, even when they're separate vertices. Unlike MikkTSpace a vertex shared
+*   by mirrored and unmirrored triangles isn't split, the majority decides its handedness.
+*
+*   O(triangles + vertices): one pass over the triangles, with a hash to find the matching vertices.
+*   The vertex position is the vertex's first 3 floats.
+*/
+
+/*
+*   Writes a float4 tangent at tangent_offset in every vertex. xyz points along +u, w is the sign
+*   that makes cross(normal, tangent.xyz) * w point along +v. Vertices whose triangles have no usable texture
+*   coordinates, or no triangles at all, get any tangent perpendicular to their normal.
+*   The normal is 3 floats at normal_offset and the texture coordinates are 2 floats at texture_coordinate_offset.
+*/
+void generate_tangents(u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset, u32 tangent_offset,
+                       const u16* indices, u32 index_count);
+void generate_tangents(u8* vertices, u32 vertex_count, u32 vertex_size, u32 normal_offset, u32 texture_coordinate_offset, u32 tangent_offset,
+                       const u32* indices, u32 index_count);
+
+#endif // _MESH_TANGENTS
@@ -0,0 +1,109 @@
+#include "mesh_weld.h"
+#include "d_hash.h"
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+
+// What vertices are compared on, float_count u32s a vertex. -0 becomes 0, snapped floats are stored as floats too
+static void weld_vertex_keys(const u8* vertices, u32 vertex_count, u32 vertex_size, f32 tolerance, u32* keys){
+
+    u32 float_count = vertex_size / sizeof(f32);
+    f32 inverse_tolerance = tolerance > 0.f ? 1.f / tolerance : 0.f;
+
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+
+        const f32* floats = (const f32*)(vertices + (u64)vertex * vertex_size);
+        u32* key = keys + (u64)vertex * float_count;
+        for(u32 i = 0; i < float_count; i++){
+            f32 value = tolerance > 0.f ? floorf(floats[i] * inverse_tolerance + 0.5f) : floats[i];
+            value += 0.f;
+            memcpy(key + i, &value, sizeof(u32));
+        }
+
+    }
+
+}
+
+struct Weld_Keys {
+    const u32* keys;
+    u32        float_count;
+};
+
+static bool weld_keys_equal(void* data, u32 a, u32 b){
+    const Weld_Keys* weld_keys = (const Weld_Keys*)data;
+    return memcmp(weld_keys->keys + (u64)a * weld_keys->float_count, weld_keys->keys + (u64)b * weld_keys->float_count, weld_keys->float_count * sizeof(u32)) == 0;
+}
+
+// Compacts the kept vertices and fills remap with each vertex's new index, returns the new vertex count
+static u32 weld_vertex_remap(u8* vertices, u32 vertex_count, u32 vertex_size, f32 tolerance, u32* remap){
+
+    u32 float_count = vertex_size / sizeof(f32);
+    u64 key_size    = (u64)float_count * sizeof(u32);
+    u32* keys       = (u32*)malloc(key_size * vertex_count);
+    u32* hashes     = (u32*)malloc((u64)vertex_count * sizeof(u32));
+    weld_vertex_keys(vertices, vertex_count, vertex_size, tolerance, keys);
+
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+        hashes[vertex] = d_std::murmur3_32((const u8*)(keys + (u64)vertex * float_count), (u32)key_size);
+    }
+
+    Weld_Keys weld_keys = {keys, float_count};
+    d_std::hash_remap_duplicates(hashes, vertex_count, weld_keys_equal, &weld_keys, remap);
+
+    // Duplicates point at an earlier vertex, whose new index is already in remap by then
+    u32 welded_count = 0;
+    for(u32 vertex = 0; vertex < vertex_count; vertex++){
+        if(remap[vertex] != vertex){
+            remap[vertex] = remap[remap[vertex]];
+            continue;
+        }
+        if(welded_count != vertex){
+            memcpy(vertices + (u64)welded_count * vertex_size, vertices + (u64)vertex * vertex_size, vertex_size);
+        }
+        remap[vertex] = welded_count++;
+    }
+
+    free(keys);
+    free(hashes);
+
+    return welded_count;
+
+}
+
+u32 weld_vertices(u8* vertices, u32 vertex_count, u32 vertex_size, u16* indices, u32 index_count, f32 tolerance){
+
+    if(vertex_count < 2 || vertex_size < sizeof(f32)){
+        return vertex_count;
+    }
+
+    u32* remap = (u32*)malloc((u64)vertex_count * sizeof(u32));
+    u32 welded_count = weld_vertex_remap(vertices, vertex_count, vertex_size, tolerance, remap);
+    for(u32 i = 0; i < index_count; i++){
+        if(indices[i] < vertex_count){
+            indices[i] = (u16)remap[indices[i]];
+        }
+    }
+    free(remap);
+
+    return welded_count;
+
+}
+
+u32 weld_vertices(u8* vertices, u32 vertex_count, u32 vertex_size, u32* indices, u32 index_count, f32 tolerance){
+
+    if(vertex_count < 2 || vertex_size < sizeof(f32)){
+        return vertex_count;
+    }
+
+    u32* remap = (u32*)malloc((u64)vertex_count * sizeof(u32));
+    u32 welded_count = weld_vertex_remap(vertices, vertex_count, vertex_size, tolerance, remap);
+    for(u32 i = 0; i < index_count; i++){
+        if(indices[i] < vertex_count){
+            indices[i] = remap[indices[i]];
+        }
+    }
+    free(remap);
+
+    return welded_count;
+
+}
@@ -0,0 +1,43 @@
+#ifndef _MESH_WELD
+#define _MESH_WELD
+
+#include "d_types.h"
+
+/*
+*   Vertex welding for indexed primitives, run on every primitive by load_gltf_model and ddx_cook before the
+*   rest of the mesh processing. Exporters split vertices along seams and per face attributes, and often write
+*   out vertices that end up identical, which only cost vertex buffer memory and post transform cache hits.
+*
+*   Vertices are vertex_size / 4 floats, and are compared on all of them. Each vertex is hashed with murmur3 into
+*   an open addressed table, so welding is O(vertices + indices). The first vertex of each group is kept, the
+*   kept vertices stay in their order.
+*/
+
+struct Mesh_Weld_Stats {
+    u64 vertex_count;         // Before welding
+    u64 welded_vertex_count;  // After
+};
+
+inline void mesh_weld_stats_add(Mesh_Weld_Stats* total, const Mesh_Weld_Stats& stats){
+    total->vertex_count        += stats.vertex_count;
+    total->welded_vertex_count += stats.welded_vertex_count;
+}
+
+// Share of the vertices welding removed, 0 to 1
+inline f32 mesh_weld_reduction(const Mesh_Weld_Stats& stats){
+    return stats.vertex_count ? 1.f - (f32)stats.welded_vertex_count / stats.vertex_count : 0.f;
+}
+
+/*
+*   Merges matching vertices, moves the kept ones to the front of vertices and remaps the indices.
+*   Returns the new vertex count. Out of range indices are left alone.
+*   With a tolerance of 0 vertices have to match exactly (0 and -0 match). Otherwise every float is snapped to a
+*   multiple of tolerance and vertices match if they snap to the same values, so two floats closer than tolerance
+*   can still land on either side of a step and stay apart. The kept vertex isn't snapped.
+*/
+u32 weld_vertices(u8* vertices, u32 vertex_count, u32 vertex_size, u16* indices, u32 index_count, f32 tolerance = 0.f);
+
+// For primitives with more vertices than u16 indices reach, welding can bring them back under
+u32 weld_vertices(u8* vertices, u32 vertex_count, u32 vertex_size, u32* indices, u32 index_count, f32 tolerance = 0.f);
+
+#endif // _MESH_WELD
@@ -0,0 +1,282 @@
+#include "meshlet.h"
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+
+#define NOT_IN_MESHLET 0xFF
+
+/////////////////////////////////
+// Bounds
+/////////////////////////////////
+
+static const f32* meshlet_position(const u8* positions, u32 position_stride, u32 vertex){
+    return (const f32*)(positions + (u64)vertex * position_stride);
+}
+
+static f32 meshlet_dot(const f32* a, const f32* b){
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static f32 meshlet_normalize(f32* v){
+    f32 length = sqrtf(meshlet_dot(v, v));
+    if(length > 0.f){
+        v[0] /= length; v[1] /= length; v[2] /= length;
+    }
+    return length;
+}
+
+static void meshlet_bounds(Meshlet* meshlet, const u16* meshlet_vertices, const u8* meshlet_triangles, const u8* positions, u32 position_stride){
+
+    const u16* vertices  = meshlet_vertices + meshlet->vertex_offset;
+    const u8*  triangles = meshlet_triangles + meshlet->triangle_offset;
+
+    // Sphere around the center of the bounding box
+    f32 bounds_min[3] = { INFINITY,  INFINITY,  INFINITY};
+    f32 bounds_max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for(u32 i = 0; i < meshlet->vertex_count; i++){
+        const f32* p = meshlet_position(positions, position_stride, vertices[i]);
+        for(u32 axis = 0; axis < 3; axis++){
+            bounds_min[axis] = p[axis] < bounds_min[axis] ? p[axis] : bounds_min[axis];
+            bounds_max[axis] = p[axis] > bounds_max[axis] ? p[axis] : bounds_max[axis];
+        }
+    }
+
+    f32 radius_squared = 0.f;
+    for(u32 axis = 0; axis < 3; axis++){
+        meshlet->center[axis] = (bounds_min[axis] + bounds_max[axis]) * 0.5f;
+    }
+    for(u32 i = 0; i < meshlet->vertex_count; i++){
+        const f32* p = meshlet_position(positions, position_stride, vertices[i]);
+        f32 offset[3] = {p[0] - meshlet->center[0], p[1] - meshlet->center[1], p[2] - meshlet->center[2]};
+        f32 distance_squared = meshlet_dot(offset, offset);
+        radius_squared = distance_squared > radius_squared ? distance_squared : radius_squared;
+    }
+    meshlet->radius = sqrtf(radius_squared);
+
+    // Cone around the average front face normal, clockwise front faces
+    f32 normals[MESHLET_MAX_TRIANGLES][3];
+    u32 normal_count = 0;
+    f32 axis[3] = {};
+
+    for(u32 i = 0; i < meshlet->triangle_count; i++){
+
+        const f32* p0 = meshlet_position(positions, position_stride, vertices[triangles[i * 3 + 0]]);
+        const f32* p1 = meshlet_position(positions, position_stride, vertices[triangles[i * 3 + 1]]);
+        const f32* p2 = meshlet_position(positions, position_stride, vertices[triangles[i * 3 + 2]]);
+
+        f32 edge0[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        f32 edge1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+
+        f32* normal = normals[normal_count];
+        normal[0] = edge0[1] * edge1[2] - edge0[2] * edge1[1];
+        normal[1] = edge0[2] * edge1[0] - edge0[0] * edge1[2];
+        normal[2] = edge0[0] * edge1[1] - edge0[1] * edge1[0];
+
+        // Degenerate triangles are never visible, they don't widen the cone
+        if(meshlet_normalize(normal) == 0.f){
+            continue;
+        }
+
+        axis[0] += normal[0]; axis[1] += normal[1]; axis[2] += normal[2];
+        normal_count++;
+
+    }
+
+    meshlet->cone_apex[0] = meshlet->cone_apex[1] = meshlet->cone_apex[2] = 0.f;
+    meshlet->cone_axis[0] = meshlet->cone_axis[1] = meshlet->cone_axis[2] = 0.f;
+    meshlet->cone_cutoff  = 1.f;
+
+    if(normal_count == 0 || meshlet_normalize(axis) == 0.f){
+        return;
+    }
+
+    f32 min_dot = 1.f;
+    for(u32 i = 0; i < normal_count; i++){
+        f32 dot = meshlet_dot(normals[i], axis);
+        min_dot = dot < min_dot ? dot : min_dot;
+    }
+
+    if(min_dot <= MESHLET_CONE_MIN_DOT){
+        return;
+    }
+
+    /*
+    *   The apex is moved back along the axis until it's behind every triangle's plane. A camera looking
+    *   at the apex from within cone_cutoff of the axis then sees the back of every triangle
+    */
+    f32 max_t = 0.f;
+    u32 normal_index = 0;
+    for(u32 i = 0; i < meshlet->triangle_count; i++){
+
+        const f32* p0 = meshlet_position(positions, position_stride, vertices[triangles[i * 3 + 0]]);
+        const f32* p1 = meshlet_position(positions, position_stride, vertices[triangles[i * 3 + 1]]);
+        const f32* p2 = meshlet_position(positions, position_stride, vertices[triangles[i * 3 + 2]]);
+
+        f32 edge0[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        f32 edge1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        f32 cross[3] = {edge0[1] * edge1[2] - edge0[2] * edge1[1], edge0[2] * edge1[0] - edge0[0] * edge1[2], edge0[0] * edge1[1] - edge0[1] * edge1[0]};
+        if(meshlet_dot(cross, cross) == 0.f){
+            continue;
+        }
+
+        const f32* normal = normals[normal_index++];
+        f32 to_center[3] = {meshlet->center[0] - p0[0], meshlet->center[1] - p0[1], meshlet->center[2] - p0[2]};
+        f32 t = meshlet_dot(to_center, normal) / meshlet_dot(axis, normal);
+        max_t = t > max_t ? t : max_t;
+
+    }
+
+    for(u32 i = 0; i < 3; i++){
+        meshlet->cone_apex[i] = meshlet->center[i] - axis[i] * max_t;
+        meshlet->cone_axis[i] = axis[i];
+    }
+    meshlet->cone_cutoff = sqrtf(1.f - min_dot * min_dot);
+
+}
+
+/////////////////////////////////
+// Builder
+/////////////////////////////////
+
+Meshlet_Counts build_meshlets(const u16* indices, u32 index_count, u32 vertex_count, const u8* positions, u32 position_stride,
+                              Meshlet* meshlets, u16* meshlet_vertices, u8* meshlet_triangles){
+
+    Meshlet_Counts counts = {};
+
+    u32 triangle_count = index_count / 3;
+    if(triangle_count == 0){
+        return counts;
+    }
+
+    // Each vertex's index in the current meshlet
+    u8* local_index = (u8*)malloc(vertex_count ? vertex_count : 1);
+    memset(local_index, NOT_IN_MESHLET, vertex_count);
+
+    Meshlet* meshlet = meshlets;
+    *meshlet = {};
+
+    for(u32 triangle = 0; triangle < triangle_count; triangle++){
+
+        const u16* corners = indices + triangle * 3;
+
+        u32 new_vertices = 0;
+        for(u32 corner = 0; corner < 3; corner++){
+            bool repeated = corner > 0 && (corners[corner] == corners[0] || (corner == 2 && corners[2] == corners[1]));
+            new_vertices += local_index[corners[corner]] == NOT_IN_MESHLET && !repeated;
+        }
+
+        // Doesn't fit, close this meshlet and start the next
+        if(meshlet->vertex_count + new_vertices > MESHLET_MAX_VERTICES || meshlet->triangle_count + 1u > MESHLET_MAX_TRIANGLES){
+
+            for(u32 i = 0; i < meshlet->vertex_count; i++){
+                local_index[meshlet_vertices[meshlet->vertex_offset + i]] = NOT_IN_MESHLET;
+            }
+
+            meshlet_bounds(meshlet, meshlet_vertices, meshlet_triangles, positions, position_stride);
+            counts.meshlet_count++;
+
+            Meshlet* next = meshlet + 1;
+            *next = {};
+            next->vertex_offset   = meshlet->vertex_offset + meshlet->vertex_count;
+            next->triangle_offset = meshlet->triangle_offset + meshlet->triangle_count * 3;
+            meshlet = next;
+
+        }
+
+        for(u32 corner = 0; corner < 3; corner++){
+            u32 vertex = corners[corner];
+            if(local_index[vertex] == NOT_IN_MESHLET){
+                local_index[vertex] = (u8)meshlet->vertex_count;
+                meshlet_vertices[meshlet->vertex_offset + meshlet->vertex_count++] = (u16)vertex;
+            }
+            meshlet_triangles[meshlet->triangle_offset + meshlet->triangle_count * 3 + corner] = local_index[vertex];
+        }
+        meshlet->triangle_count++;
+
+    }
+
+    meshlet_bounds(meshlet, meshlet_vertices, meshlet_triangles, positions, position_stride);
+    counts.meshlet_count++;
+
+    counts.vertex_count   = meshlet->vertex_offset + meshlet->vertex_count;
+    counts.triangle_count = meshlet->triangle_offset / 3 + meshlet->triangle_count;
+
+    free(local_index);
+
+    return counts;
+
+}
+
+/////////////////////////////////
+// Culling
+/////////////////////////////////
+
+void meshlet_frustum_from_matrix(const f32* matrix, Meshlet_Frustum* frustum){
+
+    // Gribb / Hartmann, the planes are sums of the matrix's columns
+    for(u32 row = 0; row < 4; row++){
+
+        f32 x = matrix[row * 4 + 0];
+        f32 y = matrix[row * 4 + 1];
+        f32 z = matrix[row * 4 + 2];
+        f32 w = matrix[row * 4 + 3];
+
+        frustum->planes[0][row] = w + x; // Left
+        frustum->planes[1][row] = w - x; // Right
+        frustum->planes[2][row] = w + y; // Bottom
+        frustum->planes[3][row] = w - y; // Top
+        frustum->planes[4][row] = z;     // Near, 0 to 1 depth
+        frustum->planes[5][row] = w - z; // Far
+
+    }
+
+    for(u32 i = 0; i < 6; i++){
+        f32* plane = frustum->planes[i];
+        f32 length = sqrtf(meshlet_dot(plane, plane));
+        if(length > 0.f){
+            plane[0] /= length; plane[1] /= length; plane[2] /= length; plane[3] /= length;
+        }
+    }
+
+}
+
+u32 cull_meshlets(const Meshlet* meshlets, u32 meshlet_count, const Meshlet_Frustum& frustum, const f32* camera_position,
+                  u8* visible, Meshlet_Cull_Stats* stats){
+
+    u32 visible_count = 0;
+
+    for(u32 i = 0; i < meshlet_count; i++){
+
+        const Meshlet& meshlet = meshlets[i];
+        stats->meshlet_count++;
+        stats->triangle_count += meshlet.triangle_count;
+
+        bool inside = true;
+        for(u32 plane = 0; plane < 6 && inside; plane++){
+            inside = meshlet_dot(frustum.planes[plane], meshlet.center) + frustum.planes[plane][3] >= -meshlet.radius;
+        }
+
+        if(!inside){
+            stats->frustum_culled_meshlets++;
+            stats->frustum_culled_triangles += meshlet.triangle_count;
+            if(visible) visible[i] = 0;
+            continue;
+        }
+
+        f32 view[3] = {meshlet.cone_apex[0] - camera_position[0], meshlet.cone_apex[1] - camera_position[1], meshlet.cone_apex[2] - camera_position[2]};
+        meshlet_normalize(view);
+        if(meshlet_dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff){
+            stats->cone_culled_meshlets++;
+            stats->cone_culled_triangles += meshlet.triangle_count;
+            if(visible) visible[i] = 0;
+            continue;
+        }
+
+        if(visible) visible[i] = 1;
+        visible_count++;
+
+    }
+
+    return visible_count;
+
+}
@@ -0,0 +1,113 @@
+#ifndef _MESHLET
+#define _MESHLET
+
+#include "d_types.h"
+
+/*
+*   Meshlets, small clusters of a primitive's triangles that can be culled on their own
+*
+*   build_meshlets walks the triangles in their optimize_mesh order and starts a new meshlet whenever
+*   the next triangle doesn't fit, so each meshlet is a run of triangles that share vertices.
+*   Every meshlet gets a bounding sphere for frustum culling and a normal cone for backface culling.
+*
+*   A meshlet is its own little indexed mesh: meshlet_vertices holds vertex_count indices into the
+*   primitive's vertices, and meshlet_triangles holds triangle_count * 3 u8 indices into those.
+*
+*   Front faces are clockwise, which is what the loaders' z flip turns glTF's counter-clockwise into.
+*/
+
+#define MESHLET_MAX_VERTICES  64
+#define MESHLET_MAX_TRIANGLES 124
+
+// The cone is wider than this (~84 degrees), it can't be backface culled from anywhere
+#define MESHLET_CONE_MIN_DOT  0.1f
+
+struct Meshlet {
+    u32 vertex_offset;    // Into the primitive's meshlet vertices
+    u32 triangle_offset;  // Into the primitive's meshlet triangles, in bytes
+    u16 vertex_count;
+    u16 triangle_count;
+
+    f32 center[3];        // Bounding sphere
+    f32 radius;
+
+    // Every triangle is backfacing from cameras where dot(normalize(cone_apex - camera), cone_axis) >= cone_cutoff
+    f32 cone_apex[3];
+    f32 cone_axis[3];
+    f32 cone_cutoff;      // 1 when the cone can't be culled
+};
+
+struct Meshlet_Counts {
+    u32 meshlet_count;
+    u32 vertex_count;     // Meshlet vertices
+    u32 triangle_count;
+};
+
+// Worst case outputs of build_meshlets for index_count indices, to size them with
+inline Meshlet_Counts meshlet_counts_bound(u32 index_count){
+
+    // A meshlet closed by the vertex limit holds at least MESHLET_MAX_VERTICES - 2 vertices, and so as many indices
+    u32 by_triangles = (index_count / 3 + MESHLET_MAX_TRIANGLES - 1) / MESHLET_MAX_TRIANGLES;
+    u32 by_vertices  = (index_count + MESHLET_MAX_VERTICES - 3) / (MESHLET_MAX_VERTICES - 2);
+
+    Meshlet_Counts bound;
+    bound.meshlet_count  = by_triangles > by_vertices ? by_triangles : by_vertices;
+    bound.vertex_count   = index_count;
+    bound.triangle_count = index_count / 3;
+    return bound;
+
+}
+
+/*
+*   Partitions a triangle list into meshlets. positions are position_stride bytes apart.
+*   The outputs have to hold meshlet_counts_bound(index_count), returns how much of them is used
+*/
+Meshlet_Counts build_meshlets(const u16* indices, u32 index_count, u32 vertex_count, const u8* positions, u32 position_stride,
+                              Meshlet* meshlets, u16* meshlet_vertices, u8* meshlet_triangles);
+
+/////////////////////////////////
+// Culling
+/////////////////////////////////
+
+// Inside is dot(plane.xyz, position) + plane.w >= 0, planes are normalized
+struct Meshlet_Frustum {
+    f32 planes[6][4];
+};
+
+struct Meshlet_Cull_Stats {
+    u64 meshlet_count;
+    u64 triangle_count;
+    u64 frustum_culled_meshlets;
+    u64 frustum_culled_triangles;
+    u64 cone_culled_meshlets;     // Inside the frustum, but every triangle faces away
+    u64 cone_culled_triangles;
+};
+
+inline void meshlet_cull_stats_add(Meshlet_Cull_Stats* total, const Meshlet_Cull_Stats& stats){
+    total->meshlet_count            += stats.meshlet_count;
+    total->triangle_count           += stats.triangle_count;
+    total->frustum_culled_meshlets  += stats.frustum_culled_meshlets;
+    total->frustum_culled_triangles += stats.frustum_culled_triangles;
+    total->cone_culled_meshlets     += stats.cone_culled_meshlets;
+    total->cone_culled_triangles    += stats.cone_culled_triangles;
+}
+
+// Share of the triangles culled, 0 to 1
+inline f32 meshlet_culled_ratio(u64 culled_triangles, const Meshlet_Cull_Stats& stats){
+    return stats.triangle_count ? (f32)culled_triangles / stats.triangle_count : 0.f;
+}
+
+/*
+*   Frustum planes of a row major matrix in DirectXMath's convention, clip = position * matrix with
+*   0 to 1 clip depth. With the model matrix in it, the planes are in model space.
+*/
+void meshlet_frustum_from_matrix(const f32* matrix, Meshlet_Frustum* frustum);
+
+/*
+*   CPU reference culler. camera_position is in the same space as the frustum.
+*   visible gets 1 or 0 per meshlet if it isn't NULL, returns the number of visible meshlets
+*/
+u32 cull_meshlets(const Meshlet* meshlets, u32 meshlet_count, const Meshlet_Frustum& frustum, const f32* camera_position,
+                  u8* visible, Meshlet_Cull_Stats* stats);
+
+#endif // _MESHLET
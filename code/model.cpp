@@ -1,6 +1,69 @@
 #include "model.h"
+#include "ddx_package.h"
+#include <DirectXPackedVector.h> // Half floats for quantized texture coordinates
+#include <float.h>
+
+/*
+*   stb_image allocates through these. While decode_image_job decodes an image on a thread, the first
+*   allocation the size of the decoded pixels is the image's region in the model's arena, so stb_image
+*   decodes straight into it. Everything else stb_image allocates is on the heap
+*/
+struct Model_Image_Region {
+    u8*  pixels;     // NULL while the thread isn't decoding an image
+    u64  size;
+    bool claimed;
+};
+
+static thread_local Model_Image_Region model_image_region;
+
+static void* model_stbi_malloc(size_t size){
+
+    Model_Image_Region& region = model_image_region;
+    if(region.pixels && !region.claimed && size == region.size){
+        region.claimed = true;
+        return region.pixels;
+    }
+    return malloc(size);
+
+}
+
+static void model_stbi_free(void* memory){
+
+    if(memory && memory == model_image_region.pixels){
+        model_image_region.claimed = false;
+        return;
+    }
+    free(memory);
+
+}
+
+static void* model_stbi_realloc(void* memory, size_t size){
+
+    Model_Image_Region& region = model_image_region;
+    if(memory == NULL || memory != region.pixels){
+        return realloc(memory, size);
+    }
+
+    if(size <= region.size){
+        return memory;
+    }
+
+    // Outgrew the region, carries on on the heap
+    void* moved = malloc(size);
+    if(moved){
+        memcpy(moved, memory, region.size);
+        region.claimed = false;
+    }
+    return moved;
+
+}
+
+#define STBI_MALLOC(size)          model_stbi_malloc(size)
+#define STBI_REALLOC(memory, size) model_stbi_realloc(memory, size)
+#define STBI_FREE(memory)          model_stbi_free(memory)
 
 #define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_EXTERNAL_IMAGE // Image files are decoded by load_materials
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "tiny_gltf.h"
@@ -10,10 +73,87 @@ using namespace d_dx12;
 using namespace DirectX;
 using namespace d_std;
 
-tg::TinyGLTF model_loader;
-
 #define BUFFER_OFFSET(i) ((char *)0 + (i))
 
+#define GLB_MAGIC      0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A // "JSON"
+#define GLB_CHUNK_BIN  0x004E4942 // "BIN\0"
+
+// Encoded bytes of an image stored in a buffer view, NULL if the image is a file or a data uri
+struct GLTF_Image_Bytes {
+    const u8* data;
+    u64       size;
+};
+
+/*
+*   Base pointer of each glTF buffer. External .bin buffers are memory mapped and a .glb's BIN
+*   chunk stays in the .glb's mapping, both read in place, instead of tinygltf reading each one
+*   into a std::vector that we then copy out of.
+*/
+struct GLTF_Buffer_Data {
+    Span<const u8*>        buffers;
+    Span<Mapped_File>      mapped_files;
+    Span<GLTF_Image_Bytes> images;     // Only set when the buffers are mapped
+    Mapped_File            glb_file;   // Kept mapped while anything reads its BIN chunk
+    bool                   mapped;
+    u64                    buffer_bytes;
+};
+
+/*
+*   Finds the JSON and BIN chunks of a .glb. bin is NULL if there's no BIN chunk.
+*   Returns false if the data isn't a .glb.
+*/
+static bool parse_glb(const u8* data, u64 size, const u8** json, u64* json_size, const u8** bin, u64* bin_size){
+
+    // 12 byte header, then the JSON chunk's 8 byte header
+    if(size < 20 || *(const u32*)data != GLB_MAGIC || *(const u32*)(data + 4) != 2){
+        return false;
+    }
+
+    u64 length = d_min((u64)*(const u32*)(data + 8), size);
+
+    *json = NULL;
+    *bin  = NULL;
+    *json_size = 0;
+    *bin_size  = 0;
+
+    for(u64 offset = 12; offset + 8 <= length;){
+
+        u64 chunk_size = *(const u32*)(data + offset);
+        u32 chunk_type = *(const u32*)(data + offset + 4);
+        offset += 8;
+
+        if(chunk_size > length - offset){
+            return false;
+        }
+
+        if(chunk_type == GLB_CHUNK_JSON && *json == NULL){
+            *json      = data + offset;
+            *json_size = chunk_size;
+        } else if(chunk_type == GLB_CHUNK_BIN && *bin == NULL){
+            *bin      = data + offset;
+            *bin_size = chunk_size;
+        }
+
+        // Chunks are 4 byte aligned
+        offset += AlignPow2Up(chunk_size, 4);
+
+    }
+
+    return *json != NULL;
+
+}
+
+// Returns a pointer to the accessor's first element, and the byte stride between elements
+static const u8* accessor_data(tg::Model& tg_model, GLTF_Buffer_Data& buffer_data, const tg::Accessor& accessor, u32* byte_stride){
+
+    const tg::BufferView& buffer_view = tg_model.bufferViews[accessor.bufferView];
+    *byte_stride = (u32)accessor.ByteStride(buffer_view);
+
+    return buffer_data.buffers.ptr[buffer_view.buffer] + buffer_view.byteOffset + accessor.byteOffset;
+
+}
+
 /*
 *   Load a gltf model
 */
@@ -47,421 +187,1874 @@ bool load_image_function(tg::Image *tg_image, const int image_idx, std::string *
 }
 #endif
 
+// Every allocation in a model's arena starts on this, enough for SSE loads of the vertices
+#define MODEL_ARENA_ALIGNMENT 16
+
+static u64 model_arena_size(u64 size){
+
+    return AlignPow2Up(size, (u64)MODEL_ARENA_ALIGNMENT);
+
+}
+
+// An arena that fits size bytes of allocations, each rounded with model_arena_size
+static Memory_Arena* model_make_arena(u64 size){
+
+    return make_arena_reserve(model_arena_size(sizeof(Memory_Arena)) + size);
+
+}
+
+// nitems from the model's arena, not zeroed
+template<typename T>
+static void model_arena_alloc(Memory_Arena* arena, Span<T>& span, u64 nitems){
+
+    span.ptr    = (T*)arena->push_aligned(nitems * sizeof(T), MODEL_ARENA_ALIGNMENT);
+    span.nitems = nitems;
+
+}
+
 /*
-*   Loads a mesh from the tg_model
-*   Stores Indicies and Verticies (Primitive attributes)
-*   Currently only supports POSITION, TEXCOORD_0, and COLOR_0
-*   Loads to CPU memory only!
+*   A job's share of the model's arena, pushed on the loading thread with room for the most the job can
+*   allocate, so jobs fill their own regions in parallel. Whatever a job doesn't use is taken back by
+*   model_arena_compact
 */
-void load_mesh(D_Model& d_model, tg::Model& tg_model, tg::Mesh& mesh){
+struct Model_Arena_Region {
+    u8* next;   // Where the job's next allocation goes
+};
 
-    // Allocate and loop through array of meshes
-    d_model.meshes.alloc(tg_model.meshes.size());
-    for(u64 mesh_index = 0; mesh_index < d_model.meshes.nitems; mesh_index++){
+// nitems from the region, not zeroed. The region's size has to account for it
+template<typename T>
+static void model_region_alloc(Model_Arena_Region* region, Span<T>& span, u64 nitems){
 
-        D_Mesh* mesh = d_model.meshes.ptr + mesh_index;
-        tg::Mesh tg_mesh = tg_model.meshes[mesh_index];
+    span.ptr     = (T*)region->next;
+    span.nitems  = nitems;
+    region->next += model_arena_size(nitems * sizeof(T));
 
-        // Allocate and loop through array of primative groups
-        mesh->primitive_groups.alloc(tg_mesh.primitives.size());
-        for(u64 primative_group_index = 0; primative_group_index < mesh->primitive_groups.nitems; primative_group_index++){
+}
 
-            D_Primitive_Group* primative_group = mesh->primitive_groups.ptr + primative_group_index;
-            tg::Primitive primitive = tg_mesh.primitives[primative_group_index];
-
-            // Fill primative group
-
-            /////////////////////
-            // Indicies
-            /////////////////////
-            {
-                // Get Indicies accessor
-                tg::Accessor index_accessor = tg_model.accessors[primitive.indices];
-                // Get the buffer fiew our accessor references
-                const tg::BufferView &buffer_view = tg_model.bufferViews[index_accessor.bufferView];
-                // The buffer our buffer view is referencing
-                const tg::Buffer &buffer = tg_model.buffers[buffer_view.buffer];
-                // Alloc mem for indicies
-                int index_byte_stride = index_accessor.ByteStride(buffer_view);
-                primative_group->indicies.alloc(index_accessor.count);
-
-                // copy over indicies
-                for(u64 i = 0; i < index_accessor.count; i++){
-                    // WARNING: u16* would need to change with different sizes / byte_strides of indicies
-                    //primative_group->indicies.ptr[i] = ((u16*)(&buffer.data.at(0) + buffer_view.byteOffset))[i];
-                    primative_group->indicies.ptr[i] = ((u16*)(&buffer.data.at(0) + index_accessor.byteOffset))[i];
-                }
+/*
+*   Slides span down to position, the first byte of the arena the compaction hasn't filled yet, and moves
+*   position past it. Spans have to come in the order they were allocated, so each one only ever moves
+*   down over space that's already been moved out of
+*/
+template<typename T>
+static void model_arena_compact(Memory_Arena* arena, Span<T>& span, u64* position){
+
+    if(span.ptr == NULL){
+        return;
+    }
+
+    T* destination = (T*)((u8*)arena + *position);
+    if(destination != span.ptr){
+        memmove(destination, span.ptr, span.nitems * sizeof(T));
+        span.ptr = destination;
+    }
+    *position += model_arena_size(span.nitems * sizeof(T));
+
+}
+
+// A primitive group's spans, in the order decode_primitive and build_procedural_box allocate them
+static void model_compact_primitive_group(Memory_Arena* arena, D_Primitive_Group& primitive_group, u64* position){
+
+    model_arena_compact(arena, primitive_group.verticies,         position);
+    model_arena_compact(arena, primitive_group.indicies,          position);
+    model_arena_compact(arena, primitive_group.indicies_32,       position);
+    model_arena_compact(arena, primitive_group.meshlets,          position);
+    model_arena_compact(arena, primitive_group.meshlet_vertices,  position);
+    model_arena_compact(arena, primitive_group.meshlet_triangles, position);
+    model_arena_compact(arena, primitive_group.lod_indicies,      position);
+
+}
+
+/*
+*   Primitives without a material, or with one that isn't in the file, use a default one after the glTF's
+*   materials. load_materials adds it when gltf_needs_default_material
+*/
+static u32 gltf_material_index(tg::Model& tg_model, int material){
+
+    return material >= 0 && material < (int)tg_model.materials.size() ? (u32)material : (u32)tg_model.materials.size();
+
+}
+
+static bool gltf_needs_default_material(tg::Model& tg_model){
+
+    for(const tg::Mesh& tg_mesh : tg_model.meshes){
+        for(const tg::Primitive& primitive : tg_mesh.primitives){
+            if(gltf_material_index(tg_model, primitive.material) == tg_model.materials.size()){
+                return true;
             }
+        }
+    }
+    return false;
 
-            /////////////////////////
-            // Primitive attributes
-            /////////////////////////
-            {
-                // Find position attribute and allocate memory
-                for (auto &attribute : primitive.attributes){
-                    if(attribute.first.compare("POSITION") == 0){
-                        tg::Accessor accessor = tg_model.accessors[attribute.second];
-                        primative_group->verticies.alloc(accessor.count, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord));
-                    }
-                }
+}
+
+// POSITION's count, 0 without one
+static u64 gltf_vertex_count(tg::Model& tg_model, const tg::Primitive& primitive){
+
+    auto position = primitive.attributes.find("POSITION");
+    return position != primitive.attributes.end() ? tg_model.accessors[position->second].count : 0;
+
+}
+
+/*
+*   The most decode_primitive allocates for primitive: every vertex (welding only removes some), indices
+*   read at full width, then the meshlet and LOD bounds for triangle lists
+*/
+static u64 gltf_primitive_arena_bound(tg::Model& tg_model, const tg::Primitive& primitive){
+
+    u64 vertex_count = gltf_vertex_count(tg_model, primitive);
+    u64 index_count  = primitive.indices >= 0 ? tg_model.accessors[primitive.indices].count : vertex_count;
+    u64 size = model_arena_size(vertex_count * sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord)) + model_arena_size(index_count * sizeof(u32));
+
+    if(primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1){
+        Meshlet_Counts bound = meshlet_counts_bound((u32)index_count);
+        size += model_arena_size(bound.meshlet_count * sizeof(Meshlet)) + model_arena_size(bound.vertex_count * sizeof(u16)) +
+                model_arena_size(bound.triangle_count * 3) + model_arena_size(mesh_lod_indices_bound((u32)index_count) * sizeof(u16));
+    }
+
+    return size;
+
+}
 
-                // For each attribute our mesh has
-                for (auto &attribute : primitive.attributes){
-                    // Get the accessor for our attribute
-                    tg::Accessor accessor = tg_model.accessors[attribute.second];
-                    // Get the buffer fiew our accessor references
-                    const tg::BufferView &buffer_view = tg_model.bufferViews[accessor.bufferView];
-                    // The buffer our buffer view is referencing
-                    const tg::Buffer &buffer = tg_model.buffers[buffer_view.buffer];
-
-                    int byte_stride = accessor.ByteStride(buffer_view);
-                    int size = 1;
-                    if(accessor.type != TINYGLTF_TYPE_SCALAR){
-                        size = accessor.type;
-                    }
-                    
-                    if(attribute.first.compare("POSITION") == 0){
-                        for(int i = 0; i < primative_group->verticies.nitems; i++){
-                            primative_group->verticies.ptr[i].position = ((DirectX::XMFLOAT3*)(&buffer.data.at(0) + buffer_view.byteOffset))[i];
-                            primative_group->verticies.ptr[i].position.z = -primative_group->verticies.ptr[i].position.z;
-                        }
-                    } else if(attribute.first.compare("NORMAL") == 0){
-                        for(int i = 0; i < primative_group->verticies.nitems; i++){
-                            primative_group->verticies.ptr[i].normal = ((DirectX::XMFLOAT3*)(&buffer.data.at(0) + buffer_view.byteOffset))[i];
-                            primative_group->verticies.ptr[i].normal.z = -primative_group->verticies.ptr[i].normal.z;
-                        }
-                    } else if(attribute.first.compare("TANGENT") == 0){
-                        for(int i = 0; i < primative_group->verticies.nitems; i++){
-                            primative_group->verticies.ptr[i].tangent = ((DirectX::XMFLOAT4*)(&buffer.data.at(0) + buffer_view.byteOffset))[i];
-                            primative_group->verticies.ptr[i].tangent.z = -primative_group->verticies.ptr[i].tangent.z;
-                            // primative_group->verticies.ptr[i].tangent.y = -primative_group->verticies.ptr[i].tangent.y;
-                        }
-                    } else if(attribute.first.compare("TEXCOORD_0") == 0){
-                        for(int i = 0; i < primative_group->verticies.nitems; i++){
-                            primative_group->verticies.ptr[i].texture_coordinates = ((DirectX::XMFLOAT2*)(&buffer.data.at(0) + buffer_view.byteOffset))[i];
-                            // Dx12 UV is different than OpenGL / GLTF
-                            // primative_group->verticies.ptr[i].texture_coordinates.y = 1 - primative_group->verticies.ptr[i].texture_coordinates.y;
-                        }
-                    } else if(attribute.first.compare("COLOR_0") == 0){
-                        for(int i = 0; i < primative_group->verticies.nitems; i++){
-                            primative_group->verticies.ptr[i].color = ((DirectX::XMFLOAT3*)(&buffer.data.at(0) + buffer_view.byteOffset))[i];
-                        }
-                    }
-
-                    #if 0
-                    char* out_buffer = (char*)calloc(500, sizeof(char));
-                    sprintf(out_buffer, "attribute.first: %s size: %u, count: %u, accessor.componentType: %u, accessor.normalized: %u, byteStride: %u, byteOffset: %u\n", attribute.first.c_str(), size, buffer_view.byteLength / byte_stride, accessor.componentType, accessor.normalized, byte_stride, BUFFER_OFFSET(accessor.byteOffset));
-                    OutputDebugString(out_buffer);
-                    free(out_buffer);
-                    #endif
+// Same mapping as ddx_cook, D3D has no fans so they're drawn as lists like any unknown mode
+static D3D_PRIMITIVE_TOPOLOGY gltf_primitive_topology(int mode){
+
+    switch(mode){
+        case TINYGLTF_MODE_POINTS:         return D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+        case TINYGLTF_MODE_LINE:           return D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+        case TINYGLTF_MODE_LINE_STRIP:     return D3D_PRIMITIVE_TOPOLOGY_LINESTRIP;
+        case TINYGLTF_MODE_TRIANGLE_STRIP: return D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+        default:                           return D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    }
+
+}
+
+// The meshes, their primitive groups and draw calls, and every primitive's bound
+static u64 gltf_meshes_arena_bound(tg::Model& tg_model){
+
+    u64 size = model_arena_size(tg_model.meshes.size() * sizeof(D_Mesh));
+    for(const tg::Mesh& tg_mesh : tg_model.meshes){
+        size += model_arena_size(tg_mesh.primitives.size() * sizeof(D_Primitive_Group)) + model_arena_size(tg_mesh.primitives.size() * sizeof(D_Draw_Call));
+        for(const tg::Primitive& primitive : tg_mesh.primitives){
+            size += gltf_primitive_arena_bound(tg_model, primitive);
+        }
+    }
+    return size;
+
+}
+
+/*
+*   Decodes one primitive from the tg_model into a primitive group
+*   Stores Indicies and Verticies (Primitive attributes)
+*   Currently only supports POSITION, NORMAL, TANGENT, TEXCOORD_0, and COLOR_0
+*   Loads to CPU memory only! Everything is allocated from region, which has gltf_primitive_arena_bound bytes
+*   Only reads tg_model, so primitives can be decoded in parallel
+*   Vertices are welded, weld_stats gets the vertex counts before and after
+*   Primitives that still have more vertices than u16 indices reach get indicies_32 instead of indicies. The mesh
+*   processing below is u16 only apart from tangents and bounds, so those are drawn without meshlets or LODs
+*   Triangle lists are run through optimize_mesh, returns its vertex cache stats
+*/
+static Mesh_Optimize_Stats decode_primitive(tg::Model& tg_model, GLTF_Buffer_Data& buffer_data, const tg::Primitive& primitive, D_Primitive_Group* primative_group,
+                                            Model_Arena_Region* region, Mesh_Weld_Stats* weld_stats){
+
+    // Fill primative group
+    primative_group->primitive_topology = gltf_primitive_topology(primitive.mode);
+
+    // Attributes the primitive doesn't have stay zero
+    model_region_alloc(region, primative_group->verticies, gltf_vertex_count(tg_model, primitive));
+    memset(primative_group->verticies.ptr, 0, primative_group->verticies.nitems * sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord));
+
+    /////////////////////
+    // Indicies
+    /////////////////////
+
+    // Read at full width, whether they fit in u16 is only known once the vertices are welded
+    Span<u32> indicies_32;
+    if(primitive.indices >= 0){
+        // Get Indicies accessor
+        const tg::Accessor& index_accessor = tg_model.accessors[primitive.indices];
+        // Where the indicies start in the buffer, and how far apart they are
+        u32 index_byte_stride;
+        const u8* index_data = accessor_data(tg_model, buffer_data, index_accessor, &index_byte_stride);
+        // Alloc mem for indicies
+        model_region_alloc(region, indicies_32, index_accessor.count);
+
+        // copy over indicies, glTF has u8, u16 and u32 ones
+        for(u64 i = 0; i < index_accessor.count; i++){
+            const u8* index = index_data + i * index_byte_stride;
+            switch(index_accessor.componentType){
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  indicies_32.ptr[i] = *index;              break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: indicies_32.ptr[i] = *(const u16*)index;  break;
+                default:                                     indicies_32.ptr[i] = *(const u32*)index;  break;
+            }
+        }
+    }
 
+    /////////////////////////
+    // Primitive attributes
+    /////////////////////////
+    {
+        // For each attribute our mesh has
+        for (const auto &attribute : primitive.attributes){
+            // Get the accessor for our attribute
+            const tg::Accessor& accessor = tg_model.accessors[attribute.second];
+            // Where the attribute starts in the buffer, and how far apart each vertex's attribute is
+            u32 byte_stride;
+            const u8* data = accessor_data(tg_model, buffer_data, accessor, &byte_stride);
+            int size = 1;
+            if(accessor.type != TINYGLTF_TYPE_SCALAR){
+                size = accessor.type;
+            }
+            
+            if(attribute.first.compare("POSITION") == 0){
+                for(int i = 0; i < primative_group->verticies.nitems; i++){
+                    primative_group->verticies.ptr[i].position = *(DirectX::XMFLOAT3*)(data + i * byte_stride);
+                    primative_group->verticies.ptr[i].position.z = -primative_group->verticies.ptr[i].position.z;
+                }
+            } else if(attribute.first.compare("NORMAL") == 0){
+                for(int i = 0; i < primative_group->verticies.nitems; i++){
+                    primative_group->verticies.ptr[i].normal = *(DirectX::XMFLOAT3*)(data + i * byte_stride);
+                    primative_group->verticies.ptr[i].normal.z = -primative_group->verticies.ptr[i].normal.z;
+                }
+            } else if(attribute.first.compare("TANGENT") == 0){
+                for(int i = 0; i < primative_group->verticies.nitems; i++){
+                    primative_group->verticies.ptr[i].tangent = *(DirectX::XMFLOAT4*)(data + i * byte_stride);
+                    primative_group->verticies.ptr[i].tangent.z = -primative_group->verticies.ptr[i].tangent.z;
+                    // primative_group->verticies.ptr[i].tangent.y = -primative_group->verticies.ptr[i].tangent.y;
+                }
+            } else if(attribute.first.compare("TEXCOORD_0") == 0){
+                for(int i = 0; i < primative_group->verticies.nitems; i++){
+                    primative_group->verticies.ptr[i].texture_coordinates = *(DirectX::XMFLOAT2*)(data + i * byte_stride);
+                    // Dx12 UV is different than OpenGL / GLTF
+                    // primative_group->verticies.ptr[i].texture_coordinates.y = 1 - primative_group->verticies.ptr[i].texture_coordinates.y;
+                }
+            } else if(attribute.first.compare("COLOR_0") == 0){
+                for(int i = 0; i < primative_group->verticies.nitems; i++){
+                    primative_group->verticies.ptr[i].color = *(DirectX::XMFLOAT3*)(data + i * byte_stride);
                 }
             }
 
             #if 0
-            for (int vertex_index = 0; vertex_index < primative_group->verticies.nitems; vertex_index++) {
-                DirectX::XMVECTOR tangent = DirectX::XMVectorZero();
-                DirectX::XMVECTOR bitangent = DirectX::XMVectorZero();
-                u32 triangles_included = 0;
-
-                for (u32 index = 0; index < primative_group->indicies.nitems; index += 3) {
-
-                    u32 index0 = primative_group->indicies.ptr[index];
-                    u32 index1 = primative_group->indicies.ptr[index + 1];
-                    u32 index2 = primative_group->indicies.ptr[index + 2];
-
-                    // Only calc if a index matches our vertex
-                    if (index0 == vertex_index || index1 == vertex_index || index2 == vertex_index) {
-                        DirectX::XMVECTOR vertex0_pos = DirectX::XMLoadFloat3(&primative_group->verticies.ptr[index0].position);
-                        DirectX::XMVECTOR vertex1_pos = DirectX::XMLoadFloat3(&primative_group->verticies.ptr[index1].position);
-                        DirectX::XMVECTOR vertex2_pos = DirectX::XMLoadFloat3(&primative_group->verticies.ptr[index2].position);
-
-                        DirectX::XMFLOAT2 vertex0_uv = primative_group->verticies.ptr[index0].texture_coordinates;
-                        DirectX::XMFLOAT2 vertex1_uv = primative_group->verticies.ptr[index1].texture_coordinates;
-                        DirectX::XMFLOAT2 vertex2_uv = primative_group->verticies.ptr[index2].texture_coordinates;
-
-                        DirectX::XMVECTOR delta_pos0;
-                        delta_pos0 = DirectX::XMVectorSubtract(vertex1_pos, vertex0_pos);
-
-                        DirectX::XMVECTOR delta_pos1;
-                        delta_pos1 = DirectX::XMVectorSubtract(vertex2_pos, vertex0_pos);
-
-                        DirectX::XMFLOAT2 delta_uv0;
-                        delta_uv0.x = vertex1_uv.x - vertex0_uv.x;
-                        delta_uv0.y = vertex1_uv.y - vertex0_uv.y;
-
-                        DirectX::XMFLOAT2 delta_uv1;
-                        delta_uv1.x = vertex2_uv.x - vertex0_uv.x;
-                        delta_uv1.y = vertex2_uv.y - vertex0_uv.y;
-
-                        float f = 1.0 / (delta_uv0.x * delta_uv1.y - delta_uv0.y * delta_uv1.x);
-                        tangent += (delta_uv1.y * delta_pos0 - delta_pos1 * delta_uv0.y) * f;
-                        bitangent += (delta_pos1 * delta_uv0.x - delta_pos0 * delta_uv1.x) * f;
-                        triangles_included += 1;
-                    }
-                }
+            char* out_buffer = (char*)calloc(500, sizeof(char));
+            sprintf(out_buffer, "attribute.first: %s size: %u, count: %u, accessor.componentType: %u, accessor.normalized: %u, byteStride: %u, byteOffset: %u\n", attribute.first.c_str(), size, buffer_view.byteLength / byte_stride, accessor.componentType, accessor.normalized, byte_stride, BUFFER_OFFSET(accessor.byteOffset));
+            OutputDebugString(out_buffer);
+            free(out_buffer);
+            #endif
 
-                if (triangles_included > 0) {
-                    tangent /= triangles_included;
-                    bitangent /= triangles_included;
-                    tangent = DirectX::XMVector3Normalize(tangent);
-                    bitangent = DirectX::XMVector3Normalize(bitangent);
-                }
+        }
+    }
 
-                XMStoreFloat3(&primative_group->verticies.ptr[vertex_index].tangent, tangent);
-                XMStoreFloat3(&primative_group->verticies.ptr[vertex_index].bitangent, bitangent);
+    // Primitives without indices draw their vertices in order
+    if(primitive.indices < 0){
+        model_region_alloc(region, indicies_32, primative_group->verticies.nitems);
+        for(u64 i = 0; i < indicies_32.nitems; i++){
+            indicies_32.ptr[i] = (u32)i;
+        }
+    }
 
-            }
-            #endif
+    // Exporters repeat vertices, merging the identical ones shrinks the vertex buffer and helps the vertex cache
+    weld_stats->vertex_count = primative_group->verticies.nitems;
+    u32 welded_vertex_count  = weld_vertices((u8*)primative_group->verticies.ptr, (u32)primative_group->verticies.nitems, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord),
+        indicies_32.ptr, (u32)indicies_32.nitems);
+    primative_group->verticies.nitems = welded_vertex_count;
+    weld_stats->welded_vertex_count = primative_group->verticies.nitems;
+
+    // u16 indices whenever the vertices allow, they're half the size
+    bool wide_indices = primative_group->verticies.nitems > 0x10000;
+    u32 index_count   = (u32)indicies_32.nitems;
+    if(wide_indices){
+        primative_group->indicies_32 = indicies_32;
+    } else {
+        // Narrowed in place, each u16 only lands on u32s already read. The compaction takes back the other half
+        u8* index_bytes = (u8*)indicies_32.ptr;
+        for(u32 i = 0; i < index_count; i++){
+            u32 index;
+            memcpy(&index, index_bytes + i * sizeof(u32), sizeof(u32));
+            u16 narrow_index = (u16)index;
+            memcpy(index_bytes + i * sizeof(u16), &narrow_index, sizeof(u16));
+        }
+        primative_group->indicies.ptr    = (u16*)index_bytes;
+        primative_group->indicies.nitems = index_count;
+    }
 
-            primative_group->material_index = primitive.material;
+    // Without TANGENT the normal map needs generated ones, the same ones ddx_cook generates
+    bool is_triangle_list = primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1;
+    if(is_triangle_list && primitive.attributes.find("TANGENT") == primitive.attributes.end()){
+        u8* vertices = (u8*)primative_group->verticies.ptr;
+        u32 vertex_count = (u32)primative_group->verticies.nitems;
+        if(wide_indices){
+            generate_tangents(vertices, vertex_count, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord),
+                offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, normal), offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, texture_coordinates),
+                offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, tangent), primative_group->indicies_32.ptr, index_count);
+        } else {
+            generate_tangents(vertices, vertex_count, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord),
+                offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, normal), offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, texture_coordinates),
+                offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, tangent), primative_group->indicies.ptr, index_count);
         }
     }
-}
 
-// Load every mesh in each node, then load the node's children nodes
-void load_model_nodes(D_Model& d_model, tg::Model& tg_model, tg::Node& node){
+    primative_group->material_index = gltf_material_index(tg_model, primitive.material);
+
+    // Welding left only the vertices the indices use
+    mesh_bounds_compute((const u8*)primative_group->verticies.ptr, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord), (u32)primative_group->verticies.nitems,
+        &primative_group->bounds);
+
+    if(wide_indices){
+        primative_group->lods[0]   = {0, index_count, 0.f};
+        primative_group->lod_count = 1;
+        return {};
+    }
+
+    Mesh_Optimize_Stats optimize_stats = {};
+    if(primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1){
+        optimize_stats = optimize_mesh((u8*)primative_group->verticies.ptr, (u32)primative_group->verticies.nitems, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord),
+            primative_group->indicies.ptr, (u32)primative_group->indicies.nitems);
+    }
+
+    if((primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1) && primative_group->indicies.nitems >= 3){
+
+        Meshlet_Counts bound = meshlet_counts_bound((u32)primative_group->indicies.nitems);
+        model_region_alloc(region, primative_group->meshlets,          bound.meshlet_count);
+        model_region_alloc(region, primative_group->meshlet_vertices,  bound.vertex_count);
+        model_region_alloc(region, primative_group->meshlet_triangles, bound.triangle_count * 3);
+
+        Meshlet_Counts counts = build_meshlets(primative_group->indicies.ptr, (u32)primative_group->indicies.nitems, (u32)primative_group->verticies.nitems,
+            (const u8*)primative_group->verticies.ptr, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord),
+            primative_group->meshlets.ptr, primative_group->meshlet_vertices.ptr, primative_group->meshlet_triangles.ptr);
+
+        // What was used, the compaction takes back the rest
+        primative_group->meshlets.nitems          = counts.meshlet_count;
+        primative_group->meshlet_vertices.nitems  = counts.vertex_count;
+        primative_group->meshlet_triangles.nitems = counts.triangle_count * 3;
 
-    if(node.mesh > -1 && node.mesh < tg_model.meshes.size()){
-        load_mesh(d_model, tg_model, tg_model.meshes[node.mesh]);
     }
 
-    for(u64 i = 0; i < node.children.size(); i++){
-        load_model_nodes(d_model, tg_model, tg_model.nodes[node.children[i]]);
+    primative_group->lods[0]   = {0, (u32)primative_group->indicies.nitems, 0.f};
+    primative_group->lod_count = 1;
+
+    if(primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1){
+
+        model_region_alloc(region, primative_group->lod_indicies, mesh_lod_indices_bound((u32)primative_group->indicies.nitems));
+
+        u32 lod_index_count;
+        primative_group->lod_count = build_lod_chain((const u8*)primative_group->verticies.ptr, (u32)primative_group->verticies.nitems, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord),
+            offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, normal), offsetof(Vertex_Position_Normal_Tangent_Color_Texturecoord, texture_coordinates),
+            primative_group->indicies.ptr, (u32)primative_group->indicies.nitems, primative_group->lod_indicies.ptr, primative_group->lods, &lod_index_count);
+
+        primative_group->lod_indicies.nitems = lod_index_count;
+
     }
 
+    return optimize_stats;
+
 }
 
-// Load the materials from tg_model to d_model
-// Currently only supports baseColorTextures
-void load_materials(D_Model& d_model, tg::Model& tg_model){
+struct GLTF_Primitive_Job {
+    const tg::Primitive* primitive;
+    D_Primitive_Group*   primitive_group;
+    Model_Arena_Region   region;
+    Mesh_Optimize_Stats  optimize_stats;
+    Mesh_Weld_Stats      weld_stats;
+};
 
-    // If there are textures available:
-    if(tg_model.textures.size() > 0){
+struct GLTF_Decode_Jobs {
+    tg::Model*          tg_model;
+    GLTF_Buffer_Data*   buffer_data;
+    GLTF_Primitive_Job* primitives;
+};
 
-        // Allocate the correct number of materials
-        d_model.materials.alloc(tg_model.materials.size());
+static void decode_primitive_job(void* data, u32 index){
 
-        // Load each material from tg_model
-        for(u16 j = 0; j < tg_model.materials.size(); j++){
+    GLTF_Decode_Jobs* decode_jobs = (GLTF_Decode_Jobs*)data;
+    GLTF_Primitive_Job& job = decode_jobs->primitives[index];
 
-            /////////////////////
-            // Albedo Texture
-            /////////////////////
+    job.optimize_stats = decode_primitive(*decode_jobs->tg_model, *decode_jobs->buffer_data, *job.primitive, job.primitive_group, &job.region, &job.weld_stats);
 
-            // Here, we are only storing, and using, the base color texture
-            u32 texture_index = tg_model.materials[j].pbrMetallicRoughness.baseColorTexture.index;
-            tg::Texture &tex = tg_model.textures[texture_index];
+}
 
-            // Get reference to corresponding material in d_model
-            D_Material &material = d_model.materials.ptr[j];
+/*
+*   Loads every mesh in the tg_model into the model's arena, which has room for gltf_meshes_arena_bound.
+*   Allocation is done up front on this thread, each primitive gets a region of its bound and is decoded
+*   as its own job. Then the primitives are packed down to what they used and the rest is popped.
+*/
+void load_meshes(D_Model& d_model, tg::Model& tg_model, GLTF_Buffer_Data& buffer_data){
 
-            // If we have a baseColorTexture
-            if(tex.source >= 0){
+    Memory_Arena* arena = d_model.arena;
+    u64 primitive_count = 0;
 
-                // Load the image corresponding to the texture
-                tg::Image &image = tg_model.images[tex.source];
+    // Allocate the meshes and their primitive groups
+    model_arena_alloc(arena, d_model.meshes, tg_model.meshes.size());
+    for(u64 mesh_index = 0; mesh_index < d_model.meshes.nitems; mesh_index++){
 
-                material.albedo_texture.texture_desc.width = image.width;
-                material.albedo_texture.texture_desc.height = image.height;
+        D_Mesh* mesh = d_model.meshes.ptr + mesh_index;
+        *mesh = {};
+        model_arena_alloc(arena, mesh->primitive_groups, tg_model.meshes[mesh_index].primitives.size());
+        model_arena_alloc(arena, mesh->draw_calls, mesh->primitive_groups.nitems);
+        for(u64 i = 0; i < mesh->primitive_groups.nitems; i++){
+            mesh->primitive_groups.ptr[i] = {};
+        }
+        primitive_count += mesh->primitive_groups.nitems;
 
-                DXGI_FORMAT image_format = DXGI_FORMAT_UNKNOWN;
-                
-                // Store the image_format
-                if(image.component == 1){
-                    if(image.bits == 8){
-                        image_format = DXGI_FORMAT_R8_UINT;
-                    } else if(image.bits == 16){
-                        image_format = DXGI_FORMAT_R16_UINT;
-                    }
-                } else if (image.component == 2){
-                    if(image.bits == 8){
-                        image_format = DXGI_FORMAT_R8G8_UINT;
-                    } else if(image.bits == 16){
-                        image_format = DXGI_FORMAT_R16G16_UINT;
-                    }
-                } else if (image.component == 3){
-                    // ?
-                } else if (image.component == 4){
-                    if(image.bits == 8){
-                        image_format = DXGI_FORMAT_R8G8B8A8_UNORM;
-                    } else if(image.bits == 16){
-                        image_format = DXGI_FORMAT_R16G16B16A16_UINT;
-                    }
-                }
+    }
 
-                // Store a description of the texture
-                material.albedo_texture.texture_desc.format     = image_format;
-                material.albedo_texture.texture_desc.usage      = Texture::USAGE::USAGE_SAMPLED;
+    // One job per primitive
+    Span<GLTF_Primitive_Job> primitive_jobs;
+    primitive_jobs.alloc(primitive_count);
 
-                // Allocate enough room for the raw image data
-                material.albedo_texture.cpu_texture_data.alloc(image.image.size());
-                // Copy the raw image data over to d_model material j
-                memcpy(material.albedo_texture.cpu_texture_data.ptr, &image.image.at(0), image.image.size());
+    u64 job_index    = 0;
+    u64 regions_size = 0;
+    for(u64 mesh_index = 0; mesh_index < d_model.meshes.nitems; mesh_index++){
 
-                
-            }
+        D_Mesh* mesh = d_model.meshes.ptr + mesh_index;
+        const tg::Mesh& tg_mesh = tg_model.meshes[mesh_index];
 
-            /////////////////////
-            // Normal Map
-            /////////////////////
-
-            // Here, we are only storing, and using, the normal texture
-            texture_index = tg_model.materials[j].normalTexture.index;
-
-            // If the texture intex is valid (isn't when we don't have a normal texture)
-            if(texture_index != UINT_MAX){
-
-                tex = tg_model.textures[texture_index];
-
-                // Get reference to corresponding material in d_model
-                material = d_model.materials.ptr[j];
-                material.material_flags |= MATERIAL_FLAG_NORMAL_TEXTURE;
-
-                // Load the image corresponding to the texture
-                tg::Image &image = tg_model.images[tex.source];
-
-                material.normal_texture.texture_desc.width = image.width;
-                material.normal_texture.texture_desc.height = image.height;
-
-                DXGI_FORMAT image_format = DXGI_FORMAT_UNKNOWN;
-                
-                // Store the image_format
-                if(image.component == 1){
-                    if(image.bits == 8){
-                        image_format = DXGI_FORMAT_R8_UINT;
-                    } else if(image.bits == 16){
-                        image_format = DXGI_FORMAT_R16_UINT;
-                    }
-                } else if (image.component == 2){
-                    if(image.bits == 8){
-                        image_format = DXGI_FORMAT_R8G8_UINT;
-                    } else if(image.bits == 16){
-                        image_format = DXGI_FORMAT_R16G16_UINT;
-                    }
-                } else if (image.component == 3){
-                    // ?
-                } else if (image.component == 4){
-                    if(image.bits == 8){
-                        image_format = DXGI_FORMAT_R8G8B8A8_UNORM;
-                    } else if(image.bits == 16){
-                        image_format = DXGI_FORMAT_R16G16B16A16_UINT;
-                    }
-                }
+        for(u64 primative_group_index = 0; primative_group_index < mesh->primitive_groups.nitems; primative_group_index++){
+            primitive_jobs.ptr[job_index].primitive       = &tg_mesh.primitives[primative_group_index];
+            primitive_jobs.ptr[job_index].primitive_group = mesh->primitive_groups.ptr + primative_group_index;
+            regions_size += gltf_primitive_arena_bound(tg_model, tg_mesh.primitives[primative_group_index]);
+            job_index++;
+        }
+
+    }
+
+    // Address space for every primitive's worst case, only the pages a job writes are touched
+    u8* regions = (u8*)arena->push_aligned(regions_size, MODEL_ARENA_ALIGNMENT);
+    u8* region  = regions;
+    for(u64 i = 0; i < primitive_count; i++){
+        primitive_jobs.ptr[i].region.next = region;
+        region += gltf_primitive_arena_bound(tg_model, *primitive_jobs.ptr[i].primitive);
+    }
+
+    GLTF_Decode_Jobs decode_jobs = {&tg_model, &buffer_data, primitive_jobs.ptr};
+
+    Job_Counter counter;
+    jobs_dispatch(decode_primitive_job, &decode_jobs, (u32)primitive_count, &counter);
+    jobs_wait(&counter);
+
+    // Regions are in primitive order, so packing them in that order only moves data down
+    u64 position = (u64)(regions - (u8*)arena);
+    for(u64 i = 0; i < primitive_count; i++){
+        model_compact_primitive_group(arena, *primitive_jobs.ptr[i].primitive_group, &position);
+    }
+    arena->pop_to(position);
+
+    // Welding and vertex cache report, per mesh and for the whole model
+    Mesh_Optimize_Stats& model_stats = d_model.load_timings.mesh_optimize;
+    Mesh_Weld_Stats& model_weld_stats = d_model.load_timings.mesh_weld;
+    model_stats      = {};
+    model_weld_stats = {};
+
+    job_index = 0;
+    for(u64 mesh_index = 0; mesh_index < d_model.meshes.nitems; mesh_index++){
+
+        Mesh_Optimize_Stats mesh_stats = {};
+        Mesh_Weld_Stats mesh_weld_stats = {};
+        for(u64 i = 0; i < d_model.meshes.ptr[mesh_index].primitive_groups.nitems; i++){
+            mesh_optimize_stats_add(&mesh_stats, primitive_jobs.ptr[job_index].optimize_stats);
+            mesh_weld_stats_add(&mesh_weld_stats, primitive_jobs.ptr[job_index].weld_stats);
+            job_index++;
+        }
+        mesh_optimize_stats_add(&model_stats, mesh_stats);
+        mesh_weld_stats_add(&model_weld_stats, mesh_weld_stats);
+
+        char stats_string[256];
+        snprintf(stats_string, sizeof(stats_string), "mesh %llu (%s): %llu triangles, vertices %llu -> %llu welded, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+            mesh_index, tg_model.meshes[mesh_index].name.c_str(), mesh_stats.before.triangle_count, mesh_weld_stats.vertex_count, mesh_weld_stats.welded_vertex_count,
+            vertex_cache_acmr(mesh_stats.before), vertex_cache_acmr(mesh_stats.after), vertex_cache_atvr(mesh_stats.before), vertex_cache_atvr(mesh_stats.after));
+        os_debug_print(stats_string);
+
+    }
+
+    primitive_jobs.d_free();
 
-                // Store a description of the texture
-                material.normal_texture.texture_desc.format     = image_format;
-                material.normal_texture.texture_desc.usage      = Texture::USAGE::USAGE_SAMPLED;
+}
+
+/*
+*   Flattens the default scene's nodes (every root node if there are no scenes) into d_model.scene.
+*   A model without nodes gets one node per mesh
+*/
+void load_scene(D_Model& d_model, tg::Model& tg_model){
+
+    u32 node_count = (u32)tg_model.nodes.size();
+    if(node_count == 0){
+        scene_one_node_per_mesh(&d_model.scene, (u32)d_model.meshes.nitems);
+        return;
+    }
+
+    Span<u32> child_offsets;
+    Span<u32> source_nodes;
+    Span<u8>  is_child;
+    child_offsets.alloc(node_count + 1);
+    source_nodes.alloc(node_count);
+    is_child.alloc(node_count);
 
-                // Allocate enough room for the raw image data
-                material.normal_texture.cpu_texture_data.alloc(image.image.size());
-                // Copy the raw image data over to d_model material j
-                memcpy(material.normal_texture.cpu_texture_data.ptr, &image.image.at(0), image.image.size());
-                        
+    for(u32 i = 0; i < node_count; i++){
+        child_offsets.ptr[i + 1] = child_offsets.ptr[i] + (u32)tg_model.nodes[i].children.size();
+    }
+
+    Span<u32> children;
+    children.alloc(d_max(child_offsets.ptr[node_count], 1u));
+    for(u32 i = 0; i < node_count; i++){
+        const std::vector<int>& node_children = tg_model.nodes[i].children;
+        for(u64 j = 0; j < node_children.size(); j++){
+            u32 child = (u32)node_children[j];
+            children.ptr[child_offsets.ptr[i] + j] = child;
+            if(child < node_count){
+                is_child.ptr[child] = 1;
+            }
+        }
+    }
+
+    Span<u32> roots;
+    u32 root_count = 0;
+    if(!tg_model.scenes.empty()){
+        const tg::Scene& tg_scene = tg_model.scenes[tg_model.defaultScene >= 0 && tg_model.defaultScene < (int)tg_model.scenes.size() ? tg_model.defaultScene : 0];
+        roots.alloc(d_max((u32)tg_scene.nodes.size(), 1u));
+        for(int root : tg_scene.nodes){
+            roots.ptr[root_count++] = (u32)root;
+        }
+    } else {
+        roots.alloc(node_count);
+        for(u32 i = 0; i < node_count; i++){
+            if(!is_child.ptr[i]){
+                roots.ptr[root_count++] = i;
             }
+        }
+    }
 
-            /////////////////////
-            // Roughness Metallic Texture
-            /////////////////////
-
-            // Here, we are only storing, and using, the base color texture
-            texture_index = tg_model.materials[j].pbrMetallicRoughness.metallicRoughnessTexture.index;
-
-            if(texture_index != UINT_MAX){
-
-                tex = tg_model.textures[texture_index];
-
-                // Get reference to corresponding material in d_model
-                material = d_model.materials.ptr[j];
-                material.material_flags |= MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE;
-
-                // If we have a baseColorTexture
-                if(tex.source >= 0){
-
-                    // Load the image corresponding to the texture
-                    tg::Image &image = tg_model.images[tex.source];
-
-                    material.roughness_metallic_texture.texture_desc.width = image.width;
-                    material.roughness_metallic_texture.texture_desc.height = image.height;
-
-                    DXGI_FORMAT image_format = DXGI_FORMAT_UNKNOWN;
-                    
-                    // Store the image_format
-                    if(image.component == 1){
-                        if(image.bits == 8){
-                            image_format = DXGI_FORMAT_R8_UINT;
-                        } else if(image.bits == 16){
-                            image_format = DXGI_FORMAT_R16_UINT;
-                        }
-                    } else if (image.component == 2){
-                        if(image.bits == 8){
-                            image_format = DXGI_FORMAT_R8G8_UINT;
-                        } else if(image.bits == 16){
-                            image_format = DXGI_FORMAT_R16G16_UINT;
-                        }
-                    } else if (image.component == 3){
-                        // ?
-                    } else if (image.component == 4){
-                        if(image.bits == 8){
-                            image_format = DXGI_FORMAT_R8G8B8A8_UNORM;
-                        } else if(image.bits == 16){
-                            image_format = DXGI_FORMAT_R16G16B16A16_UINT;
-                        }
-                    }
-
-                    // Store a description of the texture
-                    material.roughness_metallic_texture.texture_desc.format     = image_format;
-                    material.roughness_metallic_texture.texture_desc.usage      = Texture::USAGE::USAGE_SAMPLED;
-
-                    // Allocate enough room for the raw image data
-                    material.roughness_metallic_texture.cpu_texture_data.alloc(image.image.size());
-                    // Copy the raw image data over to d_model material j
-                    memcpy(material.roughness_metallic_texture.cpu_texture_data.ptr, &image.image.at(0), image.image.size());
+    Scene& scene = d_model.scene;
+    scene_flatten(&scene, node_count, child_offsets.ptr, children.ptr, roots.ptr, root_count, source_nodes.ptr);
 
-                }
+    for(u32 i = 0; i < scene.node_count; i++){
+
+        const tg::Node& tg_node = tg_model.nodes[source_nodes.ptr[i]];
+        if(tg_node.mesh >= 0 && tg_node.mesh < (int)d_model.meshes.nitems){
+            scene.mesh_indices.ptr[i] = (u32)tg_node.mesh;
+        }
+
+        f32 matrix[16];
+        if(tg_node.matrix.size() == 16){
+            for(u32 j = 0; j < 16; j++){
+                matrix[j] = (f32)tg_node.matrix[j];
             }
+        } else {
+            scene_trs_matrix(tg_node.translation.size() == 3 ? tg_node.translation.data() : NULL,
+                             tg_node.rotation.size()    == 4 ? tg_node.rotation.data()    : NULL,
+                             tg_node.scale.size()       == 3 ? tg_node.scale.data()       : NULL, matrix);
         }
+        scene_flip_z(matrix);
+        scene_set_local_matrix(&scene, i, matrix);
+
     }
+
+    scene_build_instances(&scene, (u32)d_model.meshes.nitems);
+    scene_update_world_matrices(&scene);
+
+    child_offsets.d_free();
+    children.d_free();
+    source_nodes.d_free();
+    is_child.d_free();
+    roots.d_free();
+
 }
 
 /*
-    Input: Empty D_Model, filename of gltf file
-    Output: D_Model with values from specified gltf file
+*   tinygltf is built with TINYGLTF_NO_EXTERNAL_IMAGE, so image files aren't touched while parsing.
+*   Images embedded in the glTF still come through here: keep them encoded, they're decoded later
+*   with everything else.
 */
-void load_gltf_model(D_Model& d_model, const char* filename){
+static bool defer_image_decode(tg::Image* image, const int image_index, std::string* err, std::string* warn,
+    int req_width, int req_height, const unsigned char* bytes, int size, void* user_data){
 
-    DEBUG_LOG("Loading GLTF Model!");
+    image->image.assign(bytes, bytes + size);
+    return true;
 
-    tg::Model tg_model;
-    std::string err;
-    std::string warn;
+}
 
-    bool ret = model_loader.LoadASCIIFromFile(&tg_model, &err, &warn, filename);
+// The image a material texture slot samples, -1 if the slot is empty
+static s32 texture_image_index(tg::Model& tg_model, int texture_index){
 
-    if (!warn.empty()) {
-        OutputDebugString(warn.c_str());
+    if(texture_index < 0 || texture_index >= (int)tg_model.textures.size()){
+        return -1;
     }
 
-    #if 0
-    if (!err.empty()) {
-        OutputDebugString(err.c_str());
-        DEBUG_BREAK;
-    }
-    #endif
+    return tg_model.textures[texture_index].source;
 
-    if (!ret) {
-        DEBUG_ERROR("Failed to parse glTF");
-        return;
+}
+
+/*
+*   Where an image's encoded bytes are: a mapped buffer view, embedded (kept by defer_image_decode) or a file
+*   next to the glTF, which is mapped into image_file. Unmap it once done with the bytes
+*/
+static bool gltf_image_bytes(tg::Model& tg_model, GLTF_Buffer_Data& buffer_data, const std::string& base_dir, u32 image_index,
+                             Mapped_File* image_file, const u8** encoded, u64* encoded_size){
+
+    tg::Image& tg_image = tg_model.images[image_index];
+    *image_file   = {};
+    *encoded      = tg_image.image.data();
+    *encoded_size = tg_image.image.size();
+
+    if(buffer_data.images.ptr && buffer_data.images.ptr[image_index].data){
+        *encoded      = buffer_data.images.ptr[image_index].data;
+        *encoded_size = buffer_data.images.ptr[image_index].size;
+    } else if(*encoded_size == 0){
+        std::string path = base_dir + tg_image.uri;
+        if(!os_map_file(path.c_str(), image_file, MAP_ACCESS_SEQUENTIAL)){
+            return false;
+        }
+        *encoded      = image_file->data;
+        *encoded_size = image_file->size;
     }
 
-    const tg::Scene &scene = tg_model.scenes[tg_model.defaultScene];    
+    return true;
+
+}
+
+/*
+*   The images material slots use, each once, in the order they're decoded, with how many bytes their
+*   pixels take. Read from the images' headers before the model's arena is reserved, so it has room for them
+*/
+struct GLTF_Material_Images {
+    Span<u32> image_indices;
+    Span<u64> pixel_sizes;   // 0 when the header can't be read, the image is then skipped
+    u32       count;
+};
+
+static void gltf_find_material_images(tg::Model& tg_model, GLTF_Buffer_Data& buffer_data, const std::string& base_dir, GLTF_Material_Images* material_images){
+
+    Span<bool> image_used;
+    image_used.alloc(tg_model.images.size());
+    material_images->image_indices.alloc(tg_model.images.size());
+    material_images->pixel_sizes.alloc(tg_model.images.size());
+    material_images->count = 0;
+
+    for(u64 j = 0; j < tg_model.materials.size(); j++){
+
+        const tg::Material& tg_material = tg_model.materials[j];
+        s32 slot_images[] = {
+            texture_image_index(tg_model, tg_material.pbrMetallicRoughness.baseColorTexture.index),
+            texture_image_index(tg_model, tg_material.normalTexture.index),
+            texture_image_index(tg_model, tg_material.pbrMetallicRoughness.metallicRoughnessTexture.index),
+        };
+
+        for(u32 slot = 0; slot < 3; slot++){
+            s32 image_index = slot_images[slot];
+            if(image_index >= 0 && image_index < (s32)tg_model.images.size() && !image_used.ptr[image_index]){
+                image_used.ptr[image_index] = true;
+                material_images->image_indices.ptr[material_images->count++] = image_index;
+            }
+        }
 
-    // Load each node into the d_model structure
-    for(u64 i = 0; i < scene.nodes.size(); i++){
-        load_model_nodes(d_model, tg_model, tg_model.nodes[scene.nodes[i]]);
     }
-    
-    // Separetly load the materials, primative groups keep track of what material they use
-    load_materials(d_model, tg_model);
 
-}
\ No newline at end of file
+    image_used.d_free();
+
+    // Always decoded to 4 channels, 16 bit images stay 16 bit
+    for(u32 i = 0; i < material_images->count; i++){
+
+        Mapped_File image_file;
+        const u8* encoded;
+        u64 encoded_size;
+        if(!gltf_image_bytes(tg_model, buffer_data, base_dir, material_images->image_indices.ptr[i], &image_file, &encoded, &encoded_size)){
+            os_debug_print("Error (gltf_find_material_images): couldn't open image\n");
+            continue;
+        }
+
+        int width, height, components;
+        if(stbi_info_from_memory(encoded, (int)encoded_size, &width, &height, &components)){
+            bool is_16_bit = stbi_is_16_bit_from_memory(encoded, (int)encoded_size);
+            material_images->pixel_sizes.ptr[i] = (u64)width * height * 4 * (is_16_bit ? 2 : 1);
+        } else {
+            os_debug_print("Error (gltf_find_material_images): couldn't read image header\n");
+        }
+
+        os_unmap_file(&image_file);
+
+    }
+
+}
+
+static void gltf_free_material_images(GLTF_Material_Images* material_images){
+
+    material_images->image_indices.d_free();
+    material_images->pixel_sizes.d_free();
+    *material_images = {};
+
+}
+
+// The materials plus the default one, the textures plus the white one, and every image's pixels
+static u64 gltf_materials_arena_bound(tg::Model& tg_model, const GLTF_Material_Images& material_images){
+
+    u64 size = model_arena_size((tg_model.materials.size() + 1) * sizeof(D_Material)) + model_arena_size(((u64)material_images.count + 1) * sizeof(D_Texture));
+    for(u32 i = 0; i < material_images.count; i++){
+        size += model_arena_size(material_images.pixel_sizes.ptr[i]);
+    }
+    return size;
+
+}
+
+struct GLTF_Image_Jobs {
+    tg::Model*         tg_model;
+    GLTF_Buffer_Data*  buffer_data;
+    const std::string* base_dir;
+    D_Image*           images;
+    u32*               image_indices;
+};
+
+/*
+*   Decodes one image with stb_image, always to 4 channels, into the image's pixels. Those are already
+*   in the model's arena, as big as the header said, and stb_image allocates its output there through
+*   model_image_region
+*/
+static void decode_image_job(void* data, u32 index){
+
+    GLTF_Image_Jobs* image_jobs = (GLTF_Image_Jobs*)data;
+    u32 image_index      = image_jobs->image_indices[index];
+    D_Image& image       = image_jobs->images[image_index];
+
+    // gltf_find_material_images couldn't read its header
+    if(image.pixels.ptr == NULL){
+        return;
+    }
+
+    Mapped_File image_file;
+    const u8* encoded;
+    u64       encoded_size;
+    if(!gltf_image_bytes(*image_jobs->tg_model, *image_jobs->buffer_data, *image_jobs->base_dir, image_index, &image_file, &encoded, &encoded_size)){
+        os_debug_print("Error (decode_image_job): couldn't open image\n");
+        image.pixels = {};
+        return;
+    }
+
+    int width, height, components;
+    bool is_16_bit = stbi_is_16_bit_from_memory(encoded, (int)encoded_size);
+
+    model_image_region = {image.pixels.ptr, image.pixels.nitems, false};
+    void* pixels = is_16_bit ? (void*)stbi_load_16_from_memory(encoded, (int)encoded_size, &width, &height, &components, 4)
+                             : (void*)stbi_load_from_memory(encoded, (int)encoded_size, &width, &height, &components, 4);
+    model_image_region = {};
+
+    os_unmap_file(&image_file);
+
+    u64 pixel_size = pixels ? (u64)width * height * 4 * (is_16_bit ? 2 : 1) : 0;
+    if(pixels == NULL || pixel_size != image.pixels.nitems){
+        os_debug_print("Error (decode_image_job): couldn't decode image\n");
+        if(pixels != image.pixels.ptr){
+            free(pixels);
+        }
+        image.pixels = {};
+        return;
+    }
+
+    // stb_image's output only lands on the heap when another buffer its size held the region at the time
+    if(pixels != image.pixels.ptr){
+        memcpy(image.pixels.ptr, pixels, pixel_size);
+        free(pixels);
+    }
+
+    image.width         = width;
+    image.height        = height;
+    image.format        = is_16_bit ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+    image.content_hash  = murmur3_128(image.pixels.ptr, image.pixels.nitems); // For load_materials to find images with the same pixels
+
+}
+
+// 1x1 white, materials without an albedo texture sample it since the shaders always sample albedo
+static u8 model_white_pixel[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+// Adds the white texture the first time a material needs it. d_model.textures has to have room for it
+static u32 model_white_texture(D_Model& d_model, u32* white_texture){
+
+    if(*white_texture == MATERIAL_NO_TEXTURE){
+
+        *white_texture = (u32)d_model.textures.nitems++;
+        D_Texture& texture = d_model.textures.ptr[*white_texture];
+
+        texture.texture_desc.width      = 1;
+        texture.texture_desc.height     = 1;
+        texture.texture_desc.format     = DXGI_FORMAT_R8G8B8A8_UNORM;
+        texture.texture_desc.usage      = Texture::USAGE::USAGE_SAMPLED;
+        texture.cpu_texture_data.ptr    = model_white_pixel;
+        texture.cpu_texture_data.nitems = sizeof(model_white_pixel);
+
+    }
+
+    return *white_texture;
+
+}
+
+/*
+*   The texture of a decoded image. Reuses an earlier image's texture when their pixels are the same and
+*   drops this image's copy, the compaction takes its space back. MATERIAL_NO_TEXTURE if the image didn't decode
+*/
+static u32 gltf_image_texture(D_Model& d_model, Span<D_Image>& images, Span<u32>& texture_images, u32 image_index){
+
+    D_Image& image = images.ptr[image_index];
+    if(image.pixels.ptr == NULL){
+        return MATERIAL_NO_TEXTURE;
+    }
+
+    // Models have tens to hundreds of textures, the hash rules nearly all of them out before the memcmp
+    for(u32 i = 0; i < d_model.textures.nitems; i++){
+
+        const D_Image& other = images.ptr[texture_images.ptr[i]];
+        if(other.content_hash.low == image.content_hash.low && other.content_hash.high == image.content_hash.high &&
+           other.width == image.width && other.height == image.height && other.format == image.format &&
+           memcmp(other.pixels.ptr, image.pixels.ptr, image.pixels.nitems) == 0){
+            image.pixels = {};
+            return i;
+        }
+
+    }
+
+    u32 texture_index = (u32)d_model.textures.nitems++;
+    texture_images.ptr[texture_index] = image_index;
+
+    D_Texture& texture = d_model.textures.ptr[texture_index];
+    texture.texture_desc.width  = image.width;
+    texture.texture_desc.height = image.height;
+    texture.texture_desc.format = image.format;
+    texture.texture_desc.usage  = Texture::USAGE::USAGE_SAMPLED;
+    texture.cpu_texture_data    = image.pixels;
+
+    return texture_index;
+
+}
+
+// The texture a material slot samples, MATERIAL_NO_TEXTURE if the slot is empty or its image didn't decode
+static u32 gltf_slot_texture(tg::Model& tg_model, Span<u32>& image_textures, int texture_index){
+
+    s32 image_index = texture_image_index(tg_model, texture_index);
+    if(image_index < 0 || image_index >= (s32)tg_model.images.size()){
+        return MATERIAL_NO_TEXTURE;
+    }
+
+    return image_textures.ptr[image_index];
+
+}
+
+/*
+*   Load the materials from tg_model to d_model, into the model's arena, which has room for gltf_materials_arena_bound
+*   Supports base color, normal and metallic roughness textures
+*   Only images used by one of those slots (material_images) are decoded, each once, in parallel. Images with the same
+*   pixels share one texture, so every unique image is uploaded and bound once however many slots use it
+*/
+void load_materials(D_Model& d_model, tg::Model& tg_model, GLTF_Buffer_Data& buffer_data, const std::string& base_dir, const GLTF_Material_Images& material_images){
+
+    Memory_Arena* arena = d_model.arena;
+
+    // Allocate the correct number of materials, plus the default one primitives without a material use
+    u64 gltf_material_count = tg_model.materials.size();
+    model_arena_alloc(arena, d_model.materials, gltf_material_count + gltf_needs_default_material(tg_model));
+    for(u64 j = 0; j < d_model.materials.nitems; j++){
+        d_model.materials.ptr[j] = {};
+    }
+
+    // One texture per unique image, plus room for the white texture
+    u32 image_count = material_images.count;
+    model_arena_alloc(arena, d_model.textures, image_count + 1);
+    for(u32 i = 0; i < image_count + 1; i++){
+        d_model.textures.ptr[i] = {};
+    }
+    d_model.textures.nitems = 0;
+
+    // Each image decodes straight into its pixels in the arena, as big as its header says
+    Span<D_Image> images;
+    images.alloc(tg_model.images.size());
+
+    u64 regions_size = 0;
+    for(u32 i = 0; i < image_count; i++){
+        regions_size += model_arena_size(material_images.pixel_sizes.ptr[i]);
+    }
+    u8* regions = (u8*)arena->push_aligned(regions_size, MODEL_ARENA_ALIGNMENT);
+    Model_Arena_Region region = {regions};
+    for(u32 i = 0; i < image_count; i++){
+        if(material_images.pixel_sizes.ptr[i]){
+            model_region_alloc(&region, images.ptr[material_images.image_indices.ptr[i]].pixels, material_images.pixel_sizes.ptr[i]);
+        }
+    }
+
+    GLTF_Image_Jobs image_jobs = {&tg_model, &buffer_data, &base_dir, images.ptr, material_images.image_indices.ptr};
+
+    Job_Counter counter;
+    jobs_dispatch(decode_image_job, &image_jobs, image_count, &counter);
+    jobs_wait(&counter);
+
+    Span<u32> image_textures;
+    Span<u32> texture_images;
+    image_textures.alloc(tg_model.images.size());
+    texture_images.alloc(image_count + 1);
+
+    D_Model_Load_Timings& timings = d_model.load_timings;
+    timings.image_count        = 0;
+    timings.texture_slot_count = 0;
+
+    for(u32 i = 0; i < image_count; i++){
+        u32 image_index = material_images.image_indices.ptr[i];
+        timings.image_count += images.ptr[image_index].pixels.ptr != NULL;
+        image_textures.ptr[image_index] = gltf_image_texture(d_model, images, texture_images, image_index);
+    }
+
+    // Textures are in decode order like the regions, packing them in that order only moves pixels down.
+    // Duplicates and images that didn't decode leave nothing behind
+    u64 position = (u64)(regions - (u8*)arena);
+    for(u64 i = 0; i < d_model.textures.nitems; i++){
+        model_arena_compact(arena, d_model.textures.ptr[i].cpu_texture_data, &position);
+    }
+    arena->pop_to(position);
+
+    texture_images.d_free();
+    images.d_free();
+
+    // Point each material at its textures
+    u32 white_texture = MATERIAL_NO_TEXTURE;
+    for(u64 j = 0; j < gltf_material_count; j++){
+
+        const tg::Material& tg_material = tg_model.materials[j];
+        D_Material& material = d_model.materials.ptr[j];
+
+        material.albedo_texture             = gltf_slot_texture(tg_model, image_textures, tg_material.pbrMetallicRoughness.baseColorTexture.index);
+        material.normal_texture             = gltf_slot_texture(tg_model, image_textures, tg_material.normalTexture.index);
+        material.roughness_metallic_texture = gltf_slot_texture(tg_model, image_textures, tg_material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+
+        timings.texture_slot_count += (material.albedo_texture != MATERIAL_NO_TEXTURE) + (material.normal_texture != MATERIAL_NO_TEXTURE) +
+                                      (material.roughness_metallic_texture != MATERIAL_NO_TEXTURE);
+
+        if(material.albedo_texture == MATERIAL_NO_TEXTURE){
+            material.albedo_texture = model_white_texture(d_model, &white_texture);
+        }
+        if(material.normal_texture != MATERIAL_NO_TEXTURE){
+            material.material_flags |= MATERIAL_FLAG_NORMAL_TEXTURE;
+        }
+        if(material.roughness_metallic_texture != MATERIAL_NO_TEXTURE){
+            material.material_flags |= MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE;
+        }
+
+    }
+
+    // Untextured, it samples the white texture like any material without an albedo texture
+    if(d_model.materials.nitems > gltf_material_count){
+        D_Material& material = d_model.materials.ptr[gltf_material_count];
+        material.albedo_texture             = model_white_texture(d_model, &white_texture);
+        material.normal_texture             = MATERIAL_NO_TEXTURE;
+        material.roughness_metallic_texture = MATERIAL_NO_TEXTURE;
+        material.material_flags             = MATERIAL_FLAG_NONE;
+    }
+
+    image_textures.d_free();
+    timings.texture_count = (u32)d_model.textures.nitems;
+
+}
+
+static void release_gltf_buffers(GLTF_Buffer_Data& buffer_data){
+
+    for(u64 i = 0; i < buffer_data.mapped_files.nitems; i++){
+        os_unmap_file(&buffer_data.mapped_files.ptr[i]);
+    }
+    buffer_data.mapped_files.d_free();
+    buffer_data.buffers.d_free();
+    buffer_data.images.d_free();
+    os_unmap_file(&buffer_data.glb_file);
+
+}
+
+/*
+*   Strips the buffers out of the glTF json and points each one at its data in place: .bin
+*   files are mapped, a .glb's BIN chunk is already in the .glb's mapping. Images stored in
+*   buffer views become views into those too, so tinygltf reads nothing but the json.
+*   Returns false (and maps nothing) when a buffer can't be used in place: data uris, or a
+*   .bin / BIN chunk that's missing or too small. The caller then lets tinygltf load the buffers.
+*/
+static bool map_gltf_buffers(nlohmann::json& document, const std::string& base_dir, const u8* glb_bin, u64 glb_bin_size, GLTF_Buffer_Data& buffer_data){
+
+    if(!document.contains("buffers") || !document["buffers"].is_array()){
+        return false;
+    }
+
+    nlohmann::json& buffers = document["buffers"];
+    for(u64 i = 0; i < buffers.size(); i++){
+        // Only the first buffer of a .glb may leave out its uri, it's the BIN chunk
+        bool glb_buffer = i == 0 && glb_bin && !buffers[i].contains("uri");
+        if(!glb_buffer && (!buffers[i].contains("uri") || !buffers[i]["uri"].is_string() || buffers[i]["uri"].get<std::string>().rfind("data:", 0) == 0)){
+            return false;
+        }
+    }
+
+    buffer_data.mapped_files.alloc(buffers.size());
+    buffer_data.buffers.alloc(buffers.size());
+    Span<u64> buffer_sizes;
+    buffer_sizes.alloc(buffers.size());
+
+    bool mapped = true;
+
+    for(u64 i = 0; mapped && i < buffers.size(); i++){
+
+        u64 byte_length = buffers[i].value("byteLength", (u64)0);
+
+        if(!buffers[i].contains("uri")){
+            mapped = byte_length <= glb_bin_size;
+            buffer_data.buffers.ptr[i] = glb_bin;
+            buffer_sizes.ptr[i]        = glb_bin_size;
+            continue;
+        }
+
+        std::string path = base_dir + buffers[i]["uri"].get<std::string>();
+        Mapped_File& mapped_file = buffer_data.mapped_files.ptr[i];
+        mapped = os_map_file(path.c_str(), &mapped_file, MAP_ACCESS_SEQUENTIAL) && mapped_file.size >= byte_length;
+
+        buffer_data.buffers.ptr[i] = mapped_file.data;
+        buffer_sizes.ptr[i]        = mapped_file.size;
+
+    }
+
+    // Images in buffer views. tinygltf would copy these out of the buffers while parsing
+    if(mapped && document.contains("images") && document["images"].is_array()){
+
+        nlohmann::json& images = document["images"];
+        buffer_data.images.alloc(images.size());
+
+        for(u64 i = 0; mapped && i < images.size(); i++){
+
+            if(!images[i].contains("bufferView")){
+                continue;
+            }
+
+            s64 view_index = images[i]["bufferView"].is_number_integer() ? images[i]["bufferView"].get<s64>() : -1;
+            mapped = document.contains("bufferViews") && view_index >= 0 && view_index < (s64)document["bufferViews"].size();
+            if(!mapped){
+                break;
+            }
+
+            nlohmann::json& view = document["bufferViews"][view_index];
+            s64 buffer_index = view.value("buffer", (s64)-1);
+            u64 byte_offset  = view.value("byteOffset", (u64)0);
+            u64 byte_length  = view.value("byteLength", (u64)0);
+
+            mapped = buffer_index >= 0 && buffer_index < (s64)buffers.size() &&
+                     byte_offset <= buffer_sizes.ptr[buffer_index] && byte_length <= buffer_sizes.ptr[buffer_index] - byte_offset;
+
+            if(mapped){
+                buffer_data.images.ptr[i].data = buffer_data.buffers.ptr[buffer_index] + byte_offset;
+                buffer_data.images.ptr[i].size = byte_length;
+            }
+
+        }
+
+    }
+
+    if(mapped){
+
+        for(u64 i = 0; i < buffers.size(); i++){
+            buffer_data.buffer_bytes += buffers[i].value("byteLength", (u64)0);
+        }
+
+        // tinygltf only sees the json, our accessors and decode_image_job read from the mappings.
+        // An image needs a uri or a buffer view to parse, with TINYGLTF_NO_EXTERNAL_IMAGE an empty uri is never opened
+        document.erase("buffers");
+        for(u64 i = 0; i < buffer_data.images.nitems; i++){
+            if(buffer_data.images.ptr[i].data){
+                document["images"][i].erase("bufferView");
+                document["images"][i]["uri"] = "";
+            }
+        }
+
+    } else {
+        release_gltf_buffers(buffer_data);
+    }
+
+    buffer_sizes.d_free();
+
+    return mapped;
+
+}
+
+void model_release(D_Model& d_model){
+
+    if(d_model.arena){
+        d_model.arena->release();
+    }
+    scene_free(&d_model.scene);
+    os_unmap_file(&d_model.package_file);
+
+    d_model = {};
+
+}
+
+/*
+    Input: Empty D_Model, filename of a .gltf or .glb file
+    Output: D_Model with values from specified gltf file
+*/
+void load_gltf_model(D_Model& d_model, const char* filename){
+
+    DEBUG_LOG("Loading GLTF Model!");
+
+    D_Model_Load_Timings& timings = d_model.load_timings;
+    u64 load_start_time = os_now_ticks();
+
+    tg::Model tg_model;
+    std::string err;
+    std::string warn;
+
+    Mapped_File gltf_file;
+    if(!os_map_file(filename, &gltf_file, MAP_ACCESS_SEQUENTIAL)){
+        DEBUG_ERROR("Failed to open glTF");
+        return;
+    }
+
+    // Everything up to and including the last slash
+    std::string base_dir = filename;
+    base_dir = base_dir.substr(0, base_dir.find_last_of("/\\") + 1);
+
+    // One per load, load_models runs several at once. Images are only decoded once we know which ones the materials use
+    tg::TinyGLTF model_loader;
+    model_loader.SetImageLoader(defer_image_decode, nullptr);
+
+    // A .glb is its json chunk followed by the first buffer
+    const u8* json      = gltf_file.data;
+    u64       json_size = gltf_file.size;
+    const u8* glb_bin      = NULL;
+    u64       glb_bin_size = 0;
+    bool is_binary = parse_glb(gltf_file.data, gltf_file.size, &json, &json_size, &glb_bin, &glb_bin_size);
+
+    GLTF_Buffer_Data buffer_data = {};
+    nlohmann::json document = nlohmann::json::parse(json, json + json_size, nullptr, false);
+    buffer_data.mapped = !document.is_discarded() && map_gltf_buffers(document, base_dir, glb_bin, glb_bin_size, buffer_data);
+
+    bool ret;
+    if(buffer_data.mapped){
+        std::string json_string = document.dump();
+        ret = model_loader.LoadASCIIFromString(&tg_model, &err, &warn, json_string.c_str(), (unsigned int)json_string.size(), base_dir);
+    } else if(is_binary){
+        ret = model_loader.LoadBinaryFromMemory(&tg_model, &err, &warn, gltf_file.data, (unsigned int)gltf_file.size, base_dir);
+    } else {
+        ret = model_loader.LoadASCIIFromString(&tg_model, &err, &warn, (const char*)gltf_file.data, (unsigned int)gltf_file.size, base_dir);
+    }
+
+    // The BIN chunk is read in place, the .glb stays mapped until the buffers are released
+    if(buffer_data.mapped && glb_bin){
+        buffer_data.glb_file = gltf_file;
+    } else {
+        os_unmap_file(&gltf_file);
+    }
+
+    if (!warn.empty()) {
+        OutputDebugString(warn.c_str());
+    }
+
+    #if 0
+    if (!err.empty()) {
+        OutputDebugString(err.c_str());
+        DEBUG_BREAK;
+    }
+    #endif
+
+    if (!ret) {
+        DEBUG_ERROR("Failed to parse glTF");
+        release_gltf_buffers(buffer_data);
+        return;
+    }
+
+    // tinygltf loaded the buffers itself
+    if(!buffer_data.mapped){
+        buffer_data.buffers.alloc(tg_model.buffers.size());
+        for(u64 i = 0; i < tg_model.buffers.size(); i++){
+            buffer_data.buffers.ptr[i] = tg_model.buffers[i].data.data();
+            buffer_data.buffer_bytes  += tg_model.buffers[i].data.size();
+        }
+    }
+
+    u64 parse_end_time = os_now_ticks();
+
+    // The image headers say how big the pixels get
+    GLTF_Material_Images material_images;
+    gltf_find_material_images(tg_model, buffer_data, base_dir, &material_images);
+    u64 images_found_time = os_now_ticks();
+
+    // Reserved for the most the meshes and materials can need, each pops what it didn't use
+    d_model.arena = model_make_arena(gltf_meshes_arena_bound(tg_model) + gltf_materials_arena_bound(tg_model, material_images));
+    if(d_model.arena == NULL){
+        os_debug_print("Error (load_gltf_model): couldn't reserve the model's arena\n");
+        gltf_free_material_images(&material_images);
+        release_gltf_buffers(buffer_data);
+        return;
+    }
+
+    // Decode every mesh's primitives on the job system
+    load_meshes(d_model, tg_model, buffer_data);
+    load_scene(d_model, tg_model);
+    model_update_bounds(d_model);
+    u64 mesh_end_time = os_now_ticks();
+    
+    // Separetly load the materials, primative groups keep track of what material they use
+    // Decodes the material images on the job system
+    load_materials(d_model, tg_model, buffer_data, base_dir, material_images);
+    gltf_free_material_images(&material_images);
+    u64 materials_end_time = os_now_ticks();
+
+    timings.arena_bytes    = d_model.arena->position;
+    timings.buffer_bytes   = buffer_data.buffer_bytes;
+    timings.buffers_mapped = buffer_data.mapped;
+
+    // Vertex and index data has been copied into the primitive groups
+    release_gltf_buffers(buffer_data);
+
+    timings.parse_ms        = os_ticks_to_ms((f64)(parse_end_time - load_start_time));
+    timings.mesh_decode_ms  = os_ticks_to_ms((f64)(mesh_end_time - images_found_time));
+    timings.materials_ms    = os_ticks_to_ms((f64)(materials_end_time - mesh_end_time + images_found_time - parse_end_time));
+    timings.total_ms        = os_ticks_to_ms((f64)(os_now_ticks() - load_start_time));
+    timings.worker_count    = jobs_worker_count();
+    timings.primitive_count = 0;
+    for(u64 i = 0; i < d_model.meshes.nitems; i++){
+        timings.primitive_count += (u32)d_model.meshes.ptr[i].primitive_groups.nitems;
+    }
+
+    char timing_string[384];
+    snprintf(timing_string, sizeof(timing_string), "load_gltf_model %s: parse %.2fms, mesh decode %.2fms (%u primitives, %u workers), materials %.2fms (%u images, %u textures for %u slots), total %.2fms, arena %.2f MB, buffers %.2f MB %s\n",
+        filename, timings.parse_ms, timings.mesh_decode_ms, timings.primitive_count, timings.worker_count, timings.materials_ms, timings.image_count, timings.texture_count,
+        timings.texture_slot_count, timings.total_ms, (f64)timings.arena_bytes / (1024. * 1024.),
+        (f64)timings.buffer_bytes / (1024. * 1024.), timings.buffers_mapped ? "read in place" : "copied by tinygltf");
+    os_debug_print(timing_string);
+
+}
+
+static_assert(sizeof(Package_Vertex) == sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord), "Package_Vertex has to match the vertex buffer layout");
+
+static_assert(MATERIAL_NO_TEXTURE == PACKAGE_NO_TEXTURE, "Package materials' texture indices are used as they are");
+
+// Points a texture at its cooked mip chain in the package
+static void set_package_texture(D_Texture& texture, const u8* package, u32 texture_index){
+
+    const Package_Header* header           = (const Package_Header*)package;
+    const Package_Texture& package_texture = ((const Package_Texture*)(package + header->textures_offset))[texture_index];
+
+    texture.texture_desc.width      = package_texture.width;
+    texture.texture_desc.height     = package_texture.height;
+    texture.texture_desc.format     = (DXGI_FORMAT)package_texture.format;
+    texture.texture_desc.usage      = Texture::USAGE::USAGE_SAMPLED;
+    texture.cpu_texture_data.ptr    = (u8*)package + package_texture.data_offset;
+    texture.cpu_texture_data.nitems = package_texture.data_size;
+    texture.cpu_mip_count           = (u16)package_texture.mip_count;
+
+}
+
+/*
+    Input: Empty D_Model, filename of a package cooked by ddx_cook
+    Output: D_Model pointing into the mapped package, ready to upload
+
+    Nothing is parsed or copied, the package stays mapped for the life of the model.
+*/
+void load_package_model(D_Model& d_model, const char* filename){
+
+    D_Model_Load_Timings& timings = d_model.load_timings;
+    u64 load_start_time = os_now_ticks();
+
+    if(!os_map_file(filename, &d_model.package_file, MAP_ACCESS_SEQUENTIAL)){
+        DEBUG_ERROR("Failed to open package");
+        return;
+    }
+
+    const u8* package = d_model.package_file.data;
+    const char* package_error = package_validate(package, d_model.package_file.size);
+    if(package_error){
+        char error_string[256];
+        snprintf(error_string, sizeof(error_string), "Error (load_package_model): %s: %s\n", filename, package_error);
+        os_debug_print(error_string);
+        os_unmap_file(&d_model.package_file);
+        return;
+    }
+
+    const Package_Header*    header             = (const Package_Header*)package;
+    const Package_Mesh*      package_meshes     = (const Package_Mesh*)(package + header->meshes_offset);
+    const Package_Primitive* package_primitives = (const Package_Primitive*)(package + header->primitives_offset);
+    const Package_Material*  package_materials  = (const Package_Material*)(package + header->materials_offset);
+
+    u64 parse_end_time = os_now_ticks();
+
+    // The geometry and textures stay in the mapping, the arena holds what points into it. Textures have room for the white one
+    u64 arena_size = model_arena_size((u64)header->mesh_count * sizeof(D_Mesh)) + model_arena_size((u64)header->material_count * sizeof(D_Material)) +
+                     model_arena_size(((u64)header->texture_count + 1) * sizeof(D_Texture));
+    for(u32 i = 0; i < header->mesh_count; i++){
+        arena_size += model_arena_size((u64)package_meshes[i].primitive_count * sizeof(D_Primitive_Group)) + model_arena_size((u64)package_meshes[i].primitive_count * sizeof(D_Draw_Call));
+    }
+
+    d_model.arena = model_make_arena(arena_size);
+    if(d_model.arena == NULL){
+        os_debug_print("Error (load_package_model): couldn't reserve the model's arena\n");
+        os_unmap_file(&d_model.package_file);
+        return;
+    }
+
+    model_arena_alloc(d_model.arena, d_model.meshes, header->mesh_count);
+
+    for(u32 i = 0; i < header->mesh_count; i++){
+
+        const Package_Mesh& package_mesh = package_meshes[i];
+        D_Mesh& mesh = d_model.meshes.ptr[i];
+        mesh = {};
+        model_arena_alloc(d_model.arena, mesh.primitive_groups, package_mesh.primitive_count);
+        model_arena_alloc(d_model.arena, mesh.draw_calls, package_mesh.primitive_count);
+        mesh.bounds = package_mesh.bounds;
+
+        Vertex_Position_Normal_Tangent_Color_Texturecoord* vertices = (Vertex_Position_Normal_Tangent_Color_Texturecoord*)(package + package_mesh.vertex_offset);
+        u8* indices = package + package_mesh.index_offset;
+        Meshlet* meshlets = (Meshlet*)(package + package_mesh.meshlet_offset);
+        u16* meshlet_vertices = (u16*)(package + package_mesh.meshlet_vertex_offset);
+        u8* meshlet_triangles = (u8*)(package + package_mesh.meshlet_triangle_offset);
+        u16* lod_indices = (u16*)(package + package_mesh.lod_index_offset);
+
+        for(u32 j = 0; j < package_mesh.primitive_count; j++){
+
+            const Package_Primitive& package_primitive = package_primitives[package_mesh.first_primitive + j];
+            D_Primitive_Group& primitive_group = mesh.primitive_groups.ptr[j];
+            primitive_group = {};
+
+            primitive_group.primitive_topology = (D3D_PRIMITIVE_TOPOLOGY)package_primitive.topology;
+            primitive_group.material_index     = package_primitive.material_index;
+            primitive_group.verticies.ptr      = vertices + package_primitive.vertex_offset;
+            primitive_group.verticies.nitems   = package_primitive.vertex_count;
+            if(package_mesh.index_size == sizeof(u32)){
+                primitive_group.indicies_32.ptr    = (u32*)indices + package_primitive.index_offset;
+                primitive_group.indicies_32.nitems = package_primitive.index_count;
+            } else {
+                primitive_group.indicies.ptr       = (u16*)indices + package_primitive.index_offset;
+                primitive_group.indicies.nitems    = package_primitive.index_count;
+            }
+
+            primitive_group.meshlets.ptr              = meshlets + package_primitive.meshlet_offset;
+            primitive_group.meshlets.nitems           = package_primitive.meshlet_count;
+            primitive_group.meshlet_vertices.ptr      = meshlet_vertices + package_primitive.meshlet_vertex_offset;
+            primitive_group.meshlet_vertices.nitems   = package_primitive.meshlet_vertex_count;
+            primitive_group.meshlet_triangles.ptr     = meshlet_triangles + (u64)package_primitive.meshlet_triangle_offset * 3;
+            primitive_group.meshlet_triangles.nitems  = (u64)package_primitive.meshlet_triangle_count * 3;
+
+            primitive_group.lod_indicies.ptr    = lod_indices + package_primitive.lod_index_offset;
+            primitive_group.lod_indicies.nitems = package_primitive.lod_index_count;
+            primitive_group.lod_count           = package_primitive.lod_count;
+            memcpy(primitive_group.lods, package_primitive.lods, sizeof(primitive_group.lods));
+            primitive_group.bounds              = package_primitive.bounds;
+
+        }
+
+    }
+
+    package_load_scene(package, &d_model.scene);
+    d_model.bounds = header->bounds;
+
+    u64 mesh_end_time = os_now_ticks();
+
+    // ddx_cook already shares textures between materials, plus room for the white texture
+    model_arena_alloc(d_model.arena, d_model.textures, header->texture_count + 1);
+    d_model.textures.nitems = header->texture_count;
+    for(u32 i = 0; i < header->texture_count + 1; i++){
+        d_model.textures.ptr[i] = {};
+    }
+    for(u32 i = 0; i < header->texture_count; i++){
+        set_package_texture(d_model.textures.ptr[i], package, i);
+    }
+
+    model_arena_alloc(d_model.arena, d_model.materials, header->material_count);
+    timings.texture_slot_count = 0;
+    u32 white_texture = MATERIAL_NO_TEXTURE;
+
+    for(u32 i = 0; i < header->material_count; i++){
+
+        const Package_Material& package_material = package_materials[i];
+        D_Material& material = d_model.materials.ptr[i];
+
+        material.albedo_texture             = package_material.albedo_texture;
+        material.normal_texture             = package_material.normal_texture;
+        material.roughness_metallic_texture = package_material.roughness_metallic_texture;
+        material.material_flags             = package_material.material_flags;
+
+        timings.texture_slot_count += (material.albedo_texture != MATERIAL_NO_TEXTURE) + (material.normal_texture != MATERIAL_NO_TEXTURE) +
+                                      (material.roughness_metallic_texture != MATERIAL_NO_TEXTURE);
+
+        if(material.albedo_texture == MATERIAL_NO_TEXTURE){
+            material.albedo_texture = model_white_texture(d_model, &white_texture);
+        }
+
+    }
+
+    u64 load_end_time = os_now_ticks();
+
+    timings.parse_ms        = os_ticks_to_ms((f64)(parse_end_time - load_start_time));
+    timings.mesh_decode_ms  = os_ticks_to_ms((f64)(mesh_end_time - parse_end_time));
+    timings.materials_ms    = os_ticks_to_ms((f64)(load_end_time - mesh_end_time));
+    timings.total_ms        = os_ticks_to_ms((f64)(load_end_time - load_start_time));
+    timings.primitive_count = header->primitive_count;
+    timings.worker_count    = 0;
+    timings.image_count     = header->texture_count;
+    timings.texture_count   = (u32)d_model.textures.nitems;
+    timings.buffer_bytes    = d_model.package_file.size;
+    timings.buffers_mapped  = true;
+    timings.arena_bytes     = d_model.arena->position;
+
+    char timing_string[320];
+    snprintf(timing_string, sizeof(timing_string), "load_package_model %s: map %.2fms, meshes %.2fms (%u primitives), materials %.2fms (%u textures for %u slots), total %.2fms, arena %.2f MB\n",
+        filename, timings.parse_ms, timings.mesh_decode_ms, timings.primitive_count, timings.materials_ms, timings.texture_count, timings.texture_slot_count, timings.total_ms,
+        (f64)timings.arena_bytes / (1024. * 1024.));
+    os_debug_print(timing_string);
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Procedural Models
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Grid spacing of the boxes, the biggest is 100 x 160 x 100
+#define PROCEDURAL_BOX_SPACING 150.f
+
+// Normal, then two axes across the face with u x v = normal
+static const f32 procedural_box_faces[6][3][3] = {
+    {{ 1.f,  0.f,  0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}},
+    {{-1.f,  0.f,  0.f}, {0.f, 0.f, 1.f}, {0.f, 1.f, 0.f}},
+    {{ 0.f,  1.f,  0.f}, {0.f, 0.f, 1.f}, {1.f, 0.f, 0.f}},
+    {{ 0.f, -1.f,  0.f}, {1.f, 0.f, 0.f}, {0.f, 0.f, 1.f}},
+    {{ 0.f,  0.f,  1.f}, {1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+    {{ 0.f,  0.f, -1.f}, {0.f, 1.f, 0.f}, {1.f, 0.f, 0.f}},
+};
+
+// 0 to 1, the same for the same mesh and channel every time
+static f32 procedural_random(u32 mesh_index, u32 channel){
+
+    u32 x = mesh_index * 0x9E3779B9u + channel * 0x85EBCA6Bu;
+    x ^= x >> 16; x *= 0x7FEB352Du;
+    x ^= x >> 15; x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return (f32)(x >> 8) / (f32)(1u << 24);
+
+}
+
+#define PROCEDURAL_BOX_VERTICES 24
+#define PROCEDURAL_BOX_INDICES  36
+
+// The most build_procedural_box allocates
+static u64 procedural_box_arena_bound(){
+
+    Meshlet_Counts bound = meshlet_counts_bound(PROCEDURAL_BOX_INDICES);
+    return model_arena_size(PROCEDURAL_BOX_VERTICES * sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord)) + model_arena_size(PROCEDURAL_BOX_INDICES * sizeof(u16)) +
+           model_arena_size(bound.meshlet_count * sizeof(Meshlet)) + model_arena_size(bound.vertex_count * sizeof(u16)) + model_arena_size(bound.triangle_count * 3);
+
+}
+
+/*
+*   A box of its own size and color standing on y = 0, with meshlets and bounds like a decoded glTF
+*   primitive. The triangles wind clockwise seen from outside, like glTF's do once the loaders flip z
+*   Allocated from region, which has procedural_box_arena_bound bytes
+*/
+static void build_procedural_box(D_Primitive_Group* primitive_group, u32 mesh_index, Model_Arena_Region* region){
+
+    f32 half_extents[3] = {
+        10.f + 40.f * procedural_random(mesh_index, 0),
+        10.f + 70.f * procedural_random(mesh_index, 1),
+        10.f + 40.f * procedural_random(mesh_index, 2),
+    };
+    XMFLOAT3 color = {procedural_random(mesh_index, 3), procedural_random(mesh_index, 4), procedural_random(mesh_index, 5)};
+
+    primitive_group->primitive_topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    primitive_group->material_index     = 0;
+    model_region_alloc(region, primitive_group->verticies, PROCEDURAL_BOX_VERTICES);
+    model_region_alloc(region, primitive_group->indicies,  PROCEDURAL_BOX_INDICES);
+
+    const f32 corners[4][2] = {{-1.f, -1.f}, {1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}};
+    for(u32 face = 0; face < 6; face++){
+
+        const f32* normal = procedural_box_faces[face][0];
+        const f32* u      = procedural_box_faces[face][1];
+        const f32* v      = procedural_box_faces[face][2];
+
+        for(u32 corner = 0; corner < 4; corner++){
+
+            Vertex_Position_Normal_Tangent_Color_Texturecoord& vertex = primitive_group->verticies.ptr[face * 4 + corner];
+            f32 position[3];
+            for(u32 axis = 0; axis < 3; axis++){
+                position[axis] = (normal[axis] + corners[corner][0] * u[axis] + corners[corner][1] * v[axis]) * half_extents[axis];
+            }
+            vertex.position            = {position[0], position[1] + half_extents[1], position[2]};
+            vertex.normal              = {normal[0], normal[1], normal[2]};
+            vertex.tangent             = {u[0], u[1], u[2], 1.f};
+            vertex.color               = color;
+            vertex.texture_coordinates = {(corners[corner][0] + 1.f) * 0.5f, (corners[corner][1] + 1.f) * 0.5f};
+
+        }
+
+        u16 first = (u16)(face * 4);
+        u16 face_indices[6] = {first, (u16)(first + 2), (u16)(first + 1), first, (u16)(first + 3), (u16)(first + 2)};
+        memcpy(primitive_group->indicies.ptr + face * 6, face_indices, sizeof(face_indices));
+
+    }
+
+    mesh_bounds_compute((const u8*)primitive_group->verticies.ptr, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord), (u32)primitive_group->verticies.nitems,
+        &primitive_group->bounds);
+
+    Meshlet_Counts bound = meshlet_counts_bound((u32)primitive_group->indicies.nitems);
+    model_region_alloc(region, primitive_group->meshlets,          bound.meshlet_count);
+    model_region_alloc(region, primitive_group->meshlet_vertices,  bound.vertex_count);
+    model_region_alloc(region, primitive_group->meshlet_triangles, bound.triangle_count * 3);
+
+    Meshlet_Counts counts = build_meshlets(primitive_group->indicies.ptr, (u32)primitive_group->indicies.nitems, (u32)primitive_group->verticies.nitems,
+        (const u8*)primitive_group->verticies.ptr, sizeof(Vertex_Position_Normal_Tangent_Color_Texturecoord),
+        primitive_group->meshlets.ptr, primitive_group->meshlet_vertices.ptr, primitive_group->meshlet_triangles.ptr);
+    primitive_group->meshlets.nitems          = counts.meshlet_count;
+    primitive_group->meshlet_vertices.nitems  = counts.vertex_count;
+    primitive_group->meshlet_triangles.nitems = counts.triangle_count * 3;
+
+    // Nothing to simplify on a box
+    primitive_group->lods[0]   = {0, (u32)primitive_group->indicies.nitems, 0.f};
+    primitive_group->lod_count = 1;
+
+}
+
+struct Procedural_Box_Jobs {
+    D_Mesh* meshes;
+    u8*     regions;   // procedural_box_arena_bound apart
+};
+
+static void build_procedural_box_job(void* data, u32 index){
+
+    Procedural_Box_Jobs* box_jobs = (Procedural_Box_Jobs*)data;
+    Model_Arena_Region region = {box_jobs->regions + index * procedural_box_arena_bound()};
+    build_procedural_box(box_jobs->meshes[index].primitive_groups.ptr, index, &region);
+
+}
+
+void load_procedural_model(D_Model& d_model, u32 mesh_count){
+
+    D_Model_Load_Timings& timings = d_model.load_timings;
+    u64 load_start_time = os_now_ticks();
+
+    mesh_count = d_max(mesh_count, 1u);
+
+    // The meshes, one box each, and the one material and white texture
+    u64 mesh_size  = model_arena_size(sizeof(D_Primitive_Group)) + model_arena_size(sizeof(D_Draw_Call)) + procedural_box_arena_bound();
+    d_model.arena  = model_make_arena(model_arena_size(mesh_count * sizeof(D_Mesh)) + mesh_count * mesh_size +
+                                      model_arena_size(sizeof(D_Texture)) + model_arena_size(sizeof(D_Material)));
+    if(d_model.arena == NULL){
+        os_debug_print("Error (load_procedural_model): couldn't reserve the model's arena\n");
+        return;
+    }
+    Memory_Arena* arena = d_model.arena;
+
+    model_arena_alloc(arena, d_model.meshes, mesh_count);
+    for(u32 i = 0; i < mesh_count; i++){
+        D_Mesh& mesh = d_model.meshes.ptr[i];
+        mesh = {};
+        model_arena_alloc(arena, mesh.primitive_groups, 1);
+        model_arena_alloc(arena, mesh.draw_calls, 1);
+        mesh.primitive_groups.ptr[0] = {};
+    }
+
+    Procedural_Box_Jobs box_jobs = {d_model.meshes.ptr, (u8*)arena->push_aligned(mesh_count * procedural_box_arena_bound(), MODEL_ARENA_ALIGNMENT)};
+
+    Job_Counter counter;
+    jobs_dispatch(build_procedural_box_job, &box_jobs, mesh_count, &counter);
+    jobs_wait(&counter);
+
+    // Boxes only fill part of the meshlet bounds
+    u64 position = (u64)(box_jobs.regions - (u8*)arena);
+    for(u32 i = 0; i < mesh_count; i++){
+        model_compact_primitive_group(arena, d_model.meshes.ptr[i].primitive_groups.ptr[0], &position);
+    }
+    arena->pop_to(position);
+
+    // Each mesh once, on a square-ish grid centered on the origin
+    scene_one_node_per_mesh(&d_model.scene, mesh_count);
+    u32 columns = (u32)ceilf(sqrtf((f32)mesh_count));
+    u32 rows    = (mesh_count + columns - 1) / columns;
+    for(u32 i = 0; i < mesh_count; i++){
+        f32 matrix[16];
+        scene_identity_matrix(matrix);
+        matrix[12] = ((f32)(i % columns) - (f32)(columns - 1) * 0.5f) * PROCEDURAL_BOX_SPACING;
+        matrix[14] = ((f32)(i / columns) - (f32)(rows - 1) * 0.5f) * PROCEDURAL_BOX_SPACING;
+        scene_set_local_matrix(&d_model.scene, i, matrix);
+    }
+    scene_update_world_matrices(&d_model.scene);
+    model_update_bounds(d_model);
+    u64 mesh_end_time = os_now_ticks();
+
+    // One untextured material, the boxes are told apart by their vertex colors
+    u32 white_texture = MATERIAL_NO_TEXTURE;
+    model_arena_alloc(arena, d_model.textures, 1);
+    d_model.textures.ptr[0] = {};
+    d_model.textures.nitems = 0;
+    model_arena_alloc(arena, d_model.materials, 1);
+    d_model.materials.ptr[0] = {};
+    d_model.materials.ptr[0].albedo_texture             = model_white_texture(d_model, &white_texture);
+    d_model.materials.ptr[0].normal_texture             = MATERIAL_NO_TEXTURE;
+    d_model.materials.ptr[0].roughness_metallic_texture = MATERIAL_NO_TEXTURE;
+    d_model.materials.ptr[0].material_flags             = MATERIAL_FLAG_NONE;
+
+    timings.arena_bytes        = arena->position;
+    timings.mesh_decode_ms     = os_ticks_to_ms((f64)(mesh_end_time - load_start_time));
+    timings.total_ms           = os_ticks_to_ms((f64)(os_now_ticks() - load_start_time));
+    timings.worker_count       = jobs_worker_count();
+    timings.primitive_count    = mesh_count;
+    timings.texture_count      = 1;
+    timings.texture_slot_count = 1;
+
+    char timing_string[256];
+    snprintf(timing_string, sizeof(timing_string), "load_procedural_model: %u meshes in %.2fms (%u workers), arena %.2f MB\n",
+        mesh_count, timings.total_ms, timings.worker_count, (f64)timings.arena_bytes / (1024. * 1024.));
+    os_debug_print(timing_string);
+
+}
+
+void load_model(D_Model& d_model, const char* filename){
+
+    u64 length = strlen(filename);
+    u64 procedural_length = strlen(SCENE_FILE_PROCEDURAL_PREFIX);
+    if(strncmp(filename, SCENE_FILE_PROCEDURAL_PREFIX, procedural_length) == 0){
+        load_procedural_model(d_model, (u32)strtoul(filename + procedural_length, NULL, 10));
+    } else if(length > 7 && strcmp(filename + length - 7, ".ddxpkg") == 0){
+        load_package_model(d_model, filename);
+    } else {
+        load_gltf_model(d_model, filename);
+    }
+
+}
+
+struct Model_Load_Jobs {
+    D_Model*           models;
+    const char* const* filenames;
+};
+
+static void load_model_job(void* data, u32 index){
+
+    Model_Load_Jobs* load_jobs = (Model_Load_Jobs*)data;
+    load_model(load_jobs->models[index], load_jobs->filenames[index]);
+
+}
+
+void load_models(D_Model* models, const char* const* filenames, u32 count){
+
+    Model_Load_Jobs load_jobs = {models, filenames};
+
+    Job_Counter counter;
+    jobs_dispatch(load_model_job, &load_jobs, count, &counter);
+    jobs_wait(&counter);
+
+}
+
+void model_update_bounds(D_Model& d_model){
+
+    Mesh_Bounds* mesh_bounds = (Mesh_Bounds*)malloc(d_max(d_model.meshes.nitems, (u64)1) * sizeof(Mesh_Bounds));
+    for(u64 i = 0; i < d_model.meshes.nitems; i++){
+        D_Mesh& mesh = d_model.meshes.ptr[i];
+        mesh.bounds = mesh_bounds_empty();
+        for(u64 j = 0; j < mesh.primitive_groups.nitems; j++){
+            mesh_bounds_merge(&mesh.bounds, mesh.primitive_groups.ptr[j].bounds);
+        }
+        mesh_bounds[i] = mesh.bounds;
+    }
+
+    d_model.bounds = scene_instance_bounds(&d_model.scene, mesh_bounds);
+    free(mesh_bounds);
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//  Quantized Vertices
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define QUANTIZE_UNORM10_MAX 1023.f
+#define QUANTIZE_UNORM16_MAX 65535.f
+#define QUANTIZE_DEGREES     (180.f / 3.14159265f)
+
+static f32 quantize_clamp(f32 v, f32 low, f32 high){
+    return v < low ? low : (v > high ? high : v);
+}
+
+static f32 sign_not_zero(f32 v){
+    return v >= 0.f ? 1.f : -1.f;
+}
+
+static f32 quantize_dot(const f32* a, const f32* b){
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void quantize_normalize(f32* v){
+    f32 length = sqrtf(quantize_dot(v, v));
+    if(length > 0.f){
+        v[0] /= length; v[1] /= length; v[2] /= length;
+    }
+}
+
+// Angle between two unit vectors in degrees
+static f32 quantize_angle(const f32* a, const f32* b){
+    return acosf(quantize_clamp(quantize_dot(a, b), -1.f, 1.f)) * QUANTIZE_DEGREES;
+}
+
+// Same as oct_decode in vertex_quantization.hlsli, from the 10 bit unorms
+static void oct_decode(u32 x, u32 y, f32* n){
+
+    f32 ex = (x / QUANTIZE_UNORM10_MAX) * 2.f - 1.f;
+    f32 ey = (y / QUANTIZE_UNORM10_MAX) * 2.f - 1.f;
+
+    n[0] = ex;
+    n[1] = ey;
+    n[2] = 1.f - fabsf(ex) - fabsf(ey);
+    if(n[2] < 0.f){
+        n[0] = (1.f - fabsf(ey)) * sign_not_zero(ex);
+        n[1] = (1.f - fabsf(ex)) * sign_not_zero(ey);
+    }
+    quantize_normalize(n);
+
+}
+
+/*
+*   Octahedral encoding into 10 bits each. Rounding each component on its own isn't the closest
+*   code, so all four floor / ceil neighbours are decoded and the closest one is kept
+*/
+static void oct_encode(const f32* n, u32* x, u32* y){
+
+    f32 l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    f32 ex = n[0] / l1;
+    f32 ey = n[1] / l1;
+    if(n[2] < 0.f){
+        f32 fx = (1.f - fabsf(ey)) * sign_not_zero(ex);
+        f32 fy = (1.f - fabsf(ex)) * sign_not_zero(ey);
+        ex = fx;
+        ey = fy;
+    }
+
+    f32 ux = (ex * 0.5f + 0.5f) * QUANTIZE_UNORM10_MAX;
+    f32 uy = (ey * 0.5f + 0.5f) * QUANTIZE_UNORM10_MAX;
+
+    f32 best_dot = -2.f;
+    for(u32 i = 0; i < 4; i++){
+
+        u32 cx = (u32)quantize_clamp((i & 1) ? ceilf(ux) : floorf(ux), 0.f, QUANTIZE_UNORM10_MAX);
+        u32 cy = (u32)quantize_clamp((i & 2) ? ceilf(uy) : floorf(uy), 0.f, QUANTIZE_UNORM10_MAX);
+
+        f32 decoded[3];
+        oct_decode(cx, cy, decoded);
+        f32 dot = quantize_dot(decoded, n);
+        if(dot > best_dot){
+            best_dot = dot;
+            *x = cx;
+            *y = cy;
+        }
+
+    }
+
+}
+
+// Orthonormal basis around n (Duff et al. 2017), has to match tangent_basis in vertex_quantization.hlsli
+static void tangent_basis(const f32* n, f32* b1, f32* b2){
+
+    f32 s = sign_not_zero(n[2]);
+    f32 a = -1.f / (s + n[2]);
+    f32 b = n[0] * n[1] * a;
+
+    b1[0] = 1.f + s * n[0] * n[0] * a; b1[1] = s * b;                   b1[2] = -s * n[0];
+    b2[0] = b;                         b2[1] = s + n[1] * n[1] * a;     b2[2] = -n[1];
+
+}
+
+void quantize_mesh_vertices(D_Mesh& mesh, Vertex_Quantized_Position* positions, Vertex_Quantized_Attributes* attributes, D_Vertex_Quantization_Error* error){
+
+    // The mesh's box covers every primitive group, they share the vertex buffer
+    f32 bounds_min[3] = {mesh.bounds.min[0], mesh.bounds.min[1], mesh.bounds.min[2]};
+    f32 bounds_max[3] = {mesh.bounds.max[0], mesh.bounds.max[1], mesh.bounds.max[2]};
+
+    f32 extent[3] = {};
+    for(u32 k = 0; k < 3; k++){
+        if(bounds_min[k] > bounds_max[k]){
+            bounds_min[k] = bounds_max[k] = 0.f;
+        }
+        extent[k] = bounds_max[k] - bounds_min[k];
+    }
+    mesh.position_offset = {bounds_min[0], bounds_min[1], bounds_min[2], 0.f};
+    mesh.position_scale  = {extent[0], extent[1], extent[2], 0.f};
+
+    u64 vertex_index = 0;
+    for(u64 i = 0; i < mesh.primitive_groups.nitems; i++){
+
+        D_Primitive_Group& primitive_group = mesh.primitive_groups.ptr[i];
+
+        for(u64 j = 0; j < primitive_group.verticies.nitems; j++, vertex_index++){
+
+            const Vertex_Position_Normal_Tangent_Color_Texturecoord& vertex = primitive_group.verticies.ptr[j];
+            Vertex_Quantized_Position&   out_position   = positions[vertex_index];
+            Vertex_Quantized_Attributes& out_attributes = attributes[vertex_index];
+
+            //////////////////
+            //  Position
+            //////////////////
+
+            const f32* position = &vertex.position.x;
+            for(u32 k = 0; k < 3; k++){
+                f32 unorm = extent[k] > 0.f ? (position[k] - bounds_min[k]) / extent[k] : 0.f;
+                out_position.position[k] = (u16)quantize_clamp(roundf(unorm * QUANTIZE_UNORM16_MAX), 0.f, QUANTIZE_UNORM16_MAX);
+
+                f32 decoded = bounds_min[k] + (out_position.position[k] / QUANTIZE_UNORM16_MAX) * extent[k];
+                error->max_position_error = d_max(error->max_position_error, fabsf(decoded - position[k]));
+            }
+            out_position.position[3] = 0;
+
+            //////////////////
+            //  Normal
+            //////////////////
+
+            f32 normal[3] = {vertex.normal.x, vertex.normal.y, vertex.normal.z};
+            quantize_normalize(normal);
+            if(quantize_dot(normal, normal) == 0.f){
+                normal[2] = 1.f;
+            }
+
+            u32 normal_x, normal_y;
+            oct_encode(normal, &normal_x, &normal_y);
+
+            f32 decoded_normal[3];
+            oct_decode(normal_x, normal_y, decoded_normal);
+            error->max_normal_error = d_max(error->max_normal_error, quantize_angle(normal, decoded_normal));
+
+            //////////////////
+            //  Tangent
+            //////////////////
+
+            // The angle is around the decoded normal, the basis the shader rebuilds
+            f32 b1[3], b2[3];
+            tangent_basis(decoded_normal, b1, b2);
+
+            f32 tangent[3] = {vertex.tangent.x, vertex.tangent.y, vertex.tangent.z};
+            f32 tangent_normal_dot = quantize_dot(tangent, decoded_normal);
+            for(u32 k = 0; k < 3; k++){
+                tangent[k] -= decoded_normal[k] * tangent_normal_dot;
+            }
+            quantize_normalize(tangent);
+
+            u32 tangent_angle = 0;
+            if(quantize_dot(tangent, tangent) > 0.f){
+
+                f32 angle = atan2f(quantize_dot(tangent, b2), quantize_dot(tangent, b1));
+                tangent_angle = (u32)quantize_clamp(roundf((angle / (2.f * 3.14159265f) + 0.5f) * QUANTIZE_UNORM10_MAX), 0.f, QUANTIZE_UNORM10_MAX);
+
+                f32 decoded_angle = (tangent_angle / QUANTIZE_UNORM10_MAX - 0.5f) * 2.f * 3.14159265f;
+                f32 decoded_tangent[3];
+                for(u32 k = 0; k < 3; k++){
+                    decoded_tangent[k] = cosf(decoded_angle) * b1[k] + sinf(decoded_angle) * b2[k];
+                }
+                error->max_tangent_error = d_max(error->max_tangent_error, quantize_angle(tangent, decoded_tangent));
+
+            }
+
+            u32 handedness = vertex.tangent.w < 0.f ? 0 : 3;
+            out_attributes.normal_tangent = normal_x | (normal_y << 10) | (tangent_angle << 20) | (handedness << 30);
+
+            //////////////////////////
+            //  Texture Coordinates
+            //////////////////////////
+
+            const f32* texture_coordinates = &vertex.texture_coordinates.x;
+            for(u32 k = 0; k < 2; k++){
+                out_attributes.texture_coordinates[k] = PackedVector::XMConvertFloatToHalf(texture_coordinates[k]);
+
+                f32 decoded = PackedVector::XMConvertHalfToFloat(out_attributes.texture_coordinates[k]);
+                error->max_texture_coordinate_error = d_max(error->max_texture_coordinate_error, fabsf(decoded - texture_coordinates[k]));
+            }
+
+        }
+    }
+
+}
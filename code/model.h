@@ -3,6 +3,15 @@
 #include "pch.h"
 #include "main.h"
 #include "d_dx12.h"
+#include "mesh_optimize.h"
+#include "meshlet.h"
+#include "mesh_simplify.h"
+#include "mesh_tangents.h"
+#include "mesh_weld.h"
+#include "mesh_bounds.h"
+#include "scene.h"
+#include "geometry_buffer.h"
+#include "scene_file.h"
 
 enum D_Material_Flags : u8{
     MATERIAL_FLAG_NONE           = 0x0,
@@ -10,21 +19,38 @@ enum D_Material_Flags : u8{
     MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE = 0x2
 };
 
+// Material texture slots that don't sample anything, same value as PACKAGE_NO_TEXTURE
+#define MATERIAL_NO_TEXTURE 0xFFFFFFFF
+
+// A decoded image, always 4 channels. Only while loading, the model's textures take the pixels over
+struct D_Image {
+
+    d_std::Span<u8> pixels; // In the model's arena, dropped when another image has the same pixels
+    u32 width;
+    u32 height;
+    DXGI_FORMAT format;
+    d_std::Hash_128 content_hash; // murmur3_128 of the pixels
+
+};
+
+// One per unique image, however many material slots sample it
 struct D_Texture {
 
-    d_std::Span<u8>  cpu_texture_data;
+    d_std::Span<u8>  cpu_texture_data; // In the model's arena or the mapped package, not owned
+    u16 cpu_mip_count = 0;             // Mips stored in cpu_texture_data, 0 = generate the chain when uploading
     d_dx12::Texture_Desc texture_desc;
     d_dx12::Texture* texture = NULL;
     s16 texture_binding_table_index;
 
 };
 
+// Texture slots index D_Model::textures, MATERIAL_NO_TEXTURE when empty. Albedo is never empty, see load_materials
 struct D_Material {
 
-    D_Texture albedo_texture;
-    D_Texture normal_texture;
-    D_Texture roughness_metallic_texture;
-    u32        material_flags = MATERIAL_FLAG_NONE;
+    u32 albedo_texture;
+    u32 normal_texture;
+    u32 roughness_metallic_texture;
+    u32 material_flags = MATERIAL_FLAG_NONE;
 
 };
 
@@ -33,34 +59,124 @@ struct D_Primitive_Group {
     D3D_PRIMITIVE_TOPOLOGY primitive_topology;
     d_std::Span<Vertex_Position_Normal_Tangent_Color_Texturecoord> verticies;
     d_std::Span<u16> indicies;
-    u16 material_index = -1;
+    d_std::Span<u32> indicies_32;   // Instead of indicies when the primitive needs u32 ones, see decode_primitive and load_package_model
+    u32 material_index = 0; // Always a material of the model, see gltf_material_index
+
+    // Triangle lists only, see meshlet.h
+    d_std::Span<Meshlet> meshlets;
+    d_std::Span<u16> meshlet_vertices;
+    d_std::Span<u8> meshlet_triangles;
+
+    // LOD 1 and up, drawn from after indicies. lods[0] is indicies itself
+    d_std::Span<u16> lod_indicies;
+    Mesh_Lod lods[MESH_LOD_MAX];
+    u32 lod_count = 1;
+    Mesh_Bounds bounds;   // Model space
 
 };
 
 struct D_Draw_Call {
 
-    u16 material_index;
-    u32 vertex_offset;
+    u32 material_index;
+    u32 vertex_offset;   // Base vertex and first index in the geometry buffer, not the mesh
     u32 index_offset;
     u32 index_count;
+    Mesh_Bounds bounds;  // The primitive group's, model space
 
 };
 
 struct D_Mesh {
 
     d_std::Span<D_Primitive_Group> primitive_groups;
-    d_std::Span<D_Draw_Call> draw_calls;
-    d_dx12::Buffer* vertex_buffer;
-    d_dx12::Buffer* index_buffer;
+    d_std::Span<D_Draw_Call> draw_calls;  // One per primitive group, allocated with the model and filled by the upload
+    D_Geometry_Range geometry;         // Where the vertices and indices are in the renderer's D_Geometry_Buffer
+    Mesh_Bounds bounds;                // Every primitive group's, model space
+    u32 index_size;                    // 2, or 4 when a primitive group has indicies_32
+    DirectX::XMFLOAT4 position_offset; // Quantized vertices only, position = offset + unorm * scale
+    DirectX::XMFLOAT4 position_scale;
+
+    // Kept by D_Renderer::upload_instance_data, every instance is drawn by one instanced draw per draw call
+    u32 instance_offset;                            // First of the mesh's instances in D_Renderer::instance_buffer
+    d_dx12::Descriptor_Handle instance_data_handle; // StructuredBuffer<Instance_Data>, in instance_nodes order. Only valid for the frame
+    u32 instance_count;
+    // Redone only when an instance moves
+    f32 instance_origin_center[3];  // World space sphere around every instance's origin
+    f32 instance_origin_radius;
+    f32 instance_max_scale;         // The most any instance stretches the mesh
+
+};
+
+// Worst case difference between the vertices and their quantized encoding, over the whole model
+struct D_Vertex_Quantization_Error {
+
+    f32 max_position_error;           // Model units
+    f32 max_normal_error;             // Degrees
+    f32 max_tangent_error;            // Degrees
+    f32 max_texture_coordinate_error;
+
+};
+
+// Wall time of each load_gltf_model stage
+struct D_Model_Load_Timings {
+
+    f64 parse_ms;          // Mapping the files, json and tinygltf
+    f64 mesh_decode_ms;
+    f64 materials_ms;      // Includes decoding the images
+    f64 total_ms;
+    u32 primitive_count;
+    u32 worker_count;
+    u32 image_count;       // Images decoded, ones no material slot uses are skipped
+    u32 texture_count;     // Unique textures, each uploaded once
+    u32 texture_slot_count; // Material slots that sample a texture
+    u64 arena_bytes;       // CPU memory the model holds in its arena, everything but the scene and the package mapping
+    u64 buffer_bytes;      // glTF buffer data the accessors read from
+    bool buffers_mapped;   // Read in place from the .bin / .glb mappings, not copied by tinygltf
+    Mesh_Optimize_Stats mesh_optimize; // Vertex cache before and after optimize_mesh, all meshes
+    Mesh_Weld_Stats     mesh_weld;     // Vertex counts before and after weld_vertices, all meshes
 
 };
 
+/*
+*   Every span of a model, down to the vertices and texture pixels, is allocated straight from its one arena.
+*   Packages size it exactly. glTF models reserve it for the most they can decode to, then pop what they didn't use.
+*   The scene stays separate since its placements and --instance-grid grow it after loading.
+*/
 struct D_Model {
 
+    d_std::Memory_Arena* arena = NULL; // Released in one go by model_release
     d_std::Span<D_Material> materials;
+    d_std::Span<D_Texture> textures;  // Shared by the materials, each image or package texture once
+    d_std::Mapped_File package_file;  // Cooked packages, vertices, indices and textures point into it
     d_std::Span<D_Mesh> meshes;
+    Scene scene;                      // Where the meshes are drawn, each mesh once per instance node
+    Mesh_Bounds bounds;               // Every mesh instance, in the scene's space
     DirectX::XMFLOAT3 coords;
+    D_Model_Load_Timings load_timings;
+    D_Vertex_Quantization_Error quantization_error; // Set when the model is uploaded with quantized vertices
 
 };
 
-void load_gltf_model(D_Model& d_model, const char* filename);
\ No newline at end of file
+void load_gltf_model(D_Model& d_model, const char* filename);
+void load_package_model(D_Model& d_model, const char* filename);
+// mesh_count boxes, each its own mesh and drawn with its own draw calls, on a grid. For stress testing per draw CPU work
+void load_procedural_model(D_Model& d_model, u32 mesh_count);
+// Loads .ddxpkg files with load_package_model, procedural:N with load_procedural_model, anything else with load_gltf_model
+void load_model(D_Model& d_model, const char* filename);
+
+/*
+*   load_model for every filename into models, each model as its own job. Their own decoding jobs go on the same
+*   workers, so a scene of many small models loads about as fast as one the size of all of them
+*/
+void load_models(D_Model* models, const char* const* filenames, u32 count);
+
+// Frees the model's arena, scene and package mapping. The renderer releases the GPU resources first
+void model_release(D_Model& d_model);
+
+// Redoes the meshes' bounds from their primitive groups and the model's from the scene, after the scene changes
+void model_update_bounds(D_Model& d_model);
+
+/*
+*   Encodes all of the mesh's primitive groups into the two vertex streams, one after another, and sets the
+*   mesh's position_offset / position_scale to its bounds' box. Raises error to the worst error of this mesh.
+*/
+void quantize_mesh_vertices(D_Mesh& mesh, Vertex_Quantized_Position* positions, Vertex_Quantized_Attributes* attributes, D_Vertex_Quantization_Error* error);
\ No newline at end of file
@@ -5,7 +5,6 @@
 #endif
 
 #include "d_include.h"
-#include <chrono>
 
 // TODO: Re-Evaluate
 //#include <string>
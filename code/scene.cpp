@@ -0,0 +1,428 @@
+#include "scene.h"
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define SCENE_SSE
+#include <xmmintrin.h>
+#endif
+
+/////////////////////////////////
+// Nodes
+/////////////////////////////////
+
+void scene_alloc(Scene* scene, u32 node_count){
+
+    scene_free(scene);
+
+    scene->node_count = node_count;
+    scene->parents.alloc(node_count);
+    scene->subtree_ends.alloc(node_count);
+    scene->mesh_indices.alloc(node_count);
+    scene->local_matrices.alloc(node_count);
+    scene->world_matrices.alloc(node_count);
+    scene->dirty.alloc(node_count);
+
+    for(u32 i = 0; i < node_count; i++){
+        scene->parents.ptr[i]      = SCENE_NO_PARENT;
+        scene->subtree_ends.ptr[i] = i + 1;
+        scene->mesh_indices.ptr[i] = SCENE_NO_MESH;
+        scene->dirty.ptr[i]        = 1;
+        scene_identity_matrix(scene->local_matrices.ptr[i].m);
+    }
+
+}
+
+void scene_free(Scene* scene){
+
+    scene->parents.d_free();
+    scene->subtree_ends.d_free();
+    scene->mesh_indices.d_free();
+    scene->local_matrices.d_free();
+    scene->world_matrices.d_free();
+    scene->dirty.d_free();
+    scene->instance_nodes.d_free();
+    scene->mesh_instance_offsets.d_free();
+    scene->mesh_instances_dirty.d_free();
+    scene->node_count = 0;
+
+}
+
+u32 scene_flatten(Scene* scene, u32 source_node_count, const u32* child_offsets, const u32* children, const u32* roots, u32 root_count, u32* source_nodes){
+
+    // Every root and child is pushed at most once, so this is as deep as the stack gets
+    u32 stack_size = root_count + (source_node_count ? child_offsets[source_node_count] : 0);
+    u32* stack         = (u32*)malloc((stack_size ? stack_size : 1) * sizeof(u32) * 2);
+    u8*  visited       = (u8*)calloc(source_node_count ? source_node_count : 1, 1);
+    u32* parents       = (u32*)malloc((source_node_count ? source_node_count : 1) * sizeof(u32));
+    u32  stack_count   = 0;
+    u32  node_count    = 0;
+
+    // Pairs of source node and scene parent, pushed backwards so they come off in order
+    for(u32 i = root_count; i-- > 0;){
+        if(roots[i] < source_node_count){
+            stack[stack_count * 2 + 0] = roots[i];
+            stack[stack_count * 2 + 1] = SCENE_NO_PARENT;
+            stack_count++;
+        }
+    }
+
+    while(stack_count > 0){
+
+        stack_count--;
+        u32 source_node = stack[stack_count * 2 + 0];
+        u32 parent      = stack[stack_count * 2 + 1];
+        if(visited[source_node]){
+            continue;
+        }
+        visited[source_node] = 1;
+
+        u32 node = node_count++;
+        source_nodes[node] = source_node;
+        parents[node]      = parent;
+
+        for(u32 i = child_offsets[source_node + 1]; i-- > child_offsets[source_node];){
+            if(children[i] < source_node_count && !visited[children[i]]){
+                stack[stack_count * 2 + 0] = children[i];
+                stack[stack_count * 2 + 1] = node;
+                stack_count++;
+            }
+        }
+
+    }
+
+    scene_alloc(scene, node_count);
+    memcpy(scene->parents.ptr, parents, node_count * sizeof(u32));
+
+    // Children come after their parent, so going backwards every subtree is finished before its parent's
+    for(u32 i = node_count; i-- > 0;){
+        u32 parent = parents[i];
+        if(parent != SCENE_NO_PARENT && scene->subtree_ends.ptr[i] > scene->subtree_ends.ptr[parent]){
+            scene->subtree_ends.ptr[parent] = scene->subtree_ends.ptr[i];
+        }
+    }
+
+    free(stack);
+    free(visited);
+    free(parents);
+
+    return node_count;
+
+}
+
+void scene_build_instances(Scene* scene, u32 mesh_count){
+
+    scene->mesh_instance_offsets.d_free();
+    scene->instance_nodes.d_free();
+    scene->mesh_instances_dirty.d_free();
+    scene->mesh_instance_offsets.alloc(mesh_count + 1);
+    scene->mesh_instances_dirty.alloc(mesh_count);
+    for(u32 i = 0; i < mesh_count; i++){
+        scene->mesh_instances_dirty.ptr[i] = 1;
+    }
+
+    // Counting sort by mesh, each mesh's instances stay in node order
+    u32* offsets = scene->mesh_instance_offsets.ptr;
+    for(u32 i = 0; i < scene->node_count; i++){
+        u32 mesh = scene->mesh_indices.ptr[i];
+        if(mesh < mesh_count){
+            offsets[mesh + 1]++;
+        }
+    }
+    for(u32 i = 0; i < mesh_count; i++){
+        offsets[i + 1] += offsets[i];
+    }
+
+    scene->instance_nodes.alloc(offsets[mesh_count]);
+    for(u32 i = 0; i < scene->node_count; i++){
+        u32 mesh = scene->mesh_indices.ptr[i];
+        if(mesh < mesh_count){
+            scene->instance_nodes.ptr[offsets[mesh]++] = i;
+        }
+    }
+
+    // The fill moved each offset up to the next mesh's start
+    for(u32 i = mesh_count; i > 0; i--){
+        offsets[i] = offsets[i - 1];
+    }
+    offsets[0] = 0;
+
+}
+
+void scene_one_node_per_mesh(Scene* scene, u32 mesh_count){
+
+    scene_alloc(scene, mesh_count);
+    for(u32 i = 0; i < mesh_count; i++){
+        scene->mesh_indices.ptr[i] = i;
+    }
+    scene_build_instances(scene, mesh_count);
+
+}
+
+void scene_set_local_matrix(Scene* scene, u32 node, const f32* matrix){
+
+    memcpy(scene->local_matrices.ptr[node].m, matrix, sizeof(Scene_Matrix));
+    scene->dirty.ptr[node] = 1;
+
+}
+
+void scene_replicate(Scene* scene, const Scene_Matrix* placements, u32 copies, u32 mesh_count){
+
+    u32 node_count = scene->node_count;
+    if(copies == 0 || node_count == 0){
+        return;
+    }
+
+    Scene source = *scene;
+    *scene = {};
+    scene_alloc(scene, node_count * copies);
+
+    for(u32 copy = 0; copy < copies; copy++){
+
+        u32 first = copy * node_count;
+
+        for(u32 i = 0; i < node_count; i++){
+
+            u32 node   = first + i;
+            u32 parent = source.parents.ptr[i];
+            scene->parents.ptr[node]      = parent == SCENE_NO_PARENT ? SCENE_NO_PARENT : first + parent;
+            scene->subtree_ends.ptr[node] = first + source.subtree_ends.ptr[i];
+            scene->mesh_indices.ptr[node] = source.mesh_indices.ptr[i];
+
+            // Only the roots move, their children follow
+            Scene_Matrix local = source.local_matrices.ptr[i];
+            if(parent == SCENE_NO_PARENT){
+                scene_multiply_matrix(source.local_matrices.ptr[i].m, placements[copy].m, local.m);
+            }
+            scene_set_local_matrix(scene, node, local.m);
+
+        }
+    }
+
+    scene_free(&source);
+    scene_build_instances(scene, mesh_count);
+
+}
+
+void scene_replicate_grid(Scene* scene, u32 copies, f32 spacing, u32 mesh_count){
+
+    if(copies <= 1 || scene->node_count == 0){
+        return;
+    }
+
+    d_std::Span<Scene_Matrix> placements;
+    placements.alloc(copies);
+
+    // Square-ish grid on x and z, centered on the original
+    u32 columns = (u32)ceilf(sqrtf((f32)copies));
+    u32 rows    = (copies + columns - 1) / columns;
+
+    for(u32 copy = 0; copy < copies; copy++){
+        scene_identity_matrix(placements.ptr[copy].m);
+        placements.ptr[copy].m[12] = ((f32)(copy % columns) - (f32)(columns - 1) * 0.5f) * spacing;
+        placements.ptr[copy].m[14] = ((f32)(copy / columns) - (f32)(rows - 1) * 0.5f) * spacing;
+    }
+
+    scene_replicate(scene, placements.ptr, copies, mesh_count);
+    placements.d_free();
+
+}
+
+u32 scene_update_world_matrices(Scene* scene){
+
+    const u32*    parents = scene->parents.ptr;
+    Scene_Matrix* local   = scene->local_matrices.ptr;
+    Scene_Matrix* world   = scene->world_matrices.ptr;
+    u8*           dirty   = scene->dirty.ptr;
+    const u32*    meshes  = scene->mesh_indices.ptr;
+    u64           mesh_count = scene->mesh_instances_dirty.nitems; // 0 until the instances are built
+
+    u32 updated = 0;
+    u32 node    = 0;
+
+    // A clean node's parent is clean too, or the parent's subtree would have been redone and skipped past it
+    while(node < scene->node_count){
+
+        if(!dirty[node]){
+            node++;
+            continue;
+        }
+
+        u32 subtree_end = scene->subtree_ends.ptr[node];
+        for(u32 i = node; i < subtree_end; i++){
+            if(parents[i] == SCENE_NO_PARENT){
+                world[i] = local[i];
+            } else {
+                scene_multiply_matrix(local[i].m, world[parents[i]].m, world[i].m);
+            }
+            dirty[i] = 0;
+            if(meshes[i] < mesh_count){
+                scene->mesh_instances_dirty.ptr[meshes[i]] = 1;
+            }
+        }
+
+        updated += subtree_end - node;
+        node     = subtree_end;
+
+    }
+
+    return updated;
+
+}
+
+Mesh_Bounds scene_instance_bounds(const Scene* scene, const Mesh_Bounds* mesh_bounds){
+
+    Mesh_Bounds bounds = mesh_bounds_empty();
+    for(u64 i = 0; i < scene->instance_nodes.nitems; i++){
+        u32 node = scene->instance_nodes.ptr[i];
+        Mesh_Bounds instance_bounds;
+        mesh_bounds_transform(mesh_bounds[scene->mesh_indices.ptr[node]], scene->world_matrices.ptr[node].m, &instance_bounds);
+        mesh_bounds_merge(&bounds, instance_bounds);
+    }
+    return bounds;
+
+}
+
+/////////////////////////////////
+// Matrices
+/////////////////////////////////
+
+void scene_identity_matrix(f32* matrix){
+
+    memset(matrix, 0, sizeof(Scene_Matrix));
+    matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.f;
+
+}
+
+void scene_multiply_matrix(const f32* a, const f32* b, f32* result){
+
+#ifdef SCENE_SSE
+
+    // Each row of the result is a's row weighting b's rows
+    __m128 b0 = _mm_loadu_ps(b + 0);
+    __m128 b1 = _mm_loadu_ps(b + 4);
+    __m128 b2 = _mm_loadu_ps(b + 8);
+    __m128 b3 = _mm_loadu_ps(b + 12);
+
+    for(u32 row = 0; row < 4; row++){
+        const f32* a_row = a + row * 4;
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(a_row[0]), b0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a_row[1]), b1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a_row[2]), b2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a_row[3]), b3));
+        _mm_storeu_ps(result + row * 4, sum);
+    }
+
+#else
+
+    for(u32 row = 0; row < 4; row++){
+        for(u32 column = 0; column < 4; column++){
+            result[row * 4 + column] = a[row * 4 + 0] * b[0 * 4 + column] + a[row * 4 + 1] * b[1 * 4 + column] +
+                                       a[row * 4 + 2] * b[2 * 4 + column] + a[row * 4 + 3] * b[3 * 4 + column];
+        }
+    }
+
+#endif
+
+}
+
+void scene_trs_matrix(const f64* translation, const f64* rotation, const f64* scale, f32* matrix){
+
+    f32 x = 0.f, y = 0.f, z = 0.f, w = 1.f;
+    if(rotation){
+        x = (f32)rotation[0]; y = (f32)rotation[1]; z = (f32)rotation[2]; w = (f32)rotation[3];
+    }
+
+    // Rows are where the rotation takes the x, y and z axes
+    f32 rotation_rows[3][3] = {
+        {1.f - 2.f * (y * y + z * z), 2.f * (x * y + z * w),       2.f * (x * z - y * w)},
+        {2.f * (x * y - z * w),       1.f - 2.f * (x * x + z * z), 2.f * (y * z + x * w)},
+        {2.f * (x * z + y * w),       2.f * (y * z - x * w),       1.f - 2.f * (x * x + y * y)},
+    };
+
+    for(u32 row = 0; row < 3; row++){
+        f32 row_scale = scale ? (f32)scale[row] : 1.f;
+        for(u32 column = 0; column < 3; column++){
+            matrix[row * 4 + column] = rotation_rows[row][column] * row_scale;
+        }
+        matrix[row * 4 + 3] = 0.f;
+    }
+
+    matrix[12] = translation ? (f32)translation[0] : 0.f;
+    matrix[13] = translation ? (f32)translation[1] : 0.f;
+    matrix[14] = translation ? (f32)translation[2] : 0.f;
+    matrix[15] = 1.f;
+
+}
+
+void scene_flip_z(f32* matrix){
+
+    // flip * matrix * flip, everything that mixes z with x, y or w changes sign
+    for(u32 i = 0; i < 4; i++){
+        if(i != 2){
+            matrix[i * 4 + 2] = -matrix[i * 4 + 2];
+            matrix[2 * 4 + i] = -matrix[2 * 4 + i];
+        }
+    }
+
+}
+
+f32 scene_max_scale(const f32* matrix){
+
+    f32 max_squared = 0.f;
+    for(u32 row = 0; row < 3; row++){
+        const f32* r = matrix + row * 4;
+        f32 squared = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        max_squared = squared > max_squared ? squared : max_squared;
+    }
+    return sqrtf(max_squared);
+
+}
+
+bool scene_invert_affine(const f32* matrix, f32* inverse){
+
+    const f32* m = matrix;
+
+    // Cofactors of the 3x3 part
+    f32 c00 = m[5] * m[10] - m[6] * m[9];
+    f32 c01 = m[6] * m[8]  - m[4] * m[10];
+    f32 c02 = m[4] * m[9]  - m[5] * m[8];
+
+    f32 determinant = m[0] * c00 + m[1] * c01 + m[2] * c02;
+    if(determinant == 0.f){
+        return false;
+    }
+    f32 d = 1.f / determinant;
+
+    f32 r[16];
+    r[0]  = c00 * d;
+    r[1]  = (m[2] * m[9]  - m[1] * m[10]) * d;
+    r[2]  = (m[1] * m[6]  - m[2] * m[5])  * d;
+    r[4]  = c01 * d;
+    r[5]  = (m[0] * m[10] - m[2] * m[8])  * d;
+    r[6]  = (m[2] * m[4]  - m[0] * m[6])  * d;
+    r[8]  = c02 * d;
+    r[9]  = (m[1] * m[8]  - m[0] * m[9])  * d;
+    r[10] = (m[0] * m[5]  - m[1] * m[4])  * d;
+    r[3] = r[7] = r[11] = 0.f;
+
+    // The translation, taken back through the inverted 3x3
+    for(u32 column = 0; column < 3; column++){
+        r[12 + column] = -(m[12] * r[column] + m[13] * r[4 + column] + m[14] * r[8 + column]);
+    }
+    r[15] = 1.f;
+
+    memcpy(inverse, r, sizeof(r));
+    return true;
+
+}
+
+void scene_transform_point(const f32* matrix, const f32* point, f32* result){
+
+    f32 p[3] = {point[0], point[1], point[2]};
+    for(u32 column = 0; column < 3; column++){
+        result[column] = p[0] * matrix[column] + p[1] * matrix[4 + column] + p[2] * matrix[8 + column] + matrix[12 + column];
+    }
+
+}
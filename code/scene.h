@@ -0,0 +1,107 @@
+#ifndef _SCENE
+#define _SCENE
+
+#include "d_types.h"
+#include "d_span.h"
+#include "mesh_bounds.h"
+
+/*
+*   A model's node hierarchy, flattened
+*
+*   Nodes are stored depth first, so a node's parent always comes before it and its descendants are the
+*   nodes right after it, up to subtree_end. Each part of a node is its own array. Nodes with a mesh are
+*   that mesh's instances, the mesh itself is only loaded once however many nodes use it.
+*
+*   Matrices are row major and transform row vectors, like DirectXMath: world = local * parent's world.
+*   They're in the renderer's space, the loaders flip z on the node transforms like on the vertices.
+*
+*   scene_set_local_matrix marks a node dirty, scene_update_world_matrices then redoes the world
+*   matrices of the dirty nodes' subtrees and nothing else. It also flags every mesh with an instance in
+*   those subtrees, for whoever keeps per instance data to redo just those meshes and clear the flags.
+*/
+
+#define SCENE_NO_PARENT 0xFFFFFFFF
+#define SCENE_NO_MESH   0xFFFFFFFF
+
+struct Scene_Matrix {
+    f32 m[16];
+};
+
+struct Scene {
+    u32 node_count;
+    d_std::Span<u32>          parents;         // SCENE_NO_PARENT for roots
+    d_std::Span<u32>          subtree_ends;    // One past the node's last descendant
+    d_std::Span<u32>          mesh_indices;    // SCENE_NO_MESH for nodes that only transform their children
+    d_std::Span<Scene_Matrix> local_matrices;
+    d_std::Span<Scene_Matrix> world_matrices;
+    d_std::Span<u8>           dirty;
+
+    d_std::Span<u32>          instance_nodes;         // Every node with a mesh, grouped by mesh, in node order within a mesh
+    d_std::Span<u32>          mesh_instance_offsets;  // Mesh i's instances are instance_nodes[offsets[i] .. offsets[i + 1]]
+    d_std::Span<u8>           mesh_instances_dirty;   // Per mesh, an instance's world matrix changed. Set by the scene, cleared by its users
+};
+
+// Every node starts as a root with an identity local matrix, no mesh and dirty
+void scene_alloc(Scene* scene, u32 node_count);
+void scene_free(Scene* scene);
+
+/*
+*   Lays out the nodes reachable from roots depth first and allocates the scene for them. The children of
+*   source node i are children[child_offsets[i] .. child_offsets[i + 1]], out of range ones are skipped and
+*   a node reached a second time is left out. source_nodes has to hold source_node_count, it gets the source
+*   node of each scene node, for setting their meshes and matrices. Returns the scene's node count.
+*/
+u32 scene_flatten(Scene* scene, u32 source_node_count, const u32* child_offsets, const u32* children, const u32* roots, u32 root_count, u32* source_nodes);
+
+// Fills instance_nodes and mesh_instance_offsets from mesh_indices, call once the nodes are set. Nodes with a mesh index past mesh_count aren't instances.
+// Every mesh starts dirty
+void scene_build_instances(Scene* scene, u32 mesh_count);
+
+// One root node instancing each mesh, for models without a node hierarchy
+void scene_one_node_per_mesh(Scene* scene, u32 mesh_count);
+
+void scene_set_local_matrix(Scene* scene, u32 node, const f32* matrix);
+
+/*
+*   Repeats the whole hierarchy once per placement, each copy's root matrices followed by its placement,
+*   and rebuilds the instances. For putting one model in a scene several times, see scene_file.h
+*/
+void scene_replicate(Scene* scene, const Scene_Matrix* placements, u32 copies, u32 mesh_count);
+
+/*
+*   Repeats the whole hierarchy copies times, the copies' roots spaced out on an x / z grid spacing apart, and
+*   rebuilds the instances. For stress testing instanced drawing with a single small model
+*/
+void scene_replicate_grid(Scene* scene, u32 copies, f32 spacing, u32 mesh_count);
+
+// Returns how many nodes' world matrices were updated
+u32 scene_update_world_matrices(Scene* scene);
+
+// Bounds of every instance, mesh_bounds[i] moved by the world matrix of each of mesh i's instances. The world matrices have to be up to date
+Mesh_Bounds scene_instance_bounds(const Scene* scene, const Mesh_Bounds* mesh_bounds);
+
+/////////////////////////////////
+// Matrices
+/////////////////////////////////
+
+void scene_identity_matrix(f32* matrix);
+
+// result = a * b, result can't be a or b
+void scene_multiply_matrix(const f32* a, const f32* b, f32* result);
+
+// glTF's scale, then rotation (x, y, z, w quaternion), then translation. Any of them can be NULL
+void scene_trs_matrix(const f64* translation, const f64* rotation, const f64* scale, f32* matrix);
+
+// Takes a glTF transform into the renderer's z flipped space
+void scene_flip_z(f32* matrix);
+
+// The most the matrix stretches any direction, bounding radii are scaled by it
+f32 scene_max_scale(const f32* matrix);
+
+// Inverse of a matrix whose last column is 0, 0, 0, 1. Returns false if it's singular
+bool scene_invert_affine(const f32* matrix, f32* inverse);
+
+// Point times matrix, w = 1
+void scene_transform_point(const f32* matrix, const f32* point, f32* result);
+
+#endif // _SCENE
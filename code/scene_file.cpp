@@ -0,0 +1,263 @@
+#include "scene_file.h"
+#include "d_os.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+#include "math.h"
+
+#define SCENE_FILE_MAX_LINE 4096
+
+static char* scene_file_copy_string(const char* string, u64 length){
+
+    char* copy = (char*)malloc(length + 1);
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+    return copy;
+
+}
+
+static bool scene_file_is_space(char c){
+
+    return c == ' ' || c == '\t' || c == '\r';
+
+}
+
+// Procedural assets and absolute paths are left alone
+static bool scene_file_is_relative(const char* path){
+
+    if(strncmp(path, SCENE_FILE_PROCEDURAL_PREFIX, strlen(SCENE_FILE_PROCEDURAL_PREFIX)) == 0){
+        return false;
+    }
+    return !(path[0] == '/' || path[0] == '\\' || (path[0] && path[1] == ':'));
+
+}
+
+void scene_file_reserve(Scene_File* scene_file, u32 assets, u32 placements){
+
+    if(scene_file->asset_count + assets > scene_file->asset_paths.nitems){
+        scene_file->asset_paths.nitems = scene_file->asset_count + assets;
+        scene_file->asset_paths.ptr    = (char**)realloc(scene_file->asset_paths.ptr, scene_file->asset_paths.nitems * sizeof(char*));
+    }
+
+    if(scene_file->placement_count + placements > scene_file->placements.nitems){
+        scene_file->placements.nitems = scene_file->placement_count + placements;
+        scene_file->placements.ptr    = (Scene_File_Placement*)realloc(scene_file->placements.ptr, scene_file->placements.nitems * sizeof(Scene_File_Placement));
+    }
+
+}
+
+u32 scene_file_add_asset(Scene_File* scene_file, const char* path){
+
+    for(u32 i = 0; i < scene_file->asset_count; i++){
+        if(strcmp(scene_file->asset_paths.ptr[i], path) == 0){
+            return i;
+        }
+    }
+
+    scene_file->asset_paths.ptr[scene_file->asset_count] = scene_file_copy_string(path, strlen(path));
+    return scene_file->asset_count++;
+
+}
+
+void scene_file_free(Scene_File* scene_file){
+
+    for(u32 i = 0; i < scene_file->asset_count; i++){
+        free(scene_file->asset_paths.ptr[i]);
+    }
+    free(scene_file->asset_paths.ptr);
+    free(scene_file->placements.ptr);
+    *scene_file = {};
+
+}
+
+bool scene_file_load(Scene_File* scene_file, const char* filename){
+
+    d_std::Mapped_File file;
+    if(!d_std::os_map_file(filename, &file, d_std::MAP_ACCESS_SEQUENTIAL)){
+        d_std::os_debug_print("Error (scene_file_load): couldn't open the scene file\n");
+        return false;
+    }
+
+    // At most one asset and one placement per line
+    u32 line_count = 1;
+    for(u64 i = 0; i < file.size; i++){
+        line_count += file.data[i] == '\n';
+    }
+    scene_file_reserve(scene_file, line_count, line_count);
+
+    // Everything up to and including the last slash
+    const char* last_slash = NULL;
+    for(const char* c = filename; *c; c++){
+        if(*c == '/' || *c == '\\'){
+            last_slash = c;
+        }
+    }
+    u64 directory_length = last_slash ? (u64)(last_slash - filename) + 1 : 0;
+
+    char line[SCENE_FILE_MAX_LINE];
+    char path[SCENE_FILE_MAX_LINE * 2];
+    char error_string[256];
+    u64 line_start = 0;
+
+    for(u32 line_number = 1; line_start < file.size; line_number++){
+
+        u64 line_end = line_start;
+        while(line_end < file.size && file.data[line_end] != '\n'){
+            line_end++;
+        }
+        u64 line_length = line_end - line_start;
+        const char* line_source = (const char*)file.data + line_start;
+        line_start = line_end + 1;
+
+        if(line_length >= SCENE_FILE_MAX_LINE){
+            snprintf(error_string, sizeof(error_string), "Error (scene_file_load): line %u is too long\n", line_number);
+            d_std::os_debug_print(error_string);
+            continue;
+        }
+        memcpy(line, line_source, line_length);
+        line[line_length] = '\0';
+
+        // Comments run to the end of the line
+        char* comment = strchr(line, '#');
+        if(comment){
+            *comment = '\0';
+        }
+
+        char* c = line;
+        while(scene_file_is_space(*c)) c++;
+        if(*c == '\0'){
+            continue;
+        }
+
+        if(strncmp(c, "model", 5) != 0 || !scene_file_is_space(c[5])){
+            snprintf(error_string, sizeof(error_string), "Error (scene_file_load): line %u doesn't start with model\n", line_number);
+            d_std::os_debug_print(error_string);
+            continue;
+        }
+        c += 5;
+        while(scene_file_is_space(*c)) c++;
+
+        // Quoted, or up to the next space
+        const char* path_start = c;
+        if(*c == '"'){
+            path_start = ++c;
+            while(*c && *c != '"') c++;
+        } else {
+            while(*c && !scene_file_is_space(*c)) c++;
+        }
+        u64 path_length = (u64)(c - path_start);
+        if(*c == '"') c++;
+
+        if(path_length == 0 || directory_length + path_length >= sizeof(path)){
+            snprintf(error_string, sizeof(error_string), "Error (scene_file_load): line %u has no path, or it's too long\n", line_number);
+            d_std::os_debug_print(error_string);
+            continue;
+        }
+
+        memcpy(path, path_start, path_length);
+        path[path_length] = '\0';
+        if(scene_file_is_relative(path)){
+            memmove(path + directory_length, path, path_length + 1);
+            memcpy(path, filename, directory_length);
+        }
+
+        // Translation, rotation and scale, in that order
+        f32 numbers[5] = {0.f, 0.f, 0.f, 0.f, 1.f};
+        u32 number_count = 0;
+        bool bad_number = false;
+        while(true){
+            while(scene_file_is_space(*c)) c++;
+            if(*c == '\0'){
+                break;
+            }
+            char* number_end;
+            f32 number = strtof(c, &number_end);
+            if(number_end == c || number_count == 5){
+                bad_number = true;
+                break;
+            }
+            numbers[number_count++] = number;
+            c = number_end;
+        }
+
+        if(bad_number || number_count == 1 || number_count == 2){
+            snprintf(error_string, sizeof(error_string), "Error (scene_file_load): line %u should be model <path> [x y z [rotation_y [scale]]]\n", line_number);
+            d_std::os_debug_print(error_string);
+            continue;
+        }
+
+        Scene_File_Placement& placement = scene_file->placements.ptr[scene_file->placement_count++];
+        placement.asset          = scene_file_add_asset(scene_file, path);
+        placement.translation[0] = numbers[0];
+        placement.translation[1] = numbers[1];
+        placement.translation[2] = numbers[2];
+        placement.rotation_y     = numbers[3];
+        placement.scale          = numbers[4];
+
+    }
+
+    d_std::os_unmap_file(&file);
+
+    if(scene_file->placement_count == 0){
+        d_std::os_debug_print("Error (scene_file_load): the scene file doesn't place any models\n");
+        return false;
+    }
+
+    return true;
+
+}
+
+bool scene_file_write(const Scene_File* scene_file, const char* filename){
+
+    FILE* file = fopen(filename, "w");
+    if(!file){
+        return false;
+    }
+
+    fprintf(file, "# model <path> [x y z [rotation_y [scale]]]\n");
+    for(u32 i = 0; i < scene_file->placement_count; i++){
+        const Scene_File_Placement& placement = scene_file->placements.ptr[i];
+        fprintf(file, "model \"%s\" %g %g %g %g %g\n", scene_file->asset_paths.ptr[placement.asset], placement.translation[0], placement.translation[1],
+            placement.translation[2], placement.rotation_y, placement.scale);
+    }
+
+    fclose(file);
+    return true;
+
+}
+
+void scene_file_add_grid(Scene_File* scene_file, u32 asset, u32 copies, f32 spacing){
+
+    scene_file_reserve(scene_file, 0, copies);
+
+    // Square-ish grid on x and z, centered on the origin
+    u32 columns = (u32)ceilf(sqrtf((f32)copies));
+    u32 rows    = copies ? (copies + columns - 1) / columns : 0;
+
+    for(u32 copy = 0; copy < copies; copy++){
+
+        Scene_File_Placement& placement = scene_file->placements.ptr[scene_file->placement_count++];
+        placement.asset          = asset;
+        placement.translation[0] = ((f32)(copy % columns) - (f32)(columns - 1) * 0.5f) * spacing;
+        placement.translation[1] = 0.f;
+        placement.translation[2] = ((f32)(copy / columns) - (f32)(rows - 1) * 0.5f) * spacing;
+        placement.scale          = 1.f;
+
+        // Whole degrees scattered by a multiplicative hash, the same scene every time
+        placement.rotation_y = (f32)((copy * 2654435761u >> 16) % 360);
+
+    }
+
+}
+
+void scene_file_placement_matrix(const Scene_File_Placement& placement, Scene_Matrix* matrix){
+
+    // Half the angle around y
+    f64 half_angle  = (f64)placement.rotation_y * 3.14159265358979323846 / 360.;
+    f64 rotation[4] = {0., sin(half_angle), 0., cos(half_angle)};
+    f64 scale[3]    = {placement.scale, placement.scale, placement.scale};
+    f64 translation[3] = {placement.translation[0], placement.translation[1], placement.translation[2]};
+
+    scene_trs_matrix(translation, rotation, scale, matrix->m);
+
+}
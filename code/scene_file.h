@@ -0,0 +1,60 @@
+#ifndef _SCENE_FILE
+#define _SCENE_FILE
+
+#include "d_types.h"
+#include "d_span.h"
+#include "scene.h"
+
+/*
+*   A scene description, the assets to load and where to put them
+*
+*   A text file, one placement per line, # starts a comment:
+*
+*       model <path> [x y z [rotation_y [scale]]]
+*
+*   path is a .gltf / .glb, a .ddxpkg from ddx_cook, or procedural:N for N generated meshes (see
+*   load_procedural_model). Quote it if it has spaces, relative paths are from the scene file's directory.
+*   The translation is in the asset's own units and the renderer's space (after the loaders flip z), the
+*   rotation in degrees around y. A path that's used more than once is still one asset, its placements
+*   become copies of its scene and are drawn instanced.
+*/
+
+#define SCENE_FILE_PROCEDURAL_PREFIX "procedural:"
+
+struct Scene_File_Placement {
+    u32 asset;           // Index into asset_paths
+    f32 translation[3];
+    f32 rotation_y;      // Degrees
+    f32 scale;
+};
+
+struct Scene_File {
+    d_std::Span<char*>                asset_paths; // Each path once, in the order they're first placed
+    d_std::Span<Scene_File_Placement> placements;
+    u32 asset_count;
+    u32 placement_count;
+};
+
+// Returns false if the file can't be read or places nothing. Lines that don't parse are reported and skipped
+bool scene_file_load(Scene_File* scene_file, const char* filename);
+
+bool scene_file_write(const Scene_File* scene_file, const char* filename);
+
+void scene_file_free(Scene_File* scene_file);
+
+// Adds the asset if the scene doesn't have it yet, returns its index. The scene has to have room, see scene_file_reserve
+u32 scene_file_add_asset(Scene_File* scene_file, const char* path);
+
+// Room for this many more assets and placements
+void scene_file_reserve(Scene_File* scene_file, u32 assets, u32 placements);
+
+/*
+*   Synthetic stress scene, copies placements of asset on a square-ish x / z grid spacing apart, each turned
+*   by a different rotation around y. For scaling how much the CPU does per frame with the scene size
+*/
+void scene_file_add_grid(Scene_File* scene_file, u32 asset, u32 copies, f32 spacing);
+
+// Scale, then the rotation around y, then the translation. Placements are in the renderer's space, the one the node matrices end up in
+void scene_file_placement_matrix(const Scene_File_Placement& placement, Scene_Matrix* matrix);
+
+#endif // _SCENE_FILE
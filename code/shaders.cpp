@@ -7,11 +7,29 @@ using namespace d_dx12;
 
 // This file is ment for isolation of pipeline creation and shader management
 
+/*
+*   Mesh vertices come in two streams, positions in slot 0 and the other attributes in slot 1.
+*   Passes that only need positions leave slot 1 out of their input layout, and bind_and_draw_model
+*   then only binds the position stream.
+*/
+
+// Input layout of the quantized streams, the vertex shaders decode them when compiled with QUANTIZED_VERTICES
+static void set_quantized_vertex_input(Shader_Desc& shader_desc, bool positions_only)
+{
+    shader_desc.vertex_shader_define = L"QUANTIZED_VERTICES";
+
+    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "POSITION")   , DXGI_FORMAT_R16G16B16A16_UNORM, 0});
+    if(!positions_only){
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "NORMAL")     , DXGI_FORMAT_R10G10B10A2_UNORM, 1});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TEXCOORD")   , DXGI_FORMAT_R16G16_FLOAT, 1});
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //  Forward Render PBR Shader
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Shader* create_forward_render_pbr_shader()
+Shader* create_forward_render_pbr_shader(bool quantized_vertices)
 {
 
     DEBUG_LOG("Creating Forward Rendering PBR shader");
@@ -33,11 +51,15 @@ Shader* create_forward_render_pbr_shader()
     //  Input Layout
     /////////////////
 
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "POSITION")   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "NORMAL")     , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "COLOR")      , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TEXCOORD")   , DXGI_FORMAT_R32G32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TANGENT")    , DXGI_FORMAT_R32G32B32A32_FLOAT, 0});
+    if(quantized_vertices){
+        set_quantized_vertex_input(shader_desc, false);
+    } else {
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "POSITION")   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "NORMAL")     , DXGI_FORMAT_R32G32B32_FLOAT, 1});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "COLOR")      , DXGI_FORMAT_R32G32B32_FLOAT, 1});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TEXCOORD")   , DXGI_FORMAT_R32G32_FLOAT, 1});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TANGENT")    , DXGI_FORMAT_R32G32B32A32_FLOAT, 1});
+    }
 
     /////////////////////////////////////////
     //  Create PSO using shader reflection
@@ -51,7 +73,7 @@ Shader* create_forward_render_pbr_shader()
 //  Deferred Rendering G-Buffer Shader
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Shader* create_deferred_render_gbuffer_shader()
+Shader* create_deferred_render_gbuffer_shader(bool quantized_vertices)
 {
     DEBUG_LOG("Creating Deferred Rendering G-Buffer Shader");
 
@@ -72,11 +94,15 @@ Shader* create_deferred_render_gbuffer_shader()
     //  Input Layout
     /////////////////////
 
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "POSITION")   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "NORMAL")     , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "COLOR")      , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TEXCOORD")   , DXGI_FORMAT_R32G32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TANGENT")    , DXGI_FORMAT_R32G32B32A32_FLOAT, 0});
+    if(quantized_vertices){
+        set_quantized_vertex_input(shader_desc, false);
+    } else {
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "POSITION")   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "NORMAL")     , DXGI_FORMAT_R32G32B32_FLOAT, 1});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "COLOR")      , DXGI_FORMAT_R32G32B32_FLOAT, 1});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TEXCOORD")   , DXGI_FORMAT_R32G32_FLOAT, 1});
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TANGENT")    , DXGI_FORMAT_R32G32B32A32_FLOAT, 1});
+    }
 
     /////////////////////
     //  Render Targets
@@ -155,7 +181,7 @@ Shader* create_deferred_render_shading_shader()
 //  Shadow Map Shader
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Shader* create_shadow_mapping_shader()
+Shader* create_shadow_mapping_shader(bool quantized_vertices)
 {
     DEBUG_LOG("Creating Shadow Mapping Shader");
 
@@ -176,11 +202,12 @@ Shader* create_shadow_mapping_shader()
     //  Input Layout
     /////////////////
 
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "POSITION")   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "NORMAL"  )   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TANGENT" )   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "COLOR"   )   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
-    shader_desc.input_layout.push_back({DSTR(per_frame_arena, "TEXCOORD")   , DXGI_FORMAT_R32G32_FLOAT, 0});
+    // Depth only, just the position stream
+    if(quantized_vertices){
+        set_quantized_vertex_input(shader_desc, true);
+    } else {
+        shader_desc.input_layout.push_back({DSTR(per_frame_arena, "POSITION")   , DXGI_FORMAT_R32G32B32_FLOAT, 0});
+    }
 
 
     /////////////////////////////////////////
@@ -0,0 +1,1953 @@
+// Cooks a glTF model into a .ddxpkg package (see ddx_package.h) that DDX123 memory maps and
+// uploads without parsing json, decoding images, flipping vertices or generating mips.
+//
+// Usage: ddx_cook <model.gltf|model.glb> <out.ddxpkg> [--cache <directory>] [--cache-mb N] [--no-cache] [--mesh-report] [--weld-tolerance X]
+//        ddx_cook --bench <model.gltf|model.glb> <package.ddxpkg> [--runs N]
+//        ddx_cook --cull-report <package.ddxpkg> [--frames N]
+//        ddx_cook --lod-report <package.ddxpkg> [--frames N]
+//        ddx_cook --tangent-bench <triangles> [--runs N]
+//     --cache <directory>  Derived data cache, defaults to ddx_cache next to the package
+//     --cache-mb N         Cache size cap, least recently used entries are evicted past it
+//     --no-cache           Cook everything from scratch
+//     --mesh-report        Vertex counts before and after welding, and vertex cache ACMR / ATVR before
+//                          and after optimize_mesh, of every mesh
+//     --weld-tolerance X   Also weld vertices whose attributes snap to the same multiples of X,
+//                          by default only identical vertices are welded
+//     --bench              Times getting the model ready for upload from the glTF (parse, decode,
+//                          flip, mips) against mapping the package and copying it out, with the
+//                          files evicted from the OS cache (cold) and already cached (warm)
+//     --cull-report        Runs the CPU meshlet culler along camera paths through the package's
+//                          bounds and prints the share of triangles culled by frustum and by cone
+//     --lod-report         Selects LODs for the camera and the shadow map along the same paths and
+//                          prints the triangles drawn and the CPU time of the selection
+//     --tangent-bench      Times tangent generation, which cooking runs on primitives without TANGENT,
+//                          on that many triangles of synthetic primitives and checks the result
+//
+// Cooked meshes and mip chains are kept in the cache, keyed by their source bytes and the
+// COOK_*_VERSION of the code that cooks them, so re-cooking a model only redoes what changed.
+
+#include "../d_core/d_core.cpp"
+#include "../ddx_package.h"
+#include "../mesh_optimize.cpp"
+#include "../meshlet.cpp"
+#include "../mesh_simplify.cpp"
+#include "../mesh_tangents.cpp"
+#include "../mesh_weld.cpp"
+#include "../mesh_bounds.cpp"
+#include "../scene.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_EXTERNAL_IMAGE // Images are decoded by prepare_texture_job
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define STB_IMAGE_IMPLEMENTATION
+#include "tiny_gltf.h"
+
+namespace tg = tinygltf;
+using namespace d_std;
+
+#define DEFAULT_RUNS 3
+#define DEFAULT_REPORT_FRAMES 256
+
+// What the renderer draws with, for the cull and LOD reports
+#define REPORT_FOV_DEGREES   75.f
+#define REPORT_ASPECT        (16.f / 9.f)
+#define REPORT_RENDER_HEIGHT 1080.f
+#define REPORT_MODEL_SCALE   0.1f   // bind_and_draw_model scales every model by 0.1
+#define REPORT_SHADOW_EXTENT 500.f  // Width and height of render_shadow_map's orthographic projection, the shadow map is render sized
+
+// Bump when the cooked output of that step changes, so cached entries made by older code aren't used
+#define COOK_MESH_VERSION 8
+#define COOK_MIPS_VERSION 1
+
+// Start of a cached mip chain entry
+struct Cached_Texture_Header {
+    u32 width;
+    u32 height;
+    u32 format;
+    u32 mip_count;
+};
+
+struct Cook_Image {
+    u8*  pixels;         // From stb_image, always 4 channels
+    u32  width;
+    u32  height;
+    bool is_16_bit;
+    u32  texture_index;  // Into the package's textures, PACKAGE_NO_TEXTURE if no material slot uses the image
+
+    Cache_Key   cache_key;
+    Cache_Entry cache_entry; // Set on a cache hit, the image isn't decoded
+    bool        decode_failed;
+    u64         encoded_size; // 0 if the image couldn't be opened
+    Hash_128    encoded_hash; // murmur3_128 of the encoded bytes, images with the same bytes share a texture
+};
+
+struct Cook_Stats {
+    f64 parse_ms;
+    f64 decode_ms;
+    f64 build_ms;
+    u64 vertex_count;
+    u64 index_count;
+    u32 texture_count;
+    u32 textures_deduplicated;  // Images with the same bytes as an earlier one, sharing its texture
+    u32 meshes_cached;
+    u32 textures_cached;
+    u64 meshlet_count;
+    u64 meshlet_triangle_count;
+    f64 simplify_ms;                              // Summed over the mesh jobs, so CPU time rather than wall time
+    u64 lod_triangle_count[MESH_LOD_MAX];         // Primitives without that many LODs count their last one
+    u32 node_count;
+    u32 instance_count;
+
+    std::vector<std::string>         mesh_names;
+    std::vector<Mesh_Optimize_Stats> mesh_optimize; // Per mesh
+    std::vector<Mesh_Weld_Stats>     mesh_weld;     // Per mesh
+};
+
+// A mesh's meshlets, built with the mesh and laid out in the package once every mesh is done
+struct Cook_Meshlets {
+    std::vector<Meshlet_Counts> primitives; // Per primitive
+    std::vector<Meshlet>        meshlets;
+    std::vector<u16>            vertices;
+    std::vector<u8>             triangles;
+};
+
+// What a primitive's LOD chain puts in its Package_Primitive
+struct Cook_Primitive_Lods {
+    u32      lod_count;
+    Mesh_Lod lods[MESH_LOD_MAX];
+    u32      lod_index_count;
+    Mesh_Bounds bounds;
+};
+
+// A mesh's LOD chains, built with the mesh and laid out in the package once every mesh is done
+struct Cook_Lods {
+    std::vector<Cook_Primitive_Lods> primitives; // Per primitive
+    std::vector<u16>                 indices;    // LOD 1 and up
+    f64                              simplify_ms;
+};
+
+struct Cook_Jobs {
+    tg::Model*   tg_model;
+    std::string* base_dir;
+    Cook_Image*  images;
+    u32*         texture_images;     // Image index of each package texture
+    u8*          package;
+    Derived_Data_Cache* cache;       // NULL to cook everything
+    Mesh_Optimize_Stats* mesh_stats; // Per mesh
+    Mesh_Weld_Stats*     weld_stats; // Per mesh
+    Cook_Meshlets*       meshlets;   // Per mesh
+    Cook_Lods*           lods;       // Per mesh
+    f32                  weld_tolerance;
+    volatile u32 meshes_cached;
+};
+
+struct Cooked_Package {
+    u8* data;
+    u64 size;
+};
+
+// Embedded images are kept encoded, prepare_texture_job decodes the ones the materials use
+static bool defer_image_decode(tg::Image* image, const int image_index, std::string* err, std::string* warn,
+    int req_width, int req_height, const unsigned char* bytes, int size, void* user_data){
+
+    image->image.assign(bytes, bytes + size);
+    return true;
+
+}
+
+static bool load_gltf(const char* filename, tg::Model* tg_model){
+
+    tg::TinyGLTF model_loader;
+    model_loader.SetImageLoader(defer_image_decode, nullptr);
+
+    std::string err;
+    std::string warn;
+    u64 length = strlen(filename);
+    bool is_binary = length > 4 && strcmp(filename + length - 4, ".glb") == 0;
+
+    bool ret = is_binary ? model_loader.LoadBinaryFromFile(tg_model, &err, &warn, filename)
+                         : model_loader.LoadASCIIFromFile(tg_model, &err, &warn, filename);
+
+    if(!warn.empty()){
+        printf("Warning: %s\n", warn.c_str());
+    }
+    if(!ret){
+        printf("Error: couldn't load %s: %s\n", filename, err.c_str());
+    }
+
+    return ret;
+
+}
+
+// The image a material texture slot samples, -1 if the slot is empty
+static s32 texture_image_index(tg::Model& tg_model, int texture_index){
+
+    if(texture_index < 0 || texture_index >= (int)tg_model.textures.size()){
+        return -1;
+    }
+
+    s32 image_index = tg_model.textures[texture_index].source;
+    return image_index < (s32)tg_model.images.size() ? image_index : -1;
+
+}
+
+// Looks the image's mip chain up in the cache, and decodes the image if it isn't there
+static void prepare_texture_job(void* data, u32 index){
+
+    Cook_Jobs* jobs    = (Cook_Jobs*)data;
+    u32 image_index    = jobs->texture_images[index];
+    tg::Image& tg_image = jobs->tg_model->images[image_index];
+    Cook_Image& image  = jobs->images[image_index];
+
+    Mapped_File image_file;
+    const u8* encoded      = tg_image.image.data();
+    u64       encoded_size = tg_image.image.size();
+
+    if(encoded_size == 0){
+        std::string path = *jobs->base_dir + tg_image.uri;
+        if(!os_map_file(path.c_str(), &image_file, MAP_ACCESS_SEQUENTIAL)){
+            printf("Error: couldn't open image %s\n", path.c_str());
+            return;
+        }
+        encoded      = image_file.data;
+        encoded_size = image_file.size;
+    }
+
+    image.encoded_size = encoded_size;
+    image.encoded_hash = murmur3_128(encoded, encoded_size);
+
+    if(jobs->cache){
+
+        image.cache_key = cache_key("mips", COOK_MIPS_VERSION);
+        cache_key_add(&image.cache_key, PACKAGE_VERSION);
+        cache_key_add(&image.cache_key, encoded, encoded_size);
+
+        if(cache_get(jobs->cache, image.cache_key, &image.cache_entry)){
+
+            const Cached_Texture_Header* cached = (const Cached_Texture_Header*)image.cache_entry.data;
+            bool valid = image.cache_entry.size >= sizeof(Cached_Texture_Header) && cached->mip_count == package_mip_count(cached->width, cached->height) &&
+                         image.cache_entry.size - sizeof(Cached_Texture_Header) == package_mip_chain_size(cached->width, cached->height, cached->mip_count, package_format_bytes_per_pixel(cached->format));
+
+            if(valid){
+                image.width     = cached->width;
+                image.height    = cached->height;
+                image.is_16_bit = cached->format == PACKAGE_FORMAT_R16G16B16A16_UNORM;
+                os_unmap_file(&image_file);
+                return;
+            }
+
+            cache_release(&image.cache_entry);
+
+        }
+
+    }
+
+    int width, height, components;
+    image.is_16_bit = stbi_is_16_bit_from_memory(encoded, (int)encoded_size);
+    image.pixels    = image.is_16_bit ? (u8*)stbi_load_16_from_memory(encoded, (int)encoded_size, &width, &height, &components, 4)
+                                      : (u8*)stbi_load_from_memory(encoded, (int)encoded_size, &width, &height, &components, 4);
+
+    os_unmap_file(&image_file);
+
+    if(image.pixels == NULL){
+        printf("Error: couldn't decode image %u (%s)\n", image_index, tg_image.uri.c_str());
+        return;
+    }
+
+    image.width  = width;
+    image.height = height;
+
+}
+
+// Returns a pointer to the accessor's first element and its byte stride. NULL if it has no buffer view
+static const u8* accessor_data(tg::Model& tg_model, const tg::Accessor& accessor, u32* byte_stride){
+
+    if(accessor.bufferView < 0){
+        return NULL;
+    }
+
+    const tg::BufferView& buffer_view = tg_model.bufferViews[accessor.bufferView];
+    *byte_stride = (u32)accessor.ByteStride(buffer_view);
+
+    return tg_model.buffers[buffer_view.buffer].data.data() + buffer_view.byteOffset + accessor.byteOffset;
+
+}
+
+static u32 primitive_vertex_count(tg::Model& tg_model, const tg::Primitive& primitive){
+
+    auto position = primitive.attributes.find("POSITION");
+    return position == primitive.attributes.end() ? 0 : (u32)tg_model.accessors[position->second].count;
+
+}
+
+static u32 primitive_index_count(tg::Model& tg_model, const tg::Primitive& primitive){
+
+    return primitive.indices >= 0 ? (u32)tg_model.accessors[primitive.indices].count : primitive_vertex_count(tg_model, primitive);
+
+}
+
+static u32 primitive_topology(int mode){
+
+    switch(mode){
+        case TINYGLTF_MODE_POINTS:         return PACKAGE_TOPOLOGY_POINT_LIST;
+        case TINYGLTF_MODE_LINE:           return PACKAGE_TOPOLOGY_LINE_LIST;
+        case TINYGLTF_MODE_LINE_STRIP:     return PACKAGE_TOPOLOGY_LINE_STRIP;
+        case TINYGLTF_MODE_TRIANGLE_STRIP: return PACKAGE_TOPOLOGY_TRIANGLE_STRIP;
+        default:                           return PACKAGE_TOPOLOGY_TRIANGLE_LIST;
+    }
+
+}
+
+struct Attribute_Layout {
+    const char* name;
+    u32         offset;      // In floats, into Package_Vertex
+    u32         components;
+    bool        flip_z;
+};
+
+// The glTF attributes that end up in Package_Vertex
+static const Attribute_Layout attribute_layouts[] = {
+    {"POSITION",   offsetof(Package_Vertex, position)            / sizeof(f32), 3, true},
+    {"NORMAL",     offsetof(Package_Vertex, normal)              / sizeof(f32), 3, true},
+    {"TANGENT",    offsetof(Package_Vertex, tangent)             / sizeof(f32), 4, true},
+    {"TEXCOORD_0", offsetof(Package_Vertex, texture_coordinates) / sizeof(f32), 2, false},
+    {"COLOR_0",    offsetof(Package_Vertex, color)               / sizeof(f32), 3, false},
+};
+
+// Copies count float attributes of components_to_copy floats each into the vertices, at destination_offset floats in
+static void copy_attribute(const u8* source, u32 byte_stride, u32 count, u32 components_to_copy, Package_Vertex* vertices, u32 destination_offset, bool flip_z){
+
+    for(u32 i = 0; i < count; i++){
+        const f32* attribute = (const f32*)(source + (u64)i * byte_stride);
+        f32* destination     = (f32*)&vertices[i] + destination_offset;
+        for(u32 component = 0; component < components_to_copy; component++){
+            destination[component] = attribute[component];
+        }
+        // glTF is right handed, the renderer is left handed
+        if(flip_z){
+            destination[2] = -destination[2];
+        }
+    }
+
+}
+
+/*
+*   Writes a primitive's vertices and indices in the renderer's layout.
+*   Reads the same attributes as decode_primitive in model.cpp, only float ones.
+*   Vertices are welded, which leaves welded_vertex_count of them at the front of vertices.
+*   indices are index_size wide, the mesh's. Triangle lists are run through optimize_mesh, returns its vertex
+*   cache stats, and get their meshlets and LOD chain appended. Those are u16 only, so primitives that still
+*   have more than PACKAGE_U16_VERTEX_MAX vertices after welding only get their tangents, like in decode_primitive
+*/
+static Mesh_Optimize_Stats cook_primitive(Cook_Jobs* jobs, const tg::Primitive& primitive, Package_Vertex* vertices, u32 vertex_count, void* indices, u32 index_size, u32 index_count,
+                                          Cook_Meshlets* meshlets, Cook_Lods* lods, u32* welded_vertex_count){
+
+    tg::Model& tg_model = *jobs->tg_model;
+    bool has_tangents   = false;
+
+    for(const Attribute_Layout& layout : attribute_layouts){
+
+        auto attribute = primitive.attributes.find(layout.name);
+        if(attribute == primitive.attributes.end()){
+            continue;
+        }
+
+        const tg::Accessor& accessor = tg_model.accessors[attribute->second];
+        u32 byte_stride;
+        const u8* data = accessor_data(tg_model, accessor, &byte_stride);
+
+        if(data == NULL || accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || (u32)tg::GetNumComponentsInType(accessor.type) < layout.components){
+            continue;
+        }
+
+        copy_attribute(data, byte_stride, d_min((u32)accessor.count, vertex_count), layout.components, vertices, layout.offset, layout.flip_z);
+        has_tangents |= layout.offset == offsetof(Package_Vertex, tangent) / sizeof(f32);
+
+    }
+
+    // Read at full width and welded before they're narrowed to u16, welding can bring a primitive
+    // with too many vertices back under. Unindexed primitives get 0, 1, 2, ...
+    std::vector<u32> indices_32(index_count);
+
+    if(primitive.indices < 0){
+        for(u32 i = 0; i < index_count; i++){
+            indices_32[i] = i;
+        }
+    } else {
+        const tg::Accessor& accessor = tg_model.accessors[primitive.indices];
+        u32 byte_stride;
+        const u8* data = accessor_data(tg_model, accessor, &byte_stride);
+
+        for(u32 i = 0; data && i < index_count; i++){
+            const u8* index = data + (u64)i * byte_stride;
+            switch(accessor.componentType){
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  indices_32[i] = *index;              break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: indices_32[i] = *(const u16*)index;  break;
+                default:                                     indices_32[i] = *(const u32*)index;  break;
+            }
+        }
+    }
+
+    vertex_count         = weld_vertices((u8*)vertices, vertex_count, sizeof(Package_Vertex), indices_32.data(), index_count, jobs->weld_tolerance);
+    *welded_vertex_count = vertex_count;
+
+    Mesh_Optimize_Stats optimize_stats = {};
+    Meshlet_Counts meshlet_counts = {};
+    Cook_Primitive_Lods primitive_lods = {};
+    primitive_lods.lod_count = 1;
+    primitive_lods.lods[0]   = {0, index_count, 0.f};
+
+    if(vertex_count > PACKAGE_U16_VERTEX_MAX){
+
+        // Only meshes laid out with u32 indices can end up here, welding never adds vertices
+        if(primitive_topology(primitive.mode) == PACKAGE_TOPOLOGY_TRIANGLE_LIST && !has_tangents){
+            generate_tangents((u8*)vertices, vertex_count, sizeof(Package_Vertex), offsetof(Package_Vertex, normal), offsetof(Package_Vertex, texture_coordinates),
+                offsetof(Package_Vertex, tangent), indices_32.data(), index_count);
+        }
+
+        memcpy(indices, indices_32.data(), (u64)index_count * sizeof(u32));
+        mesh_bounds_compute((const u8*)vertices, sizeof(Package_Vertex), vertex_count, &primitive_lods.bounds);
+        meshlets->primitives.push_back(meshlet_counts);
+        lods->primitives.push_back(primitive_lods);
+        return optimize_stats;
+
+    }
+
+    // Narrowed in place when the mesh is u16, otherwise into a copy that's widened back at the end
+    std::vector<u16> indices_16(index_size == sizeof(u16) ? 0 : index_count);
+    u16* indices_u16 = index_size == sizeof(u16) ? (u16*)indices : indices_16.data();
+    for(u32 i = 0; i < index_count; i++){
+        indices_u16[i] = (u16)indices_32[i];
+    }
+
+    if(primitive_topology(primitive.mode) == PACKAGE_TOPOLOGY_TRIANGLE_LIST){
+
+        if(!has_tangents){
+            generate_tangents((u8*)vertices, vertex_count, sizeof(Package_Vertex), offsetof(Package_Vertex, normal), offsetof(Package_Vertex, texture_coordinates),
+                offsetof(Package_Vertex, tangent), indices_u16, index_count);
+        }
+
+        optimize_stats = optimize_mesh((u8*)vertices, vertex_count, sizeof(Package_Vertex), indices_u16, index_count);
+
+        Meshlet_Counts bound = meshlet_counts_bound(index_count);
+        u64 meshlet_start  = meshlets->meshlets.size();
+        u64 vertex_start   = meshlets->vertices.size();
+        u64 triangle_start = meshlets->triangles.size();
+        meshlets->meshlets.resize(meshlet_start + bound.meshlet_count);
+        meshlets->vertices.resize(vertex_start + bound.vertex_count);
+        meshlets->triangles.resize(triangle_start + (u64)bound.triangle_count * 3);
+
+        meshlet_counts = build_meshlets(indices_u16, index_count, vertex_count, (const u8*)vertices, sizeof(Package_Vertex),
+            meshlets->meshlets.data() + meshlet_start, meshlets->vertices.data() + vertex_start, meshlets->triangles.data() + triangle_start);
+
+        meshlets->meshlets.resize(meshlet_start + meshlet_counts.meshlet_count);
+        meshlets->vertices.resize(vertex_start + meshlet_counts.vertex_count);
+        meshlets->triangles.resize(triangle_start + (u64)meshlet_counts.triangle_count * 3);
+
+    }
+
+    meshlets->primitives.push_back(meshlet_counts);
+
+    mesh_bounds_compute((const u8*)vertices, sizeof(Package_Vertex), vertex_count, &primitive_lods.bounds);
+
+    if(primitive_topology(primitive.mode) == PACKAGE_TOPOLOGY_TRIANGLE_LIST){
+
+        u64 simplify_start = os_now_ticks();
+        u64 lod_start      = lods->indices.size();
+        lods->indices.resize(lod_start + mesh_lod_indices_bound(index_count));
+
+        primitive_lods.lod_count = build_lod_chain((const u8*)vertices, vertex_count, sizeof(Package_Vertex), offsetof(Package_Vertex, normal), offsetof(Package_Vertex, texture_coordinates),
+            indices_u16, index_count, lods->indices.data() + lod_start, primitive_lods.lods, &primitive_lods.lod_index_count);
+
+        lods->indices.resize(lod_start + primitive_lods.lod_index_count);
+        lods->simplify_ms += os_ticks_to_ms((f64)(os_now_ticks() - simplify_start));
+
+    }
+
+    lods->primitives.push_back(primitive_lods);
+
+    if(index_size == sizeof(u32)){
+        for(u32 i = 0; i < index_count; i++){
+            ((u32*)indices)[i] = indices_u16[i];
+        }
+    }
+
+    return optimize_stats;
+
+}
+
+static void cache_key_add_accessor(Cache_Key* key, tg::Model& tg_model, const tg::Accessor& accessor){
+
+    u32 byte_stride = 0;
+    const u8* data  = accessor_data(tg_model, accessor, &byte_stride);
+
+    cache_key_add(key, accessor.componentType);
+    cache_key_add(key, accessor.type);
+    cache_key_add(key, (u64)accessor.count);
+    cache_key_add(key, byte_stride);
+
+    if(data && accessor.count > 0){
+        u64 element_size = (u64)tg::GetComponentSizeInBytes(accessor.componentType) * tg::GetNumComponentsInType(accessor.type);
+        cache_key_add(key, data, (u64)byte_stride * (accessor.count - 1) + element_size);
+    }
+
+}
+
+// Everything cook_primitive reads: each primitive's mode, and the layout and bytes of its indices and attributes
+static Cache_Key mesh_cache_key(tg::Model& tg_model, const tg::Mesh& tg_mesh, f32 weld_tolerance){
+
+    Cache_Key key = cache_key("mesh", COOK_MESH_VERSION);
+    cache_key_add(&key, PACKAGE_VERSION);
+    cache_key_add(&key, weld_tolerance);
+
+    for(const tg::Primitive& primitive : tg_mesh.primitives){
+
+        cache_key_add(&key, primitive.mode);
+        cache_key_add(&key, primitive.indices >= 0);
+        if(primitive.indices >= 0){
+            cache_key_add_accessor(&key, tg_model, tg_model.accessors[primitive.indices]);
+        }
+
+        for(const Attribute_Layout& layout : attribute_layouts){
+            auto attribute = primitive.attributes.find(layout.name);
+            cache_key_add(&key, attribute != primitive.attributes.end());
+            if(attribute != primitive.attributes.end()){
+                cache_key_add_accessor(&key, tg_model, tg_model.accessors[attribute->second]);
+            }
+        }
+
+    }
+
+    return key;
+
+}
+
+/*
+*   Cooks a mesh into the package. Its vertex blob is laid out for the vertices before welding, the welded
+*   primitives are moved down to the front of it and the mesh's and primitives' vertex counts and offsets
+*   in the package are updated, the rest of the blob is left zeroed. The index blob is laid out u32 when a
+*   primitive has more than PACKAGE_U16_VERTEX_MAX vertices before welding, and narrowed to u16 the same
+*   way when welding brings every primitive under.
+*/
+static void cook_mesh_job(void* data, u32 index){
+
+    Cook_Jobs* jobs = (Cook_Jobs*)data;
+    Package_Header* header = (Package_Header*)jobs->package;
+    Package_Mesh& mesh     = ((Package_Mesh*)(jobs->package + header->meshes_offset))[index];
+    Package_Primitive* primitives = (Package_Primitive*)(jobs->package + header->primitives_offset) + mesh.first_primitive;
+    Package_Vertex* vertices = (Package_Vertex*)(jobs->package + mesh.vertex_offset);
+    u8* indices              = jobs->package + mesh.index_offset;
+    Mesh_Optimize_Stats& mesh_stats = jobs->mesh_stats[index];
+    Mesh_Weld_Stats& weld_stats     = jobs->weld_stats[index];
+    Cook_Meshlets& meshlets         = jobs->meshlets[index];
+    Cook_Lods& lods                 = jobs->lods[index];
+
+    const tg::Mesh& tg_mesh = jobs->tg_model->meshes[index];
+
+    weld_stats.vertex_count = mesh.vertex_count;
+
+    Cache_Key key;
+    if(jobs->cache){
+
+        key = mesh_cache_key(*jobs->tg_model, tg_mesh, jobs->weld_tolerance);
+
+        Cache_Entry entry;
+        if(cache_get(jobs->cache, key, &entry)){
+
+            // Fixed size part, then the vertex, meshlet and LOD blobs whose sizes the per primitive counts give.
+            // A u16 entry fits a mesh laid out u32, welding the same vertices gives the same index size
+            u64 vertex_counts_size  = (u64)mesh.primitive_count * sizeof(u32);
+            u32 index_size          = entry.size >= vertex_counts_size + sizeof(u32) ? *(const u32*)(entry.data + vertex_counts_size) : 0;
+            u64 indices_size        = (u64)mesh.index_count * index_size;
+            u64 counts_size         = (u64)mesh.primitive_count * sizeof(Meshlet_Counts);
+            u64 primitive_lods_size = (u64)mesh.primitive_count * sizeof(Cook_Primitive_Lods);
+            u64 fixed_size          = vertex_counts_size + sizeof(u32) + indices_size + sizeof(Mesh_Optimize_Stats) + counts_size + primitive_lods_size;
+            bool valid              = (index_size == sizeof(u16) || index_size == mesh.index_size) && entry.size >= fixed_size;
+
+            Meshlet_Counts total = {};
+            u64 vertex_count     = 0;
+            u64 lod_index_count  = 0;
+            if(valid){
+                const u32* vertex_counts = (const u32*)entry.data;
+                const Meshlet_Counts* counts = (const Meshlet_Counts*)(entry.data + vertex_counts_size + sizeof(u32) + indices_size + sizeof(Mesh_Optimize_Stats));
+                const Cook_Primitive_Lods* primitive_lods = (const Cook_Primitive_Lods*)((const u8*)counts + counts_size);
+                for(u32 i = 0; i < mesh.primitive_count; i++){
+                    vertex_count         += d_min(vertex_counts[i], primitives[i].vertex_count);
+                    valid                &= vertex_counts[i] <= primitives[i].vertex_count && (vertex_counts[i] <= PACKAGE_U16_VERTEX_MAX || index_size == sizeof(u32));
+                    total.meshlet_count  += counts[i].meshlet_count;
+                    total.vertex_count   += counts[i].vertex_count;
+                    total.triangle_count += counts[i].triangle_count;
+                    lod_index_count      += primitive_lods[i].lod_index_count;
+                }
+                valid &= entry.size == fixed_size + vertex_count * sizeof(Package_Vertex) + (u64)total.meshlet_count * sizeof(Meshlet) +
+                                       (u64)total.vertex_count * sizeof(u16) + (u64)total.triangle_count * 3 + lod_index_count * sizeof(u16);
+            }
+
+            if(valid){
+                const u8* data = entry.data;
+                const u32* vertex_counts = (const u32*)data;                  data += vertex_counts_size;
+                u32 vertex_offset = 0;
+                for(u32 i = 0; i < mesh.primitive_count; i++){
+                    primitives[i].vertex_offset = vertex_offset;
+                    primitives[i].vertex_count  = vertex_counts[i];
+                    vertex_offset              += vertex_counts[i];
+                }
+                mesh.vertex_count = vertex_offset;
+                weld_stats.welded_vertex_count = vertex_offset;
+                mesh.index_size = index_size;                                 data += sizeof(u32);
+                memcpy(indices, data, indices_size);                          data += indices_size;
+                memcpy(&mesh_stats, data, sizeof(Mesh_Optimize_Stats));       data += sizeof(Mesh_Optimize_Stats);
+                meshlets.primitives.assign((const Meshlet_Counts*)data, (const Meshlet_Counts*)data + mesh.primitive_count); data += counts_size;
+                lods.primitives.assign((const Cook_Primitive_Lods*)data, (const Cook_Primitive_Lods*)data + mesh.primitive_count); data += primitive_lods_size;
+                memcpy(vertices, data, vertex_count * sizeof(Package_Vertex));                                             data += vertex_count * sizeof(Package_Vertex);
+                meshlets.meshlets.assign((const Meshlet*)data, (const Meshlet*)data + total.meshlet_count);                 data += (u64)total.meshlet_count * sizeof(Meshlet);
+                meshlets.vertices.assign((const u16*)data, (const u16*)data + total.vertex_count);                         data += (u64)total.vertex_count * sizeof(u16);
+                meshlets.triangles.assign(data, data + (u64)total.triangle_count * 3);                                     data += (u64)total.triangle_count * 3;
+                lods.indices.assign((const u16*)data, (const u16*)data + lod_index_count);
+                atomic_add_u32(&jobs->meshes_cached, 1);
+            }
+            cache_release(&entry);
+            if(valid){
+                return;
+            }
+        }
+
+    }
+
+    // Each primitive is cooked where the layout put it and welded down to the end of the previous one.
+    // Later primitives start past where this one was, so moving it down never overwrites them.
+    // u32 indices are cooked on the side, until it's known whether they stay u32
+    std::vector<u32> vertex_counts(mesh.primitive_count);
+    std::vector<u32> indices_32(mesh.index_size == sizeof(u32) ? mesh.index_count : 0);
+    bool wide_indices = false;
+    u32 vertex_offset = 0;
+    for(u32 i = 0; i < mesh.primitive_count; i++){
+        Package_Primitive& primitive = primitives[i];
+        void* primitive_indices = mesh.index_size == sizeof(u32) ? (void*)(indices_32.data() + primitive.index_offset) : (void*)((u16*)indices + primitive.index_offset);
+        Mesh_Optimize_Stats primitive_stats = cook_primitive(jobs, tg_mesh.primitives[i], vertices + primitive.vertex_offset, primitive.vertex_count, primitive_indices, mesh.index_size, primitive.index_count,
+            &meshlets, &lods, &vertex_counts[i]);
+        wide_indices |= vertex_counts[i] > PACKAGE_U16_VERTEX_MAX;
+        mesh_optimize_stats_add(&mesh_stats, primitive_stats);
+
+        memmove(vertices + vertex_offset, vertices + primitive.vertex_offset, (u64)vertex_counts[i] * sizeof(Package_Vertex));
+        primitive.vertex_offset = vertex_offset;
+        primitive.vertex_count  = vertex_counts[i];
+        vertex_offset          += vertex_counts[i];
+    }
+    memset(vertices + vertex_offset, 0, (u64)(mesh.vertex_count - vertex_offset) * sizeof(Package_Vertex));
+    mesh.vertex_count = vertex_offset;
+    weld_stats.welded_vertex_count = vertex_offset;
+
+    if(mesh.index_size == sizeof(u32)){
+        if(wide_indices){
+            memcpy(indices, indices_32.data(), (u64)mesh.index_count * sizeof(u32));
+        } else {
+            mesh.index_size = sizeof(u16);
+            for(u32 i = 0; i < mesh.index_count; i++){
+                ((u16*)indices)[i] = (u16)indices_32[i];
+            }
+        }
+    }
+
+    // The stats ride along so cached meshes still show up in the report
+    if(jobs->cache){
+        Cache_Blob blobs[] = {
+            {vertex_counts.data(),       vertex_counts.size()       * sizeof(u32)},
+            {&mesh.index_size,           sizeof(u32)},
+            {indices,                    (u64)mesh.index_count      * mesh.index_size},
+            {&mesh_stats, sizeof(Mesh_Optimize_Stats)},
+            {meshlets.primitives.data(), meshlets.primitives.size() * sizeof(Meshlet_Counts)},
+            {lods.primitives.data(),     lods.primitives.size()     * sizeof(Cook_Primitive_Lods)},
+            {vertices,                   (u64)mesh.vertex_count     * sizeof(Package_Vertex)},
+            {meshlets.meshlets.data(),   meshlets.meshlets.size()   * sizeof(Meshlet)},
+            {meshlets.vertices.data(),   meshlets.vertices.size()   * sizeof(u16)},
+            {meshlets.triangles.data(),  meshlets.triangles.size()},
+            {lods.indices.data(),        lods.indices.size()        * sizeof(u16)},
+        };
+        cache_put(jobs->cache, key, blobs, sizeof(blobs) / sizeof(blobs[0]));
+    }
+
+}
+
+// 2x2 box filter, edge texels are repeated when a dimension is odd
+template <typename T>
+static void downsample(const T* source, u32 source_width, u32 source_height, T* destination, u32 width, u32 height){
+
+    for(u32 y = 0; y < height; y++){
+
+        const T* row_0 = source + (u64)d_min(y * 2,     source_height - 1) * source_width * 4;
+        const T* row_1 = source + (u64)d_min(y * 2 + 1, source_height - 1) * source_width * 4;
+
+        for(u32 x = 0; x < width; x++){
+            u32 x_0 = d_min(x * 2,     source_width - 1) * 4;
+            u32 x_1 = d_min(x * 2 + 1, source_width - 1) * 4;
+            for(u32 channel = 0; channel < 4; channel++){
+                u32 sum = (u32)row_0[x_0 + channel] + row_0[x_1 + channel] + row_1[x_0 + channel] + row_1[x_1 + channel];
+                destination[((u64)y * width + x) * 4 + channel] = (T)((sum + 2) / 4);
+            }
+        }
+
+    }
+
+}
+
+static void cook_texture_job(void* data, u32 index){
+
+    Cook_Jobs* jobs = (Cook_Jobs*)data;
+    Package_Header* header   = (Package_Header*)jobs->package;
+    Package_Texture& texture = ((Package_Texture*)(jobs->package + header->textures_offset))[index];
+    Cook_Image& image        = jobs->images[jobs->texture_images[index]];
+
+    u32 bytes_per_pixel = package_format_bytes_per_pixel(texture.format);
+    u8* mip             = jobs->package + texture.data_offset;
+    u32 width           = texture.width;
+    u32 height          = texture.height;
+
+    if(image.cache_entry.data){
+        memcpy(mip, image.cache_entry.data + sizeof(Cached_Texture_Header), texture.data_size);
+        cache_release(&image.cache_entry);
+        return;
+    }
+
+    memcpy(mip, image.pixels, (u64)width * height * bytes_per_pixel);
+
+    for(u32 level = 1; level < texture.mip_count; level++){
+
+        u8* next_mip    = mip + (u64)width * height * bytes_per_pixel;
+        u32 next_width  = width  > 1 ? width  / 2 : 1;
+        u32 next_height = height > 1 ? height / 2 : 1;
+
+        if(image.is_16_bit){
+            downsample((const u16*)mip, width, height, (u16*)next_mip, next_width, next_height);
+        } else {
+            downsample((const u8*)mip, width, height, next_mip, next_width, next_height);
+        }
+
+        mip    = next_mip;
+        width  = next_width;
+        height = next_height;
+
+    }
+
+    if(jobs->cache && !image.decode_failed){
+        Cached_Texture_Header cached = {texture.width, texture.height, texture.format, texture.mip_count};
+        Cache_Blob blobs[] = {{&cached, sizeof(Cached_Texture_Header)}, {jobs->package + texture.data_offset, texture.data_size}};
+        cache_put(jobs->cache, image.cache_key, blobs, 2);
+    }
+
+}
+
+static u64 align_blob(u64 offset){
+    return AlignPow2Up(offset, PACKAGE_BLOB_ALIGNMENT);
+}
+
+// Flattens the default scene's nodes like load_gltf_model does, a model without nodes gets one per mesh
+static void cook_scene(tg::Model& tg_model, Scene* scene){
+
+    u32 node_count = (u32)tg_model.nodes.size();
+    if(node_count == 0){
+        scene_one_node_per_mesh(scene, (u32)tg_model.meshes.size());
+        return;
+    }
+
+    std::vector<u32> child_offsets(node_count + 1, 0);
+    std::vector<u32> children;
+    std::vector<u8>  is_child(node_count, 0);
+    for(u32 i = 0; i < node_count; i++){
+        for(int child : tg_model.nodes[i].children){
+            children.push_back((u32)child);
+            if((u32)child < node_count){
+                is_child[child] = 1;
+            }
+        }
+        child_offsets[i + 1] = (u32)children.size();
+    }
+
+    std::vector<u32> roots;
+    if(!tg_model.scenes.empty()){
+        const tg::Scene& tg_scene = tg_model.scenes[tg_model.defaultScene >= 0 && tg_model.defaultScene < (int)tg_model.scenes.size() ? tg_model.defaultScene : 0];
+        for(int root : tg_scene.nodes){
+            roots.push_back((u32)root);
+        }
+    } else {
+        for(u32 i = 0; i < node_count; i++){
+            if(!is_child[i]){
+                roots.push_back(i);
+            }
+        }
+    }
+
+    std::vector<u32> source_nodes(node_count);
+    scene_flatten(scene, node_count, child_offsets.data(), children.data(), roots.data(), (u32)roots.size(), source_nodes.data());
+
+    for(u32 i = 0; i < scene->node_count; i++){
+
+        const tg::Node& tg_node = tg_model.nodes[source_nodes[i]];
+        if(tg_node.mesh >= 0 && tg_node.mesh < (int)tg_model.meshes.size()){
+            scene->mesh_indices.ptr[i] = (u32)tg_node.mesh;
+        }
+
+        f32 matrix[16];
+        if(tg_node.matrix.size() == 16){
+            for(u32 j = 0; j < 16; j++){
+                matrix[j] = (f32)tg_node.matrix[j];
+            }
+        } else {
+            scene_trs_matrix(tg_node.translation.size() == 3 ? tg_node.translation.data() : NULL,
+                             tg_node.rotation.size()    == 4 ? tg_node.rotation.data()    : NULL,
+                             tg_node.scale.size()       == 3 ? tg_node.scale.data()       : NULL, matrix);
+        }
+        scene_flip_z(matrix);
+        scene_set_local_matrix(scene, i, matrix);
+
+    }
+
+    scene_build_instances(scene, (u32)tg_model.meshes.size());
+
+}
+
+/*
+*   Builds the whole package in memory. Images are decoded and meshes and mip chains are built
+*   on the job system, each straight into its place in the package. With a cache, meshes and
+*   mip chains whose inputs haven't changed are copied from it instead. weld_tolerance is weld_vertices' tolerance.
+*/
+static bool cook(const char* filename, Derived_Data_Cache* cache, Cooked_Package* package, Cook_Stats* stats, f32 weld_tolerance){
+
+    u64 start_time = os_now_ticks();
+
+    tg::Model tg_model;
+    if(!load_gltf(filename, &tg_model)){
+        return false;
+    }
+
+    std::string base_dir = filename;
+    base_dir = base_dir.substr(0, base_dir.find_last_of("/\\") + 1);
+
+    u64 parse_end_time = os_now_ticks();
+
+    ///////////////////////////////
+    // Images used by the materials
+    ///////////////////////////////
+
+    u32 image_count = (u32)tg_model.images.size();
+    Cook_Image* images  = (Cook_Image*)calloc(d_max(image_count, 1u), sizeof(Cook_Image));
+    u32* texture_images = (u32*)calloc(d_max(image_count, 1u), sizeof(u32));
+    u32 texture_count   = 0;
+
+    for(u32 i = 0; i < image_count; i++){
+        images[i].texture_index = PACKAGE_NO_TEXTURE;
+    }
+
+    for(const tg::Material& tg_material : tg_model.materials){
+        s32 slot_images[] = {
+            texture_image_index(tg_model, tg_material.pbrMetallicRoughness.baseColorTexture.index),
+            texture_image_index(tg_model, tg_material.normalTexture.index),
+            texture_image_index(tg_model, tg_material.pbrMetallicRoughness.metallicRoughnessTexture.index),
+        };
+        for(u32 slot = 0; slot < 3; slot++){
+            if(slot_images[slot] >= 0 && images[slot_images[slot]].texture_index == PACKAGE_NO_TEXTURE){
+                images[slot_images[slot]].texture_index = texture_count;
+                texture_images[texture_count++] = slot_images[slot];
+            }
+        }
+    }
+
+    stats->mesh_optimize.assign(tg_model.meshes.size(), Mesh_Optimize_Stats{});
+    stats->mesh_weld.assign(tg_model.meshes.size(), Mesh_Weld_Stats{});
+    stats->mesh_names.clear();
+    for(const tg::Mesh& tg_mesh : tg_model.meshes){
+        stats->mesh_names.push_back(tg_mesh.name);
+    }
+
+    std::vector<Cook_Meshlets> meshlets(tg_model.meshes.size());
+    std::vector<Cook_Lods>     lods(tg_model.meshes.size());
+
+    Cook_Jobs jobs = {&tg_model, &base_dir, images, texture_images, NULL, cache, stats->mesh_optimize.data(), stats->mesh_weld.data(), meshlets.data(), lods.data(), weld_tolerance, 0};
+
+    Job_Counter counter;
+    jobs_dispatch(prepare_texture_job, &jobs, texture_count, &counter);
+    jobs_wait(&counter);
+
+    // Exporters write the same image under several names. Images with the same encoded bytes become one
+    // texture so it's stored, uploaded and bound once. Linear search, packages have at most a few hundred textures
+    u32 unique_texture_count = 0;
+    for(u32 i = 0; i < texture_count; i++){
+
+        Cook_Image& image = images[texture_images[i]];
+        u32 duplicate_of  = PACKAGE_NO_TEXTURE;
+
+        for(u32 j = 0; j < unique_texture_count && image.encoded_size > 0; j++){
+            const Cook_Image& other = images[texture_images[j]];
+            if(other.encoded_size == image.encoded_size && other.encoded_hash.low == image.encoded_hash.low && other.encoded_hash.high == image.encoded_hash.high){
+                duplicate_of = j;
+                break;
+            }
+        }
+
+        if(duplicate_of != PACKAGE_NO_TEXTURE){
+            free(image.pixels);
+            image.pixels = NULL;
+            cache_release(&image.cache_entry);
+            image.texture_index = duplicate_of;
+            stats->textures_deduplicated++;
+            continue;
+        }
+
+        image.texture_index = unique_texture_count;
+        texture_images[unique_texture_count++] = texture_images[i];
+
+    }
+    texture_count = unique_texture_count;
+
+    u64 decode_end_time = os_now_ticks();
+
+    ///////////////////////////////
+    // Layout
+    ///////////////////////////////
+
+    u32 mesh_count      = (u32)tg_model.meshes.size();
+    u32 primitive_count = 0;
+    for(const tg::Mesh& tg_mesh : tg_model.meshes){
+        primitive_count += (u32)tg_mesh.primitives.size();
+    }
+
+    // Primitives without a material, or with one that isn't in the file, get an untextured one after the glTF's
+    u32 gltf_material_count = (u32)tg_model.materials.size();
+    bool default_material   = false;
+    for(const tg::Mesh& tg_mesh : tg_model.meshes){
+        for(const tg::Primitive& tg_primitive : tg_mesh.primitives){
+            default_material |= tg_primitive.material < 0 || tg_primitive.material >= (int)gltf_material_count;
+        }
+    }
+
+    Scene scene = {};
+    cook_scene(tg_model, &scene);
+    stats->node_count     = scene.node_count;
+    stats->instance_count = (u32)scene.instance_nodes.nitems;
+
+    Package_Header header = {};
+    header.magic             = PACKAGE_MAGIC;
+    header.version           = PACKAGE_VERSION;
+    header.mesh_count        = mesh_count;
+    header.primitive_count   = primitive_count;
+    header.material_count    = gltf_material_count + default_material;
+    header.texture_count     = texture_count;
+    header.meshes_offset     = sizeof(Package_Header);
+    header.primitives_offset = header.meshes_offset     + (u64)mesh_count            * sizeof(Package_Mesh);
+    header.materials_offset  = header.primitives_offset + (u64)primitive_count       * sizeof(Package_Primitive);
+    header.textures_offset   = header.materials_offset  + (u64)header.material_count * sizeof(Package_Material);
+    header.node_count        = scene.node_count;
+    header.nodes_offset      = header.textures_offset   + (u64)texture_count         * sizeof(Package_Texture);
+
+    // Sizes first, the package is allocated once and every job writes straight into it
+    Package_Mesh*      meshes     = (Package_Mesh*)calloc(d_max(mesh_count, 1u), sizeof(Package_Mesh));
+    Package_Primitive* primitives = (Package_Primitive*)calloc(d_max(primitive_count, 1u), sizeof(Package_Primitive));
+    Package_Texture*   textures   = (Package_Texture*)calloc(d_max(texture_count, 1u), sizeof(Package_Texture));
+
+    u64 offset = header.nodes_offset + (u64)header.node_count * sizeof(Package_Node);
+    u32 primitive_index = 0;
+
+    for(u32 i = 0; i < mesh_count; i++){
+
+        const tg::Mesh& tg_mesh = tg_model.meshes[i];
+        Package_Mesh& mesh = meshes[i];
+        mesh.first_primitive = primitive_index;
+        mesh.primitive_count = (u32)tg_mesh.primitives.size();
+        bool wide_indices    = false;
+
+        for(const tg::Primitive& tg_primitive : tg_mesh.primitives){
+            Package_Primitive& primitive = primitives[primitive_index++];
+            primitive.topology       = primitive_topology(tg_primitive.mode);
+            primitive.material_index = tg_primitive.material >= 0 && tg_primitive.material < (int)gltf_material_count ? (u32)tg_primitive.material : gltf_material_count;
+            primitive.vertex_offset  = mesh.vertex_count;
+            primitive.vertex_count   = primitive_vertex_count(tg_model, tg_primitive);
+            primitive.index_offset   = mesh.index_count;
+            primitive.index_count    = primitive_index_count(tg_model, tg_primitive);
+            mesh.vertex_count       += primitive.vertex_count;
+            mesh.index_count        += primitive.index_count;
+            wide_indices            |= primitive.vertex_count > PACKAGE_U16_VERTEX_MAX;
+        }
+
+        // u32 if welding might not bring a primitive under, cook_mesh_job narrows it if it does
+        mesh.index_size    = wide_indices ? sizeof(u32) : sizeof(u16);
+        mesh.vertex_offset = align_blob(offset);
+        mesh.index_offset  = align_blob(mesh.vertex_offset + (u64)mesh.vertex_count * sizeof(Package_Vertex));
+        offset             = mesh.index_offset + (u64)mesh.index_count * mesh.index_size;
+
+        stats->index_count  += mesh.index_count;
+
+    }
+
+    for(u32 i = 0; i < texture_count; i++){
+
+        Cook_Image& image = images[texture_images[i]];
+        Package_Texture& texture = textures[i];
+
+        // Images that failed to decode become 1x1 white
+        if(image.pixels == NULL && image.cache_entry.data == NULL){
+            image.pixels = (u8*)malloc(4);
+            memset(image.pixels, 0xFF, 4);
+            image.width         = 1;
+            image.height        = 1;
+            image.is_16_bit     = false;
+            image.decode_failed = true;
+        }
+
+        stats->textures_cached += image.cache_entry.data != NULL;
+
+        texture.width       = image.width;
+        texture.height      = image.height;
+        texture.format      = image.is_16_bit ? PACKAGE_FORMAT_R16G16B16A16_UNORM : PACKAGE_FORMAT_R8G8B8A8_UNORM;
+        texture.mip_count   = package_mip_count(image.width, image.height);
+        texture.data_offset = align_blob(offset);
+        texture.data_size   = package_mip_chain_size(texture.width, texture.height, texture.mip_count, package_format_bytes_per_pixel(texture.format));
+        offset              = texture.data_offset + texture.data_size;
+
+    }
+
+    header.file_size = offset;
+
+    package->size = header.file_size;
+    package->data = (u8*)calloc(package->size, 1);
+    memcpy(package->data, &header, sizeof(Package_Header));
+    memcpy(package->data + header.meshes_offset,     meshes,     (u64)mesh_count      * sizeof(Package_Mesh));
+    memcpy(package->data + header.primitives_offset, primitives, (u64)primitive_count * sizeof(Package_Primitive));
+    memcpy(package->data + header.textures_offset,   textures,   (u64)texture_count   * sizeof(Package_Texture));
+
+    Package_Node* nodes = (Package_Node*)(package->data + header.nodes_offset);
+    for(u32 i = 0; i < scene.node_count; i++){
+        nodes[i].parent      = scene.parents.ptr[i];
+        nodes[i].subtree_end = scene.subtree_ends.ptr[i];
+        nodes[i].mesh_index  = scene.mesh_indices.ptr[i];
+        memcpy(nodes[i].local_matrix, scene.local_matrices.ptr[i].m, sizeof(nodes[i].local_matrix));
+    }
+
+    Package_Material* materials = (Package_Material*)(package->data + header.materials_offset);
+    for(u32 i = 0; i < gltf_material_count; i++){
+
+        const tg::Material& tg_material = tg_model.materials[i];
+        s32 albedo_image             = texture_image_index(tg_model, tg_material.pbrMetallicRoughness.baseColorTexture.index);
+        s32 normal_image             = texture_image_index(tg_model, tg_material.normalTexture.index);
+        s32 roughness_metallic_image = texture_image_index(tg_model, tg_material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+
+        materials[i].albedo_texture             = albedo_image             >= 0 ? images[albedo_image].texture_index             : PACKAGE_NO_TEXTURE;
+        materials[i].normal_texture             = normal_image             >= 0 ? images[normal_image].texture_index             : PACKAGE_NO_TEXTURE;
+        materials[i].roughness_metallic_texture = roughness_metallic_image >= 0 ? images[roughness_metallic_image].texture_index : PACKAGE_NO_TEXTURE;
+
+        if(materials[i].normal_texture != PACKAGE_NO_TEXTURE){
+            materials[i].material_flags |= PACKAGE_MATERIAL_FLAG_NORMAL_TEXTURE;
+        }
+        if(materials[i].roughness_metallic_texture != PACKAGE_NO_TEXTURE){
+            materials[i].material_flags |= PACKAGE_MATERIAL_FLAG_ROUGHNESSMETALLIC_TEXTURE;
+        }
+
+    }
+
+    // The loader gives a material without an albedo texture the white one
+    if(default_material){
+        materials[gltf_material_count].albedo_texture             = PACKAGE_NO_TEXTURE;
+        materials[gltf_material_count].normal_texture             = PACKAGE_NO_TEXTURE;
+        materials[gltf_material_count].roughness_metallic_texture = PACKAGE_NO_TEXTURE;
+    }
+
+    ///////////////////////////////
+    // Vertices, indices and mips
+    ///////////////////////////////
+
+    jobs.package = package->data;
+
+    Job_Counter mesh_counter;
+    Job_Counter texture_counter;
+    jobs_dispatch(cook_mesh_job,    &jobs, mesh_count,    &mesh_counter);
+    jobs_dispatch(cook_texture_job, &jobs, texture_count, &texture_counter);
+    jobs_wait(&mesh_counter);
+    jobs_wait(&texture_counter);
+
+    ///////////////////////////////
+    // Meshlets and LODs
+    ///////////////////////////////
+
+    // Their sizes are only known now, so they go after everything else
+    u64 meshlets_offset = offset;
+    for(u32 i = 0; i < mesh_count; i++){
+        const Cook_Meshlets& mesh_meshlets = meshlets[i];
+        meshes[i].meshlet_offset          = align_blob(offset);
+        meshes[i].meshlet_vertex_offset   = align_blob(meshes[i].meshlet_offset + mesh_meshlets.meshlets.size() * sizeof(Meshlet));
+        meshes[i].meshlet_triangle_offset = align_blob(meshes[i].meshlet_vertex_offset + mesh_meshlets.vertices.size() * sizeof(u16));
+        meshes[i].lod_index_offset        = align_blob(meshes[i].meshlet_triangle_offset + mesh_meshlets.triangles.size());
+        offset                            = meshes[i].lod_index_offset + lods[i].indices.size() * sizeof(u16);
+    }
+    offset = align_blob(offset);
+
+    package->size = offset;
+    package->data = (u8*)realloc(package->data, package->size);
+    memset(package->data + meshlets_offset, 0, package->size - meshlets_offset);
+    ((Package_Header*)package->data)->file_size = package->size;
+
+    Package_Mesh*      package_meshes     = (Package_Mesh*)(package->data + header.meshes_offset);
+    Package_Primitive* package_primitives = (Package_Primitive*)(package->data + header.primitives_offset);
+    std::vector<Mesh_Bounds> mesh_bounds(mesh_count);
+
+    for(u32 i = 0; i < mesh_count; i++){
+
+        const Cook_Meshlets& mesh_meshlets = meshlets[i];
+        Package_Mesh& mesh = package_meshes[i];
+
+        mesh.meshlet_count           = (u32)mesh_meshlets.meshlets.size();
+        mesh.meshlet_vertex_count    = (u32)mesh_meshlets.vertices.size();
+        mesh.meshlet_triangle_count  = (u32)(mesh_meshlets.triangles.size() / 3);
+        mesh.meshlet_offset          = meshes[i].meshlet_offset;
+        mesh.meshlet_vertex_offset   = meshes[i].meshlet_vertex_offset;
+        mesh.meshlet_triangle_offset = meshes[i].meshlet_triangle_offset;
+
+        memcpy(package->data + mesh.meshlet_offset,          mesh_meshlets.meshlets.data(),  mesh_meshlets.meshlets.size() * sizeof(Meshlet));
+        memcpy(package->data + mesh.meshlet_vertex_offset,   mesh_meshlets.vertices.data(),  mesh_meshlets.vertices.size() * sizeof(u16));
+        memcpy(package->data + mesh.meshlet_triangle_offset, mesh_meshlets.triangles.data(), mesh_meshlets.triangles.size());
+
+        mesh.lod_index_count  = (u32)lods[i].indices.size();
+        mesh.lod_index_offset = meshes[i].lod_index_offset;
+        if(!lods[i].indices.empty()){
+            memcpy(package->data + mesh.lod_index_offset, lods[i].indices.data(), lods[i].indices.size() * sizeof(u16));
+        }
+        stats->simplify_ms += lods[i].simplify_ms;
+
+        u32 lod_index_offset = 0;
+        mesh.bounds = mesh_bounds_empty();
+
+        Meshlet_Counts primitive_offset = {};
+        for(u32 j = 0; j < mesh.primitive_count; j++){
+            Package_Primitive& primitive = package_primitives[mesh.first_primitive + j];
+            const Meshlet_Counts& counts = mesh_meshlets.primitives[j];
+            primitive.meshlet_offset          = primitive_offset.meshlet_count;
+            primitive.meshlet_count           = counts.meshlet_count;
+            primitive.meshlet_vertex_offset   = primitive_offset.vertex_count;
+            primitive.meshlet_vertex_count    = counts.vertex_count;
+            primitive.meshlet_triangle_offset = primitive_offset.triangle_count;
+            primitive.meshlet_triangle_count  = counts.triangle_count;
+            primitive_offset.meshlet_count   += counts.meshlet_count;
+            primitive_offset.vertex_count    += counts.vertex_count;
+            primitive_offset.triangle_count  += counts.triangle_count;
+
+            const Cook_Primitive_Lods& primitive_lods = lods[i].primitives[j];
+            primitive.lod_index_offset = lod_index_offset;
+            primitive.lod_index_count  = primitive_lods.lod_index_count;
+            primitive.lod_count        = primitive_lods.lod_count;
+            memcpy(primitive.lods, primitive_lods.lods, sizeof(primitive.lods));
+            primitive.bounds           = primitive_lods.bounds;
+            lod_index_offset          += primitive_lods.lod_index_count;
+            mesh_bounds_merge(&mesh.bounds, primitive.bounds);
+
+            for(u32 lod = 0; lod < MESH_LOD_MAX; lod++){
+                stats->lod_triangle_count[lod] += primitive.lods[d_min(lod, primitive.lod_count - 1)].index_count / 3;
+            }
+        }
+
+        stats->vertex_count           += mesh.vertex_count;
+        stats->meshlet_count          += mesh.meshlet_count;
+        stats->meshlet_triangle_count += mesh.meshlet_triangle_count;
+        mesh_bounds[i] = mesh.bounds;
+
+    }
+
+    // The scene's bounds need the meshes', so the scene is kept until they're done
+    scene_update_world_matrices(&scene);
+    ((Package_Header*)package->data)->bounds = scene_instance_bounds(&scene, mesh_bounds.data());
+    scene_free(&scene);
+
+    for(u32 i = 0; i < image_count; i++){
+        free(images[i].pixels);
+    }
+    free(images);
+    free(texture_images);
+    free(meshes);
+    free(primitives);
+    free(textures);
+
+    u64 end_time = os_now_ticks();
+
+    stats->parse_ms      = os_ticks_to_ms((f64)(parse_end_time - start_time));
+    stats->decode_ms     = os_ticks_to_ms((f64)(decode_end_time - parse_end_time));
+    stats->build_ms      = os_ticks_to_ms((f64)(end_time - decode_end_time));
+    stats->texture_count = texture_count;
+    stats->meshes_cached = jobs.meshes_cached;
+
+    return true;
+
+}
+
+static bool write_package(const char* filename, Cooked_Package* package){
+
+    FILE* file = fopen(filename, "wb");
+    if(file == NULL){
+        printf("Error: couldn't open %s for writing\n", filename);
+        return false;
+    }
+
+    bool written = fwrite(package->data, 1, package->size, file) == package->size;
+    written = fclose(file) == 0 && written;
+
+    if(!written){
+        printf("Error: couldn't write %s\n", filename);
+    }
+
+    return written;
+
+}
+
+// The .gltf and every file it references, for evicting them between cold runs
+static void gltf_files(const char* filename, std::vector<std::string>* files){
+
+    files->push_back(filename);
+
+    tg::Model tg_model;
+    if(!load_gltf(filename, &tg_model)){
+        return;
+    }
+
+    std::string base_dir = filename;
+    base_dir = base_dir.substr(0, base_dir.find_last_of("/\\") + 1);
+
+    for(const tg::Buffer& buffer : tg_model.buffers){
+        if(!buffer.uri.empty() && !tg::IsDataURI(buffer.uri)){
+            files->push_back(base_dir + buffer.uri);
+        }
+    }
+    for(const tg::Image& image : tg_model.images){
+        if(!image.uri.empty() && !tg::IsDataURI(image.uri)){
+            files->push_back(base_dir + image.uri);
+        }
+    }
+
+}
+
+// What load_package_model does before the upload: map, validate, then the copy into the upload heap
+static f64 load_package(const char* filename, u8* upload_copy, bool* valid){
+
+    u64 start_time = os_now_ticks();
+
+    Mapped_File package_file;
+    *valid = os_map_file(filename, &package_file, MAP_ACCESS_SEQUENTIAL) && package_validate(package_file.data, package_file.size) == NULL;
+
+    if(*valid){
+        memcpy(upload_copy, package_file.data, package_file.size);
+    }
+
+    os_unmap_file(&package_file);
+
+    return os_ticks_to_ms((f64)(os_now_ticks() - start_time));
+
+}
+
+static int bench(const char* gltf_filename, const char* package_filename, u32 runs){
+
+    std::vector<std::string> files;
+    gltf_files(gltf_filename, &files);
+
+    Mapped_File package_file;
+    if(!os_map_file(package_filename, &package_file) || package_validate(package_file.data, package_file.size) != NULL){
+        printf("Error: %s isn't a valid package, cook it first\n", package_filename);
+        return 1;
+    }
+    u64 package_size = package_file.size;
+    os_unmap_file(&package_file);
+
+    u8* upload_copy = (u8*)malloc(package_size);
+
+    printf("%s vs %s (%.2f MB), %u workers, best of %u runs\n\n", gltf_filename, package_filename,
+        (f64)package_size / (1024. * 1024.), jobs_worker_count(), runs);
+    printf("%-8s %-8s %10s %10s %10s %10s %10s\n", "cache", "source", "ms", "parse", "decode", "build", "speedup");
+
+    for(u32 pass = 0; pass < 2; pass++){
+
+        bool cold = pass == 0;
+        const char* cache = cold ? "cold" : "warm";
+        f64 best_gltf_ms    = 1e30;
+        f64 best_package_ms = 1e30;
+        Cook_Stats best_stats = {};
+
+        for(u32 run = 0; run < runs; run++){
+
+            if(cold){
+                for(std::string& file : files){
+                    os_evict_file_cache(file.c_str());
+                }
+            }
+
+            Cooked_Package package = {};
+            Cook_Stats stats = {};
+            u64 start_time = os_now_ticks();
+            bool cooked    = cook(gltf_filename, NULL, &package, &stats, 0.f);
+            f64 gltf_ms    = os_ticks_to_ms((f64)(os_now_ticks() - start_time));
+            free(package.data);
+
+            if(!cooked){
+                free(upload_copy);
+                return 1;
+            }
+
+            if(gltf_ms < best_gltf_ms){
+                best_gltf_ms = gltf_ms;
+                best_stats   = stats;
+            }
+
+            if(cold){
+                os_evict_file_cache(package_filename);
+            }
+
+            bool valid;
+            f64 package_ms  = load_package(package_filename, upload_copy, &valid);
+            best_package_ms = d_min(best_package_ms, package_ms);
+
+        }
+
+        printf("%-8s %-8s %10.2f %10.2f %10.2f %10.2f\n", cache, "gltf", best_gltf_ms, best_stats.parse_ms, best_stats.decode_ms, best_stats.build_ms);
+        printf("%-8s %-8s %10.2f %10s %10s %10s %9.1fx\n", cache, "package", best_package_ms, "-", "-", "-", best_gltf_ms / best_package_ms);
+
+    }
+
+    free(upload_copy);
+
+    return 0;
+
+}
+
+/////////////////////////////////
+// Camera paths, for the cull and LOD reports
+/////////////////////////////////
+
+// Row major, clip = position * matrix, the same matrices DirectX::XMMatrixLookToRH / XMMatrixPerspectiveFovRH make
+static void look_to_rh(const f32* eye, const f32* direction, const f32* up, f32* matrix){
+
+    f32 forward[3] = {-direction[0], -direction[1], -direction[2]};
+    meshlet_normalize(forward);
+    f32 right[3] = {up[1] * forward[2] - up[2] * forward[1], up[2] * forward[0] - up[0] * forward[2], up[0] * forward[1] - up[1] * forward[0]};
+    meshlet_normalize(right);
+    f32 camera_up[3] = {forward[1] * right[2] - forward[2] * right[1], forward[2] * right[0] - forward[0] * right[2], forward[0] * right[1] - forward[1] * right[0]};
+
+    const f32* axes[3] = {right, camera_up, forward};
+    for(u32 column = 0; column < 3; column++){
+        for(u32 row = 0; row < 3; row++){
+            matrix[row * 4 + column] = axes[column][row];
+        }
+        matrix[3 * 4 + column] = -meshlet_dot(axes[column], eye);
+        matrix[column * 4 + 3] = 0.f;
+    }
+    matrix[15] = 1.f;
+
+}
+
+static void perspective_fov_rh(f32 fov_y, f32 aspect, f32 near_z, f32 far_z, f32* matrix){
+
+    f32 height = 1.f / tanf(fov_y * 0.5f);
+    f32 range  = far_z / (near_z - far_z);
+
+    memset(matrix, 0, 16 * sizeof(f32));
+    matrix[0]  = height / aspect;
+    matrix[5]  = height;
+    matrix[10] = range;
+    matrix[11] = -1.f;
+    matrix[14] = range * near_z;
+
+}
+
+static void multiply_matrix(const f32* a, const f32* b, f32* result){
+    for(u32 row = 0; row < 4; row++){
+        for(u32 column = 0; column < 4; column++){
+            result[row * 4 + column] = a[row * 4 + 0] * b[0 * 4 + column] + a[row * 4 + 1] * b[1 * 4 + column] +
+                                       a[row * 4 + 2] * b[2 * 4 + column] + a[row * 4 + 3] * b[3 * 4 + column];
+        }
+    }
+}
+
+enum Camera_Path {
+    CAMERA_PATH_WALK,       // Along the long axis of the bounds at head height, swaying left and right
+    CAMERA_PATH_WALK_BACK,  // The same, the other way
+    CAMERA_PATH_TURN,       // Standing in the middle, turning around once
+    CAMERA_PATH_ORBIT,      // Outside the bounds looking in, going around once
+    CAMERA_PATH_COUNT,
+};
+
+static const char* camera_path_names[CAMERA_PATH_COUNT] = {"walk", "walk back", "turn", "orbit"};
+
+static void camera_path(u32 path, f32 t, const f32* bounds_min, const f32* bounds_max, f32* eye, f32* direction){
+
+    f32 center[3] = {(bounds_min[0] + bounds_max[0]) * 0.5f, (bounds_min[1] + bounds_max[1]) * 0.5f, (bounds_min[2] + bounds_max[2]) * 0.5f};
+    f32 extent[3] = {bounds_max[0] - bounds_min[0], bounds_max[1] - bounds_min[1], bounds_max[2] - bounds_min[2]};
+
+    // Y is up, walk along the longer of x and z
+    u32 long_axis  = extent[0] >= extent[2] ? 0 : 2;
+    u32 short_axis = 2 - long_axis;
+    f32 head_height = bounds_min[1] + extent[1] * 0.15f;
+    f32 two_pi      = 6.2831853f;
+
+    eye[0] = center[0]; eye[1] = head_height; eye[2] = center[2];
+    direction[0] = 0.f; direction[1] = 0.f; direction[2] = 0.f;
+
+    switch(path){
+        case CAMERA_PATH_WALK:
+        case CAMERA_PATH_WALK_BACK: {
+            f32 forward = path == CAMERA_PATH_WALK ? 1.f : -1.f;
+            f32 sway    = sinf(t * two_pi * 2.f) * 0.5f;
+            eye[long_axis]        = center[long_axis] + forward * (t - 0.5f) * extent[long_axis] * 0.8f;
+            direction[long_axis]  = forward * cosf(sway);
+            direction[short_axis] = sinf(sway);
+        } break;
+        case CAMERA_PATH_TURN: {
+            direction[0] = cosf(t * two_pi);
+            direction[2] = sinf(t * two_pi);
+        } break;
+        case CAMERA_PATH_ORBIT: {
+            f32 distance = sqrtf(meshlet_dot(extent, extent)) * 0.75f;
+            eye[0] = center[0] + cosf(t * two_pi) * distance;
+            eye[1] = center[1] + extent[1] * 0.25f;
+            eye[2] = center[2] + sinf(t * two_pi) * distance;
+            for(u32 axis = 0; axis < 3; axis++){
+                direction[axis] = center[axis] - eye[axis];
+            }
+        } break;
+    }
+
+}
+
+/*
+*   Culls every meshlet in the package from frames cameras along each path, with the renderer's
+*   projection, and prints the share of the triangles each test rejects
+*/
+static int cull_report(const char* package_filename, u32 frames){
+
+    Mapped_File package_file;
+    const char* error = NULL;
+    if(!os_map_file(package_filename, &package_file) || (error = package_validate(package_file.data, package_file.size)) != NULL){
+        printf("Error: %s isn't a valid package%s%s\n", package_filename, error ? ", " : "", error ? error : "");
+        return 1;
+    }
+
+    const u8* package = package_file.data;
+    const Package_Header*    header     = (const Package_Header*)package;
+    const Package_Mesh*      meshes     = (const Package_Mesh*)(package + header->meshes_offset);
+    const Package_Primitive* primitives = (const Package_Primitive*)(package + header->primitives_offset);
+
+    Scene scene = {};
+    package_load_scene(package, &scene);
+
+    // Bounds of every instance's meshlets, the model is drawn without the renderer's model matrix
+    f32 bounds_min[3] = { INFINITY,  INFINITY,  INFINITY};
+    f32 bounds_max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    u64 meshlet_count  = 0;
+    u64 triangle_count = 0;
+    u64 vertex_count   = 0;
+    for(u64 i = 0; i < scene.instance_nodes.nitems; i++){
+        const f32* world_matrix = scene.world_matrices.ptr[scene.instance_nodes.ptr[i]].m;
+        const Package_Mesh& mesh = meshes[scene.mesh_indices.ptr[scene.instance_nodes.ptr[i]]];
+        const Meshlet* meshlets = (const Meshlet*)(package + mesh.meshlet_offset);
+        f32 scale = scene_max_scale(world_matrix);
+        for(u32 j = 0; j < mesh.meshlet_count; j++){
+            f32 center[3];
+            scene_transform_point(world_matrix, meshlets[j].center, center);
+            for(u32 axis = 0; axis < 3; axis++){
+                bounds_min[axis] = d_min(bounds_min[axis], center[axis] - meshlets[j].radius * scale);
+                bounds_max[axis] = d_max(bounds_max[axis], center[axis] + meshlets[j].radius * scale);
+            }
+            triangle_count += meshlets[j].triangle_count;
+            vertex_count   += meshlets[j].vertex_count;
+        }
+        meshlet_count += mesh.meshlet_count;
+    }
+
+    if(meshlet_count == 0){
+        printf("%s has no meshlets\n", package_filename);
+        scene_free(&scene);
+        os_unmap_file(&package_file);
+        return 0;
+    }
+
+    printf("%s: %llu meshlets in %llu mesh instances, %llu triangles, %.1f triangles / %.1f vertices a meshlet\n", package_filename, meshlet_count,
+        (u64)scene.instance_nodes.nitems, triangle_count, (f64)triangle_count / meshlet_count, (f64)vertex_count / meshlet_count);
+
+    // Same projection as the renderer, 75 degrees at 16:9
+    f32 projection[16];
+    perspective_fov_rh(REPORT_FOV_DEGREES * 3.14159265f / 180.f, REPORT_ASPECT, 0.01f, 2500000000.f, projection);
+    f32 up[3] = {0.f, 1.f, 0.f};
+
+    printf("\n%-10s %8s %12s %10s %10s %10s\n", "path", "frames", "visible", "frustum", "cone", "culled");
+
+    for(u32 path = 0; path < CAMERA_PATH_COUNT; path++){
+
+        Meshlet_Cull_Stats path_stats = {};
+        u64 visible_meshlets = 0;
+
+        for(u32 frame = 0; frame < frames; frame++){
+
+            f32 eye[3], direction[3];
+            camera_path(path, (f32)frame / frames, bounds_min, bounds_max, eye, direction);
+
+            f32 view[16], view_projection[16];
+            look_to_rh(eye, direction, up, view);
+            multiply_matrix(view, projection, view_projection);
+
+            // Like cull_model_meshlets, the frustum and camera are taken into each instance's mesh space
+            for(u64 i = 0; i < scene.instance_nodes.nitems; i++){
+
+                u32 node = scene.instance_nodes.ptr[i];
+                const f32* world_matrix = scene.world_matrices.ptr[node].m;
+                f32 instance_view_projection[16], inverse_world[16], instance_eye[3];
+                if(!scene_invert_affine(world_matrix, inverse_world)){
+                    continue;
+                }
+                multiply_matrix(world_matrix, view_projection, instance_view_projection);
+                scene_transform_point(inverse_world, eye, instance_eye);
+
+                Meshlet_Frustum frustum;
+                meshlet_frustum_from_matrix(instance_view_projection, &frustum);
+
+                const Package_Mesh& mesh = meshes[scene.mesh_indices.ptr[node]];
+                const Meshlet* meshlets = (const Meshlet*)(package + mesh.meshlet_offset);
+                for(u32 j = 0; j < mesh.primitive_count; j++){
+                    const Package_Primitive& primitive = primitives[mesh.first_primitive + j];
+                    visible_meshlets += cull_meshlets(meshlets + primitive.meshlet_offset, primitive.meshlet_count, frustum, instance_eye, NULL, &path_stats);
+                }
+
+            }
+
+        }
+
+        printf("%-10s %8u %11.1f%% %9.1f%% %9.1f%% %9.1f%%\n", camera_path_names[path], frames,
+            100. * visible_meshlets / path_stats.meshlet_count,
+            100. * meshlet_culled_ratio(path_stats.frustum_culled_triangles, path_stats),
+            100. * meshlet_culled_ratio(path_stats.cone_culled_triangles, path_stats),
+            100. * meshlet_culled_ratio(path_stats.frustum_culled_triangles + path_stats.cone_culled_triangles, path_stats));
+
+    }
+
+    scene_free(&scene);
+    os_unmap_file(&package_file);
+
+    return 0;
+
+}
+
+/////////////////////////////////
+// LOD report
+/////////////////////////////////
+
+/*
+*   Selects every primitive's LOD for the camera and the shadow map along each camera path, the way
+*   bind_and_draw_model does, and prints the triangles drawn and the CPU time the selection took
+*/
+static int lod_report(const char* package_filename, u32 frames){
+
+    Mapped_File package_file;
+    const char* error = NULL;
+    if(!os_map_file(package_filename, &package_file) || (error = package_validate(package_file.data, package_file.size)) != NULL){
+        printf("Error: %s isn't a valid package%s%s\n", package_filename, error ? ", " : "", error ? error : "");
+        return 1;
+    }
+
+    const u8* package = package_file.data;
+    const Package_Header*    header     = (const Package_Header*)package;
+    const Package_Mesh*      meshes     = (const Package_Mesh*)(package + header->meshes_offset);
+    const Package_Primitive* primitives = (const Package_Primitive*)(package + header->primitives_offset);
+
+    Scene scene = {};
+    package_load_scene(package, &scene);
+
+    // Every triangle list of every instance, with its bounds taken through the instance's world matrix
+    struct Lod_Instance {
+        const Package_Primitive* primitive;
+        f32 center[3];
+        f32 radius;
+        f32 scale;
+    };
+    std::vector<Lod_Instance> lod_instances;
+
+    f32 bounds_min[3] = { INFINITY,  INFINITY,  INFINITY};
+    f32 bounds_max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    u64 full_triangle_count = 0;
+    u64 lod_counts[MESH_LOD_MAX] = {};
+    for(u64 i = 0; i < scene.instance_nodes.nitems; i++){
+        u32 node = scene.instance_nodes.ptr[i];
+        const f32* world_matrix = scene.world_matrices.ptr[node].m;
+        const Package_Mesh& mesh = meshes[scene.mesh_indices.ptr[node]];
+        for(u32 j = 0; j < mesh.primitive_count; j++){
+            const Package_Primitive& primitive = primitives[mesh.first_primitive + j];
+            if(primitive.topology != PACKAGE_TOPOLOGY_TRIANGLE_LIST){
+                continue;
+            }
+            Lod_Instance instance;
+            instance.primitive = &primitive;
+            instance.scale     = scene_max_scale(world_matrix);
+            instance.radius    = primitive.bounds.radius * instance.scale;
+            scene_transform_point(world_matrix, primitive.bounds.center, instance.center);
+            for(u32 axis = 0; axis < 3; axis++){
+                bounds_min[axis] = d_min(bounds_min[axis], instance.center[axis] - instance.radius);
+                bounds_max[axis] = d_max(bounds_max[axis], instance.center[axis] + instance.radius);
+            }
+            lod_instances.push_back(instance);
+            full_triangle_count += primitive.index_count / 3;
+            lod_counts[primitive.lod_count - 1]++;
+        }
+    }
+    scene_free(&scene);
+
+    if(full_triangle_count == 0){
+        printf("%s has no triangles\n", package_filename);
+        os_unmap_file(&package_file);
+        return 0;
+    }
+
+    printf("%s: %llu primitive instances, %llu triangles, primitive instances with 1 .. %u LODs:", package_filename, (u64)lod_instances.size(), full_triangle_count, MESH_LOD_MAX);
+    for(u32 lod = 0; lod < MESH_LOD_MAX; lod++){
+        printf(" %llu", lod_counts[lod]);
+    }
+    printf("\n");
+
+    // The bounds are in the scene's space, so the views are too. Perspective doesn't care about scale,
+    // but the shadow map's pixels per unit take the model scale
+    Mesh_Lod_View camera_view = {};
+    camera_view.pixel_scale     = REPORT_RENDER_HEIGHT / (2.f * tanf(REPORT_FOV_DEGREES * 3.14159265f / 360.f));
+    camera_view.orthographic    = false;
+    camera_view.max_pixel_error = MESH_LOD_DEFAULT_PIXEL_ERROR;
+
+    Mesh_Lod_View shadow_view = {};
+    shadow_view.pixel_scale     = REPORT_RENDER_HEIGHT / REPORT_SHADOW_EXTENT * REPORT_MODEL_SCALE;
+    shadow_view.orthographic    = true;
+    shadow_view.max_pixel_error = MESH_LOD_DEFAULT_PIXEL_ERROR;
+
+    printf("\n%-10s %8s %14s %14s %14s %16s\n", "path", "frames", "full", "camera", "shadow", "select us/frame");
+
+    for(u32 path = 0; path < CAMERA_PATH_COUNT; path++){
+
+        u64 camera_triangles = 0;
+        u64 shadow_triangles = 0;
+        u64 select_ticks     = 0;
+
+        for(u32 frame = 0; frame < frames; frame++){
+
+            f32 direction[3];
+            camera_path(path, (f32)frame / frames, bounds_min, bounds_max, camera_view.position, direction);
+
+            u64 start_time = os_now_ticks();
+
+            for(const Lod_Instance& instance : lod_instances){
+                const Package_Primitive& primitive = *instance.primitive;
+                u32 camera_lod = select_lod(primitive.lods, primitive.lod_count, instance.center, instance.radius, instance.scale, camera_view);
+                u32 shadow_lod = select_lod(primitive.lods, primitive.lod_count, instance.center, instance.radius, instance.scale, shadow_view);
+                camera_triangles += primitive.lods[camera_lod].index_count / 3;
+                shadow_triangles += primitive.lods[shadow_lod].index_count / 3;
+            }
+
+            select_ticks += os_now_ticks() - start_time;
+
+        }
+
+        printf("%-10s %8u %14llu %7llu %5.1f%% %7llu %5.1f%% %16.2f\n", camera_path_names[path], frames, full_triangle_count,
+            camera_triangles / frames, 100. * camera_triangles / frames / full_triangle_count,
+            shadow_triangles / frames, 100. * shadow_triangles / frames / full_triangle_count,
+            os_ticks_to_ms((f64)select_ticks) * 1000. / frames);
+
+    }
+
+    os_unmap_file(&package_file);
+
+    return 0;
+
+}
+
+/////////////////////////////////
+// Tangent benchmark
+/////////////////////////////////
+
+// Vertices along each side of a benchmark primitive, as many as u16 indices reach
+#define TANGENT_BENCH_GRID 256
+
+struct Tangent_Bench_Jobs {
+    std::vector<Package_Vertex>* primitives;
+    const u16* indices;
+    u32        index_count;
+};
+
+static void tangent_bench_job(void* data, u32 index){
+
+    Tangent_Bench_Jobs* jobs = (Tangent_Bench_Jobs*)data;
+    std::vector<Package_Vertex>& vertices = jobs->primitives[index];
+    generate_tangents((u8*)vertices.data(), (u32)vertices.size(), sizeof(Package_Vertex), offsetof(Package_Vertex, normal), offsetof(Package_Vertex, texture_coordinates),
+        offsetof(Package_Vertex, tangent), jobs->indices, jobs->index_count);
+
+}
+
+/*
+*   A rippled grid, height = sin(x + phase) * cos(y), with u along x and v along y so the exact tangent is known.
+*   Odd primitives have u mirrored, so their tangents point the other way and their handedness is -1
+*/
+static void tangent_bench_primitive(u32 primitive, Package_Vertex* vertices, f32* exact_tangents){
+
+    f32 phase  = (f32)primitive;
+    f32 mirror = primitive % 2 ? -1.f : 1.f;
+    f32 step   = 8.f / (TANGENT_BENCH_GRID - 1);
+
+    for(u32 y = 0; y < TANGENT_BENCH_GRID; y++){
+        for(u32 x = 0; x < TANGENT_BENCH_GRID; x++){
+
+            f32 px = x * step, py = y * step;
+            f32 height   = sinf(px + phase) * cosf(py);
+            f32 height_x = cosf(px + phase) * cosf(py);
+            f32 height_y = -sinf(px + phase) * sinf(py);
+
+            Package_Vertex& vertex = vertices[y * TANGENT_BENCH_GRID + x];
+            vertex = {};
+            vertex.position[0] = px; vertex.position[1] = py; vertex.position[2] = height;
+            f32 normal[3] = {-height_x, -height_y, 1.f};
+            meshlet_normalize(normal);
+            memcpy(vertex.normal, normal, sizeof(normal));
+            vertex.texture_coordinates[0] = mirror * px;
+            vertex.texture_coordinates[1] = py;
+
+            // d position / du, in the plane of the normal
+            f32* exact = exact_tangents + (y * TANGENT_BENCH_GRID + x) * 3;
+            f32 along_u[3] = {mirror, 0.f, mirror * height_x};
+            f32 along_normal = meshlet_dot(along_u, normal);
+            for(u32 i = 0; i < 3; i++){
+                exact[i] = along_u[i] - normal[i] * along_normal;
+            }
+            meshlet_normalize(exact);
+
+        }
+    }
+
+}
+
+/*
+*   Times generate_tangents on triangle_count triangles of synthetic primitives, one thread against a job per
+*   primitive like the loaders run it, and checks the result against the exact tangents
+*/
+static int tangent_bench(u32 triangle_count, u32 runs){
+
+    const u32 quads_a_side      = TANGENT_BENCH_GRID - 1;
+    const u32 vertex_count      = TANGENT_BENCH_GRID * TANGENT_BENCH_GRID;
+    const u32 primitive_indices = quads_a_side * quads_a_side * 6;
+    u32 primitive_count = d_max((triangle_count + primitive_indices / 3 - 1) / (primitive_indices / 3), 1u);
+
+    std::vector<u16> indices(primitive_indices);
+    for(u32 y = 0, i = 0; y < quads_a_side; y++){
+        for(u32 x = 0; x < quads_a_side; x++){
+            u16 corner = (u16)(y * TANGENT_BENCH_GRID + x);
+            u16 quad[6] = {corner, (u16)(corner + 1), (u16)(corner + TANGENT_BENCH_GRID),
+                           (u16)(corner + 1), (u16)(corner + TANGENT_BENCH_GRID + 1), (u16)(corner + TANGENT_BENCH_GRID)};
+            memcpy(&indices[i], quad, sizeof(quad));
+            i += 6;
+        }
+    }
+
+    std::vector<std::vector<Package_Vertex>> primitives(primitive_count);
+    std::vector<f32> exact_tangents((u64)primitive_count * vertex_count * 3);
+    for(u32 i = 0; i < primitive_count; i++){
+        primitives[i].resize(vertex_count);
+        tangent_bench_primitive(i, primitives[i].data(), exact_tangents.data() + (u64)i * vertex_count * 3);
+    }
+
+    u64 total_triangles = (u64)primitive_count * primitive_indices / 3;
+    printf("%llu triangles in %u primitives, %u workers, best of %u runs\n\n", total_triangles, primitive_count, jobs_worker_count(), runs);
+    printf("%-14s %10s %16s\n", "", "ms", "M triangles/s");
+
+    Tangent_Bench_Jobs jobs = {primitives.data(), indices.data(), primitive_indices};
+
+    for(u32 pass = 0; pass < 2; pass++){
+
+        bool parallel = pass == 1;
+        f64 best_ms   = 1e30;
+
+        for(u32 run = 0; run < runs; run++){
+
+            u64 start_time = os_now_ticks();
+            if(parallel){
+                Job_Counter counter;
+                jobs_dispatch(tangent_bench_job, &jobs, primitive_count, &counter);
+                jobs_wait(&counter);
+            } else {
+                for(u32 i = 0; i < primitive_count; i++){
+                    tangent_bench_job(&jobs, i);
+                }
+            }
+            best_ms = d_min(best_ms, os_ticks_to_ms((f64)(os_now_ticks() - start_time)));
+
+        }
+
+        printf("%-14s %10.2f %16.1f\n", parallel ? "per primitive" : "one thread", best_ms, total_triangles / (best_ms * 1000.));
+
+    }
+
+    // The grid's triangles only approximate the surface, so a little error is expected
+    f64 max_error_degrees = 0.;
+    u64 wrong_handedness  = 0;
+    for(u32 i = 0; i < primitive_count; i++){
+        f32 expected_handedness = i % 2 ? -1.f : 1.f;
+        for(u32 j = 0; j < vertex_count; j++){
+            const Package_Vertex& vertex = primitives[i][j];
+            const f32* exact = exact_tangents.data() + ((u64)i * vertex_count + j) * 3;
+            f32 cosine = d_min(d_max(meshlet_dot(vertex.tangent, exact), -1.f), 1.f);
+            max_error_degrees = d_max(max_error_degrees, (f64)acosf(cosine) * 180. / 3.14159265358979);
+            wrong_handedness += vertex.tangent[3] != expected_handedness;
+        }
+    }
+    printf("\nmax error %.3f degrees from the exact tangents, %llu of %llu vertices with the wrong handedness\n", max_error_degrees,
+        wrong_handedness, (u64)primitive_count * vertex_count);
+
+    return wrong_handedness == 0 ? 0 : 1;
+
+}
+
+int main(int argc, char** argv){
+
+    if(argc < 3 || (strcmp(argv[1], "--bench") == 0 && argc < 4)){
+        printf("Usage: ddx_cook <model.gltf|model.glb> <out.ddxpkg> [--cache <directory>] [--cache-mb N] [--no-cache] [--mesh-report] [--weld-tolerance X]\n");
+        printf("       ddx_cook --bench <model.gltf|model.glb> <package.ddxpkg> [--runs N]\n");
+        printf("       ddx_cook --cull-report <package.ddxpkg> [--frames N]\n");
+        printf("       ddx_cook --lod-report <package.ddxpkg> [--frames N]\n");
+        printf("       ddx_cook --tangent-bench <triangles> [--runs N]\n");
+        return 1;
+    }
+
+    os_timer_init();
+    jobs_init();
+
+    int result = 0;
+
+    if(strcmp(argv[1], "--bench") == 0){
+
+        u32 runs = DEFAULT_RUNS;
+        if(argc > 5 && strcmp(argv[4], "--runs") == 0){
+            runs = d_max((u32)atoi(argv[5]), 1u);
+        }
+
+        result = bench(argv[2], argv[3], runs);
+
+    } else if(strcmp(argv[1], "--cull-report") == 0){
+
+        u32 frames = DEFAULT_REPORT_FRAMES;
+        if(argc > 4 && strcmp(argv[3], "--frames") == 0){
+            frames = d_max((u32)atoi(argv[4]), 1u);
+        }
+
+        result = cull_report(argv[2], frames);
+
+    } else if(strcmp(argv[1], "--tangent-bench") == 0){
+
+        u32 runs = DEFAULT_RUNS;
+        if(argc > 4 && strcmp(argv[3], "--runs") == 0){
+            runs = d_max((u32)atoi(argv[4]), 1u);
+        }
+
+        result = tangent_bench((u32)strtoul(argv[2], NULL, 10), runs);
+
+    } else if(strcmp(argv[1], "--lod-report") == 0){
+
+        u32 frames = DEFAULT_REPORT_FRAMES;
+        if(argc > 4 && strcmp(argv[3], "--frames") == 0){
+            frames = d_max((u32)atoi(argv[4]), 1u);
+        }
+
+        result = lod_report(argv[2], frames);
+
+    } else {
+
+        // The default cache sits next to the package
+        std::string cache_directory = argv[2];
+        cache_directory = cache_directory.substr(0, cache_directory.find_last_of("/\\") + 1) + "ddx_cache";
+        u64  cache_size_cap = CACHE_DEFAULT_SIZE_CAP;
+        bool use_cache      = true;
+        bool mesh_report    = false;
+        f32  weld_tolerance = 0.f;
+
+        for(int i = 3; i < argc; i++){
+            if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc){
+                cache_directory = argv[++i];
+            } else if(strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc){
+                cache_size_cap = (u64)atoll(argv[++i]) * 1024 * 1024;
+            } else if(strcmp(argv[i], "--no-cache") == 0){
+                use_cache = false;
+            } else if(strcmp(argv[i], "--mesh-report") == 0){
+                mesh_report = true;
+            } else if(strcmp(argv[i], "--weld-tolerance") == 0 && i + 1 < argc){
+                weld_tolerance = (f32)atof(argv[++i]);
+                weld_tolerance = d_max(weld_tolerance, 0.f);
+            } else {
+                printf("Warning: unknown option %s\n", argv[i]);
+            }
+        }
+
+        Derived_Data_Cache cache;
+        if(use_cache && !cache_init(&cache, cache_directory.c_str(), cache_size_cap)){
+            printf("Warning: couldn't create the cache directory %s, or its path is too long, cooking without it\n", cache_directory.c_str());
+            use_cache = false;
+        }
+
+        Cooked_Package package = {};
+        Cook_Stats stats = {};
+
+        if(!cook(argv[1], use_cache ? &cache : NULL, &package, &stats, weld_tolerance) || !write_package(argv[2], &package)){
+            result = 1;
+        } else {
+            Package_Header* header = (Package_Header*)package.data;
+            printf("%s: %u meshes, %u primitives, %llu vertices, %llu indices, %u materials, %u textures (%u duplicate images shared), %.2f MB\n", argv[2],
+                header->mesh_count, header->primitive_count, stats.vertex_count, stats.index_count, header->material_count,
+                stats.texture_count, stats.textures_deduplicated, (f64)package.size / (1024. * 1024.));
+            printf("parse %.2fms, image decode %.2fms, build %.2fms (%u workers)\n", stats.parse_ms, stats.decode_ms, stats.build_ms, jobs_worker_count());
+
+            // Vertices before and after welding, vertex cache ACMR / ATVR before and after optimize_mesh with a MESH_OPTIMIZE_CACHE_SIZE FIFO
+            Mesh_Optimize_Stats total_stats = {};
+            Mesh_Weld_Stats total_weld_stats = {};
+            if(mesh_report){
+                printf("\n%-32s %10s %10s %10s %8s %8s %8s %8s\n", "mesh", "triangles", "vertices", "welded", "ACMR", "after", "ATVR", "after");
+            }
+            for(u64 i = 0; i < stats.mesh_optimize.size(); i++){
+                const Mesh_Optimize_Stats& mesh_stats = stats.mesh_optimize[i];
+                const Mesh_Weld_Stats& weld_stats     = stats.mesh_weld[i];
+                mesh_optimize_stats_add(&total_stats, mesh_stats);
+                mesh_weld_stats_add(&total_weld_stats, weld_stats);
+                if(mesh_report){
+                    printf("%-32.32s %10llu %10llu %10llu %8.3f %8.3f %8.3f %8.3f\n", stats.mesh_names[i].c_str(), mesh_stats.before.triangle_count,
+                        weld_stats.vertex_count, weld_stats.welded_vertex_count, vertex_cache_acmr(mesh_stats.before), vertex_cache_acmr(mesh_stats.after),
+                        vertex_cache_atvr(mesh_stats.before), vertex_cache_atvr(mesh_stats.after));
+                }
+            }
+            printf("welding: %llu -> %llu vertices (-%.1f%%)\n", total_weld_stats.vertex_count, total_weld_stats.welded_vertex_count, mesh_weld_reduction(total_weld_stats) * 100.f);
+            printf("vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%llu triangles)\n", vertex_cache_acmr(total_stats.before), vertex_cache_acmr(total_stats.after),
+                vertex_cache_atvr(total_stats.before), vertex_cache_atvr(total_stats.after), total_stats.before.triangle_count);
+            printf("scene: %u nodes, %u mesh instances\n", stats.node_count, stats.instance_count);
+            const Mesh_Bounds& bounds = header->bounds;
+            printf("bounds: (%.3f, %.3f, %.3f) to (%.3f, %.3f, %.3f), radius %.3f\n", bounds.min[0], bounds.min[1], bounds.min[2],
+                bounds.max[0], bounds.max[1], bounds.max[2], bounds.radius);
+            printf("meshlets: %llu, %.1f triangles a meshlet\n", stats.meshlet_count, stats.meshlet_count ? (f64)stats.meshlet_triangle_count / stats.meshlet_count : 0.);
+            printf("lods: triangles");
+            for(u32 lod = 0; lod < MESH_LOD_MAX; lod++){
+                printf(" %s%llu", lod ? "/ " : "", stats.lod_triangle_count[lod]);
+            }
+            printf(", %.1f ms simplifying (CPU, cooked meshes only)\n", stats.simplify_ms);
+            if(use_cache){
+                printf("cache %s: meshes %u cached, %u cooked; textures %u cached, %u cooked\n", cache_directory.c_str(),
+                    stats.meshes_cached, header->mesh_count - stats.meshes_cached, stats.textures_cached, stats.texture_count - stats.textures_cached);
+            }
+        }
+
+        if(use_cache){
+            u64 evicted_size = cache_trim(&cache);
+            if(evicted_size){
+                printf("cache over %.0f MB, evicted %.2f MB\n", (f64)cache_size_cap / (1024. * 1024.), (f64)evicted_size / (1024. * 1024.));
+            }
+        }
+
+        free(package.data);
+
+    }
+
+    jobs_shutdown();
+
+    return result;
+
+}
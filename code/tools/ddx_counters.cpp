@@ -0,0 +1,114 @@
+// Summarizes a counter ring file written by d_counters (counters.bin)
+//
+// Usage: ddx_counters <counters.bin> [--frames]
+//     --frames  Also print every frame's values as csv, oldest frame first
+
+#include "../d_core/d_core.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace d_std;
+
+static int compare_u64(const void* a, const void* b){
+    u64 value_a = *(const u64*)a;
+    u64 value_b = *(const u64*)b;
+    return (value_a > value_b) - (value_a < value_b);
+}
+
+int main(int argc, char** argv){
+
+    if(argc < 2){
+        printf("Usage: ddx_counters <counters.bin> [--frames]\n");
+        return 1;
+    }
+
+    bool print_frames = argc > 2 && strcmp(argv[2], "--frames") == 0;
+
+    FILE* file = fopen(argv[1], "rb");
+    if(file == NULL){
+        printf("Error: couldn't open %s\n", argv[1]);
+        return 1;
+    }
+
+    Counter_File_Header header;
+    if(fread(&header, sizeof(Counter_File_Header), 1, file) != 1 || header.magic != COUNTER_FILE_MAGIC){
+        printf("Error: %s is not a counter file\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+
+    if(header.version != COUNTER_FILE_VERSION){
+        printf("Error: %s is version %u, expected version %u\n", argv[1], header.version, COUNTER_FILE_VERSION);
+        fclose(file);
+        return 1;
+    }
+
+    u64 frame_count = d_min(header.frames_written, (u64)header.ring_capacity);
+    if(frame_count == 0){
+        printf("%s: no frames recorded\n", argv[1]);
+        fclose(file);
+        return 0;
+    }
+
+    // Read the ring in chronological order. The oldest frame is the slot after the newest one once the ring has wrapped
+    u64 first_frame = header.frames_written - frame_count;
+    Counter_Snapshot* snapshots = (Counter_Snapshot*)malloc(frame_count * sizeof(Counter_Snapshot));
+
+    for(u64 i = 0; i < frame_count; i++){
+        u64 slot = (first_frame + i) % header.ring_capacity;
+        fseek(file, (long)(sizeof(Counter_File_Header) + slot * sizeof(Counter_Snapshot)), SEEK_SET);
+        fread(&snapshots[i], sizeof(Counter_Snapshot), 1, file);
+    }
+
+    fclose(file);
+
+    printf("%s: %llu frames (frames %llu - %llu), %u counters\n\n", argv[1], frame_count, first_frame, header.frames_written - 1, header.counter_count);
+    printf("%-32s %12s %14s %12s %12s %12s %12s\n", "counter", "min", "mean", "p50", "p99", "max", "last");
+
+    u64* sorted_values = (u64*)malloc(frame_count * sizeof(u64));
+
+    for(u32 counter = 0; counter < header.counter_count; counter++){
+
+        f64 sum = 0.;
+        for(u64 i = 0; i < frame_count; i++){
+            sorted_values[i] = snapshots[i].values[counter];
+            sum += (f64)sorted_values[i];
+        }
+
+        qsort(sorted_values, frame_count, sizeof(u64), compare_u64);
+
+        u64 p50 = sorted_values[(u64)(0.50 * (frame_count - 1))];
+        u64 p99 = sorted_values[(u64)(0.99 * (frame_count - 1))];
+
+        printf("%-32s %12llu %14.2f %12llu %12llu %12llu %12llu\n", header.names[counter],
+            sorted_values[0], sum / (f64)frame_count, p50, p99, sorted_values[frame_count - 1],
+            snapshots[frame_count - 1].values[counter]);
+
+    }
+
+    if(print_frames){
+
+        printf("\nframe");
+        for(u32 counter = 0; counter < header.counter_count; counter++){
+            printf(",%s", header.names[counter]);
+        }
+        printf("\n");
+
+        for(u64 i = 0; i < frame_count; i++){
+            printf("%llu", snapshots[i].frame_index);
+            for(u32 counter = 0; counter < header.counter_count; counter++){
+                printf(",%llu", snapshots[i].values[counter]);
+            }
+            printf("\n");
+        }
+
+    }
+
+    free(sorted_values);
+    free(snapshots);
+
+    return 0;
+
+}
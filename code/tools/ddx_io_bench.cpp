@@ -0,0 +1,214 @@
+// Measures cold cache load time for every file in a directory (recursively), reading them
+// synchronously one at a time, and through the d_os async reader with and without the OS file cache.
+// Each file's page cache is evicted before every run.
+//
+// Usage: ddx_io_bench <directory> [--queue-depth N] [--chunk-kb N] [--runs N]
+
+#include "../d_core/d_core.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+using namespace d_std;
+
+#define DEFAULT_QUEUE_DEPTH 64
+#define DEFAULT_CHUNK_KB    1024
+#define DEFAULT_RUNS        3
+
+struct Bench_File {
+    std::string path;
+    u64         size;
+    u64         destination_offset;  // Into the shared destination buffer, OS_ASYNC_DIRECT_ALIGNMENT aligned
+};
+
+struct Bench_Result {
+    f64 best_ms;
+    u32 checksum;
+};
+
+static void evict_all(std::vector<Bench_File>& files){
+    for(Bench_File& file : files){
+        os_evict_file_cache(file.path.c_str());
+    }
+}
+
+static u32 checksum_all(std::vector<Bench_File>& files, u8* destination){
+
+    u32 checksum = 0;
+    for(Bench_File& file : files){
+        checksum ^= murmur3_32(destination + file.destination_offset, (u32)file.size, checksum);
+    }
+
+    return checksum;
+
+}
+
+static f64 read_sync(std::vector<Bench_File>& files, u8* destination){
+
+    u64 start = os_now_ticks();
+
+    for(Bench_File& file : files){
+        FILE* handle = fopen(file.path.c_str(), "rb");
+        if(handle){
+            fread(destination + file.destination_offset, 1, file.size, handle);
+            fclose(handle);
+        }
+    }
+
+    return os_ticks_to_ms((f64)(os_now_ticks() - start));
+
+}
+
+static f64 read_async(std::vector<Bench_File>& files, u8* destination, bool direct, u32 queue_depth, u32 chunk_size, const char** backend){
+
+    u64 start = os_now_ticks();
+
+    Async_Reader* reader = os_async_reader_create(queue_depth);
+    *backend = os_async_reader_backend(reader);
+
+    u8* destination_end = destination + files.back().destination_offset + AlignPow2Up(files.back().size, OS_ASYNC_DIRECT_ALIGNMENT);
+    os_async_reader_register_buffer(reader, destination, destination_end - destination);
+
+    // Every file is split into chunk_size reads and the whole batch is submitted at once
+    std::vector<Async_File> async_files(files.size());
+    std::vector<Async_Read> reads;
+
+    for(u64 i = 0; i < files.size(); i++){
+
+        if(!os_open_async_file(files[i].path.c_str(), direct, &async_files[i])){
+            printf("Error: couldn't open %s\n", files[i].path.c_str());
+            continue;
+        }
+
+        // Direct reads must cover whole sectors, the last one comes back short
+        u64 read_size = direct ? AlignPow2Up(files[i].size, OS_ASYNC_DIRECT_ALIGNMENT) : files[i].size;
+        for(u64 offset = 0; offset < read_size; offset += chunk_size){
+            Async_Read read = {};
+            read.file        = &async_files[i];
+            read.destination = destination + files[i].destination_offset + offset;
+            read.offset      = offset;
+            read.size        = (u32)d_min(read_size - offset, (u64)chunk_size);
+            reads.push_back(read);
+        }
+
+    }
+
+    os_async_reader_submit(reader, reads.data(), (u32)reads.size());
+
+    Async_Read* completed[64];
+    u32 errors = 0;
+    u32 completed_count;
+    while((completed_count = os_async_reader_wait(reader, completed, 64)) > 0){
+        for(u32 i = 0; i < completed_count; i++){
+            errors += completed[i]->error != 0;
+        }
+    }
+
+    for(Async_File& async_file : async_files){
+        os_close_async_file(&async_file);
+    }
+    os_async_reader_destroy(reader);
+
+    if(errors){
+        printf("Warning: %u reads failed\n", errors);
+    }
+
+    return os_ticks_to_ms((f64)(os_now_ticks() - start));
+
+}
+
+int main(int argc, char** argv){
+
+    if(argc < 2){
+        printf("Usage: ddx_io_bench <directory> [--queue-depth N] [--chunk-kb N] [--runs N]\n");
+        return 1;
+    }
+
+    u32 queue_depth = DEFAULT_QUEUE_DEPTH;
+    u32 chunk_size  = DEFAULT_CHUNK_KB * 1024;
+    u32 runs        = DEFAULT_RUNS;
+
+    for(int i = 2; i + 1 < argc; i += 2){
+        if(strcmp(argv[i], "--queue-depth") == 0){
+            queue_depth = (u32)atoi(argv[i + 1]);
+        } else if(strcmp(argv[i], "--chunk-kb") == 0){
+            chunk_size = (u32)AlignPow2Up((u64)atoi(argv[i + 1]) * 1024, OS_ASYNC_DIRECT_ALIGNMENT);
+        } else if(strcmp(argv[i], "--runs") == 0){
+            runs = (u32)atoi(argv[i + 1]);
+        }
+    }
+
+    os_timer_init();
+
+    // Gather files, each gets a sector aligned slot in one destination buffer
+    std::vector<Bench_File> files;
+    u64 total_size       = 0;
+    u64 destination_size = 0;
+
+    std::error_code error;
+    for(auto& entry : std::filesystem::recursive_directory_iterator(argv[1], error)){
+        if(entry.is_regular_file() && entry.file_size() > 0){
+            Bench_File file;
+            file.path               = entry.path().string();
+            file.size               = entry.file_size();
+            file.destination_offset = destination_size;
+            files.push_back(file);
+            total_size       += file.size;
+            destination_size += AlignPow2Up(file.size, OS_ASYNC_DIRECT_ALIGNMENT);
+        }
+    }
+
+    if(files.empty()){
+        printf("Error: no files found in %s\n", argv[1]);
+        return 1;
+    }
+
+    // Page aligned, as direct reads need
+    u8* destination = (u8*)d_reserve(destination_size);
+    d_commit((u_ptr)destination, destination_size);
+
+    printf("%s: %zu files, %.2f MB, queue depth %u, %u KB reads, best of %u cold runs\n\n", argv[1], files.size(),
+        (f64)total_size / (1024. * 1024.), queue_depth, chunk_size / 1024, runs);
+    printf("%-10s %-40s %10s %10s %10s\n", "mode", "backend", "ms", "MB/s", "checksum");
+
+    const char* mode_names[] = {"sync", "async", "direct"};
+    u32 reference_checksum = 0;
+    int failures = 0;
+
+    for(u32 mode = 0; mode < 3; mode++){
+
+        const char* backend = "fopen + fread";
+        f64 best_ms = 1e30;
+
+        for(u32 run = 0; run < runs; run++){
+
+            memset(destination, 0, destination_size);
+            evict_all(files);
+
+            f64 ms = mode == 0 ? read_sync(files, destination) : read_async(files, destination, mode == 2, queue_depth, chunk_size, &backend);
+            best_ms = d_min(best_ms, ms);
+
+        }
+
+        u32 checksum = checksum_all(files, destination);
+        if(mode == 0){
+            reference_checksum = checksum;
+        }
+
+        bool matches = checksum == reference_checksum;
+        failures += !matches;
+
+        printf("%-10s %-40s %10.2f %10.1f   %08x%s\n", mode_names[mode], backend, best_ms,
+            ((f64)total_size / (1024. * 1024.)) / (best_ms / 1000.), checksum, matches ? "" : " MISMATCH");
+
+    }
+
+    d_release((u_ptr)destination);
+
+    return failures;
+
+}